@@ -0,0 +1,148 @@
+// CSV formatting throughput of the log writer: CsvWriter (std::to_chars into
+// one byte buffer) against the QTextStream + QString::number path the
+// logging thread used before, and fprintf as a reference. Each writes the
+// same records of the waveform log to a file in a temporary directory.
+//
+// Fails when CsvWriter's output differs from fprintf's by a single byte.
+
+#include "csvwriter.h"
+#include "logrecord.h"
+#include "monotonicclock.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+const int Records = 3000000;
+
+QVector<LogRecord> makeRecords()
+{
+    std::mt19937 generator(3);
+    QVector<LogRecord> records(Records);
+    for (int i = 0; i < Records; ++i) {
+        const qint64 elapsed = qint64(i) * 100000 + generator() % 20000;
+        const double phase = i * 0.00628;
+        LogRecord &r = records[i];
+        r.sampleIndex = i;
+        r.elapsedTime = elapsed;
+        r.sessionTime = elapsed + 5123456789LL;
+        r.frequency = 10.0 + i * 1e-6;
+        r.amplitude = 1.0;
+        r.xCommand = 0.8 * std::sin(phase);
+        r.yCommand = 0.8 * std::cos(phase);
+        r.xFeedback = 4.0 * std::sin(phase - 0.1) + (generator() % 100) * 1e-5;
+        r.yFeedback = 4.0 * std::cos(phase - 0.1);
+    }
+    return records;
+}
+
+// The logging thread's writer before CsvWriter
+void writeTextStream(const QString &fileName, const QVector<LogRecord> &records)
+{
+    QFile file(fileName);
+    file.open(QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream stream(&file);
+    for (const LogRecord &record : records) {
+        stream << record.sampleIndex << ","
+               << QString::number(record.elapsedTime / 1.0e9, 'f', 9) << ","
+               << QString::number(record.sessionTime / 1.0e9, 'f', 9) << ","
+               << QString::number(record.frequency, 'f', 1) << ","
+               << QString::number(record.amplitude, 'f', 1) << ","
+               << QString::number(record.xCommand, 'f', 5) << ","
+               << QString::number(record.yCommand, 'f', 5) << ","
+               << QString::number(record.xFeedback, 'f', 5) << ","
+               << QString::number(record.yFeedback, 'f', 5) << "\n";
+    }
+    stream.flush();
+}
+
+void writePrintf(const QString &fileName, const QVector<LogRecord> &records)
+{
+    FILE *file = std::fopen(QFile::encodeName(fileName).constData(), "w");
+    for (const LogRecord &r : records) {
+        std::fprintf(file, "%lld,%.9f,%.9f,%.1f,%.1f,%.5f,%.5f,%.5f,%.5f\n",
+                     static_cast<long long>(r.sampleIndex), r.elapsedTime / 1e9, r.sessionTime / 1e9,
+                     r.frequency, r.amplitude, r.xCommand, r.yCommand, r.xFeedback, r.yFeedback);
+    }
+    std::fclose(file);
+}
+
+bool writeCsvWriter(const QString &fileName, const QVector<LogRecord> &records)
+{
+    CsvWriter writer;
+    if (!writer.open(fileName)) {
+        std::fprintf(stderr, "%s\n", qPrintable(writer.getLastError()));
+        return false;
+    }
+    for (const LogRecord &record : records) {
+        writer.addInt(record.sampleIndex);
+        writer.addNanoseconds(record.elapsedTime);
+        writer.addNanoseconds(record.sessionTime);
+        writer.addFixed(record.frequency, 1);
+        writer.addFixed(record.amplitude, 1);
+        writer.addFixed(record.xCommand, 5);
+        writer.addFixed(record.yCommand, 5);
+        writer.addFixed(record.xFeedback, 5);
+        writer.addFixed(record.yFeedback, 5);
+        writer.endLine();
+    }
+    return writer.close();
+}
+
+template<typename Write>
+double millionRecordsPerSecond(Write write)
+{
+    const qint64 start = MonotonicClock::nowNs();
+    write();
+    return Records / ((MonotonicClock::nowNs() - start) / 1e9) / 1e6;
+}
+
+QByteArray readAll(const QString &fileName)
+{
+    QFile file(fileName);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "No temporary directory\n");
+        return 1;
+    }
+    const QVector<LogRecord> records = makeRecords();
+    const QString textStreamName = dir.filePath("textstream.csv");
+    const QString printfName = dir.filePath("printf.csv");
+    const QString csvWriterName = dir.filePath("csvwriter.csv");
+
+    bool written = true;
+    const double textStreamRate = millionRecordsPerSecond([&]() { writeTextStream(textStreamName, records); });
+    const double printfRate = millionRecordsPerSecond([&]() { writePrintf(printfName, records); });
+    const double csvWriterRate = millionRecordsPerSecond([&]() { written = writeCsvWriter(csvWriterName, records); });
+
+    std::printf("QTextStream + QString::number  %5.2f M records/s\n", textStreamRate);
+    std::printf("fprintf                        %5.2f M records/s\n", printfRate);
+    std::printf("CsvWriter                      %5.2f M records/s (%.1fx QTextStream)\n",
+                csvWriterRate, csvWriterRate / textStreamRate);
+
+    if (!written) {
+        return 1;
+    }
+    if (readAll(csvWriterName) != readAll(printfName)) {
+        std::fprintf(stderr, "CsvWriter output differs from fprintf\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Cost of Fft::forward at the spectrum analyzer's segment lengths (4k-64k
+// points of real input), against a textbook recursive radix-2 transform on
+// std::complex as the baseline. Fails when the result drifts from a direct
+// DFT on small sizes or from the baseline on the timed ones.
+
+#include "fft.h"
+#include "monotonicclock.h"
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::complex<double> Complex;
+
+void recursiveFft(std::vector<Complex> &a)
+{
+    const int n = int(a.size());
+    if (n == 1) {
+        return;
+    }
+    std::vector<Complex> even(n / 2);
+    std::vector<Complex> odd(n / 2);
+    for (int i = 0; i < n / 2; ++i) {
+        even[i] = a[2 * i];
+        odd[i] = a[2 * i + 1];
+    }
+    recursiveFft(even);
+    recursiveFft(odd);
+    for (int k = 0; k < n / 2; ++k) {
+        const Complex t = std::polar(1.0, -2.0 * M_PI * k / n) * odd[k];
+        a[k] = even[k] + t;
+        a[k + n / 2] = even[k] - t;
+    }
+}
+
+// Largest bin difference against a direct DFT
+double errorAgainstDft(int size, std::mt19937 &generator)
+{
+    std::normal_distribution<double> noise;
+    Fft fft(size);
+    std::vector<double> x(size);
+    std::vector<double> re(fft.binCount());
+    std::vector<double> im(fft.binCount());
+    for (double &value : x) {
+        value = noise(generator);
+    }
+    fft.forward(x.data(), re.data(), im.data());
+
+    double error = 0.0;
+    for (int k = 0; k < fft.binCount(); ++k) {
+        Complex sum = 0.0;
+        for (int i = 0; i < size; ++i) {
+            sum += x[i] * std::polar(1.0, -2.0 * M_PI * double(k) * i / size);
+        }
+        error = std::max(error, std::abs(sum - Complex(re[k], im[k])));
+    }
+    return error;
+}
+
+}
+
+int main()
+{
+    std::mt19937 generator(1);
+    std::normal_distribution<double> noise;
+    int failures = 0;
+
+    for (int size : { 4, 8, 16, 1024 }) {
+        const double error = errorAgainstDft(size, generator);
+        if (!(error < 1e-9)) {
+            std::fprintf(stderr, "N=%d differs from the direct DFT by %g\n", size, error);
+            ++failures;
+        }
+    }
+
+    std::printf("     N      Fft  ns/(N log2 N)  recursive   max diff\n");
+    for (int size = 4096; size <= 65536; size *= 2) {
+        Fft fft(size);
+        std::vector<double> x(size);
+        std::vector<double> re(fft.binCount());
+        std::vector<double> im(fft.binCount());
+        for (double &value : x) {
+            value = noise(generator);
+        }
+
+        const int reps = 20000000 / size;
+        qint64 start = MonotonicClock::nowNs();
+        for (int r = 0; r < reps; ++r) {
+            fft.forward(x.data(), re.data(), im.data());
+        }
+        const double fftUs = (MonotonicClock::nowNs() - start) / 1000.0 / reps;
+
+        const int referenceReps = reps / 10 + 1;
+        std::vector<Complex> reference(size);
+        start = MonotonicClock::nowNs();
+        for (int r = 0; r < referenceReps; ++r) {
+            for (int i = 0; i < size; ++i) {
+                reference[i] = x[i];
+            }
+            recursiveFft(reference);
+        }
+        const double referenceUs = (MonotonicClock::nowNs() - start) / 1000.0 / referenceReps;
+
+        double difference = 0.0;
+        for (int k = 0; k < fft.binCount(); ++k) {
+            difference = std::max(difference, std::abs(reference[k] - Complex(re[k], im[k])));
+        }
+
+        std::printf("%6d %7.1f us %10.2f %9.1f us %10.3g\n", size, fftUs,
+                    fftUs * 1000.0 / (size * std::log2(double(size))), referenceUs, difference);
+        if (!(difference < 1e-8)) {
+            std::fprintf(stderr, "N=%d differs from the recursive FFT by %g\n", size, difference);
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
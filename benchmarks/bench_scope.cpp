@@ -0,0 +1,189 @@
+// GUI-thread time of the waveform display, before and after ScopeWidget.
+//
+// Drives both displays headless (offscreen platform) the way buffered output
+// does: a 10 ms tick delivers 100 frames of a 10 kS/s X/Y sine. The
+// baseline is the old updateWaveformDisplay(): keep the last sample of each
+// tick in a 100-point window, draw two antialiased polylines into a new
+// QPixmap and hand it to a QLabel, whose repaint is timed too. ScopeWidget
+// times its own GUI-thread work (addSamples and paint) in guiHistogram().
+// Fails unless the scope takes less GUI-thread time than the baseline.
+
+#include "scopewidget.h"
+#include "monotonicclock.h"
+#include <QApplication>
+#include <QLabel>
+#include <QPainter>
+#include <QPixmap>
+#include <QTimer>
+#include <QVector>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const double SampleRate = 10000.0;
+const int TickMs = 10;
+const int FramesPerTick = 100;
+const int RunMs = 3000;
+const int Width = 800;
+const int Height = 200;
+
+// The waveform display as it was before ScopeWidget
+class PixmapScope : public QLabel
+{
+public:
+    PixmapScope()
+        : m_xData(100, 0.0)
+        , m_yData(100, 0.0)
+        , m_paintNs(0)
+    {
+        setStyleSheet("border: 1px solid gray; background-color: black;");
+    }
+
+    void addSamples(const double *x, const double *y, int count)
+    {
+        m_xData.pop_front();
+        m_xData.push_back(x[count - 1]);
+        m_yData.pop_front();
+        m_yData.push_back(y[count - 1]);
+        updateWaveformDisplay();
+    }
+
+    qint64 paintNs() const { return m_paintNs; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        const qint64 start = MonotonicClock::nowNs();
+        QLabel::paintEvent(event);
+        m_paintNs += MonotonicClock::nowNs() - start;
+    }
+
+private:
+    QVector<double> m_xData;
+    QVector<double> m_yData;
+    qint64 m_paintNs;
+
+    void updateWaveformDisplay()
+    {
+        QPixmap pixmap(width(), height());
+        pixmap.fill(Qt::black);
+
+        QPainter painter(&pixmap);
+        painter.setRenderHint(QPainter::Antialiasing);
+
+        const int centerY = height() / 2;
+        painter.setPen(QPen(Qt::darkGray, 1));
+        painter.drawLine(0, centerY, width(), centerY);
+
+        const double pointSpacing = static_cast<double>(width()) / (m_xData.size() - 1);
+        const QVector<double> *channels[2] = { &m_xData, &m_yData };
+        const Qt::GlobalColor colors[2] = { Qt::green, Qt::red };
+        for (int channel = 0; channel < 2; ++channel) {
+            const QVector<double> &data = *channels[channel];
+            painter.setPen(QPen(colors[channel], 2));
+            QPolygonF points;
+            for (int i = 0; i < data.size(); ++i) {
+                points << QPointF(width() - (data.size() - 1 - i) * pointSpacing,
+                                  centerY - data[i] * centerY * 0.9);
+            }
+            painter.drawPolyline(points);
+        }
+        painter.end();
+
+        setPixmap(pixmap);
+    }
+};
+
+struct Result {
+    quint64 ticks;
+    double msPerSecond;
+    double usPerTick;
+};
+
+// Runs the event loop for RunMs with display shown, handing each tick's
+// frames to feed; returns the number of ticks
+template<typename Feed>
+quint64 drive(QWidget *display, Feed feed)
+{
+    display->resize(Width, Height);
+    display->show();
+
+    QVector<double> x(FramesPerTick);
+    QVector<double> y(FramesPerTick);
+    quint64 frame = 0;
+    quint64 ticks = 0;
+
+    QTimer tick;
+    tick.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&tick, &QTimer::timeout, [&]() {
+        for (int i = 0; i < FramesPerTick; ++i, ++frame) {
+            const double phase = 2.0 * M_PI * 37.0 * frame / SampleRate;
+            x[i] = 0.8 * std::sin(phase);
+            y[i] = 0.8 * std::cos(phase);
+        }
+        feed(x.constData(), y.constData(), FramesPerTick);
+        ++ticks;
+    });
+    tick.start(TickMs);
+
+    QTimer::singleShot(RunMs, qApp, &QCoreApplication::quit);
+    QApplication::exec();
+    tick.stop();
+    display->hide();
+    return ticks;
+}
+
+Result result(quint64 ticks, qint64 totalNs)
+{
+    Result r;
+    r.ticks = ticks;
+    r.msPerSecond = totalNs / 1.0e6 / (RunMs / 1000.0);
+    r.usPerTick = ticks ? totalNs / 1000.0 / ticks : 0.0;
+    return r;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    PixmapScope pixmapScope;
+    qint64 pixmapFeedNs = 0;
+    const quint64 pixmapTicks = drive(&pixmapScope, [&](const double *x, const double *y, int count) {
+        const qint64 start = MonotonicClock::nowNs();
+        pixmapScope.addSamples(x, y, count);
+        pixmapFeedNs += MonotonicClock::nowNs() - start;
+    });
+    const Result before = result(pixmapTicks, pixmapFeedNs + pixmapScope.paintNs());
+
+    ScopeWidget scope;
+    scope.setSampleRate(SampleRate);
+    scope.setTimeWindow(1.0);
+    const quint64 scopeTicks = drive(&scope, [&](const double *x, const double *y, int count) {
+        scope.addSamples(x, y, count);
+    });
+    const LatencyHistogram &gui = scope.guiHistogram();
+    const Result after = result(scopeTicks, qint64(gui.meanNs() * gui.count()));
+
+    std::printf("%d ms run, %d frames per %d ms tick, %dx%d\n", RunMs, FramesPerTick, TickMs, Width, Height);
+    std::printf("QPixmap + QLabel  %6llu ticks %8.1f us/tick %7.2f ms/s GUI thread\n",
+                static_cast<unsigned long long>(before.ticks), before.usPerTick, before.msPerSecond);
+    std::printf("ScopeWidget       %6llu ticks %8.1f us/tick %7.2f ms/s GUI thread\n",
+                static_cast<unsigned long long>(after.ticks), after.usPerTick, after.msPerSecond);
+    std::printf("ScopeWidget       %s\n", qPrintable(gui.summary()));
+
+    if (before.ticks == 0 || after.ticks == 0) {
+        std::fprintf(stderr, "The tick timer never fired\n");
+        return 1;
+    }
+    if (!(after.msPerSecond < before.msPerSecond)) {
+        std::fprintf(stderr, "ScopeWidget took more GUI-thread time than the pixmap path\n");
+        return 1;
+    }
+    return 0;
+}
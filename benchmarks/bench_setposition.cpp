@@ -0,0 +1,90 @@
+// Cost of FastSteeringMirror::setPosition over the null backend, which
+// discards the sample, so what is left is the mirror's own path: the device
+// state check, clamping, voltage conversion and the backend call.
+//
+// The per-write probe row puts the check setPosition made before the state
+// cache back in front of every call: an out-of-line call into the backend
+// inside a try block. On the null backend that is the floor of the old
+// cost; with a card, the SDK's getChannelCount() round trip comes on top.
+
+#include "faststeeringmirror.h"
+#include "monotonicclock.h"
+#include "nullaobackend.h"
+#include <QCoreApplication>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const int Calls = 1000000;
+const int Runs = 5;
+
+// Stands in for the SDK property read of the old isDeviceOpen()
+Q_DECL_NOINLINE bool probeDevice(AoBackend *backend)
+{
+    try {
+        return backend->type() == AoBackend::Null;
+    } catch (...) {
+        return false;
+    }
+}
+
+template<typename Call>
+double bestNsPerCall(Call call)
+{
+    double best = 1e30;
+    for (int run = 0; run < Runs; ++run) {
+        const qint64 start = MonotonicClock::nowNs();
+        for (int i = 0; i < Calls; ++i) {
+            call(i);
+        }
+        best = qMin(best, double(MonotonicClock::nowNs() - start) / Calls);
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    FastSteeringMirror mirror;
+    if (!mirror.setBackendType(AoBackend::Null) || !mirror.initialize() || !mirror.openDevice("Null output")) {
+        std::fprintf(stderr, "Failed to open the null backend: %s\n", qPrintable(mirror.getLastError()));
+        return 1;
+    }
+    NullAoBackend *backend = qobject_cast<NullAoBackend *>(mirror.backend());
+
+    auto position = [](int i) { return std::sin(i * 1e-3); };
+    int failures = 0;
+
+    mirror.setInstrumentationEnabled(false);
+    const double checkNs = bestNsPerCall([&](int) { failures += !mirror.isDeviceOpen(); });
+    const double cachedNs = bestNsPerCall([&](int i) {
+        failures += !mirror.setPosition(position(i), -position(i));
+    });
+    const double probedNs = bestNsPerCall([&](int i) {
+        failures += !(probeDevice(backend) && mirror.setPosition(position(i), -position(i)));
+    });
+
+    mirror.setInstrumentationEnabled(true);
+    const double timedNs = bestNsPerCall([&](int i) {
+        failures += !mirror.setPosition(position(i), -position(i));
+    });
+
+    std::printf("isDeviceOpen                      %7.1f ns\n", checkNs);
+    std::printf("setPosition, state cache          %7.1f ns\n", cachedNs);
+    std::printf("setPosition, per-write probe      %7.1f ns\n", probedNs);
+    std::printf("setPosition, write histogram on   %7.1f ns\n", timedNs);
+
+    // Every call reached the backend
+    const quint64 expected = quint64(Calls) * Runs * 3;
+    if (failures != 0 || backend->writeCount() != expected) {
+        std::fprintf(stderr, "%d failed calls, %llu writes of %llu\n", failures,
+                     static_cast<unsigned long long>(backend->writeCount()),
+                     static_cast<unsigned long long>(expected));
+        return 1;
+    }
+    return 0;
+}
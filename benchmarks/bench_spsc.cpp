@@ -0,0 +1,260 @@
+// Log record hand-off from the output loop to the writer thread: the
+// SpscQueue path LoggingThread uses against the QMutex + QVector swap it
+// replaced. The producer paces itself to 1M records/s (and runs flat out
+// for the queue alone); the consumer formats each record as a CSV line into
+// /dev/null, so formatting cost is in the loop but the disk is not.
+//
+// Reports the mean and worst push time, records written and dropped. Fails
+// when a record is lost without being counted as dropped or arrives out of
+// order.
+
+#include "spscqueue.h"
+#include "logrecord.h"
+#include "loggingthread.h"
+#include "monotonicclock.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+struct Result {
+    double meanPushNs;
+    qint64 maxPushNs;
+    quint64 written;
+    quint64 dropped;
+    double seconds;
+    bool ordered;
+};
+
+// Consumer side shared by both schemes: formats and checks the sequence
+class Writer
+{
+public:
+    explicit Writer(bool format)
+        : m_file(format ? std::fopen("/dev/null", "w") : nullptr)
+        , m_next(0)
+        , m_written(0)
+        , m_ordered(true)
+    {
+    }
+
+    ~Writer()
+    {
+        if (m_file) {
+            std::fclose(m_file);
+        }
+    }
+
+    void write(const LogRecord *records, int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            const LogRecord &r = records[i];
+            // Dropped records leave gaps, but never a step backwards
+            if (r.sampleIndex < m_next) {
+                m_ordered = false;
+            }
+            m_next = r.sampleIndex + 1;
+            if (m_file) {
+                std::fprintf(m_file, "%lld,%.9f,%.9f,%.1f,%.1f,%.5f,%.5f,%.5f,%.5f\n",
+                             static_cast<long long>(r.sampleIndex), r.elapsedTime / 1e9,
+                             r.sessionTime / 1e9, r.frequency, r.amplitude, r.xCommand,
+                             r.yCommand, r.xFeedback, r.yFeedback);
+            }
+        }
+        m_written += count;
+    }
+
+    void flush()
+    {
+        if (m_file) {
+            std::fflush(m_file);
+        }
+    }
+
+    quint64 written() const { return m_written; }
+    bool ordered() const { return m_ordered; }
+
+private:
+    FILE *m_file;
+    qint64 m_next;
+    quint64 m_written;
+    bool m_ordered;
+};
+
+LogRecord makeRecord(qint64 i)
+{
+    LogRecord record = { i, i * 1000, i * 1000, 10.0, 1.0, 0.1, 0.2, 0.3, 0.4 };
+    return record;
+}
+
+// Calls push(record) count times at ratePerSecond (0: flat out), timing each
+template<typename Push>
+Result produce(qint64 count, qint64 ratePerSecond, Push push)
+{
+    Result result = {};
+    double totalNs = 0.0;
+    const qint64 startNs = MonotonicClock::nowNs();
+    for (qint64 i = 0; i < count; ++i) {
+        if (ratePerSecond > 0) {
+            const qint64 dueNs = startNs + i * 1000000000LL / ratePerSecond;
+            while (MonotonicClock::nowNs() < dueNs) {
+            }
+        }
+        const LogRecord record = makeRecord(i);
+        const qint64 pushStartNs = MonotonicClock::nowNs();
+        if (!push(record)) {
+            ++result.dropped;
+        }
+        const qint64 pushNs = MonotonicClock::nowNs() - pushStartNs;
+        totalNs += pushNs;
+        result.maxPushNs = qMax(result.maxPushNs, pushNs);
+    }
+    result.seconds = (MonotonicClock::nowNs() - startNs) / 1e9;
+    result.meanPushNs = totalNs / count;
+    return result;
+}
+
+// LoggingThread's scheme: drop when full, eventfd every WakeBatch records,
+// the writer also wakes on its own every 20 ms
+Result runSpsc(qint64 count, qint64 ratePerSecond, bool format)
+{
+    SpscQueue<LogRecord> queue(LoggingThread::QueueCapacityLog2);
+    const int wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    std::atomic<bool> stop(false);
+    Writer writer(format);
+
+    std::thread consumer([&]() {
+        pollfd wake = { wakeFd, POLLIN, 0 };
+        const timespec interval = { 0, 20000000 };
+        for (;;) {
+            const bool stopping = stop.load(std::memory_order_acquire);
+            const LogRecord *records = nullptr;
+            int n;
+            while ((n = queue.peek(&records, 1024)) > 0) {
+                writer.write(records, n);
+                queue.release(n);
+            }
+            writer.flush();
+            if (stopping) {
+                break;
+            }
+            ppoll(&wake, 1, &interval, nullptr);
+            quint64 value;
+            ssize_t ignored = read(wakeFd, &value, sizeof(value));
+            Q_UNUSED(ignored);
+        }
+    });
+
+    auto signal = [wakeFd]() {
+        const quint64 one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        Q_UNUSED(ignored);
+    };
+
+    int unsignalled = 0;
+    Result result = produce(count, ratePerSecond, [&](const LogRecord &record) {
+        if (!queue.tryPush(record)) {
+            return false;
+        }
+        if (++unsignalled >= LoggingThread::WakeBatch) {
+            unsignalled = 0;
+            signal();
+        }
+        return true;
+    });
+
+    stop.store(true, std::memory_order_release);
+    signal();
+    consumer.join();
+    close(wakeFd);
+
+    result.written = writer.written();
+    result.ordered = writer.ordered();
+    return result;
+}
+
+// The scheme before SpscQueue: append under a mutex, the writer swaps the
+// whole vector out every millisecond. Never drops, the backlog is unbounded.
+Result runMutex(qint64 count, qint64 ratePerSecond, bool format)
+{
+    QMutex mutex;
+    QVector<LogRecord> pending;
+    std::atomic<bool> stop(false);
+    Writer writer(format);
+
+    std::thread consumer([&]() {
+        QVector<LogRecord> local;
+        for (;;) {
+            const bool stopping = stop.load(std::memory_order_acquire);
+            {
+                QMutexLocker locker(&mutex);
+                local.swap(pending);
+            }
+            writer.write(local.constData(), local.size());
+            local.clear();
+            writer.flush();
+            if (stopping) {
+                break;
+            }
+            usleep(1000);
+        }
+    });
+
+    Result result = produce(count, ratePerSecond, [&](const LogRecord &record) {
+        QMutexLocker locker(&mutex);
+        pending.append(record);
+        return true;
+    });
+
+    stop.store(true, std::memory_order_release);
+    consumer.join();
+
+    result.written = writer.written();
+    result.ordered = writer.ordered();
+    return result;
+}
+
+bool report(const char *name, qint64 count, const Result &result)
+{
+    std::printf("%-26s push mean %6.1f ns max %9lld ns, %9llu written, %9llu dropped, %.2f s\n",
+                name, result.meanPushNs, static_cast<long long>(result.maxPushNs),
+                static_cast<unsigned long long>(result.written),
+                static_cast<unsigned long long>(result.dropped), result.seconds);
+
+    bool ok = true;
+    if (result.written + result.dropped != quint64(count)) {
+        std::fprintf(stderr, "%s: %lld records pushed, %llu written + %llu dropped\n", name,
+                     static_cast<long long>(count),
+                     static_cast<unsigned long long>(result.written),
+                     static_cast<unsigned long long>(result.dropped));
+        ok = false;
+    }
+    if (!result.ordered) {
+        std::fprintf(stderr, "%s: records arrived out of order\n", name);
+        ok = false;
+    }
+    return ok;
+}
+
+}
+
+int main()
+{
+    const qint64 Paced = 3000000;
+    const qint64 FlatOut = 20000000;
+    bool ok = true;
+
+    ok &= report("SPSC, 1M/s, formatted", Paced, runSpsc(Paced, 1000000, true));
+    ok &= report("Mutex, 1M/s, formatted", Paced, runMutex(Paced, 1000000, true));
+    ok &= report("SPSC, flat out", FlatOut, runSpsc(FlatOut, 0, false));
+    ok &= report("SPSC, flat out, formatted", Paced, runSpsc(Paced, 0, true));
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+// LoggingThread against a disk that cannot keep up: the producer paces
+// itself to 20k records/s, as the output thread would, while the CSV sink
+// is throttled to 4 MB/s and stalls for 4 s once, longer than the queue
+// holds. Runs once per overflow policy:
+//  - DropOnOverflow: records are dropped, every record is either written or
+//    counted as dropped, and addRecord() never waits for the stall.
+//  - BlockOnOverflow: nothing is dropped, every record is written, and the
+//    producer is held up until the sink drains.
+// Prints the addRecord() latency distribution of each run.
+
+#include "loggingthread.h"
+#include "csvlogsink.h"
+#include "latencyhistogram.h"
+#include "monotonicclock.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+namespace {
+
+const double RecordRate = 20000.0;
+const double Seconds = 6.0;
+const qint64 StallAfterNs = 500000000LL;
+const qint64 StallNs = 4000000000LL;
+const double SinkBytesPerSecond = 4.0e6;
+const int LineBytes = 78;   // A waveform CSV line
+
+// Worst addRecord() allowed under DropOnOverflow: far below the stall, with
+// room for the scheduler on a loaded machine
+const qint64 MaxDropPolicyNs = 10000000LL;
+
+// A CSV sink behind a slow disk with one long stall
+class ThrottledSink : public CsvLogSink
+{
+public:
+    ThrottledSink()
+        : m_openedNs(0)
+        , m_stalled(false)
+    {
+    }
+
+    bool open(const QString &fileName, double sampleRate, const LogFile::Options &options) override
+    {
+        m_openedNs = MonotonicClock::nowNs();
+        m_stalled = false;
+        return CsvLogSink::open(fileName, sampleRate, options);
+    }
+
+    bool write(const LogRecord *records, int count) override
+    {
+        const bool ok = CsvLogSink::write(records, count);
+        ::usleep(static_cast<useconds_t>(count * LineBytes * 1.0e6 / SinkBytesPerSecond));
+
+        if (!m_stalled && MonotonicClock::nowNs() - m_openedNs >= StallAfterNs) {
+            m_stalled = true;
+            MonotonicClock::sleepUntil(MonotonicClock::nowNs() + StallNs);
+        }
+        return ok;
+    }
+
+private:
+    qint64 m_openedNs;
+    bool m_stalled;
+};
+
+struct Run {
+    quint64 produced;
+    quint64 written;
+    quint64 dropped;
+    quint64 blocked;
+    qint64 maxAddNs;
+};
+
+Run run(LoggingThread::OverflowPolicy policy, const QString &fileName, LatencyHistogram *histogram)
+{
+    LoggingThread logger;
+    logger.setOverflowPolicy(policy);
+    Run result = {};
+    if (!logger.startLogging(new ThrottledSink, fileName, RecordRate)) {
+        std::fprintf(stderr, "%s\n", qPrintable(logger.getLastError()));
+        return result;
+    }
+
+    const qint64 periodNs = static_cast<qint64>(1.0e9 / RecordRate);
+    const qint64 count = static_cast<qint64>(Seconds * RecordRate);
+    qint64 deadlineNs = MonotonicClock::nowNs();
+    for (qint64 i = 0; i < count; ++i) {
+        deadlineNs += periodNs;
+        MonotonicClock::sleepUntil(deadlineNs);
+
+        const double phase = i * 0.01;
+        const LogRecord record = { i, i * periodNs, deadlineNs, 10.0, 1.0, std::sin(phase),
+                                   std::cos(phase), std::sin(phase), std::cos(phase) };
+        const qint64 startNs = MonotonicClock::nowNs();
+        logger.addRecord(record);
+        histogram->record(MonotonicClock::nowNs() - startNs);
+    }
+    logger.stopLogging();
+
+    result.produced = quint64(count);
+    result.written = logger.writtenCount();
+    result.dropped = logger.droppedCount();
+    result.blocked = logger.blockedCount();
+    result.maxAddNs = histogram->maxNs();
+    return result;
+}
+
+void report(const char *name, const Run &result, const LatencyHistogram &histogram)
+{
+    std::printf("%s: %llu produced, %llu written, %llu dropped, %llu waits for room\n", name,
+                static_cast<unsigned long long>(result.produced),
+                static_cast<unsigned long long>(result.written),
+                static_cast<unsigned long long>(result.dropped),
+                static_cast<unsigned long long>(result.blocked));
+    std::printf("  addRecord p50 %.2f us, p99.9 %.2f us, max %.1f us\n",
+                histogram.percentileNs(50.0) / 1000.0, histogram.percentileNs(99.9) / 1000.0,
+                result.maxAddNs / 1000.0);
+}
+
+bool check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+    }
+    return condition;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "No temporary directory\n");
+        return 1;
+    }
+
+    bool ok = true;
+
+    LatencyHistogram dropHistogram("addRecord, drop");
+    const Run drop = run(LoggingThread::DropOnOverflow, dir.filePath("drop.csv"), &dropHistogram);
+    report("DropOnOverflow", drop, dropHistogram);
+    ok &= check(drop.produced > 0, "drop run started");
+    ok &= check(drop.dropped > 0, "the stall overflows the queue and records are dropped");
+    ok &= check(drop.written + drop.dropped == drop.produced, "every record is written or counted as dropped");
+    ok &= check(drop.blocked == 0, "the drop policy never waits for room");
+    ok &= check(drop.maxAddNs < MaxDropPolicyNs, "addRecord does not wait for the sink under the drop policy");
+
+    LatencyHistogram blockHistogram("addRecord, block");
+    const Run block = run(LoggingThread::BlockOnOverflow, dir.filePath("block.csv"), &blockHistogram);
+    report("BlockOnOverflow", block, blockHistogram);
+    ok &= check(block.produced > 0, "block run started");
+    ok &= check(block.dropped == 0, "nothing is dropped under the block policy");
+    ok &= check(block.written == block.produced, "every record is written under the block policy");
+    ok &= check(block.blocked > 0, "the producer waits for room during the stall");
+
+    return ok ? 0 : 1;
+}
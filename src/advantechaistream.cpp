@@ -0,0 +1,154 @@
+#include "advantechaistream.h"
+#include <QDebug>
+
+AdvantechAiStream::AdvantechAiStream(const QString &deviceName, const QString &profilePath,
+                                     QObject *parent)
+    : AiStream(parent)
+    , m_wfAiCtrl(nullptr)
+    , m_deviceName(deviceName)
+    , m_profilePath(profilePath)
+{
+}
+
+AdvantechAiStream::~AdvantechAiStream()
+{
+    stop();
+    releaseDevice();
+}
+
+bool AdvantechAiStream::checkError(ErrorCode errorCode, const QString &context)
+{
+    if (errorCode == Success || errorCode < 0xE0000000) {
+        return true;
+    }
+
+    setLastError(QString("%1, error code: 0x%2").arg(context,
+        QString::number(errorCode, 16).right(8).toUpper()));
+    qDebug() << "Buffered AI:" << getLastError();
+    return false;
+}
+
+bool AdvantechAiStream::startDevice()
+{
+    releaseDevice();
+
+    m_wfAiCtrl = WaveformAiCtrl::Create();
+    if (!m_wfAiCtrl) {
+        setLastError("Failed to create WaveformAiCtrl instance");
+        return false;
+    }
+
+    std::wstring wDeviceName = m_deviceName.toStdWString();
+    DeviceInformation devInfo(wDeviceName.c_str());
+    if (!checkError(m_wfAiCtrl->setSelectedDevice(devInfo), "Failed to select device")) {
+        releaseDevice();
+        return false;
+    }
+
+    if (!m_profilePath.isEmpty()) {
+        std::wstring wProfilePath = m_profilePath.toStdWString();
+        ErrorCode errCode = m_wfAiCtrl->LoadProfile(wProfilePath.c_str());
+        if (errCode != Success) {
+            qDebug() << "Warning: Failed to load profile for buffered AI, error code:" << errCode;
+        }
+    }
+
+    const int channels = channelCount();
+    const int frames = bufferFrames();
+
+    // Streaming acquisition (section count 0), internal clock at the AO rate
+    Conversion *conversion = m_wfAiCtrl->getConversion();
+    Record *record = m_wfAiCtrl->getRecord();
+    if (!checkError(conversion->setChannelStart(0), "Failed to set start channel")
+        || !checkError(conversion->setChannelCount(channels), "Failed to set channel count")
+        || !checkError(conversion->setClockSource(SigInternalClock), "Failed to select clock source")
+        || !checkError(conversion->setClockRate(sampleRate()), "Failed to set clock rate")
+        || !checkError(record->setSectionLength(frames), "Failed to set section length")
+        || !checkError(record->setSectionCount(0), "Failed to enable streaming")) {
+        releaseDevice();
+        return false;
+    }
+
+    for (int i = 0; i < channels; i++) {
+        if (!checkError(m_wfAiCtrl->getChannels()->getItem(i).setValueRange(V_Neg10To10),
+                        QString("Failed to set voltage range for channel %1").arg(i))) {
+            releaseDevice();
+            return false;
+        }
+    }
+
+    if (conversion->getClockRate() != sampleRate()) {
+        qDebug() << "Warning: AI clock rate" << conversion->getClockRate()
+                 << "S/s differs from requested" << sampleRate() << "S/s";
+    }
+
+    m_transferBuffer.resize(frames * channels);
+    m_wfAiCtrl->addDataReadyHandler(onDataReady, this);
+    m_wfAiCtrl->addOverrunHandler(onOverrun, this);
+
+    if (!checkError(m_wfAiCtrl->Prepare(), "Failed to prepare buffered AI")
+        || !checkError(m_wfAiCtrl->Start(), "Failed to start buffered AI")) {
+        releaseDevice();
+        return false;
+    }
+
+    qDebug() << "Buffered AI started on" << m_deviceName;
+    return true;
+}
+
+void AdvantechAiStream::stopDevice()
+{
+    if (m_wfAiCtrl) {
+        m_wfAiCtrl->Stop();
+    }
+    releaseDevice();
+}
+
+void AdvantechAiStream::releaseDevice()
+{
+    if (!m_wfAiCtrl) {
+        return;
+    }
+
+    m_wfAiCtrl->removeDataReadyHandler(onDataReady, this);
+    m_wfAiCtrl->removeOverrunHandler(onOverrun, this);
+    m_wfAiCtrl->Release();
+    m_wfAiCtrl->Dispose();
+    m_wfAiCtrl = nullptr;
+}
+
+void BDAQCALL AdvantechAiStream::onDataReady(void *sender, BfdAiEventArgs *args, void *userParam)
+{
+    Q_UNUSED(sender);
+    AdvantechAiStream *self = static_cast<AdvantechAiStream *>(userParam);
+
+    // args->Count is the amount of new data in samples (all channels)
+    const int channels = self->channelCount();
+    int samples = qMin(args->Count, static_cast<int>(self->m_transferBuffer.size()));
+    samples -= samples % channels;
+    if (samples <= 0) {
+        return;
+    }
+
+    int32 returned = 0;
+    ErrorCode errCode = self->m_wfAiCtrl->GetData(samples, self->m_transferBuffer.data(), 0, &returned);
+    if (!self->checkError(errCode, "Failed to read buffered AI")) {
+        emit self->streamError(self->getLastError());
+        return;
+    }
+
+    self->pushFrames(self->m_transferBuffer.constData(), returned / channels);
+}
+
+void BDAQCALL AdvantechAiStream::onOverrun(void *sender, BfdAiEventArgs *args, void *userParam)
+{
+    Q_UNUSED(sender);
+    Q_UNUSED(args);
+    AdvantechAiStream *self = static_cast<AdvantechAiStream *>(userParam);
+
+    // Samples were lost inside the driver, so indices after this point no
+    // longer line up with the AO clock
+    self->reportDeviceOverrun(QString("Buffered AI overrun on %1: samples were lost, feedback "
+                                      "is no longer aligned until acquisition restarts")
+                                  .arg(self->m_deviceName));
+}
@@ -0,0 +1,40 @@
+#ifndef ADVANTECHAISTREAM_H
+#define ADVANTECHAISTREAM_H
+
+#include "aistream.h"
+#include "bdaqctrl.h"
+
+using namespace Automation::BDaq;
+
+// Streaming acquisition through the SDK's WaveformAiCtrl. Channels start at
+// AI0 (X sensor), AI1 (Y sensor). The conversion clock runs at the AO rate
+// from the card's internal timebase, so the two streams do not drift; the
+// fixed offset between their start points is taken out by the aligner.
+class AdvantechAiStream : public AiStream
+{
+    Q_OBJECT
+
+public:
+    explicit AdvantechAiStream(const QString &deviceName, const QString &profilePath = QString(),
+                               QObject *parent = nullptr);
+    ~AdvantechAiStream();
+
+protected:
+    bool startDevice() override;
+    void stopDevice() override;
+
+private:
+    WaveformAiCtrl *m_wfAiCtrl;
+    QString m_deviceName;
+    QString m_profilePath;
+    QVector<double> m_transferBuffer;
+
+    bool checkError(ErrorCode errorCode, const QString &context);
+    void releaseDevice();
+
+    // SDK event callbacks, invoked from the driver's event thread
+    static void BDAQCALL onDataReady(void *sender, BfdAiEventArgs *args, void *userParam);
+    static void BDAQCALL onOverrun(void *sender, BfdAiEventArgs *args, void *userParam);
+};
+
+#endif // ADVANTECHAISTREAM_H
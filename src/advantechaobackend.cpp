@@ -0,0 +1,287 @@
+#include "advantechaobackend.h"
+#include "advantechaostream.h"
+#include "advantechaistream.h"
+#include <QDebug>
+
+AdvantechAoBackend::AdvantechAoBackend(QObject *parent)
+    : AoBackend(parent)
+    , m_aoCtrl(nullptr)
+    , m_open(false)
+{
+}
+
+AdvantechAoBackend::~AdvantechAoBackend()
+{
+    cleanup();
+}
+
+bool AdvantechAoBackend::initialize()
+{
+    if (m_aoCtrl) {
+        return true;
+    }
+
+    try {
+        // Create the AO control instance
+        m_aoCtrl = InstantAoCtrl::Create();
+        if (!m_aoCtrl) {
+            setLastError("Failed to create InstantAoCtrl instance");
+            qDebug() << "Initialization failed:" << getLastError();
+            return false;
+        }
+        return true;
+    }
+    catch (const std::exception &e) {
+        setLastError(QString("Exception during initialization: %1").arg(e.what()));
+        qDebug() << "Initialization failed with exception:" << getLastError();
+        return false;
+    }
+}
+
+void AdvantechAoBackend::cleanup()
+{
+    close();
+
+    if (m_aoCtrl) {
+        m_aoCtrl->Dispose();
+        m_aoCtrl = nullptr;
+    }
+}
+
+QStringList AdvantechAoBackend::availableDevices()
+{
+    QStringList devices;
+
+    if (!m_aoCtrl) {
+        qWarning() << "Advantech backend not initialized";
+        return devices;
+    }
+
+    Array<DeviceTreeNode> *supportedDevices = m_aoCtrl->getSupportedDevices();
+    qDebug() << "Found" << supportedDevices->getCount() << "supported devices";
+
+    for (int i = 0; i < supportedDevices->getCount(); i++) {
+        DeviceTreeNode const &node = supportedDevices->getItem(i);
+        QString description = QString::fromWCharArray(node.Description);
+
+        // Check for various Advantech card models with AO capability
+        if (description.contains("PCIE-1824", Qt::CaseInsensitive) ||
+            description.contains("PCIE-1816", Qt::CaseInsensitive) ||
+            description.contains("PCIE-1810", Qt::CaseInsensitive) ||
+            description.contains("PCIE-1802", Qt::CaseInsensitive) ||
+            description.contains("USB-4702", Qt::CaseInsensitive) ||
+            description.contains("USB-4704", Qt::CaseInsensitive) ||
+            description.contains("USB-4750", Qt::CaseInsensitive) ||
+            // Add any other model numbers that support AO
+            // Or use a more generic check if possible:
+            description.contains("AO", Qt::CaseInsensitive)) {
+
+            devices.append(description);
+            qDebug() << "Found compatible device:" << description;
+        }
+    }
+
+    if (devices.isEmpty()) {
+        qDebug() << "No compatible Advantech analog output devices found";
+    }
+
+    return devices;
+}
+
+bool AdvantechAoBackend::open(const QString &deviceName, const QString &profilePath)
+{
+    close();
+
+    if (!m_aoCtrl) {
+        setLastError("Advantech backend not initialized");
+        return false;
+    }
+
+    m_profilePath = profilePath;
+    if (!configureDevice(deviceName)) {
+        return false;
+    }
+
+    // Hear about the card disappearing instead of polling it on every write
+    m_aoCtrl->getDevice()->addRemovedHandler(onDeviceRemoved, this);
+    m_deviceName = deviceName;
+    m_open = true;
+    return true;
+}
+
+bool AdvantechAoBackend::configureDevice(const QString &deviceName)
+{
+    try {
+        // Simple approach similar to Advantech examples
+        std::wstring wDeviceName = deviceName.toStdWString();
+        DeviceInformation devInfo(wDeviceName.c_str());
+
+        // Select the device
+        ErrorCode errCode = m_aoCtrl->setSelectedDevice(devInfo);
+        qDebug() << "setSelectedDevice returned code:" << errCode;
+
+        if (errCode != Success) {
+            setLastError(QString("Failed to select device, error code: 0x%1").arg(
+                QString::number(errCode, 16).right(8).toUpper()));
+            qDebug() << getLastError();
+            return false;
+        }
+
+        qDebug() << "Device selected successfully";
+
+        // If a profile path was provided, try to load it
+        if (!m_profilePath.isEmpty()) {
+            qDebug() << "Applying device profile from:" << m_profilePath;
+            std::wstring wProfilePath = m_profilePath.toStdWString();
+            errCode = m_aoCtrl->LoadProfile(wProfilePath.c_str());
+
+            if (errCode != Success) {
+                qDebug() << "Warning: Failed to load profile, error code:" << errCode;
+                // Continue - non-fatal error
+            } else {
+                qDebug() << "Profile loaded successfully";
+            }
+        }
+
+        // Check if we have at least 2 channels for X and Y control
+        int channelCount = m_aoCtrl->getChannelCount();
+        qDebug() << "Device reports" << channelCount << "channels";
+
+        if (channelCount < 2) {
+            setLastError("Device doesn't have enough channels (need at least 2)");
+            qDebug() << getLastError();
+            return false;
+        }
+
+        // Try to get device info to verify connection
+        DeviceInformation currentDevice;
+        m_aoCtrl->getSelectedDevice(currentDevice);
+        qDebug() << "Connected to device:" << QString::fromWCharArray(currentDevice.Description);
+
+        // Set the voltage range for both channels
+        for (int i = 0; i < 2; i++) {
+            errCode = m_aoCtrl->getChannels()->getItem(i).setValueRange(V_Neg10To10);
+            if (errCode != Success) {
+                setLastError(QString("Failed to set voltage range for channel %1").arg(i));
+                qDebug() << getLastError();
+                return false;
+            }
+        }
+
+        qDebug() << "Voltage ranges set successfully";
+
+        // Initialize to zero position
+        double zeroValues[2] = {0.0, 0.0};
+        errCode = m_aoCtrl->Write(0, 2, zeroValues);
+        if (errCode != Success) {
+            setLastError(QString("Failed to write initial values"));
+            qDebug() << getLastError();
+            return false;
+        }
+
+        qDebug() << "Wrote initial values successfully";
+        return true;
+    }
+    catch (const std::exception &e) {
+        setLastError(QString("Exception when opening device: %1").arg(e.what()));
+        qDebug() << getLastError();
+        return false;
+    }
+}
+
+void AdvantechAoBackend::close()
+{
+    if (!m_open) {
+        return;
+    }
+
+    qDebug() << "Closing device, setting outputs to zero";
+    // Set outputs to zero before closing
+    double zeroValues[2] = {0.0, 0.0};
+    m_aoCtrl->Write(0, 2, zeroValues);
+
+    m_aoCtrl->getDevice()->removeRemovedHandler(onDeviceRemoved, this);
+    m_deviceName.clear();
+    m_open = false;
+}
+
+bool AdvantechAoBackend::loadProfile(const QString &profilePath)
+{
+    if (!m_aoCtrl) {
+        setLastError("Mirror controller not initialized");
+        qDebug() << "Cannot load profile:" << getLastError();
+        return false;
+    }
+
+    qDebug() << "Loading profile:" << profilePath;
+
+    try {
+        std::wstring wProfilePath = profilePath.toStdWString();
+        ErrorCode errCode = m_aoCtrl->LoadProfile(wProfilePath.c_str());
+
+        if (errCode != Success) {
+            setLastError(QString("Failed to load profile, error code: 0x%1").arg(
+                QString::number(errCode, 16).right(8).toUpper()));
+            qDebug() << getLastError();
+            return false;
+        }
+
+        qDebug() << "Profile loaded successfully";
+        m_profilePath = profilePath;
+        return true;
+    }
+    catch (const std::exception &e) {
+        setLastError(QString("Exception when loading profile: %1").arg(e.what()));
+        qDebug() << getLastError();
+        return false;
+    }
+}
+
+bool AdvantechAoBackend::write(const double voltages[2])
+{
+    ErrorCode errCode = m_aoCtrl->Write(0, 2, const_cast<double *>(voltages));
+    return checkError(errCode);
+}
+
+AoStream *AdvantechAoBackend::createStream(QObject *parent)
+{
+    if (!m_open) {
+        setLastError("Device not open");
+        return nullptr;
+    }
+
+    // The buffered control opens its own handle on the same card
+    return new AdvantechAoStream(m_deviceName, m_profilePath, parent);
+}
+
+AiStream *AdvantechAoBackend::createAiStream(QObject *parent)
+{
+    if (!m_open) {
+        setLastError("Device not open");
+        return nullptr;
+    }
+
+    // Sensor outputs wired to AI0 (X) and AI1 (Y) of the same card
+    return new AdvantechAiStream(m_deviceName, m_profilePath, parent);
+}
+
+bool AdvantechAoBackend::checkError(ErrorCode errorCode)
+{
+    // Warning codes still leave the outputs updated
+    if (errorCode >= 0xE0000000 && errorCode != Success) {
+        setLastError(QString("Error Code: 0x%1").arg(
+            QString::number(errorCode, 16).right(8).toUpper()));
+        qDebug() << "Device error:" << getLastError();
+        return false;
+    }
+    return true;
+}
+
+void BDAQCALL AdvantechAoBackend::onDeviceRemoved(void *sender, DeviceEventArgs *args, void *userParam)
+{
+    Q_UNUSED(sender);
+    Q_UNUSED(args);
+
+    AdvantechAoBackend *backend = static_cast<AdvantechAoBackend *>(userParam);
+    emit backend->deviceRemoved();
+}
@@ -0,0 +1,47 @@
+#ifndef ADVANTECHAOBACKEND_H
+#define ADVANTECHAOBACKEND_H
+
+#include "aobackend.h"
+#include "bdaqctrl.h"
+
+using namespace Automation::BDaq;
+
+// Advantech DAQNavi card through InstantAoCtrl, with BufferedAoCtrl streams
+class AdvantechAoBackend : public AoBackend
+{
+    Q_OBJECT
+
+public:
+    explicit AdvantechAoBackend(QObject *parent = nullptr);
+    ~AdvantechAoBackend();
+
+    Type type() const override { return Advantech; }
+
+    bool initialize() override;
+    void cleanup() override;
+
+    QStringList availableDevices() override;
+
+    bool open(const QString &deviceName, const QString &profilePath) override;
+    void close() override;
+
+    bool loadProfile(const QString &profilePath) override;
+
+    bool write(const double voltages[2]) override;
+
+    AoStream *createStream(QObject *parent) override;
+    AiStream *createAiStream(QObject *parent) override;
+
+private:
+    InstantAoCtrl *m_aoCtrl;
+    QString m_deviceName;
+    QString m_profilePath;
+    bool m_open;
+
+    bool configureDevice(const QString &deviceName);
+    bool checkError(ErrorCode errorCode);
+
+    static void BDAQCALL onDeviceRemoved(void *sender, DeviceEventArgs *args, void *userParam);
+};
+
+#endif // ADVANTECHAOBACKEND_H
@@ -0,0 +1,151 @@
+#include "advantechaostream.h"
+#include <QDebug>
+
+AdvantechAoStream::AdvantechAoStream(const QString &deviceName, const QString &profilePath,
+                                     QObject *parent)
+    : AoStream(parent)
+    , m_bfdAoCtrl(nullptr)
+    , m_deviceName(deviceName)
+    , m_profilePath(profilePath)
+{
+}
+
+AdvantechAoStream::~AdvantechAoStream()
+{
+    stop();
+    releaseDevice();
+}
+
+bool AdvantechAoStream::checkError(ErrorCode errorCode, const QString &context)
+{
+    if (errorCode == Success || errorCode < 0xE0000000) {
+        return true;
+    }
+
+    setLastError(QString("%1, error code: 0x%2").arg(context,
+        QString::number(errorCode, 16).right(8).toUpper()));
+    qDebug() << "Buffered AO:" << getLastError();
+    return false;
+}
+
+bool AdvantechAoStream::startDevice()
+{
+    releaseDevice();
+
+    m_bfdAoCtrl = BufferedAoCtrl::Create();
+    if (!m_bfdAoCtrl) {
+        setLastError("Failed to create BufferedAoCtrl instance");
+        return false;
+    }
+
+    std::wstring wDeviceName = m_deviceName.toStdWString();
+    DeviceInformation devInfo(wDeviceName.c_str());
+    if (!checkError(m_bfdAoCtrl->setSelectedDevice(devInfo), "Failed to select device")) {
+        releaseDevice();
+        return false;
+    }
+
+    if (!m_profilePath.isEmpty()) {
+        std::wstring wProfilePath = m_profilePath.toStdWString();
+        ErrorCode errCode = m_bfdAoCtrl->LoadProfile(wProfilePath.c_str());
+        if (errCode != Success) {
+            qDebug() << "Warning: Failed to load profile for buffered AO, error code:" << errCode;
+        }
+    }
+
+    const int channels = channelCount();
+    const int frames = bufferFrames();
+
+    // Streaming mode, internal clock at the requested rate
+    ScanChannel *scanChannel = m_bfdAoCtrl->getScanChannel();
+    ConvertClock *convertClock = m_bfdAoCtrl->getConvertClock();
+    if (!checkError(m_bfdAoCtrl->setStreaming(true), "Failed to enable streaming")
+        || !checkError(scanChannel->setChannelStart(0), "Failed to set start channel")
+        || !checkError(scanChannel->setChannelCount(channels), "Failed to set channel count")
+        || !checkError(scanChannel->setSamples(frames), "Failed to set buffer size")
+        || !checkError(convertClock->setSource(SigInternalClock), "Failed to select clock source")
+        || !checkError(convertClock->setRate(sampleRate()), "Failed to set clock rate")) {
+        releaseDevice();
+        return false;
+    }
+
+    for (int i = 0; i < channels; i++) {
+        if (!checkError(m_bfdAoCtrl->getChannels()->getItem(i).setValueRange(V_Neg10To10),
+                        QString("Failed to set voltage range for channel %1").arg(i))) {
+            releaseDevice();
+            return false;
+        }
+    }
+
+    qDebug() << "Buffered AO clock rate:" << convertClock->getRate() << "S/s";
+
+    m_bfdAoCtrl->addDataTransmittedHandler(onDataTransmitted, this);
+    m_bfdAoCtrl->addUnderrunHandler(onUnderrun, this);
+
+    if (!checkError(m_bfdAoCtrl->Prepare(), "Failed to prepare buffered AO")) {
+        releaseDevice();
+        return false;
+    }
+
+    // Prime the whole device buffer before the clock starts
+    m_transferBuffer.resize(frames * channels);
+    fillFromQueue(m_transferBuffer.data(), frames);
+    if (!checkError(m_bfdAoCtrl->SetData(frames * channels, m_transferBuffer.data()),
+                    "Failed to prime buffered AO")
+        || !checkError(m_bfdAoCtrl->Start(), "Failed to start buffered AO")) {
+        releaseDevice();
+        return false;
+    }
+
+    qDebug() << "Buffered AO started on" << m_deviceName;
+    return true;
+}
+
+void AdvantechAoStream::stopDevice()
+{
+    if (m_bfdAoCtrl) {
+        // Action 0: stop immediately instead of draining the buffer
+        m_bfdAoCtrl->Stop(0);
+    }
+    releaseDevice();
+}
+
+void AdvantechAoStream::releaseDevice()
+{
+    if (!m_bfdAoCtrl) {
+        return;
+    }
+
+    m_bfdAoCtrl->removeDataTransmittedHandler(onDataTransmitted, this);
+    m_bfdAoCtrl->removeUnderrunHandler(onUnderrun, this);
+    m_bfdAoCtrl->Release();
+    m_bfdAoCtrl->Dispose();
+    m_bfdAoCtrl = nullptr;
+}
+
+void BDAQCALL AdvantechAoStream::onDataTransmitted(void *sender, BfdAoEventArgs *args, void *userParam)
+{
+    Q_UNUSED(sender);
+    AdvantechAoStream *self = static_cast<AdvantechAoStream *>(userParam);
+
+    // args->Count is the size of the blank area in samples (all channels)
+    const int channels = self->channelCount();
+    int frames = qMin(args->Count / channels, self->bufferFrames());
+    if (frames <= 0) {
+        return;
+    }
+
+    self->fillFromQueue(self->m_transferBuffer.data(), frames);
+    ErrorCode errCode = self->m_bfdAoCtrl->SetData(frames * channels, self->m_transferBuffer.data());
+    if (!self->checkError(errCode, "Failed to refill buffered AO")) {
+        emit self->streamError(self->getLastError());
+    }
+}
+
+void BDAQCALL AdvantechAoStream::onUnderrun(void *sender, BfdAoEventArgs *args, void *userParam)
+{
+    Q_UNUSED(sender);
+    Q_UNUSED(args);
+    AdvantechAoStream *self = static_cast<AdvantechAoStream *>(userParam);
+    qDebug() << "Buffered AO device underrun on" << self->m_deviceName;
+}
@@ -0,0 +1,40 @@
+#ifndef ADVANTECHAOSTREAM_H
+#define ADVANTECHAOSTREAM_H
+
+#include "aostream.h"
+#include "bdaqctrl.h"
+
+using namespace Automation::BDaq;
+
+// Streaming output through the SDK's BufferedAoCtrl. The card's ConvertClock
+// paces the samples; each DataTransmitted event refills the blank half of the
+// device buffer from the host FIFO, or from the pattern in cyclic mode. The
+// SDK's own cyclic mode is not used, so the host does this copy in both.
+class AdvantechAoStream : public AoStream
+{
+    Q_OBJECT
+
+public:
+    explicit AdvantechAoStream(const QString &deviceName, const QString &profilePath = QString(),
+                               QObject *parent = nullptr);
+    ~AdvantechAoStream();
+
+protected:
+    bool startDevice() override;
+    void stopDevice() override;
+
+private:
+    BufferedAoCtrl *m_bfdAoCtrl;
+    QString m_deviceName;
+    QString m_profilePath;
+    QVector<double> m_transferBuffer;
+
+    bool checkError(ErrorCode errorCode, const QString &context);
+    void releaseDevice();
+
+    // SDK event callbacks, invoked from the driver's event thread
+    static void BDAQCALL onDataTransmitted(void *sender, BfdAoEventArgs *args, void *userParam);
+    static void BDAQCALL onUnderrun(void *sender, BfdAoEventArgs *args, void *userParam);
+};
+
+#endif // ADVANTECHAOSTREAM_H
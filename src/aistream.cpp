@@ -0,0 +1,176 @@
+#include "aistream.h"
+#include <QDebug>
+#include <cstring>
+
+AiStream::AiStream(QObject *parent)
+    : QObject(parent)
+    , m_ringFrames(0)
+    , m_writeIndex(0)
+    , m_readIndex(0)
+    , m_sampleRate(0.0)
+    , m_channelCount(0)
+    , m_bufferFrames(0)
+    , m_running(false)
+    , m_overruns(0)
+    , m_deviceOverruns(0)
+    , m_alignmentLostAt(-1)
+{
+}
+
+AiStream::~AiStream()
+{
+    // Derived classes stop their device in their own destructor
+}
+
+bool AiStream::start(double sampleRate, int channelCount, int bufferFrames)
+{
+    stop();
+
+    if (sampleRate <= 0.0 || channelCount <= 0 || bufferFrames <= 0) {
+        setLastError("Invalid acquisition configuration");
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_sampleRate = sampleRate;
+        m_channelCount = channelCount;
+        m_bufferFrames = bufferFrames;
+        m_ringFrames = bufferFrames * 8;
+        m_ring.resize(m_ringFrames * channelCount);
+        m_writeIndex = 0;
+        m_readIndex = 0;
+        m_overruns = 0;
+        m_deviceOverruns = 0;
+        m_alignmentLostAt = -1;
+        m_running = true;
+    }
+
+    if (!startDevice()) {
+        QMutexLocker locker(&m_mutex);
+        m_running = false;
+        return false;
+    }
+
+    qDebug() << "AI stream started:" << sampleRate << "S/s," << channelCount
+             << "channels," << bufferFrames << "frame device buffer";
+    return true;
+}
+
+void AiStream::stop()
+{
+    bool wasRunning = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        wasRunning = m_running;
+        m_running = false;
+    }
+
+    // Stop outside the lock, the backend's clock context may be waiting on it
+    if (wasRunning) {
+        stopDevice();
+    }
+}
+
+bool AiStream::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running;
+}
+
+int AiStream::read(double *frames, int maxFrames, quint64 *firstFrame)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int count = static_cast<int>(qMin<quint64>(m_writeIndex - m_readIndex, maxFrames));
+    *firstFrame = m_readIndex;
+
+    for (int i = 0; i < count; ++i) {
+        int slot = static_cast<int>((m_readIndex + i) % m_ringFrames);
+        std::memcpy(frames + i * m_channelCount, m_ring.constData() + slot * m_channelCount,
+                    sizeof(double) * m_channelCount);
+    }
+
+    m_readIndex += count;
+    return count;
+}
+
+int AiStream::availableFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_writeIndex - m_readIndex);
+}
+
+quint64 AiStream::framesAcquired() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writeIndex;
+}
+
+quint64 AiStream::overrunCount() const
+{
+    return m_overruns.load(std::memory_order_relaxed);
+}
+
+quint64 AiStream::deviceOverrunCount() const
+{
+    return m_deviceOverruns.load(std::memory_order_relaxed);
+}
+
+qint64 AiStream::alignmentLostAt() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_alignmentLostAt;
+}
+
+void AiStream::reportDeviceOverrun(const QString &message)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_running) {
+            return;
+        }
+        // Frames already pushed were counted before the loss
+        if (m_alignmentLostAt < 0) {
+            m_alignmentLostAt = static_cast<qint64>(m_writeIndex);
+        }
+    }
+
+    m_deviceOverruns.fetch_add(1, std::memory_order_relaxed);
+    setLastError(message);
+    emit streamError(message);
+}
+
+void AiStream::pushFrames(const double *frames, int frameCount)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_running) {
+        return;
+    }
+
+    for (int i = 0; i < frameCount; ++i) {
+        int slot = static_cast<int>(m_writeIndex % m_ringFrames);
+        std::memcpy(m_ring.data() + slot * m_channelCount, frames + i * m_channelCount,
+                    sizeof(double) * m_channelCount);
+        ++m_writeIndex;
+    }
+
+    // Reader fell behind: the overwritten frames are gone
+    if (m_writeIndex - m_readIndex > static_cast<quint64>(m_ringFrames)) {
+        m_readIndex = m_writeIndex - m_ringFrames;
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+QString AiStream::getLastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+void AiStream::setLastError(const QString &error)
+{
+    // Also set from the driver's callback thread
+    QMutexLocker locker(&m_mutex);
+    m_lastError = error;
+}
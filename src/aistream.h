@@ -0,0 +1,92 @@
+#ifndef AISTREAM_H
+#define AISTREAM_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+
+// Hardware-clocked analog input stream, used to acquire the mirror's
+// position-sensor outputs alongside a buffered AO stream.
+//
+// The backend pushes interleaved frames (one value per channel) from its
+// clock context into a host-side ring. Every frame carries its index on the
+// acquisition clock, counted from the first frame after start(), so a
+// consumer can pair it with the AO frame clocked out at the same tick.
+class AiStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AiStream(QObject *parent = nullptr);
+    virtual ~AiStream();
+
+    // Start acquiring. bufferFrames is the size of the device-side buffer;
+    // the host ring holds eight times that much backlog.
+    bool start(double sampleRate, int channelCount = 2, int bufferFrames = 4096);
+    void stop();
+    bool isRunning() const;
+
+    // Take up to maxFrames acquired frames. firstFrame receives the index of
+    // the first one. Returns the number of frames copied.
+    int read(double *frames, int maxFrames, quint64 *firstFrame);
+    int availableFrames() const;
+
+    double sampleRate() const { return m_sampleRate; }
+    int channelCount() const { return m_channelCount; }
+    int bufferFrames() const { return m_bufferFrames; }
+
+    // Statistics. overrunCount() counts frames dropped because the reader
+    // fell behind, with indices intact; deviceOverrunCount() counts samples
+    // lost inside the driver, after which the indices no longer line up.
+    quint64 framesAcquired() const;
+    quint64 overrunCount() const;
+    quint64 deviceOverrunCount() const;
+
+    // First frame acquired after the device lost samples, -1 while none
+    // were lost since start(). Frames from here on cannot be paired with
+    // the AO frame clocked out at the same tick.
+    qint64 alignmentLostAt() const;
+
+    QString getLastError() const;
+
+signals:
+    void streamError(const QString &errorMessage);
+
+protected:
+    // Backend hooks
+    virtual bool startDevice() = 0;
+    virtual void stopDevice() = 0;
+
+    // Called by the backend from its clock context. When the reader has
+    // fallen a full ring behind, the oldest frames are dropped and counted
+    // as an overrun; the frame indices stay correct.
+    void pushFrames(const double *frames, int frameCount);
+
+    // Called by the backend from its driver context when samples were lost
+    // before they reached pushFrames(). Emits streamError.
+    void reportDeviceOverrun(const QString &message);
+
+    void setLastError(const QString &error);
+
+private:
+    mutable QMutex m_mutex;
+    QVector<double> m_ring;
+    int m_ringFrames;
+    quint64 m_writeIndex;     // Index of the next frame to be acquired
+    quint64 m_readIndex;      // Index of the next frame to be read
+
+    double m_sampleRate;
+    int m_channelCount;
+    int m_bufferFrames;
+    bool m_running;
+
+    std::atomic<quint64> m_overruns;
+    std::atomic<quint64> m_deviceOverruns;
+    qint64 m_alignmentLostAt;
+
+    QString m_lastError;
+};
+
+#endif // AISTREAM_H
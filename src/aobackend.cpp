@@ -0,0 +1,83 @@
+#include "aobackend.h"
+#include "advantechaobackend.h"
+#include "simulatedaobackend.h"
+#include "nullaobackend.h"
+
+AoBackend::AoBackend(QObject *parent)
+    : QObject(parent)
+{
+}
+
+AoBackend::~AoBackend()
+{
+}
+
+AoBackend *AoBackend::create(Type type, QObject *parent)
+{
+    switch (type) {
+    case Simulated:
+        return new SimulatedAoBackend(parent);
+    case Null:
+        return new NullAoBackend(parent);
+    case Advantech:
+    default:
+        return new AdvantechAoBackend(parent);
+    }
+}
+
+QString AoBackend::typeName(Type type)
+{
+    switch (type) {
+    case Simulated: return "simulated";
+    case Null: return "null";
+    case Advantech:
+    default: return "advantech";
+    }
+}
+
+bool AoBackend::typeFromName(const QString &name, Type *type)
+{
+    const Type types[] = { Advantech, Simulated, Null };
+    for (Type candidate : types) {
+        if (name.compare(typeName(candidate), Qt::CaseInsensitive) == 0) {
+            *type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString AoBackend::displayName(Type type)
+{
+    switch (type) {
+    case Simulated: return "Simulated mirror";
+    case Null: return "Null output (benchmark)";
+    case Advantech:
+    default: return "Advantech D/A card";
+    }
+}
+
+AiStream *AoBackend::createAiStream(QObject *parent)
+{
+    Q_UNUSED(parent);
+    setLastError("Feedback acquisition is not supported by " + displayName(type()));
+    return nullptr;
+}
+
+bool AoBackend::loadProfile(const QString &profilePath)
+{
+    Q_UNUSED(profilePath);
+    return true;
+}
+
+QString AoBackend::getLastError() const
+{
+    QMutexLocker locker(&m_errorMutex);
+    return m_lastError;
+}
+
+void AoBackend::setLastError(const QString &error)
+{
+    QMutexLocker locker(&m_errorMutex);
+    m_lastError = error;
+}
@@ -0,0 +1,76 @@
+#ifndef AOBACKEND_H
+#define AOBACKEND_H
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+class AoStream;
+class AiStream;
+
+// Analog output device behind FastSteeringMirror. Implementations own the
+// device handle; the mirror keeps the position/voltage logic and the device
+// state machine.
+class AoBackend : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Type {
+        Advantech,
+        Simulated,
+        Null
+    };
+
+    explicit AoBackend(QObject *parent = nullptr);
+    virtual ~AoBackend();
+
+    static AoBackend *create(Type type, QObject *parent = nullptr);
+
+    // Names used on the command line ("advantech", "simulated", "null")
+    static QString typeName(Type type);
+    static bool typeFromName(const QString &name, Type *type);
+    static QString displayName(Type type);
+
+    virtual Type type() const = 0;
+
+    virtual bool initialize() = 0;
+    virtual void cleanup() = 0;
+
+    virtual QStringList availableDevices() = 0;
+
+    // Open the device with both channels configured and driven to 0 V
+    virtual bool open(const QString &deviceName, const QString &profilePath) = 0;
+    virtual void close() = 0;
+
+    virtual bool loadProfile(const QString &profilePath);
+
+    // Hot path: update both channels at once. Returns false on an
+    // error-level failure, after which the device should be reopened.
+    virtual bool write(const double voltages[2]) = 0;
+
+    // Buffered output stream for the open device, owned by parent
+    virtual AoStream *createStream(QObject *parent) = 0;
+
+    // Buffered acquisition of the mirror's position sensors, clocked at the
+    // same rate as the output stream. Create it before the output stream.
+    // Returns nullptr when the backend has no feedback inputs.
+    virtual AiStream *createAiStream(QObject *parent);
+
+    QString getLastError() const;
+
+signals:
+    // The device disappeared. May be emitted from a driver thread.
+    void deviceRemoved();
+
+protected:
+    // write() fails on the output thread while the GUI reads the error
+    void setLastError(const QString &error);
+
+private:
+    mutable QMutex m_errorMutex;
+    QString m_lastError;
+};
+
+#endif // AOBACKEND_H
@@ -0,0 +1,345 @@
+#include "aostream.h"
+#include <QDebug>
+#include <cstring>
+
+AoStream::AoStream(QObject *parent)
+    : QObject(parent)
+    , m_fifoFrames(0)
+    , m_readFrame(0)
+    , m_queued(0)
+    , m_cyclic(false)
+    , m_patternPending(false)
+    , m_pendingFadeFrames(0)
+    , m_patternFrame(0)
+    , m_fadeFrame(0)
+    , m_fadeFrames(0)
+    , m_fadeRemaining(0)
+    , m_patternSwaps(0)
+    , m_sampleRate(0.0)
+    , m_channelCount(0)
+    , m_bufferFrames(0)
+    , m_armed(false)
+    , m_deviceStarted(false)
+    , m_framesTransmitted(0)
+    , m_underruns(0)
+{
+}
+
+AoStream::~AoStream()
+{
+    // Derived classes stop their device in their own destructor; by the time
+    // we get here only the FIFO is left.
+}
+
+bool AoStream::start(double sampleRate, int channelCount, int bufferFrames)
+{
+    stop();
+
+    if (sampleRate <= 0.0 || channelCount <= 0 || bufferFrames <= 0) {
+        setLastError("Invalid stream configuration");
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_sampleRate = sampleRate;
+    m_channelCount = channelCount;
+    m_bufferFrames = bufferFrames;
+    m_fifoFrames = bufferFrames * 4;
+    m_fifo.resize(m_fifoFrames * channelCount);
+    m_lastFrame.fill(0.0, channelCount);
+    m_readFrame = 0;
+    m_queued = 0;
+    m_framesTransmitted = 0;
+    m_underruns = 0;
+    m_deviceStarted = false;
+    m_cyclic = false;
+    m_armed = true;
+
+    qDebug() << "AO stream armed:" << sampleRate << "S/s," << channelCount
+             << "channels," << bufferFrames << "frame device buffer";
+    return true;
+}
+
+bool AoStream::startCyclic(double sampleRate, int channelCount, const double *pattern,
+                           int patternFrames, int bufferFrames)
+{
+    if (patternFrames <= 0) {
+        setLastError("Empty cyclic pattern");
+        return false;
+    }
+
+    if (!start(sampleRate, channelCount, bufferFrames)) {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cyclic = true;
+        m_pattern.resize(patternFrames * channelCount);
+        std::memcpy(m_pattern.data(), pattern, sizeof(double) * patternFrames * channelCount);
+        m_pendingPattern.clear();
+        m_fadePattern.clear();
+        m_patternPending = false;
+        m_pendingFadeFrames = 0;
+        m_patternFrame = 0;
+        m_fadeFrame = 0;
+        m_fadeFrames = 0;
+        m_fadeRemaining = 0;
+        m_patternSwaps = 0;
+        m_deviceStarted = true;
+    }
+
+    qDebug() << "Cyclic pattern of" << patternFrames << "frames uploaded";
+
+    // The pattern primes the device buffer, no need to wait for the FIFO
+    if (!launchDevice()) {
+        QMutexLocker locker(&m_mutex);
+        m_deviceStarted = false;
+        m_armed = false;
+        m_cyclic = false;
+        return false;
+    }
+    return true;
+}
+
+bool AoStream::setCyclicPattern(const double *pattern, int patternFrames, int fadeFrames,
+                                quint64 *swapIndex)
+{
+    if (patternFrames <= 0 || fadeFrames < 0) {
+        return false;
+    }
+
+    // Build the copy outside the lock so the clock context never waits on it
+    QVector<double> staged(patternFrames * m_channelCount);
+    std::memcpy(staged.data(), pattern, sizeof(double) * staged.size());
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_cyclic) {
+        return false;
+    }
+    m_pendingPattern.swap(staged);
+    m_patternPending = true;
+    m_pendingFadeFrames = fadeFrames;
+    if (swapIndex) {
+        *swapIndex = m_patternSwaps + 1;
+    }
+    return true;
+}
+
+bool AoStream::isCyclic() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cyclic;
+}
+
+quint64 AoStream::patternSwapCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_patternSwaps;
+}
+
+bool AoStream::isPatternSettled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_patternPending && m_fadeRemaining == 0;
+}
+
+void AoStream::stop()
+{
+    bool wasStarted = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        wasStarted = m_deviceStarted;
+        m_armed = false;
+        m_deviceStarted = false;
+        m_cyclic = false;
+    }
+
+    // Stop outside the lock, the backend's clock context may be waiting on it
+    if (wasStarted) {
+        stopDevice();
+        qDebug() << "AO stream stopped after" << m_framesTransmitted.load()
+                 << "frames," << m_underruns.load() << "underruns";
+    }
+}
+
+void AoStream::setStartHook(std::function<void()> hook)
+{
+    m_startHook = std::move(hook);
+}
+
+bool AoStream::launchDevice()
+{
+    if (m_startHook) {
+        m_startHook();
+    }
+    return startDevice();
+}
+
+bool AoStream::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deviceStarted;
+}
+
+int AoStream::write(const double *frames, int frameCount)
+{
+    bool startNow = false;
+    int accepted = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_armed || m_cyclic) {
+            return 0;
+        }
+
+        accepted = qMin(frameCount, m_fifoFrames - m_queued);
+        int writeFrame = (m_readFrame + m_queued) % m_fifoFrames;
+        for (int done = 0; done < accepted; ) {
+            int chunk = qMin(accepted - done, m_fifoFrames - writeFrame);
+            std::memcpy(m_fifo.data() + writeFrame * m_channelCount,
+                        frames + done * m_channelCount,
+                        sizeof(double) * chunk * m_channelCount);
+            done += chunk;
+            writeFrame = (writeFrame + chunk) % m_fifoFrames;
+        }
+        m_queued += accepted;
+
+        // Start the device once its buffer can be fully primed
+        if (!m_deviceStarted && m_queued >= m_bufferFrames) {
+            m_deviceStarted = true;
+            startNow = true;
+        }
+    }
+
+    if (startNow && !launchDevice()) {
+        QMutexLocker locker(&m_mutex);
+        m_deviceStarted = false;
+        m_armed = false;
+        locker.unlock();
+        emit streamError(getLastError());
+    }
+
+    return accepted;
+}
+
+int AoStream::freeFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return (m_armed && !m_cyclic) ? m_fifoFrames - m_queued : 0;
+}
+
+int AoStream::queuedFrames() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queued;
+}
+
+quint64 AoStream::framesTransmitted() const
+{
+    return m_framesTransmitted.load(std::memory_order_relaxed);
+}
+
+quint64 AoStream::underrunCount() const
+{
+    return m_underruns.load(std::memory_order_relaxed);
+}
+
+QString AoStream::getLastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+void AoStream::fillFromQueue(double *dest, int frameCount)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_cyclic) {
+        fillFromPattern(dest, frameCount);
+        m_framesTransmitted.fetch_add(frameCount, std::memory_order_relaxed);
+        return;
+    }
+
+    int available = qMin(frameCount, m_queued);
+    for (int done = 0; done < available; ) {
+        int chunk = qMin(available - done, m_fifoFrames - m_readFrame);
+        std::memcpy(dest + done * m_channelCount,
+                    m_fifo.constData() + m_readFrame * m_channelCount,
+                    sizeof(double) * chunk * m_channelCount);
+        done += chunk;
+        m_readFrame = (m_readFrame + chunk) % m_fifoFrames;
+    }
+    m_queued -= available;
+
+    if (available > 0) {
+        std::memcpy(m_lastFrame.data(), dest + (available - 1) * m_channelCount,
+                    sizeof(double) * m_channelCount);
+    }
+
+    // Hold the last value rather than jumping to zero on underrun
+    if (available < frameCount) {
+        for (int i = available; i < frameCount; ++i) {
+            std::memcpy(dest + i * m_channelCount, m_lastFrame.constData(),
+                        sizeof(double) * m_channelCount);
+        }
+        m_underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    m_framesTransmitted.fetch_add(frameCount, std::memory_order_relaxed);
+}
+
+void AoStream::fillFromPattern(double *dest, int frameCount)
+{
+    // Called with m_mutex held
+    const int channels = m_channelCount;
+    for (int done = 0; done < frameCount; ) {
+        if (m_patternFrame == 0 && m_patternPending && m_fadeRemaining == 0) {
+            // Buffers only change places, so the clock context never frees
+            // memory: the old pattern plays on as the fade source, and the
+            // one before it is left in m_pendingPattern
+            m_fadePattern.swap(m_pattern);
+            m_pattern.swap(m_pendingPattern);
+            m_patternPending = false;
+            m_fadeFrame = 0;
+            m_fadeFrames = m_pendingFadeFrames;
+            m_fadeRemaining = m_fadeFrames;
+            ++m_patternSwaps;
+        }
+
+        int patternFrames = m_pattern.size() / channels;
+        int chunk = qMin(frameCount - done, patternFrames - m_patternFrame);
+        const double *to = m_pattern.constData() + m_patternFrame * channels;
+        double *out = dest + done * channels;
+
+        if (m_fadeRemaining > 0) {
+            int fadePatternFrames = m_fadePattern.size() / channels;
+            chunk = qMin(chunk, qMin(m_fadeRemaining, fadePatternFrames - m_fadeFrame));
+            const double *from = m_fadePattern.constData() + m_fadeFrame * channels;
+            const double step = 1.0 / m_fadeFrames;
+            const int faded = m_fadeFrames - m_fadeRemaining;
+            for (int i = 0; i < chunk; ++i) {
+                const double weight = (faded + i) * step;
+                for (int ch = 0; ch < channels; ++ch) {
+                    const int k = i * channels + ch;
+                    out[k] = from[k] + weight * (to[k] - from[k]);
+                }
+            }
+            m_fadeFrame = (m_fadeFrame + chunk) % fadePatternFrames;
+            m_fadeRemaining -= chunk;
+        } else {
+            std::memcpy(out, to, sizeof(double) * chunk * channels);
+        }
+
+        done += chunk;
+        m_patternFrame = (m_patternFrame + chunk) % patternFrames;
+    }
+
+    std::memcpy(m_lastFrame.data(), dest + (frameCount - 1) * channels,
+                sizeof(double) * channels);
+}
+
+void AoStream::setLastError(const QString &error)
+{
+    QMutexLocker locker(&m_mutex);
+    m_lastError = error;
+}
@@ -0,0 +1,129 @@
+#ifndef AOSTREAM_H
+#define AOSTREAM_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+
+// Hardware-clocked analog output stream.
+//
+// Frames are interleaved (one value per channel) and queued into a host-side
+// FIFO. The backend pulls frames from the FIFO at its own clock rate, so the
+// output timing no longer depends on when the producer happens to run. The
+// device is started once the FIFO holds enough frames to prime its buffer.
+class AoStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AoStream(QObject *parent = nullptr);
+    virtual ~AoStream();
+
+    // Arm the stream. bufferFrames is the size of the device-side buffer; the
+    // host FIFO holds four times that much backlog.
+    bool start(double sampleRate, int channelCount = 2, int bufferFrames = 4096);
+
+    // Start cyclic playback of a pattern of interleaved frames. The pattern
+    // is copied once and the caller queues nothing more, but the looping is
+    // done on the host: every refill from the backend's clock context copies
+    // frames out of the pattern under m_mutex (blending them during a fade),
+    // so playback costs a copy per frame and contends with
+    // setCyclicPattern() for the lock.
+    bool startCyclic(double sampleRate, int channelCount, const double *pattern,
+                     int patternFrames, int bufferFrames = 4096);
+
+    // Replace the cyclic pattern. The switch happens when the current pattern
+    // wraps, so the output never jumps mid-period. Over the first fadeFrames
+    // frames after the switch the output crossfades from the old pattern,
+    // still looping, to the new one, so a change of amplitude or phase
+    // shows up as a ramp rather than a step. A pattern staged during a fade
+    // waits for the next wrap after it. swapIndex, when given, receives the
+    // patternSwapCount() at which this pattern is playing.
+    bool setCyclicPattern(const double *pattern, int patternFrames, int fadeFrames = 0,
+                          quint64 *swapIndex = nullptr);
+    bool isCyclic() const;
+    quint64 patternSwapCount() const;
+
+    // No pattern staged and no fade in progress
+    bool isPatternSettled() const;
+
+    void stop();
+    bool isRunning() const;
+
+    // Called on the starting thread immediately before the device starts,
+    // e.g. to start an acquisition that must share the output's frame 0
+    void setStartHook(std::function<void()> hook);
+
+    // Queue interleaved frames. Returns the number of frames accepted.
+    int write(const double *frames, int frameCount);
+    int freeFrames() const;
+    int queuedFrames() const;
+
+    double sampleRate() const { return m_sampleRate; }
+    int channelCount() const { return m_channelCount; }
+    int bufferFrames() const { return m_bufferFrames; }
+
+    // Statistics
+    quint64 framesTransmitted() const;
+    quint64 underrunCount() const;
+
+    QString getLastError() const;
+
+signals:
+    void streamError(const QString &errorMessage);
+
+protected:
+    // Backend hooks, called with the stream armed and primed
+    virtual bool startDevice() = 0;
+    virtual void stopDevice() = 0;
+
+    // Called by the backend from its clock context. Always produces
+    // frameCount frames. In cyclic mode they come from the pattern; otherwise
+    // frames the FIFO cannot supply repeat the last value and are counted as
+    // an underrun.
+    void fillFromQueue(double *dest, int frameCount);
+
+    void setLastError(const QString &error);
+
+private:
+    mutable QMutex m_mutex;
+    QVector<double> m_fifo;
+    int m_fifoFrames;
+    int m_readFrame;
+    int m_queued;
+    QVector<double> m_lastFrame;
+
+    // Cyclic playback
+    bool m_cyclic;
+    QVector<double> m_pattern;
+    QVector<double> m_pendingPattern;
+    QVector<double> m_fadePattern;      // Pattern being faded out
+    bool m_patternPending;
+    int m_pendingFadeFrames;
+    int m_patternFrame;
+    int m_fadeFrame;
+    int m_fadeFrames;
+    int m_fadeRemaining;
+    quint64 m_patternSwaps;
+
+    void fillFromPattern(double *dest, int frameCount);
+
+    std::function<void()> m_startHook;
+    bool launchDevice();
+
+    double m_sampleRate;
+    int m_channelCount;
+    int m_bufferFrames;
+    bool m_armed;
+    bool m_deviceStarted;
+
+    std::atomic<quint64> m_framesTransmitted;
+    std::atomic<quint64> m_underruns;
+
+    QString m_lastError;
+};
+
+#endif // AOSTREAM_H
@@ -0,0 +1,471 @@
+#include "binarylog.h"
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const int FixedHeaderBytes = 40;
+const int ColumnHeaderBytes = 12;
+
+int paddedTo8(int bytes)
+{
+    return (bytes + 7) & ~7;
+}
+
+template<typename T>
+void put(char *&p, T value)
+{
+    qToLittleEndian(value, p);
+    p += sizeof(T);
+}
+
+void putDouble(char *&p, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(p, bits);
+}
+
+void putFloat(char *&p, float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(p, bits);
+}
+
+template<typename T>
+T get(const char *&p)
+{
+    const T value = qFromLittleEndian<T>(p);
+    p += sizeof(T);
+    return value;
+}
+
+double getDouble(const char *&p)
+{
+    const quint64 bits = get<quint64>(p);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float getFloat(const char *&p)
+{
+    const quint32 bits = get<quint32>(p);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Encoded bytes for records values of a column, before padding
+int encodedBytes(BinaryLogFormat::Encoding encoding, BinaryLogColumn::Type type, int records)
+{
+    switch (encoding) {
+    case BinaryLogFormat::Delta32:
+        return records * 4;
+    case BinaryLogFormat::Raw:
+        return records * (type == BinaryLogColumn::Float32 ? 4 : 8);
+    default:
+        return 0;
+    }
+}
+
+// No block starts with a zero magic, so zeros where a block header belongs
+// are the padding of an O_DIRECT flush (see LogFile)
+bool isZeroPadding(const QByteArray &bytes)
+{
+    const char *data = bytes.constData();
+    for (int i = 0; i < bytes.size(); ++i) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+BinaryLogWriter::BinaryLogWriter()
+    : m_pending(0)
+    , m_recordsWritten(0)
+{
+}
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+    close();
+}
+
+bool BinaryLogWriter::open(const QString &fileName, const QVector<BinaryLogColumn> &columns,
+                           double sampleRate, qint64 startWallMs, const LogFile::Options &options)
+{
+    close();
+
+    m_columns = columns;
+    m_intColumns.clear();
+    m_realColumns.clear();
+    QVector<QByteArray> names;
+    QVector<QByteArray> units;
+    int headerBytes = FixedHeaderBytes;
+    for (int column = 0; column < columns.size(); ++column) {
+        if (columns[column].type == BinaryLogColumn::Int64) {
+            m_intColumns.append(column);
+        } else {
+            m_realColumns.append(column);
+        }
+        names.append(columns[column].name.toUtf8().left(255));
+        units.append(columns[column].unit.toUtf8().left(255));
+        headerBytes += ColumnHeaderBytes + names.last().size() + units.last().size();
+    }
+    m_ints.resize(m_intColumns.size() * BlockRecords);
+    m_reals.resize(m_realColumns.size() * BlockRecords);
+    m_block.resize(BinaryLogFormat::BlockHeaderBytes
+                   + columns.size() * (BinaryLogFormat::DescriptorBytes + BlockRecords * 8));
+    m_pending = 0;
+    m_recordsWritten = 0;
+
+    QByteArray header(paddedTo8(headerBytes), '\0');
+    char *p = header.data();
+    std::memcpy(p, BinaryLogFormat::Magic, sizeof(BinaryLogFormat::Magic));
+    p += sizeof(BinaryLogFormat::Magic);
+    put<quint32>(p, BinaryLogFormat::Version);
+    put<quint32>(p, header.size());
+    putDouble(p, sampleRate);
+    put<qint64>(p, startWallMs);
+    put<quint32>(p, BlockRecords);
+    put<quint32>(p, columns.size());
+    for (int column = 0; column < columns.size(); ++column) {
+        put<quint8>(p, columns[column].type);
+        put<quint8>(p, qBound(0, columns[column].decimals, 255));
+        put<quint8>(p, names[column].size());
+        put<quint8>(p, units[column].size());
+        putDouble(p, columns[column].scale);
+        std::memcpy(p, names[column].constData(), names[column].size());
+        p += names[column].size();
+        std::memcpy(p, units[column].constData(), units[column].size());
+        p += units[column].size();
+    }
+
+    if (!m_file.open(fileName, options, header)) {
+        m_lastError = m_file.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return true;
+    }
+    bool ok = flushBlock();
+    if (!m_file.close() && ok) {
+        m_lastError = m_file.getLastError();
+        ok = false;
+    }
+    return ok;
+}
+
+bool BinaryLogWriter::flushBlock()
+{
+    if (m_pending == 0) {
+        return true;
+    }
+
+    const int records = m_pending;
+    m_pending = 0;
+
+    // Descriptors after the block header, values after the descriptors
+    char *const start = m_block.data();
+    char *descriptor = start + BinaryLogFormat::BlockHeaderBytes;
+    char *data = descriptor + m_columns.size() * BinaryLogFormat::DescriptorBytes;
+    int intSlot = 0;
+    int realSlot = 0;
+
+    for (const BinaryLogColumn &column : m_columns) {
+        BinaryLogFormat::Encoding encoding = BinaryLogFormat::Raw;
+        double min = 0.0;
+        double max = 0.0;
+        qint64 base = 0;
+        qint64 step = 0;
+
+        if (column.type == BinaryLogColumn::Int64) {
+            const qint64 *values = m_ints.constData() + intSlot++ * BlockRecords;
+            qint64 lo = values[0];
+            qint64 hi = values[0];
+            step = records > 1 ? values[1] - values[0] : 0;
+            bool linear = true;
+            for (int i = 1; i < records; ++i) {
+                lo = qMin(lo, values[i]);
+                hi = qMax(hi, values[i]);
+                linear = linear && values[i] - values[i - 1] == step;
+            }
+            min = double(lo);
+            max = double(hi);
+
+            if (lo == hi) {
+                encoding = BinaryLogFormat::Constant;
+                base = lo;
+                step = 0;
+            } else if (linear) {
+                encoding = BinaryLogFormat::Linear;
+                base = values[0];
+            } else if (quint64(hi) - quint64(lo) <= std::numeric_limits<quint32>::max()) {
+                encoding = BinaryLogFormat::Delta32;
+                base = lo;
+                step = 0;
+                for (int i = 0; i < records; ++i) {
+                    put<quint32>(data, quint32(quint64(values[i]) - quint64(lo)));
+                }
+            } else {
+                step = 0;
+                for (int i = 0; i < records; ++i) {
+                    put<qint64>(data, values[i]);
+                }
+            }
+        } else {
+            const double *values = m_reals.constData() + realSlot++ * BlockRecords;
+            const bool single = column.type == BinaryLogColumn::Float32;
+
+            // Constant means bit-identical once stored; NaNs (feedback not
+            // acquired) stay out of the min/max
+            const double first = single ? double(float(values[0])) : values[0];
+            bool constant = true;
+            double lo = std::numeric_limits<double>::infinity();
+            double hi = -std::numeric_limits<double>::infinity();
+            for (int i = 0; i < records; ++i) {
+                const double stored = single ? double(float(values[i])) : values[i];
+                constant = constant && std::memcmp(&stored, &first, sizeof(stored)) == 0;
+                if (!std::isnan(stored)) {
+                    lo = qMin(lo, stored);
+                    hi = qMax(hi, stored);
+                }
+            }
+            if (lo > hi) {
+                lo = hi = std::numeric_limits<double>::quiet_NaN();
+            }
+            min = lo;
+            max = hi;
+
+            if (constant) {
+                encoding = BinaryLogFormat::Constant;
+            } else if (single) {
+                for (int i = 0; i < records; ++i) {
+                    putFloat(data, float(values[i]));
+                }
+            } else {
+                for (int i = 0; i < records; ++i) {
+                    putDouble(data, values[i]);
+                }
+            }
+        }
+
+        while ((data - start) & 7) {
+            *data++ = 0;
+        }
+
+        put<quint8>(descriptor, encoding);
+        std::memset(descriptor, 0, 7);
+        descriptor += 7;
+        putDouble(descriptor, min);
+        putDouble(descriptor, max);
+        put<qint64>(descriptor, base);
+        put<qint64>(descriptor, step);
+    }
+
+    const int blockBytes = int(data - start);
+    char *header = start;
+    put<quint32>(header, BinaryLogFormat::BlockMagic);
+    put<quint32>(header, records);
+    put<quint32>(header, blockBytes);
+    put<quint32>(header, 0);
+
+    // The block goes to the kernel whole; the file rotates between blocks
+    if (!m_file.write(start, blockBytes) || !m_file.flush() || !m_file.rotateIfDue()) {
+        m_lastError = m_file.getLastError();
+        return false;
+    }
+    m_recordsWritten += records;
+    return true;
+}
+
+BinaryLogReader::BinaryLogReader()
+    : m_sampleRate(0.0)
+    , m_startWallMs(0)
+    , m_blockRecords(0)
+{
+}
+
+bool BinaryLogReader::open(const QString &fileName)
+{
+    m_file.close();
+    m_columns.clear();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = "Failed to open log file: " + m_file.errorString();
+        return false;
+    }
+
+    const QByteArray fixed = m_file.read(FixedHeaderBytes);
+    if (fixed.size() < FixedHeaderBytes
+        || std::memcmp(fixed.constData(), BinaryLogFormat::Magic, sizeof(BinaryLogFormat::Magic)) != 0) {
+        m_lastError = fileName + " is not a binary log";
+        return false;
+    }
+
+    const char *p = fixed.constData() + sizeof(BinaryLogFormat::Magic);
+    const quint32 version = get<quint32>(p);
+    const quint32 headerBytes = get<quint32>(p);
+    m_sampleRate = getDouble(p);
+    m_startWallMs = get<qint64>(p);
+    m_blockRecords = get<quint32>(p);
+    const quint32 columnCount = get<quint32>(p);
+    if (version != BinaryLogFormat::Version) {
+        m_lastError = QString("Unsupported binary log version %1").arg(version);
+        return false;
+    }
+    if (headerBytes < quint32(FixedHeaderBytes) || columnCount == 0 || columnCount > 1024
+        || m_blockRecords == 0 || m_blockRecords > (1u << 24)) {
+        m_lastError = "Damaged binary log header";
+        return false;
+    }
+
+    const QByteArray table = m_file.read(headerBytes - FixedHeaderBytes);
+    p = table.constData();
+    const char *const end = p + table.size();
+    for (quint32 column = 0; column < columnCount; ++column) {
+        if (end - p < ColumnHeaderBytes) {
+            m_lastError = "Damaged binary log header";
+            return false;
+        }
+        BinaryLogColumn info;
+        const quint8 type = get<quint8>(p);
+        info.decimals = get<quint8>(p);
+        const quint8 nameBytes = get<quint8>(p);
+        const quint8 unitBytes = get<quint8>(p);
+        info.scale = getDouble(p);
+        if (type > BinaryLogColumn::Float64 || end - p < nameBytes + unitBytes) {
+            m_lastError = "Damaged binary log header";
+            return false;
+        }
+        info.type = BinaryLogColumn::Type(type);
+        info.name = QString::fromUtf8(p, nameBytes);
+        p += nameBytes;
+        info.unit = QString::fromUtf8(p, unitBytes);
+        p += unitBytes;
+        m_columns.append(info);
+    }
+
+    m_lastError.clear();
+    return true;
+}
+
+bool BinaryLogReader::readBlock(BinaryLogBlock &block, bool decode)
+{
+    block.records = 0;
+    const int columns = m_columns.size();
+    const int descriptorBytes = columns * BinaryLogFormat::DescriptorBytes;
+
+    const QByteArray header = m_file.read(BinaryLogFormat::BlockHeaderBytes);
+    if (header.isEmpty() || isZeroPadding(header)) {
+        // End of the log, or the zero padding an O_DIRECT flush leaves at
+        // the tail of a log that is still open or was never closed
+        m_lastError.clear();
+        return false;
+    }
+    const char *p = header.constData();
+    const quint32 magic = header.size() == BinaryLogFormat::BlockHeaderBytes ? get<quint32>(p) : 0;
+    const quint32 records = magic ? get<quint32>(p) : 0;
+    const quint32 blockBytes = magic ? get<quint32>(p) : 0;
+    const quint32 payloadBytes = blockBytes - BinaryLogFormat::BlockHeaderBytes;
+    if (magic != BinaryLogFormat::BlockMagic || records == 0 || records > m_blockRecords
+        || blockBytes < quint32(BinaryLogFormat::BlockHeaderBytes + descriptorBytes)
+        || payloadBytes - descriptorBytes > quint64(records) * columns * 8 + columns * 8) {
+        m_lastError = "Damaged or truncated block at offset " + QString::number(m_file.pos() - header.size());
+        return false;
+    }
+
+    // Skipping reads the descriptors alone
+    m_block = m_file.read(decode ? payloadBytes : descriptorBytes);
+    const bool complete = decode ? m_block.size() == int(payloadBytes)
+                                 : m_block.size() == descriptorBytes
+                                       && m_file.pos() + (payloadBytes - descriptorBytes) <= m_file.size();
+    if (!complete) {
+        m_lastError = "Truncated block at the end of the log";
+        return false;
+    }
+    if (!decode) {
+        m_file.seek(m_file.pos() + (payloadBytes - descriptorBytes));
+    }
+
+    block.min.resize(columns);
+    block.max.resize(columns);
+    block.ints.resize(0);
+    block.reals.resize(0);
+
+    const char *descriptor = m_block.constData();
+    const char *data = descriptor + descriptorBytes;
+    const char *const end = m_block.constData() + m_block.size();
+    for (int column = 0; column < columns; ++column) {
+        const BinaryLogColumn::Type type = m_columns[column].type;
+        const BinaryLogFormat::Encoding encoding = BinaryLogFormat::Encoding(get<quint8>(descriptor));
+        descriptor += 7;
+        block.min[column] = getDouble(descriptor);
+        block.max[column] = getDouble(descriptor);
+        const qint64 base = get<qint64>(descriptor);
+        const qint64 step = get<qint64>(descriptor);
+        if (encoding > BinaryLogFormat::Raw
+            || (type != BinaryLogColumn::Int64 && (encoding == BinaryLogFormat::Linear || encoding == BinaryLogFormat::Delta32))) {
+            m_lastError = QString("Unknown encoding in column %1").arg(column);
+            return false;
+        }
+        if (!decode) {
+            continue;
+        }
+
+        const int bytes = encodedBytes(encoding, type, records);
+        if (end - data < bytes) {
+            m_lastError = "Damaged block: column data overruns the block";
+            return false;
+        }
+
+        if (type == BinaryLogColumn::Int64) {
+            block.ints.append(QVector<qint64>(records));
+            qint64 *values = block.ints.last().data();
+            for (quint32 i = 0; i < records; ++i) {
+                switch (encoding) {
+                case BinaryLogFormat::Constant:
+                    values[i] = base;
+                    break;
+                case BinaryLogFormat::Linear:
+                    values[i] = base + qint64(i) * step;
+                    break;
+                case BinaryLogFormat::Delta32:
+                    values[i] = qint64(quint64(base) + get<quint32>(data));
+                    break;
+                case BinaryLogFormat::Raw:
+                    values[i] = get<qint64>(data);
+                    break;
+                }
+            }
+        } else {
+            block.reals.append(QVector<double>(records));
+            double *values = block.reals.last().data();
+            for (quint32 i = 0; i < records; ++i) {
+                if (encoding == BinaryLogFormat::Constant) {
+                    values[i] = block.min[column];
+                } else if (type == BinaryLogColumn::Float32) {
+                    values[i] = getFloat(data);
+                } else {
+                    values[i] = getDouble(data);
+                }
+            }
+        }
+        data += paddedTo8(bytes) - bytes;
+    }
+
+    block.records = records;
+    return true;
+}
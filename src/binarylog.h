@@ -0,0 +1,160 @@
+#ifndef BINARYLOG_H
+#define BINARYLOG_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QFile>
+#include "logfile.h"
+
+// Compact columnar recording format (.jtmlog).
+//
+// A fixed header carries the schema, the nominal sample rate and the
+// wall-clock time of the session epoch. Records follow in blocks of up to
+// BlockRecords; inside a block each column is stored contiguously, little
+// endian, with its min and max in a per-block descriptor so a reader can
+// summarize or skip blocks without decoding them. Integer columns that
+// advance by a fixed step (sample index, buffered-mode timestamps) or never
+// change cost nothing per record, other integer columns shrink to 32-bit
+// offsets when the block's range allows; float columns are stored as
+// declared unless constant.
+//
+// File header (little endian):
+//   char[8]  "JTMLOG\r\n"
+//   u32      version
+//   u32      header size in bytes, including the column table
+//   f64      nominal sample rate, 0 if unknown
+//   i64      wall-clock ms since the Unix epoch at session time 0
+//   u32      records per full block
+//   u32      column count
+//   per column: u8 type, u8 decimals, u8 name length, u8 unit length,
+//               f64 scale, name and unit in UTF-8
+//   zero padding to a multiple of 8
+// Block:
+//   u32 "JBLK", u32 record count, u32 block size in bytes, u32 reserved
+//   per column: u8 encoding, 7 reserved, f64 min, f64 max, i64 base, i64 step
+//   per column: the encoded values, zero padded to a multiple of 8
+//
+// A block is written whole, so a crash loses at most the block being filled.
+// When the log rotates, each file starts with its own copy of the header.
+
+struct BinaryLogColumn {
+    enum Type : quint8 {
+        Int64 = 0,
+        Float32 = 1,
+        Float64 = 2
+    };
+
+    QString name;
+    QString unit;           // Unit of stored value * scale
+    Type type = Float32;
+    double scale = 1.0;
+    int decimals = 0;       // Digits after the point when written as text
+
+    // "Name(unit)", as in the CSV header
+    QString label() const { return unit.isEmpty() ? name : name + "(" + unit + ")"; }
+};
+
+class BinaryLogFormat
+{
+public:
+    static constexpr char Magic[8] = {'J', 'T', 'M', 'L', 'O', 'G', '\r', '\n'};
+    static constexpr quint32 Version = 1;
+    static constexpr quint32 BlockMagic = 0x4b4c424a;  // "JBLK"
+    static constexpr int BlockHeaderBytes = 16;
+    static constexpr int DescriptorBytes = 40;
+
+    enum Encoding : quint8 {
+        Constant = 0,   // Every value is base (min for float columns)
+        Linear = 1,     // base + i * step
+        Delta32 = 2,    // base + u32 offset
+        Raw = 3         // The column's own type
+    };
+};
+
+class BinaryLogWriter
+{
+public:
+    static constexpr int BlockRecords = 4096;
+
+    BinaryLogWriter();
+    ~BinaryLogWriter();
+
+    bool open(const QString &fileName, const QVector<BinaryLogColumn> &columns,
+              double sampleRate, qint64 startWallMs,
+              const LogFile::Options &options = LogFile::Options());
+    bool close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // One record: the Int64 columns in schema order, then the others
+    bool append(const qint64 *ints, const double *reals)
+    {
+        for (int i = 0; i < m_intColumns.size(); ++i) {
+            m_ints[i * BlockRecords + m_pending] = ints[i];
+        }
+        for (int i = 0; i < m_realColumns.size(); ++i) {
+            m_reals[i * BlockRecords + m_pending] = reals[i];
+        }
+        return ++m_pending < BlockRecords || flushBlock();
+    }
+
+    // Write the records appended so far as a (short) block
+    bool flushBlock();
+    int pendingRecords() const { return m_pending; }
+
+    qint64 recordsWritten() const { return m_recordsWritten; }
+    const LogFile &file() const { return m_file; }
+    QString getLastError() const { return m_lastError; }
+
+private:
+    LogFile m_file;
+    QVector<BinaryLogColumn> m_columns;
+    QVector<int> m_intColumns;      // Schema indices by storage type
+    QVector<int> m_realColumns;
+    QVector<qint64> m_ints;         // Column-major, BlockRecords per column
+    QVector<double> m_reals;
+    QByteArray m_block;
+    int m_pending;
+    qint64 m_recordsWritten;
+    QString m_lastError;
+};
+
+// A decoded block; ints holds the Int64 columns and reals the others, in
+// schema order, each with records values
+struct BinaryLogBlock {
+    int records = 0;
+    QVector<double> min;            // Per schema column
+    QVector<double> max;
+    QVector<QVector<qint64>> ints;
+    QVector<QVector<double>> reals;
+};
+
+class BinaryLogReader
+{
+public:
+    BinaryLogReader();
+
+    bool open(const QString &fileName);
+    void close() { m_file.close(); }
+
+    const QVector<BinaryLogColumn> &columns() const { return m_columns; }
+    double sampleRate() const { return m_sampleRate; }
+    qint64 startWallMs() const { return m_startWallMs; }
+
+    // The next block; with decode false only the counts and min/max are
+    // filled and the values are skipped. False at the end of the file or
+    // on a damaged block, which getLastError() then describes.
+    bool readBlock(BinaryLogBlock &block, bool decode = true);
+    QString getLastError() const { return m_lastError; }
+
+private:
+    QFile m_file;
+    QVector<BinaryLogColumn> m_columns;
+    double m_sampleRate;
+    qint64 m_startWallMs;
+    quint32 m_blockRecords;
+    QByteArray m_block;
+    QString m_lastError;
+};
+
+#endif // BINARYLOG_H
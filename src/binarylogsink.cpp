@@ -0,0 +1,89 @@
+#include "binarylogsink.h"
+#include "monotonicclock.h"
+
+namespace {
+
+// The CSV columns, stored compactly: times stay integer nanoseconds, values
+// drop to single precision, well past the digits the CSV keeps
+QVector<BinaryLogColumn> logRecordColumns()
+{
+    auto column = [](const char *name, const char *unit, BinaryLogColumn::Type type, double scale, int decimals) {
+        BinaryLogColumn info;
+        info.name = name;
+        info.unit = unit;
+        info.type = type;
+        info.scale = scale;
+        info.decimals = decimals;
+        return info;
+    };
+    return {
+        column("Sample", "", BinaryLogColumn::Int64, 1.0, 0),
+        column("ElapsedTime", "s", BinaryLogColumn::Int64, 1.0e-9, 9),
+        column("SessionTime", "s", BinaryLogColumn::Int64, 1.0e-9, 9),
+        column("Frequency", "Hz", BinaryLogColumn::Float32, 1.0, 1),
+        column("Amplitude", "", BinaryLogColumn::Float32, 1.0, 1),
+        column("X-Command", "", BinaryLogColumn::Float32, 1.0, 5),
+        column("Y-Command", "", BinaryLogColumn::Float32, 1.0, 5),
+        column("X-Feedback", "V", BinaryLogColumn::Float32, 1.0, 5),
+        column("Y-Feedback", "V", BinaryLogColumn::Float32, 1.0, 5)
+    };
+}
+
+}
+
+BinaryLogSink::BinaryLogSink()
+    : m_blockStartNs(0)
+{
+}
+
+bool BinaryLogSink::open(const QString &fileName, double sampleRate, const LogFile::Options &options)
+{
+    if (!m_writer.open(fileName, logRecordColumns(), sampleRate,
+                       MonotonicClock::wallTime(0).toMSecsSinceEpoch(), options)) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogSink::write(const LogRecord *records, int count)
+{
+    bool ok = true;
+    for (int i = 0; i < count; ++i) {
+        const LogRecord &record = records[i];
+
+        // Column order of logRecordColumns(), integers first
+        const qint64 ints[] = {record.sampleIndex, record.elapsedTime, record.sessionTime};
+        const double reals[] = {record.frequency, record.amplitude, record.xCommand, record.yCommand,
+                                record.xFeedback, record.yFeedback};
+        if (m_writer.pendingRecords() == 0) {
+            m_blockStartNs = MonotonicClock::nowNs();
+        }
+        ok = m_writer.append(ints, reals) && ok;
+    }
+    if (!ok) {
+        m_lastError = m_writer.getLastError();
+    }
+    return ok;
+}
+
+bool BinaryLogSink::flush()
+{
+    // Records reach the file a block at a time, and within MaxBlockAgeNs of
+    // the first record in a block
+    if (m_writer.pendingRecords() > 0 && MonotonicClock::nowNs() - m_blockStartNs >= MaxBlockAgeNs
+        && !m_writer.flushBlock()) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLogSink::close()
+{
+    if (!m_writer.close()) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
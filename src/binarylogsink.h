@@ -0,0 +1,27 @@
+#ifndef BINARYLOGSINK_H
+#define BINARYLOGSINK_H
+
+#include "logsink.h"
+#include "binarylog.h"
+
+// Waveform records as a binary columnar log (.jtmlog)
+class BinaryLogSink : public LogSink
+{
+public:
+    // A partly filled block is written once this old
+    static constexpr qint64 MaxBlockAgeNs = 1000000000LL;
+
+    BinaryLogSink();
+
+    bool open(const QString &fileName, double sampleRate, const LogFile::Options &options) override;
+    bool write(const LogRecord *records, int count) override;
+    bool flush() override;
+    bool close() override;
+    qint64 bytesWritten() const override { return m_writer.file().bytesWritten(); }
+
+private:
+    BinaryLogWriter m_writer;
+    qint64 m_blockStartNs;      // First record of the open block
+};
+
+#endif // BINARYLOGSINK_H
@@ -0,0 +1,54 @@
+#include "csvlogsink.h"
+
+bool CsvLogSink::open(const QString &fileName, double sampleRate, const LogFile::Options &options)
+{
+    Q_UNUSED(sampleRate);
+    if (!m_writer.open(fileName, options,
+                       "Sample,ElapsedTime(s),SessionTime(s),Frequency(Hz),Amplitude,X-Command,Y-Command,X-Feedback(V),Y-Feedback(V)\n")) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool CsvLogSink::write(const LogRecord *records, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const LogRecord &record = records[i];
+        m_writer.addInt(record.sampleIndex);
+        m_writer.addNanoseconds(record.elapsedTime);
+        m_writer.addNanoseconds(record.sessionTime);
+        m_writer.addFixed(record.frequency, 1);
+        m_writer.addFixed(record.amplitude, 1);
+        m_writer.addFixed(record.xCommand, 5);
+        m_writer.addFixed(record.yCommand, 5);
+        m_writer.addFixed(record.xFeedback, 5);
+        m_writer.addFixed(record.yFeedback, 5);
+        m_writer.endLine();
+    }
+
+    // Only whole lines go to the next file
+    if (!m_writer.rotateIfDue()) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool CsvLogSink::flush()
+{
+    if (!m_writer.flush()) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool CsvLogSink::close()
+{
+    if (!m_writer.close()) {
+        m_lastError = m_writer.getLastError();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef CSVLOGSINK_H
+#define CSVLOGSINK_H
+
+#include "logsink.h"
+#include "csvwriter.h"
+
+// Waveform records as CSV text, one line per record
+class CsvLogSink : public LogSink
+{
+public:
+    bool open(const QString &fileName, double sampleRate, const LogFile::Options &options) override;
+    bool write(const LogRecord *records, int count) override;
+    bool flush() override;
+    bool close() override;
+    qint64 bytesWritten() const override { return m_writer.file().bytesWritten(); }
+
+private:
+    CsvWriter m_writer;
+};
+
+#endif // CSVLOGSINK_H
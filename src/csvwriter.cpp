@@ -0,0 +1,150 @@
+#include "csvwriter.h"
+#include <charconv>
+#include <cstring>
+
+CsvWriter::CsvWriter()
+    : m_buffer(new char[BufferBytes])
+    , m_used(0)
+    , m_lineStart(true)
+    , m_failed(false)
+{
+}
+
+CsvWriter::~CsvWriter()
+{
+    close();
+    delete[] m_buffer;
+}
+
+bool CsvWriter::open(const QString &fileName, const LogFile::Options &options, const QByteArray &header)
+{
+    close();
+
+    m_used = 0;
+    m_lineStart = true;
+    m_failed = false;
+    if (!m_file.open(fileName, options, header)) {
+        m_lastError = m_file.getLastError();
+        return false;
+    }
+    return true;
+}
+
+bool CsvWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return true;
+    }
+    const bool ok = flush();
+    if (!m_file.close() && ok) {
+        m_lastError = m_file.getLastError();
+        return false;
+    }
+    return ok;
+}
+
+char *CsvWriter::beginCell()
+{
+    // Leaves room for the cell and the line end after it
+    if (m_used > BufferBytes - MaxCellBytes - 2) {
+        drain();
+    }
+    if (!m_lineStart) {
+        m_buffer[m_used++] = ',';
+    }
+    m_lineStart = false;
+    return m_buffer + m_used;
+}
+
+void CsvWriter::addText(const char *text, int size)
+{
+    if (m_used > BufferBytes - size - 2) {
+        drain();
+    }
+    if (!m_lineStart) {
+        m_buffer[m_used++] = ',';
+    }
+    m_lineStart = false;
+
+    // Longer than the buffer: pass it through in pieces
+    while (size > 0) {
+        const int chunk = qMin(size, BufferBytes - 1 - m_used);
+        std::memcpy(m_buffer + m_used, text, chunk);
+        m_used += chunk;
+        text += chunk;
+        size -= chunk;
+        if (size > 0) {
+            drain();
+        }
+    }
+}
+
+void CsvWriter::addInt(qint64 value)
+{
+    char *const cell = beginCell();
+    m_used = int(std::to_chars(cell, m_buffer + BufferBytes, value).ptr - m_buffer);
+}
+
+void CsvWriter::addFixed(double value, int decimals)
+{
+    char *const cell = beginCell();
+    m_used = int(std::to_chars(cell, m_buffer + BufferBytes, value, std::chars_format::fixed,
+                               qBound(0, decimals, 30)).ptr - m_buffer);
+}
+
+void CsvWriter::addNanoseconds(qint64 ns)
+{
+    char *p = beginCell();
+    const quint64 magnitude = ns < 0 ? 0 - quint64(ns) : quint64(ns);
+    if (ns < 0) {
+        *p++ = '-';
+    }
+    p = std::to_chars(p, m_buffer + BufferBytes, magnitude / 1000000000ULL).ptr;
+    *p++ = '.';
+    quint32 fraction = quint32(magnitude % 1000000000ULL);
+    for (int digit = 8; digit >= 0; --digit) {
+        p[digit] = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    m_used = int(p + 9 - m_buffer);
+}
+
+void CsvWriter::endLine()
+{
+    if (m_used >= BufferBytes) {
+        drain();
+    }
+    m_buffer[m_used++] = '\n';
+    m_lineStart = true;
+}
+
+void CsvWriter::drain()
+{
+    // After a failed write the rest of the run is discarded, not retried
+    if (!m_failed && m_used > 0 && !m_file.write(m_buffer, m_used)) {
+        m_failed = true;
+        m_lastError = m_file.getLastError();
+    }
+    m_used = 0;
+}
+
+bool CsvWriter::flush()
+{
+    drain();
+    if (!m_failed && !m_file.flush()) {
+        m_failed = true;
+        m_lastError = m_file.getLastError();
+    }
+    return !m_failed;
+}
+
+bool CsvWriter::rotateIfDue()
+{
+    // Lines are only ever split between buffers, never between files
+    drain();
+    if (!m_failed && !m_file.rotateIfDue()) {
+        m_failed = true;
+        m_lastError = m_file.getLastError();
+    }
+    return !m_failed;
+}
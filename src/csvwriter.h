@@ -0,0 +1,61 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QString>
+#include <QByteArray>
+#include "logfile.h"
+
+// Buffered CSV output without per-cell allocations.
+//
+// Numbers are formatted with std::to_chars straight into one large byte
+// buffer, and whole buffers go to a LogFile; nothing passes through QString
+// or UTF-16. Timestamps in nanoseconds are printed as seconds with integer
+// arithmetic, so they are exact at any magnitude. The output matches
+// QString::number(value, 'f', decimals) for the same values.
+class CsvWriter
+{
+public:
+    static constexpr int BufferBytes = 1 << 20;
+
+    CsvWriter();
+    ~CsvWriter();
+
+    // header (the column names) starts the file and every rotated one
+    bool open(const QString &fileName, const LogFile::Options &options = LogFile::Options(),
+              const QByteArray &header = QByteArray());
+    bool close();
+    bool isOpen() const { return m_file.isOpen(); }
+
+    // Cells of the current line, comma separated
+    void addText(const char *text, int size);
+    void addText(const QByteArray &text) { addText(text.constData(), text.size()); }
+    void addInt(qint64 value);
+    void addFixed(double value, int decimals);
+    void addNanoseconds(qint64 ns);
+    void endLine();
+
+    // Hand the buffered lines to the kernel; also done when the buffer fills
+    bool flush();
+
+    // Between lines: continue in a new file if the current one is full
+    bool rotateIfDue();
+
+    const LogFile &file() const { return m_file; }
+    QString getLastError() const { return m_lastError; }
+
+private:
+    // Room for any single cell: a fixed-point double needs up to 309 digits
+    static constexpr int MaxCellBytes = 400;
+
+    LogFile m_file;
+    char *m_buffer;
+    int m_used;
+    bool m_lineStart;
+    bool m_failed;
+    QString m_lastError;
+
+    char *beginCell();
+    void drain();
+};
+
+#endif // CSVWRITER_H
@@ -0,0 +1,82 @@
+#include "ellipsefit.h"
+#include <QtMath>
+#include <cmath>
+
+EllipseFit::EllipseFit()
+{
+    reset();
+}
+
+void EllipseFit::reset()
+{
+    m_count = 0;
+    m_originX = 0.0;
+    m_originY = 0.0;
+    m_sumX = 0.0;
+    m_sumY = 0.0;
+    m_sumXX = 0.0;
+    m_sumYY = 0.0;
+    m_sumXY = 0.0;
+    m_lastX = 0.0;
+    m_lastY = 0.0;
+    m_area = 0.0;
+}
+
+void EllipseFit::add(double x, double y)
+{
+    if (m_count == 0) {
+        m_originX = x;
+        m_originY = y;
+    }
+    x -= m_originX;
+    y -= m_originY;
+
+    m_sumX += x;
+    m_sumY += y;
+    m_sumXX += x * x;
+    m_sumYY += y * y;
+    m_sumXY += x * y;
+    m_area += m_lastX * y - x * m_lastY;
+    m_lastX = x;
+    m_lastY = y;
+    ++m_count;
+}
+
+EllipseFit::Result EllipseFit::result() const
+{
+    Result result = {};
+    result.count = m_count;
+    if (m_count < 3) {
+        return result;
+    }
+
+    const double meanX = m_sumX / m_count;
+    const double meanY = m_sumY / m_count;
+    const double varX = qMax(0.0, m_sumXX / m_count - meanX * meanX);
+    const double varY = qMax(0.0, m_sumYY / m_count - meanY * meanY);
+    const double covXY = m_sumXY / m_count - meanX * meanY;
+
+    result.centerX = m_originX + meanX;
+    result.centerY = m_originY + meanY;
+    result.xAmplitude = std::sqrt(2.0 * varX);
+    result.yAmplitude = std::sqrt(2.0 * varY);
+
+    // Principal axes of the covariance
+    const double halfSum = 0.5 * (varX + varY);
+    const double root = std::hypot(0.5 * (varX - varY), covXY);
+    result.majorAxis = std::sqrt(2.0 * (halfSum + root));
+    result.minorAxis = std::sqrt(2.0 * qMax(0.0, halfSum - root));
+    if (result.majorAxis <= 0.0) {
+        return result;
+    }
+    result.axisRatio = result.minorAxis / result.majorAxis;
+    result.rotation = qRadiansToDegrees(0.5 * std::atan2(2.0 * covXY, varX - varY));
+
+    // Y leading X by 0..180 degrees runs clockwise, which sweeps a negative
+    // area; the closing segment back to the first point is left out
+    const double correlation = varX > 0.0 && varY > 0.0 ? covXY / std::sqrt(varX * varY) : 1.0;
+    const double magnitude = qRadiansToDegrees(std::acos(qBound(-1.0, correlation, 1.0)));
+    result.phase = m_area <= 0.0 ? magnitude : -magnitude;
+    result.valid = true;
+    return result;
+}
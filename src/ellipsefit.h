@@ -0,0 +1,54 @@
+#ifndef ELLIPSEFIT_H
+#define ELLIPSEFIT_H
+
+#include <QtGlobal>
+
+// Ellipse traced by two sinusoids of the same frequency,
+//   x = cx + a sin(wt), y = cy + b sin(wt + phase),
+// fitted from running moments of the points.
+//
+// Over whole revolutions the mean is the center, the variances are a^2/2
+// and b^2/2, and the covariance is ab cos(phase)/2, so adding a point is a
+// handful of multiply-adds and the fit is exact for a clean ellipse. The
+// sign of the phase comes from the direction of travel. Points are taken
+// relative to the first one to keep the sums well conditioned.
+class EllipseFit
+{
+public:
+    struct Result {
+        bool valid;
+        int count;
+        double centerX;
+        double centerY;
+        double xAmplitude;      // a
+        double yAmplitude;      // b
+        double majorAxis;       // Semi-axes
+        double minorAxis;
+        double axisRatio;       // Minor over major, 1 for a circle
+        double rotation;        // Of the major axis from X, degrees in (-90, 90]
+        double phase;           // Of Y relative to X, degrees in (-180, 180]
+    };
+
+    EllipseFit();
+
+    void reset();
+    void add(double x, double y);
+    int count() const { return m_count; }
+
+    Result result() const;
+
+private:
+    int m_count;
+    double m_originX;
+    double m_originY;
+    double m_sumX;
+    double m_sumY;
+    double m_sumXX;
+    double m_sumYY;
+    double m_sumXY;
+    double m_lastX;
+    double m_lastY;
+    double m_area;              // Twice the signed area swept, shoelace sum
+};
+
+#endif // ELLIPSEFIT_H
@@ -1,17 +1,35 @@
 #include "faststeeringmirror.h"
+#include "nco.h"
+#include "simulatedaostream.h"
+#include "tracelog.h"
 #include <QDebug>
-
-using namespace Automation::BDaq;
+#include <QtMath>
+#include <chrono>
+#include <cmath>
 
 FastSteeringMirror::FastSteeringMirror(QObject *parent)
     : QObject(parent)
-    , m_aoCtrl(nullptr)
+    , m_backend(nullptr)
+    , m_backendType(AoBackend::Advantech)
     , m_initialized(false)
+    , m_deviceState(DeviceState::Closed)
     , m_minVoltage(-10.0)
     , m_maxVoltage(10.0)
+    , m_instrumentationEnabled(true)
+    , m_writeHistogram("AO write duration")
+    , m_stream(nullptr)
+    , m_streamActive(false)
+    , m_feedbackEnabled(false)
+    , m_feedbackStream(nullptr)
+    , m_periodicWaveform{0.0, 0.0, 0.0, false, false}
+    , m_periodicFrequency(0.0)
+    , m_stagedFrequency(0.0)
+    , m_stagedSwapIndex(0)
+    , m_slopeEnvelope(0.0)
+    , m_amplitudeEnvelope(0.0)
 {
-    m_currentVoltages[0] = 0.0;
-    m_currentVoltages[1] = 0.0;
+    m_currentVoltages[0].store(0.0, std::memory_order_relaxed);
+    m_currentVoltages[1].store(0.0, std::memory_order_relaxed);
 }
 
 FastSteeringMirror::~FastSteeringMirror()
@@ -25,77 +43,60 @@ bool FastSteeringMirror::initialize()
         return true;
     }
 
-    try {
-        // Create the AO control instance
-        m_aoCtrl = InstantAoCtrl::Create();
-        if (!m_aoCtrl) {
-            m_lastError = "Failed to create InstantAoCtrl instance";
-            qDebug() << "Initialization failed:" << m_lastError;
-            return false;
-        }
-
-        m_initialized = true;
-        qDebug() << "FastSteeringMirror initialized successfully";
-        return true;
+    if (!m_backend) {
+        m_backend = AoBackend::create(m_backendType, this);
+        connect(m_backend, &AoBackend::deviceRemoved, this,
+                &FastSteeringMirror::onBackendDeviceRemoved, Qt::DirectConnection);
     }
-    catch (const std::exception &e) {
-        m_lastError = QString("Exception during initialization: %1").arg(e.what());
-        qDebug() << "Initialization failed with exception:" << m_lastError;
+
+    if (!m_backend->initialize()) {
+        m_lastError = m_backend->getLastError();
+        qDebug() << "Initialization failed:" << m_lastError;
         return false;
     }
+
+    m_initialized = true;
+    qDebug() << "FastSteeringMirror initialized with" << AoBackend::displayName(m_backendType);
+    return true;
 }
 
 void FastSteeringMirror::cleanup()
 {
+    stopStreaming();
     closeDevice();
 
-    if (m_aoCtrl) {
-        m_aoCtrl->Dispose();
-        m_aoCtrl = nullptr;
+    if (m_backend) {
+        m_backend->cleanup();
+        delete m_backend;
+        m_backend = nullptr;
     }
 
     m_initialized = false;
     qDebug() << "FastSteeringMirror cleaned up";
 }
 
-QStringList FastSteeringMirror::getAvailableDevices() const
+bool FastSteeringMirror::setBackendType(AoBackend::Type type)
 {
-    QStringList devices;
+    if (type == m_backendType && m_backend) {
+        return true;
+    }
 
+    bool wasInitialized = m_initialized;
+    cleanup();
+    m_backendType = type;
+
+    qDebug() << "Mirror output backend:" << AoBackend::displayName(type);
+    return wasInitialized ? initialize() : true;
+}
+
+QStringList FastSteeringMirror::getAvailableDevices() const
+{
     if (!m_initialized) {
         qWarning() << "FastSteeringMirror not initialized";
-        return devices;
-    }
-
-    Array<DeviceTreeNode> *supportedDevices = m_aoCtrl->getSupportedDevices();
-    qDebug() << "Found" << supportedDevices->getCount() << "supported devices";
-
-    for (int i = 0; i < supportedDevices->getCount(); i++) {
-        DeviceTreeNode const &node = supportedDevices->getItem(i);
-        QString description = QString::fromWCharArray(node.Description);
-
-        // Check for various Advantech card models with AO capability
-        if (description.contains("PCIE-1824", Qt::CaseInsensitive) ||
-            description.contains("PCIE-1816", Qt::CaseInsensitive) ||
-            description.contains("PCIE-1810", Qt::CaseInsensitive) ||
-            description.contains("PCIE-1802", Qt::CaseInsensitive) ||
-            description.contains("USB-4702", Qt::CaseInsensitive) ||
-            description.contains("USB-4704", Qt::CaseInsensitive) ||
-            description.contains("USB-4750", Qt::CaseInsensitive) ||
-            // Add any other model numbers that support AO
-            // Or use a more generic check if possible:
-            description.contains("AO", Qt::CaseInsensitive)) {
-
-            devices.append(description);
-            qDebug() << "Found compatible device:" << description;
-        }
-    }
-
-    if (devices.isEmpty()) {
-        qDebug() << "No compatible Advantech analog output devices found";
+        return QStringList();
     }
 
-    return devices;
+    return m_backend->availableDevices();
 }
 
 void FastSteeringMirror::setProfilePath(const QString &profilePath)
@@ -106,34 +107,19 @@ void FastSteeringMirror::setProfilePath(const QString &profilePath)
 
 bool FastSteeringMirror::loadProfile(const QString &profilePath)
 {
-    if (!m_initialized || !m_aoCtrl) {
+    if (!m_initialized) {
         m_lastError = "Mirror controller not initialized";
         qDebug() << "Cannot load profile:" << m_lastError;
         return false;
     }
 
-    qDebug() << "Loading profile:" << profilePath;
-
-    try {
-        std::wstring wProfilePath = profilePath.toStdWString();
-        ErrorCode errCode = m_aoCtrl->LoadProfile(wProfilePath.c_str());
-
-        if (errCode != Success) {
-            m_lastError = QString("Failed to load profile, error code: 0x%1").arg(
-                QString::number(errCode, 16).right(8).toUpper());
-            qDebug() << m_lastError;
-            return false;
-        }
-
-        qDebug() << "Profile loaded successfully";
-        m_profilePath = profilePath;
-        return true;
-    }
-    catch (const std::exception &e) {
-        m_lastError = QString("Exception when loading profile: %1").arg(e.what());
-        qDebug() << m_lastError;
+    if (!m_backend->loadProfile(profilePath)) {
+        m_lastError = m_backend->getLastError();
         return false;
     }
+
+    m_profilePath = profilePath;
+    return true;
 }
 
 bool FastSteeringMirror::openDevice(const QString &deviceName)
@@ -148,122 +134,88 @@ bool FastSteeringMirror::openDevice(const QString &deviceName)
     closeDevice();
 
     qDebug() << "Attempting to open device:" << deviceName;
+    setDeviceState(DeviceState::Opening);
 
-    try {
-        // Simple approach similar to Advantech examples
-        std::wstring wDeviceName = deviceName.toStdWString();
-        DeviceInformation devInfo(wDeviceName.c_str());
-
-        // Select the device
-        ErrorCode errCode = m_aoCtrl->setSelectedDevice(devInfo);
-        qDebug() << "setSelectedDevice returned code:" << errCode;
-
-        if (errCode != Success) {
-            m_lastError = QString("Failed to select device, error code: 0x%1").arg(
-                QString::number(errCode, 16).right(8).toUpper());
-            qDebug() << m_lastError;
-            return false;
-        }
-
-        qDebug() << "Device selected successfully";
-
-        // If a profile path was provided, try to load it
-        if (!m_profilePath.isEmpty()) {
-            qDebug() << "Applying device profile from:" << m_profilePath;
-            std::wstring wProfilePath = m_profilePath.toStdWString();
-            errCode = m_aoCtrl->LoadProfile(wProfilePath.c_str());
-
-            if (errCode != Success) {
-                qDebug() << "Warning: Failed to load profile, error code:" << errCode;
-                // Continue - non-fatal error
-            } else {
-                qDebug() << "Profile loaded successfully";
-            }
-        }
-
-        // Check if we have at least 2 channels for X and Y control
-        int channelCount = m_aoCtrl->getChannelCount();
-        qDebug() << "Device reports" << channelCount << "channels";
+    if (!m_backend->open(deviceName, m_profilePath)) {
+        m_lastError = m_backend->getLastError();
+        setDeviceState(DeviceState::Closed);
+        return false;
+    }
 
-        if (channelCount < 2) {
-            m_lastError = "Device doesn't have enough channels (need at least 2)";
-            qDebug() << m_lastError;
-            return false;
-        }
+    m_currentVoltages[0].store(0.0, std::memory_order_relaxed);
+    m_currentVoltages[1].store(0.0, std::memory_order_relaxed);
+    m_deviceName = deviceName;
+    setDeviceState(DeviceState::Open);
 
-        // Try to get device info to verify connection
-        DeviceInformation currentDevice;
-        m_aoCtrl->getSelectedDevice(currentDevice);
-        qDebug() << "Connected to device:" << QString::fromWCharArray(currentDevice.Description);
-
-        // Set the voltage range for both channels
-        for (int i = 0; i < 2; i++) {
-            errCode = m_aoCtrl->getChannels()->getItem(i).setValueRange(V_Neg10To10);
-            if (errCode != Success) {
-                m_lastError = QString("Failed to set voltage range for channel %1").arg(i);
-                qDebug() << m_lastError;
-                return false;
-            }
-        }
+    qDebug() << "Device opened successfully!";
+    return true;
+}
 
-        qDebug() << "Voltage ranges set successfully";
+void FastSteeringMirror::closeDevice()
+{
+    stopStreaming();
 
-        // Initialize to zero position
-        double zeroValues[2] = {0.0, 0.0};
-        errCode = m_aoCtrl->Write(0, 2, zeroValues);
-        if (errCode != Success) {
-            m_lastError = QString("Failed to write initial values");
-            qDebug() << m_lastError;
-            return false;
-        }
+    if (m_deviceState.load(std::memory_order_acquire) == DeviceState::Closed) {
+        return;
+    }
 
-        qDebug() << "Wrote initial values successfully";
+    // The backend drives the outputs to zero if it still can
+    m_backend->close();
+    m_deviceName.clear();
+    setDeviceState(DeviceState::Closed);
+}
 
-        m_currentVoltages[0] = 0.0;
-        m_currentVoltages[1] = 0.0;
+bool FastSteeringMirror::isDeviceOpen() const
+{
+    return m_deviceState.load(std::memory_order_acquire) == DeviceState::Open;
+}
 
-        // If we got this far, everything seems good
-        qDebug() << "Device opened successfully!";
-        return true;
-    }
-    catch (const std::exception &e) {
-        m_lastError = QString("Exception when opening device: %1").arg(e.what());
-        qDebug() << m_lastError;
-        return false;
-    }
+FastSteeringMirror::DeviceState FastSteeringMirror::deviceState() const
+{
+    return m_deviceState.load(std::memory_order_acquire);
 }
 
-void FastSteeringMirror::closeDevice()
+void FastSteeringMirror::setDeviceState(DeviceState state)
 {
-    if (m_aoCtrl && m_aoCtrl->getState() != Idle) {
-        qDebug() << "Closing device, setting outputs to zero";
-        // Set outputs to zero before closing
-        double zeroValues[2] = {0.0, 0.0};
-        m_aoCtrl->Write(0, 2, zeroValues);
+    DeviceState previous = m_deviceState.exchange(state, std::memory_order_acq_rel);
+    if (previous != state) {
+        qDebug() << "Mirror device state" << static_cast<int>(previous)
+                 << "->" << static_cast<int>(state);
     }
 }
 
-bool FastSteeringMirror::isDeviceOpen() const
+void FastSteeringMirror::enterFaultedState(const QString &reason)
 {
-    if (!m_initialized || !m_aoCtrl) {
-        return false;
+    if (m_deviceState.load(std::memory_order_acquire) == DeviceState::Closed) {
+        return;
     }
 
-    try {
-        // Just try to get the channel count - if this works, the device is likely connected
-        int channelCount = m_aoCtrl->getChannelCount();
-        return channelCount > 0;
-    }
-    catch (...) {
-        return false;
-    }
+    setDeviceState(DeviceState::Faulted);
+    m_lastError = reason;
+    qDebug() << "Mirror device faulted:" << reason;
+    emit deviceError(reason);
+}
+
+void FastSteeringMirror::onBackendDeviceRemoved()
+{
+    // Called on a driver thread: stop the hot path right away, then hand the
+    // rest over to the mirror's own thread
+    m_deviceState.store(DeviceState::Faulted, std::memory_order_release);
+    QMetaObject::invokeMethod(this, [this]() {
+        enterFaultedState("Device removed");
+    }, Qt::QueuedConnection);
 }
 
 bool FastSteeringMirror::setPosition(double xPosition, double yPosition)
 {
     if (!isDeviceOpen()) {
         m_lastError = "Device not open";
-        qDebug() << "Cannot set position:" << m_lastError;
+        JTM_DEBUG(TraceLog::Mirror, "Cannot set position: device not open");
+        return false;
+    }
+
+    if (isStreaming()) {
+        m_lastError = "Streaming output active";
         return false;
     }
 
@@ -276,19 +228,20 @@ bool FastSteeringMirror::setPosition(double xPosition, double yPosition)
     voltages[0] = positionToVoltage(xPosition);
     voltages[1] = positionToVoltage(yPosition);
 
-    qDebug() << "Setting position:" << xPosition << yPosition;
-    qDebug() << "Corresponding voltages:" << voltages[0] << voltages[1];
+    JTM_TRACE(TraceLog::Mirror, "Setting position: %.4f %.4f (%.3f V, %.3f V)",
+              xPosition, yPosition, voltages[0], voltages[1]);
 
     // Write to device
-    ErrorCode errCode = m_aoCtrl->Write(0, 2, voltages);
-    if (errCode != Success) {
-        checkError(errCode);
+    if (!timedWrite(voltages)) {
+        // An error-level failure means the device can no longer be trusted,
+        // it has to be reopened
+        enterFaultedState(m_backend->getLastError());
         return false;
     }
 
     // Update current voltages
-    m_currentVoltages[0] = voltages[0];
-    m_currentVoltages[1] = voltages[1];
+    m_currentVoltages[0].store(voltages[0], std::memory_order_relaxed);
+    m_currentVoltages[1].store(voltages[1], std::memory_order_relaxed);
 
     // Emit signal
     emit positionChanged(xPosition, yPosition);
@@ -296,9 +249,336 @@ bool FastSteeringMirror::setPosition(double xPosition, double yPosition)
     return true;
 }
 
+bool FastSteeringMirror::writePosition(double xPosition, double yPosition)
+{
+    if (m_deviceState.load(std::memory_order_acquire) != DeviceState::Open ||
+        m_streamActive.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    double voltages[2];
+    voltages[0] = positionToVoltage(qBound(-1.0, xPosition, 1.0));
+    voltages[1] = positionToVoltage(qBound(-1.0, yPosition, 1.0));
+
+    if (!timedWrite(voltages)) {
+        // Stop further writes now, report on the mirror's own thread
+        m_deviceState.store(DeviceState::Faulted, std::memory_order_release);
+        QMetaObject::invokeMethod(this, [this]() {
+            enterFaultedState(m_backend->getLastError());
+        }, Qt::QueuedConnection);
+        return false;
+    }
+
+    m_currentVoltages[0].store(voltages[0], std::memory_order_relaxed);
+    m_currentVoltages[1].store(voltages[1], std::memory_order_relaxed);
+    return true;
+}
+
+bool FastSteeringMirror::timedWrite(const double voltages[2])
+{
+    if (!m_instrumentationEnabled.load(std::memory_order_relaxed)) {
+        return m_backend->write(voltages);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = m_backend->write(voltages);
+    m_writeHistogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return ok;
+}
+
+void FastSteeringMirror::setInstrumentationEnabled(bool enabled)
+{
+    m_instrumentationEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool FastSteeringMirror::instrumentationEnabled() const
+{
+    return m_instrumentationEnabled.load(std::memory_order_relaxed);
+}
+
+bool FastSteeringMirror::startStreaming(double sampleRate, int bufferFrames)
+{
+    stopStreaming();
+
+    if (!isDeviceOpen()) {
+        m_lastError = "Device not open";
+        qDebug() << "Cannot start streaming:" << m_lastError;
+        return false;
+    }
+
+    // Keep the output thread off the device while the stream owns it
+    m_streamActive.store(true, std::memory_order_release);
+
+    m_stream = m_backend->createStream(this);
+    if (!m_stream) {
+        m_lastError = m_backend->getLastError();
+        m_streamActive.store(false, std::memory_order_release);
+        return false;
+    }
+
+    connect(m_stream, &AoStream::streamError, this, &FastSteeringMirror::deviceError);
+
+    if (m_feedbackEnabled) {
+        m_feedbackStream = m_backend->createAiStream(this);
+        if (m_feedbackStream) {
+            connect(m_feedbackStream, &AiStream::streamError, this, &FastSteeringMirror::deviceError);
+            AiStream *feedback = m_feedbackStream;
+            m_stream->setStartHook([feedback, sampleRate, bufferFrames]() {
+                if (!feedback->start(sampleRate, 2, bufferFrames)) {
+                    qDebug() << "Feedback acquisition failed to start:" << feedback->getLastError();
+                }
+            });
+        } else {
+            qDebug() << "Streaming without feedback:" << m_backend->getLastError();
+        }
+    }
+
+    if (!m_stream->start(sampleRate, 2, bufferFrames)) {
+        m_lastError = m_stream->getLastError();
+        delete m_stream;
+        m_stream = nullptr;
+        delete m_feedbackStream;
+        m_feedbackStream = nullptr;
+        m_streamActive.store(false, std::memory_order_release);
+        return false;
+    }
+
+    m_streamScratch.resize(m_stream->bufferFrames() * 2);
+    qDebug() << "Streaming output armed at" << sampleRate << "S/s on"
+             << AoBackend::displayName(m_backendType);
+    return true;
+}
+
+void FastSteeringMirror::stopStreaming()
+{
+    if (!m_stream) {
+        return;
+    }
+
+    // Stop the output before the acquisition so every frame acquired has a
+    // command behind it
+    m_stream->stop();
+    delete m_stream;
+    m_stream = nullptr;
+
+    if (m_feedbackStream) {
+        m_feedbackStream->stop();
+        delete m_feedbackStream;
+        m_feedbackStream = nullptr;
+    }
+
+    // Leave the mirror centred, the buffered output holds its last value
+    if (isDeviceOpen()) {
+        double zeroValues[2] = {0.0, 0.0};
+        m_backend->write(zeroValues);
+        m_currentVoltages[0].store(0.0, std::memory_order_relaxed);
+        m_currentVoltages[1].store(0.0, std::memory_order_relaxed);
+    }
+    m_streamActive.store(false, std::memory_order_release);
+}
+
+void FastSteeringMirror::setFeedbackEnabled(bool enabled)
+{
+    m_feedbackEnabled = enabled;
+}
+
+bool FastSteeringMirror::isStreaming() const
+{
+    return m_stream != nullptr;
+}
+
+int FastSteeringMirror::queueSamples(const double *xPositions, const double *yPositions, int count)
+{
+    if (!m_stream) {
+        return 0;
+    }
+
+    count = qMin(count, m_stream->freeFrames());
+    if (m_streamScratch.size() < count * 2) {
+        m_streamScratch.resize(count * 2);
+    }
+
+    // Interleave and convert to voltages
+    double *frames = m_streamScratch.data();
+    for (int i = 0; i < count; ++i) {
+        frames[2 * i] = positionToVoltage(qBound(-1.0, xPositions[i], 1.0));
+        frames[2 * i + 1] = positionToVoltage(qBound(-1.0, yPositions[i], 1.0));
+    }
+
+    int queued = m_stream->write(frames, count);
+    if (queued > 0) {
+        m_currentVoltages[0].store(frames[2 * (queued - 1)], std::memory_order_relaxed);
+        m_currentVoltages[1].store(frames[2 * (queued - 1) + 1], std::memory_order_relaxed);
+    }
+    return queued;
+}
+
+int FastSteeringMirror::streamFreeSamples() const
+{
+    return m_stream ? m_stream->freeFrames() : 0;
+}
+
+bool FastSteeringMirror::startPeriodicWaveform(const PeriodicWaveform &waveform, double sampleRate)
+{
+    stopStreaming();
+
+    if (waveform.frequency <= 0.0 || sampleRate <= 0.0) {
+        m_lastError = "Invalid waveform frequency or sample rate";
+        return false;
+    }
+
+    // Build the stream through the same path as block streaming, then switch
+    // it to cyclic playback of the synthesized pattern
+    int bufferFrames = qMax(256, static_cast<int>(sampleRate * 0.02));
+    if (!startStreaming(sampleRate, bufferFrames)) {
+        return false;
+    }
+
+    double frequency = 0.0;
+    int frames = synthesizePeriod(waveform, sampleRate, &frequency);
+    m_periodicWaveform = waveform;
+    stagePatternEnvelope(waveform, true);
+
+    if (!m_stream->startCyclic(sampleRate, 2, m_periodTable.constData(), frames, bufferFrames)) {
+        m_lastError = m_stream->getLastError();
+        stopStreaming();
+        return false;
+    }
+
+    m_periodicFrequency = frequency;
+    m_stagedFrequency = frequency;
+    m_stagedSwapIndex = 0;
+    qDebug() << "Periodic waveform started:" << frequency << "Hz,"
+             << frames << "samples per pattern";
+    return true;
+}
+
+bool FastSteeringMirror::updatePeriodicWaveform(const PeriodicWaveform &waveform)
+{
+    if (!m_stream || !m_stream->isCyclic()) {
+        m_lastError = "Periodic waveform not running";
+        return false;
+    }
+
+    if (waveform.frequency <= 0.0) {
+        m_lastError = "Invalid waveform frequency";
+        return false;
+    }
+
+    double frequency = 0.0;
+    int frames = synthesizePeriod(waveform, m_stream->sampleRate(), &frequency);
+    int fadeFrames = stagePatternEnvelope(waveform, m_stream->isPatternSettled());
+
+    // Whatever plays now keeps being reported until the new pattern swaps in
+    double playing = periodicFrequency();
+    quint64 swapIndex = 0;
+    if (!m_stream->setCyclicPattern(m_periodTable.constData(), frames, fadeFrames, &swapIndex)) {
+        m_lastError = "Failed to stage waveform update";
+        return false;
+    }
+
+    m_periodicWaveform = waveform;
+    m_periodicFrequency = playing;
+    m_stagedFrequency = frequency;
+    m_stagedSwapIndex = swapIndex;
+    return true;
+}
+
+double FastSteeringMirror::periodicFrequency() const
+{
+    if (m_stream && m_stream->patternSwapCount() < m_stagedSwapIndex) {
+        return m_periodicFrequency;
+    }
+    return m_stagedFrequency;
+}
+
+int FastSteeringMirror::synthesizePeriod(const PeriodicWaveform &waveform, double sampleRate, double *frequency)
+{
+    // Pick the number of periods whose length lands closest to a whole
+    // number of samples, so the loop point has no phase error
+    const int maxFrames = 1 << 20;
+    const double samplesPerPeriod = sampleRate / waveform.frequency;
+    int periods = 1;
+    int frames = qMax(1, qRound(samplesPerPeriod));
+    double bestError = qAbs(frames - samplesPerPeriod) / samplesPerPeriod;
+
+    for (int p = 2; p <= 64 && bestError > 1e-9; ++p) {
+        double exact = samplesPerPeriod * p;
+        if (exact > maxFrames) {
+            break;
+        }
+        int n = qRound(exact);
+        double error = qAbs(n - exact) / exact;
+        if (error < bestError) {
+            bestError = error;
+            periods = p;
+            frames = n;
+        }
+    }
+
+    *frequency = sampleRate * periods / frames;
+
+    // One pass of the NCO over the pattern ends back at phase zero, to
+    // within the resolution of the 64-bit phase increment
+    QVector<double> x(frames);
+    QVector<double> y(frames);
+    Nco nco(sampleRate);
+    nco.setFrequency(*frequency);
+    nco.setAmplitude(waveform.amplitude);
+    nco.setPhaseOffset(waveform.phaseOffset);
+    nco.generate(x.data(), y.data(), frames);
+
+    m_periodTable.resize(frames * 2);
+    double *table = m_periodTable.data();
+    for (int i = 0; i < frames; ++i) {
+        table[2 * i] = positionToVoltage(waveform.xEnabled ? qBound(-1.0, x[i], 1.0) : 0.0);
+        table[2 * i + 1] = positionToVoltage(waveform.yEnabled ? qBound(-1.0, y[i], 1.0) : 0.0);
+    }
+
+    return frames;
+}
+
+int FastSteeringMirror::stagePatternEnvelope(const PeriodicWaveform &next, bool reset)
+{
+    // Output amplitude, zero with both axes off
+    auto amplitude = [](const PeriodicWaveform &waveform) {
+        return (waveform.xEnabled || waveform.yEnabled) ? waveform.amplitude : 0.0;
+    };
+
+    // Once the stream has settled only the latest staged pattern still plays
+    if (reset) {
+        m_slopeEnvelope = amplitude(m_periodicWaveform) * m_periodicWaveform.frequency;
+        m_amplitudeEnvelope = amplitude(m_periodicWaveform);
+    }
+    m_slopeEnvelope = qMax(m_slopeEnvelope, amplitude(next) * next.frequency);
+    m_amplitudeEnvelope = qMax(m_amplitudeEnvelope, amplitude(next));
+
+    // A sine's largest sample-to-sample step is amplitude * 2*pi*f / rate,
+    // so no pattern in the envelope steps further than this
+    const double rate = m_stream->sampleRate();
+    const double step = 2.0 * M_PI * m_slopeEnvelope / rate;
+
+    // The crossfade adds at most (old - new) / fadeFrames to each step. That
+    // is kept under 4% of the sine step, inside the 5% margin of the limit.
+    int fadeFrames = 0;
+    if (step > 0.0) {
+        const double spread = m_amplitudeEnvelope + amplitude(next);
+        fadeFrames = static_cast<int>(qMin(std::ceil(spread / (0.04 * step)), double(1 << 30)));
+    }
+
+    SimulatedAoStream *simulated = qobject_cast<SimulatedAoStream *>(m_stream);
+    if (simulated) {
+        double voltsPerUnit = (m_maxVoltage - m_minVoltage) / 2.0;
+        simulated->setStepLimit(voltsPerUnit * step * 1.05 + 1e-9);
+    }
+    return fadeFrames;
+}
+
 QPair<double, double> FastSteeringMirror::getCurrentVoltages() const
 {
-    return QPair<double, double>(m_currentVoltages[0], m_currentVoltages[1]);
+    return QPair<double, double>(m_currentVoltages[0].load(std::memory_order_relaxed),
+                                 m_currentVoltages[1].load(std::memory_order_relaxed));
 }
 
 bool FastSteeringMirror::setVoltageRange(double minVoltage, double maxVoltage)
@@ -318,18 +598,6 @@ QString FastSteeringMirror::getLastError() const
     return m_lastError;
 }
 
-void FastSteeringMirror::checkError(ErrorCode errorCode)
-{
-    if (errorCode >= 0xE0000000 && errorCode != Success) {
-        QString errorMessage = QString("Error Code: 0x%1").arg(
-            QString::number(errorCode, 16).right(8).toUpper());
-
-        m_lastError = errorMessage;
-        qDebug() << "Device error:" << errorMessage;
-        emit deviceError(errorMessage);
-    }
-}
-
 double FastSteeringMirror::positionToVoltage(double position) const
 {
     // Map position (-1.0 to 1.0) to voltage range
@@ -3,15 +3,36 @@
 
 #include <QObject>
 #include <QString>
-#include "bdaqctrl.h"
-
-using namespace Automation::BDaq;
+#include <QVector>
+#include <atomic>
+#include "aobackend.h"
+#include "aostream.h"
+#include "aistream.h"
+#include "latencyhistogram.h"
+
+// X/Y sine pattern for cyclic output. Y leads X by phaseOffset degrees.
+struct PeriodicWaveform {
+    double frequency;    // Hz
+    double amplitude;    // Normalized, 0.0 to 1.0
+    double phaseOffset;  // Degrees
+    bool xEnabled;
+    bool yEnabled;
+};
 
 class FastSteeringMirror : public QObject
 {
     Q_OBJECT
 
 public:
+    // Device lifecycle. Only openDevice/closeDevice and the driver's error
+    // callbacks change it, so checking it costs a single atomic load.
+    enum class DeviceState {
+        Closed,
+        Opening,
+        Open,
+        Faulted
+    };
+
     explicit FastSteeringMirror(QObject *parent = nullptr);
     ~FastSteeringMirror();
 
@@ -19,6 +40,12 @@ public:
     bool initialize();
     void cleanup();
 
+    // Output backend. Switching closes the current device; the new backend
+    // is initialized right away if the mirror already is.
+    bool setBackendType(AoBackend::Type type);
+    AoBackend::Type backendType() const { return m_backendType; }
+    AoBackend *backend() const { return m_backend; }
+
     // Get available devices
     QStringList getAvailableDevices() const;
 
@@ -26,13 +53,53 @@ public:
     bool openDevice(const QString &deviceName);
     void closeDevice();
     bool isDeviceOpen() const;
+    DeviceState deviceState() const;
 
     // Set mirror position (-1.0 to 1.0 range for each axis)
     bool setPosition(double xPosition, double yPosition);
 
+    // Output-thread hot path: same as setPosition but without signals or
+    // error strings. Safe to call from one thread other than the mirror's
+    // while nothing else writes to the device.
+    bool writePosition(double xPosition, double yPosition);
+
     // Get current output voltage values
     QPair<double, double> getCurrentVoltages() const;
 
+    // Hardware-clocked streaming output. Positions are queued in blocks and
+    // clocked out by the card's ConvertClock (or the simulated stand-in).
+    bool startStreaming(double sampleRate, int bufferFrames = 4096);
+    void stopStreaming();
+    bool isStreaming() const;
+    int queueSamples(const double *xPositions, const double *yPositions, int count);
+    int streamFreeSamples() const;
+    AoStream *stream() const { return m_stream; }
+
+    // Acquire the position sensors (AI0/AI1) alongside streaming output.
+    // Takes effect at the next startStreaming; the AI clock is started
+    // right before the AO device so both count frames from the same tick.
+    // Streaming still runs without feedback when the backend has no AI.
+    void setFeedbackEnabled(bool enabled);
+    bool feedbackEnabled() const { return m_feedbackEnabled; }
+    AiStream *feedbackStream() const { return m_feedbackStream; }
+
+    // Periodic output: an integer number of periods is synthesized once and
+    // played in a loop. Nothing is synthesized per sample, but the host still
+    // copies the pattern into the device buffer on every refill (see
+    // AoStream::startCyclic()).
+    // Updates take effect at the next period boundary and crossfade from the
+    // old pattern over a few periods, slowly enough that no step exceeds the
+    // slew of the steeper of the two sines.
+    bool startPeriodicWaveform(const PeriodicWaveform &waveform, double sampleRate);
+    bool updatePeriodicWaveform(const PeriodicWaveform &waveform);
+
+    // Frequency actually produced, after rounding the pattern to whole
+    // samples. A staged update counts once the stream has swapped it in.
+    double periodicFrequency() const;
+
+    // Frequency of the latest pattern, whether it is playing yet or not
+    double stagedPeriodicFrequency() const { return m_stagedFrequency; }
+
     // Configure voltage range
     bool setVoltageRange(double minVoltage, double maxVoltage);
 
@@ -43,24 +110,64 @@ public:
     // Error handling
     QString getLastError() const;
 
+    // Convert normalized position (-1.0 to 1.0) to voltage
+    double positionToVoltage(double position) const;
+
+    // Duration of each single-point backend write, recorded while enabled
+    void setInstrumentationEnabled(bool enabled);
+    bool instrumentationEnabled() const;
+    LatencyHistogram &writeHistogram() { return m_writeHistogram; }
+
 signals:
     void positionChanged(double xPosition, double yPosition);
     void deviceError(const QString &errorMessage);
 
 private:
-    InstantAoCtrl *m_aoCtrl;
+    AoBackend *m_backend;
+    AoBackend::Type m_backendType;
     bool m_initialized;
+    std::atomic<DeviceState> m_deviceState;
     QString m_lastError;
     double m_minVoltage;
     double m_maxVoltage;
-    double m_currentVoltages[2];
+    std::atomic<double> m_currentVoltages[2];
     QString m_profilePath;
-
-    // Error handling helper
-    void checkError(ErrorCode errorCode);
-
-    // Convert normalized position (-1.0 to 1.0) to voltage
-    double positionToVoltage(double position) const;
+    QString m_deviceName;
+
+    // Write timing
+    std::atomic<bool> m_instrumentationEnabled;
+    LatencyHistogram m_writeHistogram;
+
+    // Streaming output
+    AoStream *m_stream;
+    std::atomic<bool> m_streamActive;
+    QVector<double> m_streamScratch;
+
+    // Feedback acquisition
+    bool m_feedbackEnabled;
+    AiStream *m_feedbackStream;
+
+    // Periodic output
+    PeriodicWaveform m_periodicWaveform;    // Latest staged
+    QVector<double> m_periodTable;
+    double m_periodicFrequency;             // Playing before the staged pattern
+    double m_stagedFrequency;
+    quint64 m_stagedSwapIndex;
+
+    // Largest amplitude * frequency and amplitude of the patterns staged
+    // since the stream last settled, any of which may still be playing
+    double m_slopeEnvelope;
+    double m_amplitudeEnvelope;
+
+    int synthesizePeriod(const PeriodicWaveform &waveform, double sampleRate, double *frequency);
+    int stagePatternEnvelope(const PeriodicWaveform &next, bool reset);
+
+    bool timedWrite(const double voltages[2]);
+
+    // Device lifecycle helpers
+    void setDeviceState(DeviceState state);
+    void enterFaultedState(const QString &reason);
+    void onBackendDeviceRemoved();
 };
 
 #endif // FASTSTEERINGMIRROR_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "feedbackaligner.h"
+
+FeedbackAligner::FeedbackAligner(int historyFrames)
+    : m_history(qMax(1, historyFrames))
+    , m_sampleRate(1.0)
+    , m_startSessionNs(0)
+    , m_delayFrames(0)
+    , m_lostFrom(-1)
+    , m_matched(0)
+    , m_unmatched(0)
+    , m_unaligned(0)
+{
+    reset(1.0);
+}
+
+void FeedbackAligner::reset(double sampleRate, qint64 startSessionNs)
+{
+    for (Command &command : m_history) {
+        command.index = -1;
+    }
+    m_sampleRate = sampleRate > 0.0 ? sampleRate : 1.0;
+    m_startSessionNs = startSessionNs;
+    m_lostFrom = -1;
+    m_matched = 0;
+    m_unmatched = 0;
+    m_unaligned = 0;
+}
+
+void FeedbackAligner::setAlignmentLost(qint64 firstIndex)
+{
+    if (m_lostFrom < 0 || firstIndex < m_lostFrom) {
+        m_lostFrom = qMax<qint64>(0, firstIndex);
+    }
+}
+
+void FeedbackAligner::setDelayFrames(int frames)
+{
+    m_delayFrames = qMax(0, frames);
+}
+
+void FeedbackAligner::addCommands(qint64 firstIndex, const double *x, const double *y, int count,
+                                  double frequency, double amplitude)
+{
+    const int size = m_history.size();
+    for (int i = 0; i < count; ++i) {
+        qint64 index = firstIndex + i;
+        Command &command = m_history[static_cast<int>(index % size)];
+        command.index = index;
+        command.x = x[i];
+        command.y = y[i];
+        command.frequency = frequency;
+        command.amplitude = amplitude;
+    }
+}
+
+int FeedbackAligner::align(qint64 firstIndex, const double *feedback, int count,
+                           QVector<LogRecord> *records)
+{
+    const int size = m_history.size();
+    int appended = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (m_lostFrom >= 0 && firstIndex + i >= m_lostFrom) {
+            ++m_unaligned;
+            continue;
+        }
+
+        qint64 commandIndex = firstIndex + i - m_delayFrames;
+        if (commandIndex < 0) {
+            // Acquired before the first command reached the sensor
+            ++m_unmatched;
+            continue;
+        }
+
+        const Command &command = m_history[static_cast<int>(commandIndex % size)];
+        if (command.index != commandIndex) {
+            ++m_unmatched;
+            continue;
+        }
+
+        LogRecord record;
+        record.sampleIndex = commandIndex;
+        record.elapsedTime = static_cast<qint64>(commandIndex * 1.0e9 / m_sampleRate);
+        record.sessionTime = m_startSessionNs + record.elapsedTime;
+        record.frequency = command.frequency;
+        record.amplitude = command.amplitude;
+        record.xCommand = command.x;
+        record.yCommand = command.y;
+        record.xFeedback = feedback[2 * i];
+        record.yFeedback = feedback[2 * i + 1];
+        records->append(record);
+        ++appended;
+    }
+
+    m_matched += appended;
+    return appended;
+}
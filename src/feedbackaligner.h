@@ -0,0 +1,67 @@
+#ifndef FEEDBACKALIGNER_H
+#define FEEDBACKALIGNER_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "logrecord.h"
+
+// Pairs acquired sensor frames with the commands that produced them.
+//
+// Commands are remembered by their frame index on the AO clock. The AI
+// stream counts frames on a clock of the same rate started at the same
+// tick, so feedback frame i answers command i - delayFrames, where the delay
+// covers the converter pipeline and the mirror's own response. Commands
+// older than the history window, or feedback for commands never recorded,
+// are counted as unmatched instead of being paired with the wrong sample.
+// Once the acquisition has lost samples its indices are off by an unknown
+// amount, so feedback from that frame on is counted as unaligned and never
+// paired until the next reset().
+class FeedbackAligner
+{
+public:
+    explicit FeedbackAligner(int historyFrames = 65536);
+
+    // Forget all commands and counters; sampleRate sets the log timestamps
+    // and startSessionNs is the session time of frame 0
+    void reset(double sampleRate, qint64 startSessionNs = 0);
+
+    void setDelayFrames(int frames);
+    int delayFrames() const { return m_delayFrames; }
+
+    // Record count commanded positions starting at frame firstIndex
+    void addCommands(qint64 firstIndex, const double *x, const double *y, int count,
+                     double frequency, double amplitude);
+
+    // Pair count interleaved X/Y feedback frames starting at frame
+    // firstIndex with their commands and append the matches to records.
+    // Returns the number of records appended.
+    int align(qint64 firstIndex, const double *feedback, int count, QVector<LogRecord> *records);
+
+    // Stop pairing feedback from frame firstIndex on, see AiStream::alignmentLostAt()
+    void setAlignmentLost(qint64 firstIndex);
+    bool alignmentLost() const { return m_lostFrom >= 0; }
+
+    quint64 matchedCount() const { return m_matched; }
+    quint64 unmatchedCount() const { return m_unmatched; }
+    quint64 unalignedCount() const { return m_unaligned; }
+
+private:
+    struct Command {
+        qint64 index;  // -1 while the slot is empty
+        double x;
+        double y;
+        double frequency;
+        double amplitude;
+    };
+
+    QVector<Command> m_history;
+    double m_sampleRate;
+    qint64 m_startSessionNs;
+    int m_delayFrames;
+    qint64 m_lostFrom;      // -1 while aligned
+    quint64 m_matched;
+    quint64 m_unmatched;
+    quint64 m_unaligned;
+};
+
+#endif // FEEDBACKALIGNER_H
@@ -0,0 +1,144 @@
+#include "fft.h"
+#include <QtMath>
+#include <cmath>
+#include <utility>
+
+Fft::Fft(int size)
+    : m_size(0)
+{
+    if (size > 0) {
+        setSize(size);
+    }
+}
+
+bool Fft::setSize(int size)
+{
+    if (size < 4 || !isPowerOfTwo(size)) {
+        return false;
+    }
+    if (size == m_size) {
+        return true;
+    }
+
+    m_size = size;
+    const int half = size / 2;
+    m_cos.resize(half);
+    m_sin.resize(half);
+    for (int k = 0; k < half; ++k) {
+        const double angle = 2.0 * M_PI * k / size;
+        m_cos[k] = std::cos(angle);
+        m_sin[k] = std::sin(angle);
+    }
+
+    m_re.resize(half);
+    m_im.resize(half);
+    m_workRe.resize(half);
+    m_workIm.resize(half);
+    return true;
+}
+
+void Fft::complexForward(const double **re, const double **im)
+{
+    double *xr = m_re.data();
+    double *xi = m_im.data();
+    double *yr = m_workRe.data();
+    double *yi = m_workIm.data();
+    const double *cosTable = m_cos.constData();
+    const double *sinTable = m_sin.constData();
+
+    // Each pass splits length-n sub-transforms, interleaved with stride s,
+    // into two of length n/2; the twiddle W_n^p is W_N^(2ps)
+    int n = m_size / 2;
+    int s = 1;
+    while (n > 1) {
+        const int m = n / 2;
+        if (s == 1) {
+            for (int p = 0; p < m; ++p) {
+                const double wr = cosTable[2 * p];
+                const double wi = sinTable[2 * p];
+                const double ar = xr[p];
+                const double ai = xi[p];
+                const double br = xr[p + m];
+                const double bi = xi[p + m];
+                const double dr = ar - br;
+                const double di = ai - bi;
+                yr[2 * p] = ar + br;
+                yi[2 * p] = ai + bi;
+                yr[2 * p + 1] = dr * wr + di * wi;
+                yi[2 * p + 1] = di * wr - dr * wi;
+            }
+        } else {
+            for (int p = 0; p < m; ++p) {
+                const double wr = cosTable[2 * p * s];
+                const double wi = sinTable[2 * p * s];
+                const double *ar = xr + s * p;
+                const double *ai = xi + s * p;
+                const double *br = xr + s * (p + m);
+                const double *bi = xi + s * (p + m);
+                double *sumR = yr + s * 2 * p;
+                double *sumI = yi + s * 2 * p;
+                double *diffR = sumR + s;
+                double *diffI = sumI + s;
+                for (int q = 0; q < s; ++q) {
+                    const double dr = ar[q] - br[q];
+                    const double di = ai[q] - bi[q];
+                    sumR[q] = ar[q] + br[q];
+                    sumI[q] = ai[q] + bi[q];
+                    diffR[q] = dr * wr + di * wi;
+                    diffI[q] = di * wr - dr * wi;
+                }
+            }
+        }
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+        n = m;
+        s *= 2;
+    }
+
+    *re = xr;
+    *im = xi;
+}
+
+void Fft::forward(const double *input, double *re, double *im)
+{
+    const int half = m_size / 2;
+    if (half == 0) {
+        return;
+    }
+
+    // Even samples as real part, odd as imaginary
+    double *packedRe = m_re.data();
+    double *packedIm = m_im.data();
+    for (int i = 0; i < half; ++i) {
+        packedRe[i] = input[2 * i];
+        packedIm[i] = input[2 * i + 1];
+    }
+
+    const double *zr = nullptr;
+    const double *zi = nullptr;
+    complexForward(&zr, &zi);
+
+    const double *cosTable = m_cos.constData();
+    const double *sinTable = m_sin.constData();
+
+    // Separate the even and odd spectra and combine them:
+    // X[k] = E[k] + W_N^k O[k]
+    re[0] = zr[0] + zi[0];
+    im[0] = 0.0;
+    re[half] = zr[0] - zi[0];
+    im[half] = 0.0;
+    for (int k = 1; k < half; ++k) {
+        const double ar = zr[k];
+        const double ai = zi[k];
+        const double br = zr[half - k];
+        const double bi = -zi[half - k];
+        const double evenR = 0.5 * (ar + br);
+        const double evenI = 0.5 * (ai + bi);
+        const double oddR = 0.5 * (ai - bi);
+        const double oddI = -0.5 * (ar - br);
+        const double wr = cosTable[k];
+        const double wi = sinTable[k];
+        re[k] = evenR + wr * oddR + wi * oddI;
+        im[k] = evenI + wr * oddI - wi * oddR;
+    }
+}
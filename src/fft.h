@@ -0,0 +1,46 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <QVector>
+
+// Forward FFT of real signals, power-of-two sizes.
+//
+// A real transform of size N runs as a complex transform of N/2 points on
+// the even/odd samples packed as re/im, followed by a split pass. The
+// complex transform is a radix-2 Stockham autosort: no bit reversal, data
+// in separate re/im arrays, and every pass after the first two walks
+// contiguous memory with one twiddle per inner loop, so the butterflies
+// vectorize. Twiddles are computed directly for every index, not by
+// recurrence, so precision does not fall off with size.
+//
+// setSize() allocates; forward() does not.
+class Fft
+{
+public:
+    explicit Fft(int size = 0);
+
+    // Power of two, 4 or more; returns false and keeps the old size otherwise
+    bool setSize(int size);
+    int size() const { return m_size; }
+    int binCount() const { return m_size / 2 + 1; }
+
+    // size() inputs to binCount() bins, unscaled (a sine of amplitude A
+    // on bin k reads back with magnitude A N/2)
+    void forward(const double *input, double *re, double *im);
+
+    static bool isPowerOfTwo(int value) { return value > 0 && (value & (value - 1)) == 0; }
+
+private:
+    int m_size;
+    QVector<double> m_cos;  // W_N^k = cos - i sin, k < N/2
+    QVector<double> m_sin;
+    QVector<double> m_re;   // Two N/2 point ping-pong buffers
+    QVector<double> m_im;
+    QVector<double> m_workRe;
+    QVector<double> m_workIm;
+
+    // Transforms N/2 points in m_re/m_im; returns the buffers holding the result
+    void complexForward(const double **re, const double **im);
+};
+
+#endif // FFT_H
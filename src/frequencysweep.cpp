@@ -0,0 +1,277 @@
+#include "frequencysweep.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QVector<double> SweepSettings::frequencyList(double start, double stop, int points, bool logarithmic)
+{
+    QVector<double> frequencies;
+    if (points <= 0 || start <= 0.0 || stop <= 0.0) {
+        return frequencies;
+    }
+    if (points == 1) {
+        frequencies.append(start);
+        return frequencies;
+    }
+
+    for (int i = 0; i < points; ++i) {
+        double t = static_cast<double>(i) / (points - 1);
+        frequencies.append(logarithmic ? start * std::pow(stop / start, t)
+                                       : start + (stop - start) * t);
+    }
+    return frequencies;
+}
+
+FrequencySweep::FrequencySweep()
+    : m_sampleRate(0.0)
+    , m_totalFrames(0)
+    , m_generator(nullptr)
+    , m_generatePoint(0)
+    , m_generated(0)
+    , m_analyzePoint(0)
+    , m_nextIndex(0)
+    , m_complete(false)
+{
+}
+
+FrequencySweep::~FrequencySweep()
+{
+    stop();
+}
+
+bool FrequencySweep::start(const SweepSettings &settings, double sampleRate)
+{
+    stop();
+
+    if (sampleRate <= 0.0 || settings.frequencies.isEmpty()) {
+        m_lastError = "No frequencies to sweep";
+        return false;
+    }
+
+    m_settings = settings;
+    std::sort(m_settings.frequencies.begin(), m_settings.frequencies.end());
+    for (double frequency : m_settings.frequencies) {
+        if (frequency <= 0.0 || frequency >= 0.45 * sampleRate) {
+            m_lastError = QString("%1 Hz is outside the usable range at %2 S/s")
+                              .arg(frequency).arg(sampleRate);
+            return false;
+        }
+    }
+    m_sampleRate = sampleRate;
+
+    // Lay out the sweep in output frames
+    const int count = m_settings.frequencies.size();
+    m_points.resize(count);
+    m_dfts.resize(count);
+    qint64 position = 0;
+    const qint64 chirpFrames = qMax<qint64>(1, qRound64(m_settings.chirpSeconds * sampleRate));
+
+    for (int i = 0; i < count; ++i) {
+        const double frequency = m_settings.frequencies[i];
+        Point &point = m_points[i];
+        point.frequency = frequency;
+
+        if (m_settings.mode == SweepSettings::SteppedSine) {
+            // A whole number of cycles in the window keeps the other
+            // harmonics out of the bin
+            const double framesPerCycle = sampleRate / frequency;
+            qint64 settle = qMax(qCeil(m_settings.settleCycles * framesPerCycle),
+                                 qCeil(m_settings.settleSeconds * sampleRate));
+            qint64 measure = qMax<qint64>(1, qRound64(qMax(1, m_settings.measureCycles) * framesPerCycle));
+            point.start = position;
+            point.measureStart = position + settle;
+            point.end = point.measureStart + measure;
+            position = point.end;
+        } else {
+            point.start = 0;
+            point.measureStart = 0;
+            point.end = chirpFrames;
+            position = chirpFrames;
+        }
+
+        m_dfts[i].configure(frequency, sampleRate, 4);
+    }
+    m_totalFrames = position;
+
+    WaveformSettings waveform;
+    waveform.amplitude = m_settings.amplitude;
+    waveform.phaseOffset = m_settings.phaseOffset;
+    waveform.xEnabled = m_settings.xEnabled;
+    waveform.yEnabled = m_settings.yEnabled;
+    waveform.frequency = m_settings.frequencies.first();
+    if (m_settings.mode == SweepSettings::Chirp) {
+        waveform.shape = WaveformShape::Chirp;
+        waveform.endFrequency = m_settings.frequencies.last();
+        waveform.sweepSeconds = m_settings.chirpSeconds;
+    } else {
+        waveform.shape = WaveformShape::Sine;
+    }
+    m_generator = WaveformGenerator::create(waveform, sampleRate);
+
+    m_results.clear();
+    m_results.reserve(count);
+    m_generatePoint = 0;
+    m_generated = 0;
+    m_analyzePoint = 0;
+    m_nextIndex = 0;
+    m_complete = false;
+    return true;
+}
+
+void FrequencySweep::stop()
+{
+    delete m_generator;
+    m_generator = nullptr;
+}
+
+void FrequencySweep::generate(double *x, double *y, int count)
+{
+    int done = 0;
+    while (done < count) {
+        if (!m_generator || m_generated >= m_totalFrames) {
+            std::fill(x + done, x + count, 0.0);
+            std::fill(y + done, y + count, 0.0);
+            m_generated += count - done;
+            return;
+        }
+
+        const Point &point = m_points[m_generatePoint];
+        const qint64 segmentEnd = (m_settings.mode == SweepSettings::SteppedSine) ? point.end
+                                                                                : m_totalFrames;
+        const int n = static_cast<int>(qMin<qint64>(count - done, segmentEnd - m_generated));
+        m_generator->generate(x + done, y + done, n);
+        done += n;
+        m_generated += n;
+
+        // Step to the next frequency without a phase jump
+        if (m_generated == segmentEnd && m_settings.mode == SweepSettings::SteppedSine
+            && m_generatePoint + 1 < m_points.size()) {
+            ++m_generatePoint;
+            WaveformSettings waveform = m_generator->settings();
+            waveform.frequency = m_points[m_generatePoint].frequency;
+            m_generator->configure(waveform);
+        }
+    }
+}
+
+double FrequencySweep::currentFrequency() const
+{
+    if (m_points.isEmpty()) {
+        return 0.0;
+    }
+    if (m_settings.mode == SweepSettings::Chirp) {
+        double t = qBound(0.0, static_cast<double>(m_generated) / m_totalFrames, 1.0);
+        return m_points.first().frequency + (m_points.last().frequency - m_points.first().frequency) * t;
+    }
+    return m_points[m_generatePoint].frequency;
+}
+
+void FrequencySweep::analyze(qint64 index, const double command[2], const double feedback[2])
+{
+    if (m_complete || index < m_nextIndex) {
+        return;
+    }
+
+    const double samples[4] = {command[0], command[1], feedback[0], feedback[1]};
+    const int count = m_points.size();
+
+    if (m_settings.mode == SweepSettings::Chirp) {
+        // Every point integrates across the whole chirp
+        if (index < m_totalFrames) {
+            const qint64 gap = index - m_nextIndex;
+            for (SingleBinDft &dft : m_dfts) {
+                if (gap > 0) {
+                    dft.skip(gap);
+                }
+                dft.add(samples);
+            }
+            m_nextIndex = index + 1;
+        }
+        if (index >= m_totalFrames - 1) {
+            for (int i = 0; i < count; ++i) {
+                finishPoint(i);
+            }
+            m_analyzePoint = count;
+            m_complete = true;
+        }
+        return;
+    }
+
+    // Close every point whose window has gone by
+    while (m_analyzePoint < count && index >= m_points[m_analyzePoint].end) {
+        finishPoint(m_analyzePoint++);
+    }
+    if (m_analyzePoint == count) {
+        m_complete = true;
+        return;
+    }
+
+    const Point &point = m_points[m_analyzePoint];
+    if (index >= point.measureStart) {
+        // Missing frames still move the reference on
+        SingleBinDft &dft = m_dfts[m_analyzePoint];
+        const qint64 gap = index - qMax(m_nextIndex, point.measureStart);
+        if (gap > 0) {
+            dft.skip(gap);
+        }
+        dft.add(samples);
+    }
+    m_nextIndex = index + 1;
+
+    if (index == point.end - 1) {
+        finishPoint(m_analyzePoint++);
+        m_complete = m_analyzePoint == count;
+    }
+}
+
+bool FrequencySweep::isComplete() const
+{
+    return m_complete;
+}
+
+void FrequencySweep::finishPoint(int point)
+{
+    const SingleBinDft &dft = m_dfts[point];
+    const bool enabled[2] = {m_settings.xEnabled, m_settings.yEnabled};
+
+    BodePoint result;
+    result.frequency = m_points[point].frequency;
+    result.samples = dft.count();
+
+    for (int axis = 0; axis < 2; ++axis) {
+        const std::complex<double> command = dft.bin(axis);
+        const std::complex<double> feedback = dft.bin(2 + axis);
+        result.commandAmplitude[axis] = std::abs(command);
+        result.feedbackAmplitude[axis] = std::abs(feedback);
+
+        if (enabled[axis] && std::abs(command) > 1e-9) {
+            const std::complex<double> response = feedback / command;
+            result.gain[axis] = std::abs(response);
+            result.phaseDeg[axis] = qRadiansToDegrees(std::arg(response));
+        } else {
+            result.gain[axis] = std::numeric_limits<double>::quiet_NaN();
+            result.phaseDeg[axis] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    m_results.append(result);
+}
+
+void FrequencySweep::writeTable(QTextStream &out) const
+{
+    out << "Frequency(Hz),X-Gain,X-Gain(dB),X-Phase(deg),Y-Gain,Y-Gain(dB),Y-Phase(deg),Samples\n";
+    for (const BodePoint &point : m_results) {
+        out << QString::number(point.frequency, 'g', 8);
+        for (int axis = 0; axis < 2; ++axis) {
+            if (std::isnan(point.gain[axis])) {
+                out << ",,,";
+                continue;
+            }
+            out << "," << QString::number(point.gain[axis], 'g', 6)
+                << "," << QString::number(20.0 * std::log10(point.gain[axis]), 'f', 3)
+                << "," << QString::number(point.phaseDeg[axis], 'f', 2);
+        }
+        out << "," << point.samples << "\n";
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef FREQUENCYSWEEP_H
+#define FREQUENCYSWEEP_H
+
+#include <QString>
+#include <QVector>
+#include <QTextStream>
+#include "waveformgenerator.h"
+#include "singlebindft.h"
+
+struct SweepSettings {
+    enum Mode {
+        SteppedSine,  // Settle, then measure a whole number of cycles per point
+        Chirp         // One linear chirp, every point measured across all of it
+    };
+
+    Mode mode;
+    QVector<double> frequencies;  // Hz, analysed in ascending order
+    double amplitude;             // Normalized command amplitude
+    double phaseOffset;           // Degrees, Y leads X
+    bool xEnabled;
+    bool yEnabled;
+    double settleCycles;          // Stepped: cycles discarded after each step
+    double settleSeconds;         // Stepped: minimum settle time
+    int measureCycles;            // Stepped: cycles integrated per point
+    double chirpSeconds;          // Chirp: sweep duration
+
+    SweepSettings()
+        : mode(SteppedSine)
+        , amplitude(0.2)
+        , phaseOffset(0.0)
+        , xEnabled(true)
+        , yEnabled(true)
+        , settleCycles(5.0)
+        , settleSeconds(0.05)
+        , measureCycles(20)
+        , chirpSeconds(20.0)
+    {
+    }
+
+    // Points from start to stop, logarithmically or linearly spaced
+    static QVector<double> frequencyList(double start, double stop, int points, bool logarithmic);
+};
+
+// Response of both axes at one frequency, feedback relative to command
+struct BodePoint {
+    double frequency;
+    double gain[2];         // NaN for an axis that was not driven
+    double phaseDeg[2];
+    double commandAmplitude[2];
+    double feedbackAmplitude[2];
+    qint64 samples;
+};
+
+// Drives a frequency-response measurement and reduces it on line.
+//
+// The whole sweep is laid out in output frames before it starts, so the
+// generating side (filling the AO stream) and the analysing side (aligned
+// command/feedback frames, arriving later and possibly with gaps) agree on
+// which frame belongs to which point purely by sample index. Analysis keeps
+// one SingleBinDft per point; only the Bode table is retained.
+class FrequencySweep
+{
+public:
+    FrequencySweep();
+    ~FrequencySweep();
+
+    bool start(const SweepSettings &settings, double sampleRate);
+    void stop();
+    bool isRunning() const { return m_generator != nullptr; }
+    const SweepSettings &settings() const { return m_settings; }
+
+    // Generating side: the next count frames of command, in sequence. After
+    // the last point the command rests at zero.
+    void generate(double *x, double *y, int count);
+    double currentFrequency() const;
+    qint64 totalFrames() const { return m_totalFrames; }
+    qint64 generatedFrames() const { return m_generated; }
+
+    // Analysing side: one aligned frame, command and feedback in the same
+    // units (volts). Frames must arrive in increasing index order.
+    void analyze(qint64 index, const double command[2], const double feedback[2]);
+
+    bool isComplete() const;
+    int pointCount() const { return m_points.size(); }
+    const QVector<BodePoint> &results() const { return m_results; }
+
+    void writeTable(QTextStream &out) const;
+    QString getLastError() const { return m_lastError; }
+
+private:
+    struct Point {
+        double frequency;
+        qint64 start;         // First frame commanded at this frequency
+        qint64 measureStart;  // First frame integrated
+        qint64 end;           // One past the last frame
+    };
+
+    SweepSettings m_settings;
+    double m_sampleRate;
+    QVector<Point> m_points;
+    QVector<SingleBinDft> m_dfts;  // One per point
+    QVector<BodePoint> m_results;
+    qint64 m_totalFrames;
+
+    // Generating side
+    WaveformGenerator *m_generator;
+    int m_generatePoint;
+    qint64 m_generated;
+
+    // Analysing side
+    int m_analyzePoint;
+    qint64 m_nextIndex;
+    bool m_complete;
+
+    QString m_lastError;
+
+    void finishPoint(int point);
+};
+
+#endif // FREQUENCYSWEEP_H
@@ -0,0 +1,115 @@
+#ifndef HISTORYRING_H
+#define HISTORYRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// Fixed-capacity time-series history between one producer and any number
+// of readers.
+//
+// Values are addressed by their absolute index (0 for the first value ever
+// written), so every reader keeps its own cursor and the producer never
+// waits for anyone: old values are simply overwritten. Readers look at the
+// storage in place through segments() and then call isIntact() to find out
+// whether the producer lapped them while they were looking; the newest
+// readable() values are always safe to read, the rest of the ring (the
+// guard) is where the producer may be writing.
+//
+// Single producer only. The producer and reader state live on separate
+// cache lines, and the storage is cache-line aligned.
+template<typename T>
+class HistoryRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "HistoryRing stores plain values");
+
+public:
+    // Capacity is 2^capacityLog2 values; an eighth of it is the guard
+    explicit HistoryRing(int capacityLog2)
+        : m_capacity(quint64(1) << qBound(4, capacityLog2, 30))
+        , m_mask(m_capacity - 1)
+        , m_guard(m_capacity / 8)
+        , m_data(static_cast<T *>(::operator new[](m_capacity * sizeof(T), std::align_val_t(64))))
+        , m_written(0)
+    {
+    }
+
+    ~HistoryRing()
+    {
+        ::operator delete[](m_data, std::align_val_t(64));
+    }
+
+    HistoryRing(const HistoryRing &) = delete;
+    HistoryRing &operator=(const HistoryRing &) = delete;
+
+    quint64 capacity() const { return m_capacity; }
+    quint64 readable() const { return m_capacity - m_guard; }
+
+    // Producer side
+    void push(const T &value)
+    {
+        const quint64 written = m_written.load(std::memory_order_relaxed);
+        m_data[written & m_mask] = value;
+        m_written.store(written + 1, std::memory_order_release);
+    }
+
+    void write(const T *values, int count)
+    {
+        // Published in guard-sized steps, so unpublished values never reach
+        // into the readable part of the ring
+        while (count > 0) {
+            const int chunk = static_cast<int>(qMin<quint64>(count, m_guard));
+            const quint64 written = m_written.load(std::memory_order_relaxed);
+            const quint64 offset = written & m_mask;
+            const quint64 first = qMin<quint64>(chunk, m_capacity - offset);
+            std::memcpy(m_data + offset, values, first * sizeof(T));
+            std::memcpy(m_data, values + first, (chunk - first) * sizeof(T));
+            m_written.store(written + chunk, std::memory_order_release);
+            values += chunk;
+            count -= chunk;
+        }
+    }
+
+    // Reader side: values written so far, and the oldest one still readable
+    quint64 written() const { return m_written.load(std::memory_order_acquire); }
+    quint64 oldest(quint64 written) const { return written > readable() ? written - readable() : 0; }
+
+    // In-place view of count values from index first: at most two spans,
+    // the second one empty unless the range wraps
+    void segments(quint64 first, int count, const T **a, int *countA, const T **b, int *countB) const
+    {
+        const quint64 offset = first & m_mask;
+        const int head = static_cast<int>(qMin<quint64>(count, m_capacity - offset));
+        *a = m_data + offset;
+        *countA = head;
+        *b = m_data;
+        *countB = count - head;
+    }
+
+    // Whether values from index first on were left alone while they were
+    // being read; call after reading
+    bool isIntact(quint64 first) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return m_written.load(std::memory_order_relaxed) <= first + readable();
+    }
+
+private:
+    const quint64 m_capacity;
+    const quint64 m_mask;
+    const quint64 m_guard;
+    T *const m_data;
+
+    // Alone on its cache line (alignas also pads the class to a full line)
+    alignas(64) std::atomic<quint64> m_written;
+};
+
+// X/Y position pair as kept in display history
+struct PositionSample {
+    float x;
+    float y;
+};
+
+#endif // HISTORYRING_H
@@ -1,4 +1,5 @@
 #include "joystickmanager.h"
+#include "tracelog.h"
 #include <QDebug>
 
 JoystickManager::JoystickManager(QObject *parent)
@@ -6,6 +7,12 @@ JoystickManager::JoystickManager(QObject *parent)
     , m_pollTimer(new QTimer(this))
     , m_currentJoystick(nullptr)
     , m_sdlInitialized(false)
+    , m_setpointMailbox(nullptr)
+    , m_xAxis(0)
+    , m_yAxis(1)
+    , m_invertX(false)
+    , m_invertY(false)
+    , m_deadzone(0.05)  // 5% deadzone
 {
     m_pollTimer->setInterval(16); // ~60Hz polling
     connect(m_pollTimer, &QTimer::timeout, this, &JoystickManager::pollEvents);
@@ -95,6 +102,8 @@ void JoystickManager::closeJoystick()
     
     // Clear calibration data
     m_axisCalibration.clear();
+    m_axisValues.clear();
+    publishSetpoint();
 }
 
 bool JoystickManager::isJoystickOpen() const
@@ -153,14 +162,90 @@ void JoystickManager::calibrateAxes()
         cal.calibrated = true;
         m_axisCalibration.append(cal);
         
-        qDebug() << "Calibrated axis" << i << "center:" << cal.center;
+        JTM_DEBUG(TraceLog::Joystick, "Calibrated axis %d center: %d", i, cal.center);
     }
+
+    // Every axis now reads as centered
+    m_axisValues.fill(0, numAxes);
+    publishSetpoint();
+}
+
+void JoystickManager::setSetpointMailbox(SetpointMailbox *mailbox)
+{
+    m_setpointMailbox = mailbox;
+    publishSetpoint();
+}
+
+void JoystickManager::setAxisMapping(int xAxis, int yAxis)
+{
+    m_xAxis = xAxis;
+    m_yAxis = yAxis;
+    publishSetpoint();
+}
+
+void JoystickManager::setAxisInversion(bool invertX, bool invertY)
+{
+    m_invertX = invertX;
+    m_invertY = invertY;
+    publishSetpoint();
+}
+
+void JoystickManager::setDeadzone(double deadzone)
+{
+    m_deadzone = deadzone;
+    publishSetpoint();
+}
+
+double JoystickManager::mapAxisToPosition(int axisValue) const
+{
+    // Convert joystick axis value (-32768 to 32767) to position (-1.0 to 1.0)
+    double normalizedValue = axisValue / 32768.0;
+
+    // Apply deadzone
+    if (qAbs(normalizedValue) < m_deadzone) {
+        return 0.0;
+    }
+
+    // Rescale the remaining range to still use the full -1 to 1 output range
+    if (normalizedValue > 0) {
+        normalizedValue = (normalizedValue - m_deadzone) / (1.0 - m_deadzone);
+    } else {
+        normalizedValue = (normalizedValue + m_deadzone) / (1.0 - m_deadzone);
+    }
+
+    return qBound(-1.0, normalizedValue, 1.0);
+}
+
+void JoystickManager::publishSetpoint()
+{
+    if (!m_setpointMailbox) {
+        return;
+    }
+
+    // Unmapped axes and a closed joystick both read as center
+    double xPosition = 0.0;
+    double yPosition = 0.0;
+    if (m_xAxis >= 0 && m_xAxis < m_axisValues.size()) {
+        xPosition = mapAxisToPosition(m_axisValues[m_xAxis]);
+    }
+    if (m_yAxis >= 0 && m_yAxis < m_axisValues.size()) {
+        yPosition = mapAxisToPosition(m_axisValues[m_yAxis]);
+    }
+
+    // Apply inversion if needed
+    if (m_invertX) xPosition = -xPosition;
+    if (m_invertY) yPosition = -yPosition;
+
+    m_setpointMailbox->publish(xPosition, yPosition);
 }
 
 void JoystickManager::pollEvents()
 {
     if (!m_sdlInitialized) return;
     
+    // Publish once per poll, after the queued motion has been applied
+    bool mappedAxisMoved = false;
+
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
@@ -179,6 +264,13 @@ void JoystickManager::pollEvents()
                         if (adjustedValue > 32767) adjustedValue = 32767;
                     }
                     
+                    if (axis < m_axisValues.size()) {
+                        m_axisValues[axis] = adjustedValue;
+                        if (axis == m_xAxis || axis == m_yAxis) {
+                            mappedAxisMoved = true;
+                        }
+                    }
+
                     emit axisChanged(axis, adjustedValue);
                 }
                 break;
@@ -201,4 +293,8 @@ void JoystickManager::pollEvents()
                 break;
         }
     }
+
+    if (mappedAxisMoved) {
+        publishSetpoint();
+    }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <QMap>
 #include <QVector>
 #include <SDL2/SDL.h>
+#include "setpointmailbox.h"
 
 class JoystickManager : public QObject
 {
@@ -30,6 +31,14 @@ public:
     // Add calibration method that can be called externally if needed
     void calibrateAxes();
 
+    // Mirror setpoint mapping. Mapped positions are published straight into
+    // the mailbox as axis events arrive, so the mirror writer never has to
+    // go through the GUI.
+    void setSetpointMailbox(SetpointMailbox *mailbox);
+    void setAxisMapping(int xAxis, int yAxis);
+    void setAxisInversion(bool invertX, bool invertY);
+    void setDeadzone(double deadzone);
+
 signals:
     void joysticksChanged();
     void buttonChanged(int button, bool pressed);
@@ -55,8 +64,19 @@ private:
         bool calibrated;
     };
     QVector<AxisCalibration> m_axisCalibration;
+
+    // Calibrated axis values and the mapping onto the mirror
+    QVector<int> m_axisValues;
+    SetpointMailbox *m_setpointMailbox;
+    int m_xAxis;
+    int m_yAxis;
+    bool m_invertX;
+    bool m_invertY;
+    double m_deadzone;
     
     void scanJoysticks();
+    double mapAxisToPosition(int axisValue) const;
+    void publishSetpoint();
 };
 
 #endif // JOYSTICKMANAGER_H
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "binarylog.h"
+#include "tracklog.h"
+#include <QFile>
+#include <QDateTime>
+#include <cstdio>
+
+// Converts a binary waveform log (.jtmlog) or tracker log (.jtmtrk) to CSV,
+// so analysis scripts that read CSV keep working:
+//
+//   jtmlog2csv recording.jtmlog [recording.csv]
+//
+// Without an output file the CSV goes to standard output. A log cut short
+// by a crash converts up to its last complete block or record.
+
+namespace {
+
+int convertBinaryLog(BinaryLogReader &reader, QFile &output)
+{
+    const QVector<BinaryLogColumn> &columns = reader.columns();
+    QByteArray text;
+    for (int column = 0; column < columns.size(); ++column) {
+        if (column > 0) {
+            text.append(',');
+        }
+        text.append(columns[column].label().toUtf8());
+    }
+    text.append('\n');
+
+    // A block at a time: a few hundred kB of text
+    BinaryLogBlock block;
+    qint64 records = 0;
+    while (reader.readBlock(block)) {
+        for (int i = 0; i < block.records; ++i) {
+            int intColumn = 0;
+            int realColumn = 0;
+            for (int column = 0; column < columns.size(); ++column) {
+                const BinaryLogColumn &info = columns[column];
+                if (column > 0) {
+                    text.append(',');
+                }
+                if (info.type == BinaryLogColumn::Int64) {
+                    const qint64 value = block.ints[intColumn++][i];
+                    if (info.scale == 1.0 && info.decimals == 0) {
+                        text.append(QByteArray::number(value));
+                    } else {
+                        text.append(QByteArray::number(value * info.scale, 'f', info.decimals));
+                    }
+                } else {
+                    text.append(QByteArray::number(block.reals[realColumn++][i] * info.scale, 'f', info.decimals));
+                }
+            }
+            text.append('\n');
+        }
+
+        if (output.write(text) != text.size()) {
+            fprintf(stderr, "Failed to write output: %s\n", output.errorString().toLocal8Bit().constData());
+            return 1;
+        }
+        text.clear();
+        records += block.records;
+    }
+    if (records == 0 && !text.isEmpty()) {
+        output.write(text);
+    }
+    output.close();
+
+    if (!reader.getLastError().isEmpty()) {
+        fprintf(stderr, "%s (%lld records converted)\n",
+                reader.getLastError().toLocal8Bit().constData(), static_cast<long long>(records));
+        return 1;
+    }
+    return 0;
+}
+
+// The columns of the CSV tracker log, from the decoded status messages
+int convertTrackLog(TrackLogReader &reader, QFile &output)
+{
+    QByteArray text(TrackLogFormat::CsvHeader);
+
+    QVector<TrackLogRecord> records(4096);
+    int count;
+    while ((count = reader.read(records.data(), records.size())) > 0) {
+        for (int i = 0; i < count; ++i) {
+            const TrackLogRecord &record = records[i];
+            const TrackData data = record.decode();
+            const QDateTime wallTime = QDateTime::fromMSecsSinceEpoch(reader.startWallMs() + record.sessionNs / 1000000);
+            text.append(QByteArray::number(record.sessionNs / 1.0e9, 'f', 6)).append(',');
+            text.append(wallTime.toString("yyyy-MM-dd HH:mm:ss.zzz").toLatin1()).append(',');
+            text.append(QByteArray::number(data.rawErrorX, 'f', 5)).append(',');
+            text.append(QByteArray::number(data.rawErrorY, 'f', 5)).append(',');
+            text.append(QByteArray::number(data.filteredErrorX, 'f', 5)).append(',');
+            text.append(QByteArray::number(data.filteredErrorY, 'f', 5)).append(',');
+            for (const uint16_t word : {data.targetPolarity, data.trackState, data.trackMode, data.status,
+                                        data.targetSizeX, data.targetSizeY, data.targetLeft, data.targetTop,
+                                        data.targetPixelCount}) {
+                text.append(QByteArray::number(word)).append(',');
+            }
+            text.append(QByteArray::number(data.azimuth)).append(',');
+            text.append(QByteArray::number(data.elevation)).append('\n');
+        }
+
+        if (output.write(text) != text.size()) {
+            fprintf(stderr, "Failed to write output: %s\n", output.errorString().toLocal8Bit().constData());
+            return 1;
+        }
+        text.clear();
+    }
+    if (!text.isEmpty()) {
+        output.write(text);
+    }
+    output.close();
+
+    if (!reader.getLastError().isEmpty()) {
+        fprintf(stderr, "%s\n", reader.getLastError().toLocal8Bit().constData());
+        return 1;
+    }
+    return 0;
+}
+
+bool openOutput(QFile &output, int argc, char *argv[])
+{
+    bool opened = false;
+    if (argc == 3) {
+        output.setFileName(QString::fromLocal8Bit(argv[2]));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        fprintf(stderr, "Failed to open output: %s\n", output.errorString().toLocal8Bit().constData());
+    }
+    return opened;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s <log.jtmlog|log.jtmtrk> [out.csv]\n", argv[0]);
+        return 2;
+    }
+
+    const QString input = QString::fromLocal8Bit(argv[1]);
+    QFile output;
+    if (input.endsWith(".jtmtrk", Qt::CaseInsensitive)) {
+        TrackLogReader reader;
+        if (!reader.open(input)) {
+            fprintf(stderr, "%s\n", reader.getLastError().toLocal8Bit().constData());
+            return 1;
+        }
+        return openOutput(output, argc, argv) ? convertTrackLog(reader, output) : 1;
+    }
+
+    BinaryLogReader reader;
+    if (!reader.open(input)) {
+        fprintf(stderr, "%s\n", reader.getLastError().toLocal8Bit().constData());
+        return 1;
+    }
+    return openOutput(output, argc, argv) ? convertBinaryLog(reader, output) : 1;
+}
@@ -0,0 +1,117 @@
+#include "latencyhistogram.h"
+#include <limits>
+
+LatencyHistogram::LatencyHistogram(const QString &name)
+    : m_name(name)
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < BucketCount; ++i) {
+        m_counts[i].store(0, std::memory_order_relaxed);
+    }
+    m_totalCount.store(0, std::memory_order_relaxed);
+    m_totalNs.store(0, std::memory_order_relaxed);
+    m_minNs.store(std::numeric_limits<qint64>::max(), std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_totalCount.load(std::memory_order_relaxed);
+}
+
+qint64 LatencyHistogram::minNs() const
+{
+    return count() > 0 ? m_minNs.load(std::memory_order_relaxed) : 0;
+}
+
+qint64 LatencyHistogram::maxNs() const
+{
+    return m_maxNs.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::meanNs() const
+{
+    quint64 n = count();
+    return n > 0 ? static_cast<double>(m_totalNs.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SubBucketCount) {
+        return index;
+    }
+
+    int exponent = index / SubBucketCount + SubBucketBits - 1;
+    int subBucket = index % SubBucketCount;
+    int shift = exponent - SubBucketBits;
+    qint64 lower = static_cast<qint64>(SubBucketCount + subBucket) << shift;
+    return lower + (static_cast<qint64>(1) << shift) - 1;
+}
+
+qint64 LatencyHistogram::percentileNs(double percentile) const
+{
+    // Sum the buckets rather than trusting m_totalCount, which a concurrent
+    // record may already have bumped
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        total += m_counts[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    quint64 target = static_cast<quint64>(qBound(0.0, percentile, 100.0) / 100.0 * total + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+
+    quint64 cumulative = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        cumulative += m_counts[i].load(std::memory_order_relaxed);
+        if (cumulative >= target) {
+            return qMin(bucketUpperBound(i), maxNs());
+        }
+    }
+    return maxNs();
+}
+
+QString LatencyHistogram::summary() const
+{
+    return QString("n=%1, p50=%2, p99=%3, p99.9=%4, max=%5 us")
+        .arg(count())
+        .arg(percentileNs(50.0) / 1000.0, 0, 'f', 2)
+        .arg(percentileNs(99.0) / 1000.0, 0, 'f', 2)
+        .arg(percentileNs(99.9) / 1000.0, 0, 'f', 2)
+        .arg(maxNs() / 1000.0, 0, 'f', 2);
+}
+
+void LatencyHistogram::writeDistribution(QTextStream &out) const
+{
+    quint64 counts[BucketCount];
+    quint64 total = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    out << "# " << m_name << ": " << summary() << "\n";
+    out << "# mean " << QString::number(meanNs() / 1000.0, 'f', 3)
+        << " us, min " << QString::number(minNs() / 1000.0, 'f', 3) << " us\n";
+    out << "Value(us),Percentile,TotalCount\n";
+
+    quint64 cumulative = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        cumulative += counts[i];
+        out << QString::number(qMin(bucketUpperBound(i), maxNs()) / 1000.0, 'f', 3) << ","
+            << QString::number(100.0 * cumulative / total, 'f', 4) << ","
+            << cumulative << "\n";
+    }
+    out << "\n";
+}
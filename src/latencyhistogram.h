@@ -0,0 +1,99 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QTextStream>
+#include <atomic>
+
+// HDR-style log-linear histogram of nanosecond durations.
+//
+// Values below 2^SubBucketBits ns are counted exactly; above that every
+// power of two is split into 2^SubBucketBits linear sub-buckets, so any
+// recorded value is known to within ~3%. The range tops out at ~2200 s;
+// larger values land in the last bucket.
+//
+// record() is lock-free and wait-free apart from the max/min update (a CAS
+// that only loops while a new extreme is being set), so it can be called
+// from the output thread while the GUI reads percentiles.
+class LatencyHistogram
+{
+public:
+    static const int SubBucketBits = 5;
+    static const int SubBucketCount = 1 << SubBucketBits;
+    static const int MaxExponent = 40;
+    static const int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBucketCount;
+
+    explicit LatencyHistogram(const QString &name = QString());
+
+    QString name() const { return m_name; }
+
+    void record(qint64 valueNs)
+    {
+        if (valueNs < 0) {
+            valueNs = 0;
+        }
+
+        m_counts[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+        m_totalCount.fetch_add(1, std::memory_order_relaxed);
+        m_totalNs.fetch_add(valueNs, std::memory_order_relaxed);
+
+        qint64 max = m_maxNs.load(std::memory_order_relaxed);
+        while (valueNs > max &&
+               !m_maxNs.compare_exchange_weak(max, valueNs, std::memory_order_relaxed)) {
+        }
+        qint64 min = m_minNs.load(std::memory_order_relaxed);
+        while (valueNs < min &&
+               !m_minNs.compare_exchange_weak(min, valueNs, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Concurrent records during a reset may survive it; the counts stay
+    // consistent with themselves either way
+    void reset();
+
+    quint64 count() const;
+    qint64 minNs() const;
+    qint64 maxNs() const;
+    double meanNs() const;
+
+    // Highest value equivalent to the bucket holding the given percentile
+    // (0-100), capped at the recorded maximum
+    qint64 percentileNs(double percentile) const;
+
+    // "n=..., p50=..., p99=..., p99.9=..., max=..." in microseconds
+    QString summary() const;
+
+    // Cumulative distribution, one line per populated bucket:
+    // value (us), percentile, cumulative count
+    void writeDistribution(QTextStream &out) const;
+
+private:
+    QString m_name;
+    std::atomic<quint64> m_counts[BucketCount];
+    std::atomic<quint64> m_totalCount;
+    std::atomic<qint64> m_totalNs;
+    std::atomic<qint64> m_minNs;
+    std::atomic<qint64> m_maxNs;
+
+    static int bucketIndex(qint64 valueNs)
+    {
+        quint64 value = static_cast<quint64>(valueNs);
+        if (value < static_cast<quint64>(SubBucketCount)) {
+            return static_cast<int>(value);
+        }
+
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent > MaxExponent) {
+            return BucketCount - 1;
+        }
+
+        // Top SubBucketBits bits below the leading one pick the sub-bucket
+        int shift = exponent - SubBucketBits;
+        int subBucket = static_cast<int>((value >> shift) & (SubBucketCount - 1));
+        return (exponent - SubBucketBits + 1) * SubBucketCount + subBucket;
+    }
+
+    static qint64 bucketUpperBound(int index);
+};
+
+#endif // LATENCYHISTOGRAM_H
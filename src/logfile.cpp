@@ -0,0 +1,236 @@
+#include "logfile.h"
+#include "monotonicclock.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+qint64 alignDown(qint64 value, qint64 alignment)
+{
+    return value / alignment * alignment;
+}
+
+qint64 alignUp(qint64 value, qint64 alignment)
+{
+    return alignDown(value + alignment - 1, alignment);
+}
+
+}
+
+LogFile::LogFile()
+    : m_fileIndex(0)
+    , m_fd(-1)
+    , m_buffer(nullptr)
+    , m_bufferOffset(0)
+    , m_used(0)
+    , m_flushed(0)
+    , m_allocated(0)
+    , m_openedNs(0)
+    , m_bytesWritten(0)
+{
+}
+
+LogFile::~LogFile()
+{
+    close();
+    ::operator delete[](m_buffer, std::align_val_t(BlockBytes));
+}
+
+bool LogFile::open(const QString &fileName, const Options &options, const QByteArray &header)
+{
+    close();
+
+    const qint64 oldChunkBytes = m_options.chunkBytes;
+    m_baseName = fileName;
+    m_options = options;
+    m_options.chunkBytes = qMax<qint64>(BlockBytes, alignUp(options.chunkBytes, BlockBytes));
+    m_options.extentBytes = qMax(m_options.chunkBytes, options.extentBytes);
+    m_header = header;
+    m_fileIndex = 0;
+    m_bytesWritten.store(0, std::memory_order_relaxed);
+
+    if (!m_buffer || oldChunkBytes != m_options.chunkBytes) {
+        ::operator delete[](m_buffer, std::align_val_t(BlockBytes));
+        m_buffer = static_cast<char *>(::operator new[](m_options.chunkBytes, std::align_val_t(BlockBytes)));
+    }
+
+    return openFile();
+}
+
+bool LogFile::close()
+{
+    return closeFile();
+}
+
+QString LogFile::rotatedName(const QString &fileName, int index)
+{
+    if (index <= 1) {
+        return fileName;
+    }
+    const QFileInfo info(fileName);
+    const QString suffix = info.suffix();
+    return info.path() + "/" + info.completeBaseName() + QString("-%1").arg(index)
+           + (suffix.isEmpty() ? QString() : "." + suffix);
+}
+
+bool LogFile::fail(const QString &what)
+{
+    m_lastError = QString("%1 %2: %3").arg(what, m_currentName, QString::fromLocal8Bit(strerror(errno)));
+    return false;
+}
+
+bool LogFile::openFile()
+{
+    ++m_fileIndex;
+    m_currentName = rotatedName(m_baseName, m_fileIndex);
+    const QByteArray path = QFile::encodeName(m_currentName);
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (m_options.direct) {
+        flags |= O_DIRECT;
+    }
+    m_fd = ::open(path.constData(), flags, 0644);
+    if (m_fd < 0 && m_options.direct && errno == EINVAL) {
+        // Filesystems like tmpfs refuse O_DIRECT; the writes stay aligned
+        qDebug() << "O_DIRECT not supported for" << m_currentName << "- using the page cache";
+        m_options.direct = false;
+        m_fd = ::open(path.constData(), flags & ~O_DIRECT, 0644);
+    }
+    if (m_fd < 0) {
+        return fail("Failed to open log file");
+    }
+
+    m_bufferOffset = 0;
+    m_used = 0;
+    m_flushed = 0;
+    m_allocated = 0;
+    m_openedNs = MonotonicClock::nowNs();
+    if (!reserve(m_options.extentBytes) || !write(m_header)) {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool LogFile::closeFile()
+{
+    if (m_fd < 0) {
+        return true;
+    }
+
+    // Drops the unused reservation and any O_DIRECT padding at the tail
+    bool ok = flush();
+    if (ftruncate(m_fd, m_bufferOffset + m_used) != 0 && ok) {
+        ok = fail("Failed to truncate log file");
+    }
+    ::close(m_fd);
+    m_fd = -1;
+    return ok;
+}
+
+bool LogFile::reserve(qint64 end)
+{
+    if (end <= m_allocated) {
+        return true;
+    }
+
+    const qint64 target = alignUp(end, m_options.extentBytes);
+    if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, m_allocated, target - m_allocated) != 0) {
+        if (errno == EOPNOTSUPP || errno == ENOSYS) {
+            // Nothing to reserve on this filesystem; don't ask again
+            m_allocated = std::numeric_limits<qint64>::max();
+            return true;
+        }
+        return fail("Failed to reserve space for log file");
+    }
+    m_allocated = target;
+    return true;
+}
+
+bool LogFile::writeOut(qint64 from, qint64 to)
+{
+    // O_DIRECT needs whole blocks: pad the tail with zeros, which the next
+    // write or the final truncate replaces. Truncating here instead would
+    // give back the reservation on every flush.
+    if (m_options.direct) {
+        const qint64 padded = alignUp(to, BlockBytes);
+        std::memset(m_buffer + to, 0, padded - to);
+        to = padded;
+    }
+    if (!reserve(m_bufferOffset + to)) {
+        return false;
+    }
+
+    while (from < to) {
+        const ssize_t written = pwrite(m_fd, m_buffer + from, to - from, m_bufferOffset + from);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return fail("Failed to write log file");
+        }
+        from += written;
+    }
+    return true;
+}
+
+bool LogFile::write(const char *data, qint64 size)
+{
+    if (m_fd < 0) {
+        return false;
+    }
+
+    m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    while (size > 0) {
+        const qint64 count = qMin(size, m_options.chunkBytes - m_used);
+        std::memcpy(m_buffer + m_used, data, count);
+        m_used += count;
+        data += count;
+        size -= count;
+
+        // A full chunk goes out whole, less any blocks a flush already wrote
+        if (m_used == m_options.chunkBytes) {
+            if (!writeOut(alignDown(m_flushed, BlockBytes), m_used)) {
+                return false;
+            }
+            m_bufferOffset += m_used;
+            m_used = 0;
+            m_flushed = 0;
+        }
+    }
+    return true;
+}
+
+bool LogFile::flush()
+{
+    if (m_fd < 0 || m_used == m_flushed) {
+        return true;
+    }
+    if (!writeOut(alignDown(m_flushed, BlockBytes), m_used)) {
+        return false;
+    }
+    m_flushed = m_used;
+    return true;
+}
+
+bool LogFile::rotateIfDue()
+{
+    if (m_fd < 0) {
+        return false;
+    }
+
+    const bool full = m_options.rotateBytes > 0 && m_bufferOffset + m_used >= m_options.rotateBytes;
+    const bool old = m_options.rotateNs > 0 && MonotonicClock::nowNs() - m_openedNs >= m_options.rotateNs;
+    if (!full && !old) {
+        return true;
+    }
+    return closeFile() && openFile();
+}
@@ -0,0 +1,90 @@
+#ifndef LOGFILE_H
+#define LOGFILE_H
+
+#include <QString>
+#include <QByteArray>
+#include <atomic>
+
+// Append-only log file for multi-hour recordings.
+//
+// Space is reserved ahead of the data with fallocate() in large extents, so
+// the file stays in a few contiguous runs on disk however slowly it grows.
+// Data is collected in a chunk buffer and written in whole, aligned chunks
+// at aligned offsets; flush() writes only the partial block at the tail,
+// which the next write rewrites in place. With Options::direct the writes
+// bypass the page cache (O_DIRECT), which those sizes and offsets allow.
+// The reservation is kept out of the file size (FALLOC_FL_KEEP_SIZE), so a
+// crashed run still leaves a file that ends at its data; close() also gives
+// back the reserved space that was not used.
+//
+// With O_DIRECT a flush writes the tail block zero padded, and the padding
+// is only cut off at close() or rotation. A file that is still being
+// written, or was left by a crash, can end in up to BlockBytes - 1 zero
+// bytes, and readers stop at them.
+//
+// Rotation starts a new file, named name-2.ext, name-3.ext and so on, once
+// the current one passes a size or age limit. The owner calls rotateIfDue()
+// between records, and the header given to open() starts every file.
+class LogFile
+{
+public:
+    static constexpr int BlockBytes = 4096;
+
+    struct Options {
+        qint64 chunkBytes = 4 << 20;        // Write size, a multiple of BlockBytes
+        qint64 extentBytes = 64 << 20;      // fallocate() step
+        bool direct = false;                // O_DIRECT
+        qint64 rotateBytes = 0;             // 0: no size limit
+        qint64 rotateNs = 0;                // 0: no age limit
+    };
+
+    LogFile();
+    ~LogFile();
+
+    bool open(const QString &fileName, const Options &options, const QByteArray &header = QByteArray());
+    bool close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    bool write(const char *data, qint64 size);
+    bool write(const QByteArray &data) { return write(data.constData(), data.size()); }
+
+    // Hand everything written so far to the kernel
+    bool flush();
+
+    bool rotateIfDue();
+    QString currentFileName() const { return m_currentName; }
+    // The name of the index-th file of a rotated log, counting from 1
+    static QString rotatedName(const QString &fileName, int index);
+    int fileCount() const { return m_fileIndex; }
+
+    // All files of this run, headers included; readable from any thread
+    qint64 bytesWritten() const { return m_bytesWritten.load(std::memory_order_relaxed); }
+
+    QString getLastError() const { return m_lastError; }
+
+private:
+    QString m_baseName;
+    QString m_currentName;
+    Options m_options;
+    QByteArray m_header;
+    int m_fileIndex;
+    int m_fd;
+
+    char *m_buffer;             // Aligned for O_DIRECT, chunkBytes long
+    qint64 m_bufferOffset;      // File offset of m_buffer[0], block aligned
+    qint64 m_used;
+    qint64 m_flushed;           // Bytes of the buffer already in the file
+    qint64 m_allocated;         // Reserved up to this offset
+    qint64 m_openedNs;
+
+    std::atomic<qint64> m_bytesWritten;
+    QString m_lastError;
+
+    bool openFile();
+    bool closeFile();
+    bool writeOut(qint64 from, qint64 to);
+    bool reserve(qint64 end);
+    bool fail(const QString &what);
+};
+
+#endif // LOGFILE_H
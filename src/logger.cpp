@@ -1,10 +1,13 @@
 #include "logger.h"
+#include "monotonicclock.h"
 #include <QDebug>
 
 Logger::Logger(QObject *parent)
     : QObject(parent)
     , m_isLogging(false)
-    , m_headerWritten(false)
+    , m_binary(false)
+    , m_failed(false)
+    , m_lastFlushNs(0)
 {
 }
 
@@ -19,20 +22,22 @@ bool Logger::startLogging(const QString& filename)
         stopLogging();
     }
 
-    m_logFile.setFileName(filename);
-    if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit errorOccurred("Failed to open log file: " + filename);
+    m_binary = filename.endsWith(".jtmtrk", Qt::CaseInsensitive);
+    if (m_binary) {
+        if (!m_trackLog.open(filename, MonotonicClock::wallTime(0).toMSecsSinceEpoch(), m_fileOptions)) {
+            emit errorOccurred(m_trackLog.getLastError());
+            return false;
+        }
+    } else if (!m_writer.open(filename, m_fileOptions, TrackLogFormat::CsvHeader)) {
+        // Session time lines up with the other logs, the timestamp is for
+        // people; every rotated file starts with the header too
+        emit errorOccurred(m_writer.getLastError());
         return false;
     }
 
-    m_textStream.setDevice(&m_logFile);
-
-    // Set high precision for floating point values
-    m_textStream.setRealNumberPrecision(5); // 5 decimal places for track errors
-    m_textStream.setRealNumberNotation(QTextStream::FixedNotation);
-
     m_isLogging = true;
-    m_headerWritten = false;
+    m_failed = false;
+    m_lastFlushNs = MonotonicClock::nowNs();
 
     return true;
 }
@@ -40,36 +45,71 @@ bool Logger::startLogging(const QString& filename)
 void Logger::stopLogging()
 {
     if (m_isLogging) {
-        m_logFile.close();
+        if (m_binary) {
+            if (!m_trackLog.close() && !m_failed) {
+                reportError(m_trackLog.getLastError());
+            }
+        } else if (!m_writer.close() && !m_failed) {
+            reportError(m_writer.getLastError());
+        }
         m_isLogging = false;
     }
 }
 
-void Logger::writeHeader()
+void Logger::reportError(const QString& errorMsg)
 {
-    // Simplified header with only time, x raw error, and y raw error
-    m_textStream << "Timestamp,RawErrorX,RawErrorY" << Qt::endl;
-    m_headerWritten = true;
+    // Once per run: the writers drop everything after a failure
+    m_failed = true;
+    qDebug() << "Tracker log:" << errorMsg;
+    emit errorOccurred(errorMsg);
 }
 
-void Logger::logData(const TrackData& data)
+void Logger::logData(const uint16_t* statusMsg, qint64 sessionNs)
 {
     if (!m_isLogging) {
         return;
     }
 
-    if (!m_headerWritten) {
-        writeHeader();
+    // The raw message copied into the mapping, decoded when read; the
+    // kernel does the writing
+    if (m_binary) {
+        if (!m_trackLog.append(sessionNs, statusMsg) && !m_failed) {
+            reportError(m_trackLog.getLastError());
+        }
+        return;
     }
 
-    // Get current timestamp with millisecond precision
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
+    // Wall-clock label from the session clock, so it never jumps
+    const QByteArray timestamp = MonotonicClock::wallTime(sessionNs).toString("yyyy-MM-dd HH:mm:ss.zzz").toLatin1();
 
-    // Write timestamp and raw errors with 5 decimal places (full card precision)
-    m_textStream << timestamp << ","
-                 << QString::number(data.rawErrorX, 'f', 5) << ","
-                 << QString::number(data.rawErrorY, 'f', 5) << Qt::endl;
+    // Write timestamps and track errors with 5 decimal places (full card
+    // precision), then the rest of the message as integers
+    const TrackData data = TrackData::fromStatusMessage(statusMsg);
+    m_writer.addFixed(sessionNs / 1.0e9, 6);
+    m_writer.addText(timestamp);
+    m_writer.addFixed(data.rawErrorX, 5);
+    m_writer.addFixed(data.rawErrorY, 5);
+    m_writer.addFixed(data.filteredErrorX, 5);
+    m_writer.addFixed(data.filteredErrorY, 5);
+    m_writer.addInt(data.targetPolarity);
+    m_writer.addInt(data.trackState);
+    m_writer.addInt(data.trackMode);
+    m_writer.addInt(data.status);
+    m_writer.addInt(data.targetSizeX);
+    m_writer.addInt(data.targetSizeY);
+    m_writer.addInt(data.targetLeft);
+    m_writer.addInt(data.targetTop);
+    m_writer.addInt(data.targetPixelCount);
+    m_writer.addInt(data.azimuth);
+    m_writer.addInt(data.elevation);
+    m_writer.endLine();
 
-    // Ensure data is written to disk immediately
-    m_textStream.flush();
+    // Hand lines to the kernel in batches instead of one write per sample
+    const qint64 now = MonotonicClock::nowNs();
+    if (now - m_lastFlushNs >= FlushIntervalNs) {
+        m_lastFlushNs = now;
+        if ((!m_writer.flush() || !m_writer.rotateIfDue()) && !m_failed) {
+            reportError(m_writer.getLastError());
+        }
+    }
 }
\ No newline at end of file
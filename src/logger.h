@@ -2,33 +2,48 @@
 #define LOGGER_H
 
 #include <QObject>
-#include <QFile>
-#include <QTextStream>
 #include <QDateTime>
 #include "trackdata.h"
+#include "csvwriter.h"
+#include "tracklog.h"
 
 class Logger : public QObject
 {
     Q_OBJECT
 public:
+    // Lines reach the kernel at least this often while samples arrive
+    static constexpr qint64 FlushIntervalNs = 20000000LL;
+
     explicit Logger(QObject *parent = nullptr);
     ~Logger();
 
+    // A .jtmtrk file name selects the memory-mapped binary log, anything
+    // else CSV
     bool startLogging(const QString& filename);
     void stopLogging();
     bool isLogging() const { return m_isLogging; }
-    void logData(const TrackData& data);
+    // A status message of TrackData::StatusMessageWords words, as read by
+    // TrackerMemory::readStatusMessage(); sessionNs is the MonotonicClock
+    // session time it was read at
+    void logData(const uint16_t* statusMsg, qint64 sessionNs);
+
+    // Write size, O_DIRECT and rotation for the next startLogging()
+    void setFileOptions(const LogFile::Options& options) { m_fileOptions = options; }
+    qint64 bytesWritten() const { return m_binary ? m_trackLog.bytesWritten() : m_writer.file().bytesWritten(); }
 
 signals:
     void errorOccurred(const QString& errorMsg);
 
 private:
-    QFile m_logFile;
-    QTextStream m_textStream;
+    CsvWriter m_writer;
+    TrackLogWriter m_trackLog;
+    LogFile::Options m_fileOptions;
     bool m_isLogging;
-    bool m_headerWritten;
+    bool m_binary;
+    bool m_failed;
+    qint64 m_lastFlushNs;
 
-    void writeHeader();
+    void reportError(const QString& errorMsg);
 };
 
 #endif // LOGGER_H
\ No newline at end of file
@@ -1,107 +1,188 @@
 #include "loggingthread.h"
 #include <QDebug>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 LoggingThread::LoggingThread(QObject *parent)
     : QThread(parent)
-    , m_logFile(nullptr)
-    , m_logStream(nullptr)
+    , m_sink(nullptr)
+    , m_sinkFailed(false)
+    , m_queue(QueueCapacityLog2)
+    , m_wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_unsignalled(0)
     , m_isLogging(false)
     , m_shouldStop(false)
+    , m_overflowPolicy(DropOnOverflow)
+    , m_written(0)
+    , m_dropped(0)
+    , m_blocked(0)
 {
+    if (m_wakeFd < 0) {
+        // The writer still flushes every FlushIntervalUs without it
+        qDebug() << "Logging thread: eventfd failed, relying on the flush interval";
+    }
 }
 
 LoggingThread::~LoggingThread()
 {
     stopLogging();
+    delete m_sink;
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+bool LoggingThread::startLogging(const QString& filename, double sampleRate)
+{
+    return startLogging(LogSink::create(filename), filename, sampleRate);
 }
 
-void LoggingThread::startLogging(const QString& filename)
+bool LoggingThread::startLogging(LogSink* sink, const QString& filename, double sampleRate)
 {
-    if (m_isLogging) {
+    if (isLogging()) {
         stopLogging();
     }
 
-    m_logFile = new QFile(filename);
-    if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qDebug() << "Failed to open log file:" << m_logFile->errorString();
-        delete m_logFile;
-        m_logFile = nullptr;
-        return;
+    delete m_sink;
+    m_sink = sink;
+    if (!m_sink->open(filename, sampleRate, m_fileOptions)) {
+        m_lastError = m_sink->getLastError();
+        qDebug() << m_lastError;
+        return false;
     }
+    m_sinkFailed = false;
 
-    m_logStream = new QTextStream(m_logFile);
-    m_logStream->setRealNumberPrecision(5);
-    m_logStream->setRealNumberNotation(QTextStream::FixedNotation);
+    // The writer thread is not running, so this thread may act as consumer
+    discardQueued();
+    m_unsignalled = 0;
+    m_written.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_blocked.store(0, std::memory_order_relaxed);
 
-    // Write header
-    *m_logStream << "ElapsedTime(s),Frequency(Hz),Amplitude,X-Command,Y-Command,X-Feedback(V),Y-Feedback(V)" << Qt::endl;
-
-    m_isLogging = true;
-    m_shouldStop = false;
+    m_shouldStop.store(false, std::memory_order_relaxed);
+    m_isLogging.store(true, std::memory_order_release);
     start();
+    return true;
 }
 
 void LoggingThread::stopLogging()
 {
-    if (!m_isLogging) {
+    if (!isLogging()) {
         return;
     }
 
-    m_shouldStop = true;
-    m_condition.wakeOne();
+    // The writer drains whatever is queued before it exits
+    m_isLogging.store(false, std::memory_order_release);
+    m_shouldStop.store(true, std::memory_order_release);
+    wake();
     wait();
 
-    if (m_logStream) {
-        m_logStream->flush();
-        delete m_logStream;
-        m_logStream = nullptr;
+    if (!m_sink->close()) {
+        m_lastError = m_sink->getLastError();
+        qDebug() << m_lastError;
     }
 
-    if (m_logFile) {
-        m_logFile->close();
-        delete m_logFile;
-        m_logFile = nullptr;
-    }
+    qDebug() << "Logging stopped:" << writtenCount() << "records written," << droppedCount()
+             << "dropped," << blockedCount() << "waits for room";
+}
 
-    m_isLogging = false;
+void LoggingThread::wake()
+{
+    if (m_wakeFd >= 0) {
+        const quint64 one = 1;
+        const ssize_t result = ::write(m_wakeFd, &one, sizeof(one));
+        Q_UNUSED(result);   // A saturated counter is still a pending wakeup
+    }
 }
 
 void LoggingThread::addRecord(const LogRecord& record)
 {
-    if (!m_isLogging) {
+    if (!isLogging()) {
         return;
     }
 
-    QMutexLocker locker(&m_mutex);
-    m_buffer.append(record);
-    m_condition.wakeOne();
+    while (!m_queue.tryPush(record)) {
+        if (overflowPolicy() == DropOnOverflow) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Make sure the writer is draining, then give it a moment
+        m_blocked.fetch_add(1, std::memory_order_relaxed);
+        wake();
+        QThread::usleep(50);
+        if (!isLogging()) {
+            return;
+        }
+    }
+
+    if (++m_unsignalled >= WakeBatch) {
+        m_unsignalled = 0;
+        wake();
+    }
+}
+
+int LoggingThread::writeQueued()
+{
+    // The sink formats and writes with nothing locked; the producer keeps
+    // filling the free part of the queue meanwhile
+    int total = 0;
+    const LogRecord *records = nullptr;
+    int count = 0;
+    while ((count = m_queue.peek(&records, 1024)) > 0) {
+        const bool written = m_sink->write(records, count);
+        m_queue.release(count);
+        total += count;
+        reportSinkResult(written);
+    }
+
+    m_written.fetch_add(total, std::memory_order_relaxed);
+    reportSinkResult(m_sink->flush());
+    return total;
+}
+
+void LoggingThread::reportSinkResult(bool ok)
+{
+    // Once per run: a full disk fails every write after the first
+    if (!ok && !m_sinkFailed) {
+        m_sinkFailed = true;
+        qDebug() << "Logging thread:" << m_sink->getLastError();
+    }
+}
+
+void LoggingThread::discardQueued()
+{
+    const LogRecord *records = nullptr;
+    int count = 0;
+    while ((count = m_queue.peek(&records, 1024)) > 0) {
+        m_queue.release(count);
+    }
 }
 
 void LoggingThread::run()
 {
-    while (!m_shouldStop) {
-        QMutexLocker locker(&m_mutex);
-
-        if (m_buffer.isEmpty()) {
-            m_condition.wait(&m_mutex);
-            if (m_shouldStop) {
-                break;
-            }
+    pollfd wakeup;
+    wakeup.fd = m_wakeFd;
+    wakeup.events = POLLIN;
+
+    timespec interval;
+    interval.tv_sec = FlushIntervalUs / 1000000;
+    interval.tv_nsec = (FlushIntervalUs % 1000000) * 1000;
+
+    while (true) {
+        // Seen before draining, so the last records before a stop are written
+        const bool stopping = m_shouldStop.load(std::memory_order_acquire);
+        writeQueued();
+        if (stopping) {
+            break;
         }
 
-        // Write all records in the buffer
-        for (const LogRecord& record : m_buffer) {
-            double elapsedSeconds = record.elapsedTime / 1.0e9;
-            *m_logStream << QString::number(elapsedSeconds, 'f', 9) << ","
-                        << QString::number(record.frequency, 'f', 1) << ","
-                        << QString::number(record.amplitude, 'f', 1) << ","
-                        << QString::number(record.xCommand, 'f', 5) << ","
-                        << QString::number(record.yCommand, 'f', 5) << ","
-                        << QString::number(record.xFeedback, 'f', 5) << ","
-                        << QString::number(record.yFeedback, 'f', 5) << "\n";
+        wakeup.revents = 0;
+        if (ppoll(&wakeup, m_wakeFd >= 0 ? 1 : 0, &interval, nullptr) > 0 && (wakeup.revents & POLLIN)) {
+            quint64 value = 0;
+            const ssize_t result = ::read(m_wakeFd, &value, sizeof(value));
+            Q_UNUSED(result);
         }
-
-        m_buffer.clear();
-        m_logStream->flush();
     }
-}
\ No newline at end of file
+}
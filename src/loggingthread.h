@@ -2,35 +2,88 @@
 #define LOGGINGTHREAD_H
 
 #include <QThread>
-#include <QFile>
-#include <QTextStream>
-#include <QMutex>
-#include <QWaitCondition>
+#include <atomic>
 #include "logrecord.h"
+#include "spscqueue.h"
+#include "logsink.h"
 
+// Writes waveform log records to CSV, or to a binary log when the file name
+// ends in .jtmlog, on its own thread.
+//
+// Records travel through a lock-free SpscQueue, so addRecord() never waits
+// for formatting or disk I/O: the writer reads them in place and hands them
+// to a LogSink with no lock held, however long the disk takes. The writer is
+// woken through an eventfd once WakeBatch records are queued, and on its own
+// every FlushIntervalUs, so a slow trickle still reaches the file promptly
+// without a wakeup per record.
+// When the queue is full the record is dropped and counted, or with
+// BlockOnOverflow the producer waits for room.
+//
+// One producer at a time: the output thread in software-timed mode, the
+// stream thread in buffered mode.
 class LoggingThread : public QThread
 {
     Q_OBJECT
 public:
+    enum OverflowPolicy {
+        DropOnOverflow,
+        BlockOnOverflow
+    };
+
+    // 64k records: a minute at 1 kS/s, 6.5 s at 10 kS/s
+    static constexpr int QueueCapacityLog2 = 16;
+    static constexpr int WakeBatch = 256;
+    static constexpr long FlushIntervalUs = 20000;
+
     explicit LoggingThread(QObject *parent = nullptr);
     ~LoggingThread();
 
-    void startLogging(const QString& filename);
+    // sampleRate is the nominal rate recorded in a binary log's header
+    bool startLogging(const QString& filename, double sampleRate = 0.0);
+    // Log through a given sink, e.g. a stand-in; takes ownership
+    bool startLogging(LogSink* sink, const QString& filename, double sampleRate = 0.0);
     void stopLogging();
     void addRecord(const LogRecord& record);
-    bool isLogging() const { return m_isLogging; }
+    bool isLogging() const { return m_isLogging.load(std::memory_order_acquire); }
+
+    // Write size, O_DIRECT and rotation for the next startLogging()
+    void setFileOptions(const LogFile::Options& options) { m_fileOptions = options; }
+    LogFile::Options fileOptions() const { return m_fileOptions; }
+
+    void setOverflowPolicy(OverflowPolicy policy) { m_overflowPolicy.store(policy, std::memory_order_relaxed); }
+    OverflowPolicy overflowPolicy() const { return m_overflowPolicy.load(std::memory_order_relaxed); }
+
+    // Since the last startLogging()
+    quint64 queuedCount() const { return m_queue.size(); }
+    quint64 writtenCount() const { return m_written.load(std::memory_order_relaxed); }
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    quint64 blockedCount() const { return m_blocked.load(std::memory_order_relaxed); }
+    qint64 bytesWritten() const { return m_sink ? m_sink->bytesWritten() : 0; }
+
+    QString getLastError() const { return m_lastError; }
 
 protected:
     void run() override;
 
 private:
-    QFile* m_logFile;
-    QTextStream* m_logStream;
-    QVector<LogRecord> m_buffer;
-    QMutex m_mutex;
-    QWaitCondition m_condition;
-    bool m_isLogging;
-    bool m_shouldStop;
+    LogSink* m_sink;
+    LogFile::Options m_fileOptions;
+    bool m_sinkFailed;          // Writer side
+    QString m_lastError;
+    SpscQueue<LogRecord> m_queue;
+    int m_wakeFd;
+    int m_unsignalled;          // Producer side: records since the last wakeup
+    std::atomic<bool> m_isLogging;
+    std::atomic<bool> m_shouldStop;
+    std::atomic<OverflowPolicy> m_overflowPolicy;
+    std::atomic<quint64> m_written;
+    std::atomic<quint64> m_dropped;
+    std::atomic<quint64> m_blocked;
+
+    void wake();
+    int writeQueued();
+    void reportSinkResult(bool ok);
+    void discardQueued();
 };
 
-#endif // LOGGINGTHREAD_H
\ No newline at end of file
+#endif // LOGGINGTHREAD_H
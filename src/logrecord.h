@@ -2,12 +2,14 @@
 #define LOGRECORD_H
 
 struct LogRecord {
+    qint64 sampleIndex;  // Frame index on the output clock
     qint64 elapsedTime;  // Time in nanoseconds since start
+    qint64 sessionTime;  // MonotonicClock session time in nanoseconds
     double frequency;
     double amplitude;
     double xCommand;
     double yCommand;
-    double xFeedback;
+    double xFeedback;    // Sensor volts when acquired, else the commanded volts
     double yFeedback;
 };
 
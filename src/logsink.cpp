@@ -0,0 +1,15 @@
+#include "logsink.h"
+#include "csvlogsink.h"
+#include "binarylogsink.h"
+
+LogSink::~LogSink()
+{
+}
+
+LogSink *LogSink::create(const QString &fileName)
+{
+    if (fileName.endsWith(".jtmlog", Qt::CaseInsensitive)) {
+        return new BinaryLogSink();
+    }
+    return new CsvLogSink();
+}
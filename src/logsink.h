@@ -0,0 +1,41 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <QString>
+#include "logrecord.h"
+#include "logfile.h"
+
+// Destination of LoggingThread's records.
+//
+// All calls come from the logging thread between open() and close(), so a
+// sink needs no locking and may block on the disk as long as it has to: the
+// producers only ever touch the lock-free queue in front of it. Formatting
+// and writing happen here, with nothing held.
+class LogSink
+{
+public:
+    virtual ~LogSink();
+
+    // The sink for a file name: a binary log for .jtmlog, otherwise CSV
+    static LogSink *create(const QString &fileName);
+
+    // sampleRate is the nominal rate, for formats that record it; options
+    // set the file's write size, O_DIRECT and rotation
+    virtual bool open(const QString &fileName, double sampleRate, const LogFile::Options &options) = 0;
+    virtual bool write(const LogRecord *records, int count) = 0;
+
+    // Called whenever the queue runs empty, and at least every
+    // LoggingThread::FlushIntervalUs while logging
+    virtual bool flush() = 0;
+    virtual bool close() = 0;
+
+    // Bytes in the log files so far; read from other threads for statistics
+    virtual qint64 bytesWritten() const = 0;
+
+    QString getLastError() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+#endif // LOGSINK_H
@@ -0,0 +1,552 @@
+#include "logviewwidget.h"
+#include "binarylog.h"
+#include "tracklog.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QFile>
+#include <QDateTime>
+#include <QDebug>
+#include <cmath>
+#include <limits>
+
+LogViewWidget::LogViewWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_sampleRate(1000.0)
+    , m_viewFirst(0.0)
+    , m_viewSpan(1000.0)
+    , m_follow(false)
+    , m_dragging(false)
+    , m_dragStartX(0.0)
+    , m_dragStartFirst(0.0)
+{
+    setMinimumSize(300, 150);
+}
+
+void LogViewWidget::clearTraces()
+{
+    m_traces.clear();
+    m_columns.clear();
+    update();
+}
+
+int LogViewWidget::addTrace(const QString &name, const QColor &color)
+{
+    Trace trace;
+    trace.name = name;
+    trace.color = color;
+    m_traces.append(trace);
+    return m_traces.size() - 1;
+}
+
+QColor LogViewWidget::traceColor(int index)
+{
+    static const Qt::GlobalColor colors[] = {Qt::green, Qt::yellow, Qt::cyan, Qt::magenta, Qt::red, Qt::white};
+    return colors[index % (sizeof(colors) / sizeof(colors[0]))];
+}
+
+bool LogViewWidget::loadCsv(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError = "Failed to open log file: " + file.errorString();
+        return false;
+    }
+
+    // Header: one time column (seconds or a timestamp), the sample index,
+    // and value columns
+    const QList<QByteArray> header = file.readLine().trimmed().split(',');
+    int timeColumn = -1;
+    QVector<int> valueColumns;
+    QVector<Trace> traces;
+    for (int column = 0; column < header.size(); ++column) {
+        const QString name = QString::fromLatin1(header[column]);
+        if (timeColumn < 0 && name.contains("time", Qt::CaseInsensitive)) {
+            timeColumn = column;
+        } else if (!name.startsWith("Sample", Qt::CaseInsensitive)) {
+            valueColumns.append(column);
+            Trace trace;
+            trace.name = name;
+            traces.append(trace);
+        }
+    }
+    if (valueColumns.isEmpty()) {
+        m_lastError = "No value columns in " + fileName;
+        return false;
+    }
+
+    // The size gives a rough row count to reserve for
+    const qint64 expectedRows = file.size() / qMax(8, int(header.size()) * 10);
+    for (Trace &trace : traces) {
+        trace.pyramid.reserve(expectedRows);
+    }
+
+    double firstTime = 0.0;
+    double lastTime = 0.0;
+    qint64 rows = 0;
+    qint64 skipped = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith('\0')) {
+            // Zero padding at the tail of an O_DIRECT log that is still open
+            // or was never closed (see LogFile); no data follows it
+            break;
+        }
+        const QList<QByteArray> fields = line.trimmed().split(',');
+        if (fields.size() < header.size()) {
+            ++skipped;
+            continue;
+        }
+
+        if (timeColumn >= 0) {
+            bool ok = false;
+            double time = fields[timeColumn].toDouble(&ok);
+            if (!ok) {
+                time = QDateTime::fromString(QString::fromLatin1(fields[timeColumn]), "yyyy-MM-dd HH:mm:ss.zzz")
+                           .toMSecsSinceEpoch() / 1000.0;
+            }
+            if (rows == 0) {
+                firstTime = time;
+            }
+            lastTime = time;
+        }
+
+        for (int i = 0; i < valueColumns.size(); ++i) {
+            traces[i].pyramid.append(fields[valueColumns[i]].toDouble());
+        }
+        ++rows;
+    }
+
+    if (rows == 0) {
+        m_lastError = "No samples in " + fileName;
+        return false;
+    }
+    if (skipped > 0) {
+        qDebug() << "Log viewer skipped" << skipped << "short lines in" << fileName;
+    }
+
+    // Samples are taken as evenly spaced over the logged time span
+    for (int i = traces.size() - 1; i >= 0 && traces.size() > 1; --i) {
+        const MinMaxPyramid::Summary summary = traces[i].pyramid.summarize(0, traces[i].pyramid.size());
+        if (summary.min == summary.max) {
+            traces.remove(i);
+        }
+    }
+    showLoaded(traces, rows > 1 && lastTime > firstTime ? (rows - 1) / (lastTime - firstTime) : 1.0);
+    return true;
+}
+
+bool LogViewWidget::loadBinaryLog(const QString &fileName)
+{
+    BinaryLogReader reader;
+    if (!reader.open(fileName)) {
+        m_lastError = reader.getLastError();
+        return false;
+    }
+
+    // First pass over the block descriptors alone: which value columns
+    // change, and the time span when the header has no rate
+    const QVector<BinaryLogColumn> &columns = reader.columns();
+    QVector<double> min(columns.size(), std::numeric_limits<double>::infinity());
+    QVector<double> max(columns.size(), -std::numeric_limits<double>::infinity());
+    int timeColumn = -1;
+    for (int column = 0; column < columns.size() && timeColumn < 0; ++column) {
+        if (columns[column].name.contains("time", Qt::CaseInsensitive)) {
+            timeColumn = column;
+        }
+    }
+
+    BinaryLogBlock block;
+    qint64 rows = 0;
+    while (reader.readBlock(block, false)) {
+        for (int column = 0; column < columns.size(); ++column) {
+            min[column] = qMin(min[column], block.min[column]);
+            max[column] = qMax(max[column], block.max[column]);
+        }
+        rows += block.records;
+    }
+    if (rows == 0) {
+        m_lastError = reader.getLastError().isEmpty() ? "No samples in " + fileName : reader.getLastError();
+        return false;
+    }
+
+    // Value columns are the non-integer ones; integers are indices and times
+    QVector<int> valueColumns;
+    QVector<Trace> traces;
+    int realIndex = 0;
+    QVector<int> realIndices;
+    for (int column = 0; column < columns.size(); ++column) {
+        if (columns[column].type == BinaryLogColumn::Int64) {
+            continue;
+        }
+        if (min[column] != max[column]) {
+            valueColumns.append(column);
+            realIndices.append(realIndex);
+            Trace trace;
+            trace.name = columns[column].label();
+            trace.pyramid.reserve(rows);
+            traces.append(trace);
+        }
+        ++realIndex;
+    }
+    if (traces.isEmpty()) {
+        m_lastError = "No changing value columns in " + fileName;
+        return false;
+    }
+
+    // Second pass decodes the values
+    reader.close();
+    if (!reader.open(fileName)) {
+        m_lastError = reader.getLastError();
+        return false;
+    }
+    while (reader.readBlock(block)) {
+        for (int i = 0; i < traces.size(); ++i) {
+            const QVector<double> &values = block.reals[realIndices[i]];
+            const double scale = columns[valueColumns[i]].scale;
+            for (int row = 0; row < block.records; ++row) {
+                traces[i].pyramid.append(values[row] * scale);
+            }
+        }
+    }
+    if (!reader.getLastError().isEmpty()) {
+        qDebug() << "Log viewer:" << reader.getLastError() << "in" << fileName;
+    }
+
+    const double span = timeColumn >= 0 ? (max[timeColumn] - min[timeColumn]) * columns[timeColumn].scale : 0.0;
+    double sampleRate = reader.sampleRate();
+    if (sampleRate <= 0.0) {
+        sampleRate = rows > 1 && span > 0.0 ? (rows - 1) / span : 1.0;
+    }
+    showLoaded(traces, sampleRate);
+    return true;
+}
+
+bool LogViewWidget::loadTrackLog(const QString &fileName)
+{
+    TrackLogReader reader;
+    if (!reader.open(fileName)) {
+        m_lastError = reader.getLastError();
+        return false;
+    }
+    if (reader.recordCount() == 0) {
+        m_lastError = "No samples in " + fileName;
+        return false;
+    }
+
+    // The rest of the message is state codes, better read from the CSV
+    const char *const names[] = {"RawErrorX", "RawErrorY", "FilteredErrorX", "FilteredErrorY",
+                                 "TargetPixelCount", "Azimuth", "Elevation"};
+    QVector<Trace> traces;
+    for (const char *name : names) {
+        Trace trace;
+        trace.name = name;
+        trace.pyramid.reserve(reader.recordCount());
+        traces.append(trace);
+    }
+
+    QVector<TrackLogRecord> records(4096);
+    qint64 firstNs = 0;
+    qint64 lastNs = 0;
+    qint64 rows = 0;
+    int count;
+    while ((count = reader.read(records.data(), records.size())) > 0) {
+        for (int i = 0; i < count; ++i) {
+            const TrackData data = records[i].decode();
+            const double values[] = {data.rawErrorX, data.rawErrorY, data.filteredErrorX, data.filteredErrorY,
+                                     double(data.targetPixelCount), double(data.azimuth), double(data.elevation)};
+            for (int trace = 0; trace < traces.size(); ++trace) {
+                traces[trace].pyramid.append(values[trace]);
+            }
+            if (rows == 0) {
+                firstNs = records[i].sessionNs;
+            }
+            lastNs = records[i].sessionNs;
+            ++rows;
+        }
+    }
+    if (!reader.getLastError().isEmpty()) {
+        qDebug() << "Log viewer:" << reader.getLastError() << "in" << fileName;
+    }
+
+    // Samples are taken as evenly spaced over the logged time span
+    for (int i = traces.size() - 1; i >= 0 && traces.size() > 1; --i) {
+        const MinMaxPyramid::Summary summary = traces[i].pyramid.summarize(0, traces[i].pyramid.size());
+        if (summary.min == summary.max) {
+            traces.remove(i);
+        }
+    }
+    showLoaded(traces, rows > 1 && lastNs > firstNs ? (rows - 1) * 1.0e9 / (lastNs - firstNs) : 1.0);
+    return true;
+}
+
+void LogViewWidget::showLoaded(QVector<Trace> &traces, double sampleRate)
+{
+    m_traces.clear();
+    m_columns.clear();
+    for (Trace &trace : traces) {
+        trace.color = traceColor(m_traces.size());
+        m_traces.append(trace);
+    }
+    setSampleRate(sampleRate);
+    setFollow(false);
+    zoomToFit();
+}
+
+void LogViewWidget::setSampleRate(double sampleRate)
+{
+    m_sampleRate = sampleRate > 0.0 ? sampleRate : 1.0;
+    update();
+}
+
+qint64 LogViewWidget::dataLength() const
+{
+    qint64 length = 0;
+    for (const Trace &trace : m_traces) {
+        length = qMax(length, trace.pyramid.size());
+    }
+    return length;
+}
+
+void LogViewWidget::dataAppended()
+{
+    if (m_follow) {
+        m_viewFirst = dataLength() - m_viewSpan;
+    }
+    update();
+}
+
+void LogViewWidget::setFollow(bool follow)
+{
+    m_follow = follow;
+    dataAppended();
+}
+
+void LogViewWidget::stopFollowing()
+{
+    if (m_follow) {
+        m_follow = false;
+        emit followChanged(false);
+    }
+}
+
+void LogViewWidget::zoomToFit()
+{
+    setView(0.0, qMax<qint64>(dataLength(), 10));
+}
+
+void LogViewWidget::setView(double first, double span)
+{
+    // No closer than a few samples across, no wider than a day
+    m_viewSpan = qBound(4.0, span, 86400.0 * m_sampleRate);
+    m_viewFirst = first;
+    if (m_follow) {
+        m_viewFirst = dataLength() - m_viewSpan;
+    }
+    update();
+}
+
+QRect LogViewWidget::plotArea() const
+{
+    return rect().adjusted(55, 10, -15, -25);
+}
+
+void LogViewWidget::wheelEvent(QWheelEvent *event)
+{
+    const QRect area = plotArea();
+    const double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0.0 || area.width() <= 0) {
+        return;
+    }
+    stopFollowing();
+
+    // Keep the sample under the cursor where it is
+    const double position = qBound(0.0, (event->position().x() - area.left()) / area.width(), 1.0);
+    const double anchor = m_viewFirst + position * m_viewSpan;
+    const double span = m_viewSpan * std::pow(0.8, steps);
+    setView(anchor - position * span, span);
+}
+
+void LogViewWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = true;
+        m_dragStartX = event->position().x();
+        m_dragStartFirst = m_viewFirst;
+    }
+}
+
+void LogViewWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging || plotArea().width() <= 0) {
+        return;
+    }
+    stopFollowing();
+    const double shift = (event->position().x() - m_dragStartX) / plotArea().width() * m_viewSpan;
+    setView(m_dragStartFirst - shift, m_viewSpan);
+}
+
+void LogViewWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        m_dragging = false;
+    }
+}
+
+void LogViewWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    stopFollowing();
+    zoomToFit();
+}
+
+void LogViewWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    const QRect area = plotArea();
+    painter.setPen(QPen(Qt::darkGray, 1));
+    painter.drawRect(area);
+
+    const qint64 length = dataLength();
+    if (length == 0 || area.width() <= 0) {
+        painter.setPen(Qt::gray);
+        painter.drawText(area, Qt::AlignCenter, "No data");
+        return;
+    }
+
+    // One summary per column and trace; the vertical range follows the view
+    const int width = area.width();
+    const double samplesPerColumn = m_viewSpan / width;
+    m_columns.resize(m_traces.size());
+    double minValue = std::numeric_limits<double>::infinity();
+    double maxValue = -std::numeric_limits<double>::infinity();
+    for (int t = 0; t < m_traces.size(); ++t) {
+        m_columns[t].resize(width);
+        m_traces[t].pyramid.reduce(m_viewFirst, samplesPerColumn, width, m_columns[t].data());
+        for (const MinMaxPyramid::Summary &column : m_columns[t]) {
+            if (column.count > 0) {
+                minValue = qMin(minValue, double(column.min));
+                maxValue = qMax(maxValue, double(column.max));
+            }
+        }
+    }
+    if (!(minValue <= maxValue)) {
+        minValue = -1.0;
+        maxValue = 1.0;
+    }
+    const double pad = qMax((maxValue - minValue) * 0.05, 1e-6);
+    minValue -= pad;
+    maxValue += pad;
+
+    auto valueToY = [&](double value) {
+        return area.bottom() - (value - minValue) / (maxValue - minValue) * area.height();
+    };
+    auto sampleToX = [&](double sample) {
+        return area.left() + (sample - m_viewFirst) / m_viewSpan * width;
+    };
+
+    // Round grid steps of 1, 2 or 5 times a power of ten
+    auto gridStep = [](double range, int lines) {
+        const double rough = range / lines;
+        const double magnitude = std::pow(10.0, std::floor(std::log10(rough)));
+        for (double multiple : {1.0, 2.0, 5.0}) {
+            if (magnitude * multiple >= rough) {
+                return magnitude * multiple;
+            }
+        }
+        return magnitude * 10.0;
+    };
+
+    const QFontMetrics metrics = painter.fontMetrics();
+    const QPen gridPen(QColor(50, 50, 50), 1, Qt::DotLine);
+
+    const double valueStep = gridStep(maxValue - minValue, 5);
+    for (double value = std::ceil(minValue / valueStep) * valueStep; value <= maxValue; value += valueStep) {
+        const int y = static_cast<int>(valueToY(value));
+        painter.setPen(gridPen);
+        painter.drawLine(area.left(), y, area.right(), y);
+        painter.setPen(Qt::gray);
+        painter.drawText(QRect(0, y - metrics.height() / 2, area.left() - 4, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(value, 'g', 4));
+    }
+
+    const double firstTime = m_viewFirst / m_sampleRate;
+    const double spanTime = m_viewSpan / m_sampleRate;
+    const double timeStep = gridStep(spanTime, 8);
+    for (double time = std::ceil(firstTime / timeStep) * timeStep; time <= firstTime + spanTime;
+         time += timeStep) {
+        const int x = static_cast<int>(sampleToX(time * m_sampleRate));
+        painter.setPen(gridPen);
+        painter.drawLine(x, area.top(), x, area.bottom());
+        painter.setPen(Qt::gray);
+        painter.drawText(QRect(x - 40, area.bottom() + 4, 80, metrics.height()),
+                         Qt::AlignHCenter | Qt::AlignTop, QString("%1 s").arg(time, 0, 'g', 6));
+    }
+
+    painter.setClipRect(area);
+    for (int t = 0; t < m_traces.size(); ++t) {
+        const Trace &trace = m_traces[t];
+        if (samplesPerColumn <= 1.0) {
+            // Few enough samples to draw each one
+            const qint64 first = qMax<qint64>(0, static_cast<qint64>(std::floor(m_viewFirst)));
+            const qint64 last = qMin<qint64>(trace.pyramid.size(),
+                                             static_cast<qint64>(std::ceil(m_viewFirst + m_viewSpan)) + 1);
+            QPolygonF line;
+            for (qint64 i = first; i < last; ++i) {
+                line << QPointF(sampleToX(i), valueToY(trace.pyramid.sample(i)));
+            }
+            painter.setPen(QPen(trace.color, 1));
+            painter.drawPolyline(line);
+            continue;
+        }
+
+        // Min..max per column, joined to the previous column so steep
+        // edges stay connected, with the mean on top
+        const QVector<MinMaxPyramid::Summary> &columns = m_columns[t];
+        QColor envelope = trace.color;
+        envelope.setAlpha(140);
+        painter.setPen(QPen(envelope, 1));
+        QPolygonF mean;
+        const MinMaxPyramid::Summary *previous = nullptr;
+        for (int column = 0; column < width; ++column) {
+            const MinMaxPyramid::Summary &summary = columns[column];
+            if (summary.count == 0) {
+                previous = nullptr;
+                continue;
+            }
+            double low = summary.min;
+            double high = summary.max;
+            if (previous) {
+                low = qMin(low, double(previous->max));
+                high = qMax(high, double(previous->min));
+            }
+            const int x = area.left() + column;
+            painter.drawLine(x, static_cast<int>(valueToY(high)), x, static_cast<int>(valueToY(low)));
+            mean << QPointF(x + 0.5, valueToY(summary.mean()));
+            previous = &summary;
+        }
+        painter.setPen(QPen(trace.color.lighter(150), 1));
+        painter.drawPolyline(mean);
+    }
+    painter.setClipping(false);
+
+    // Legend and scale
+    int legendX = area.left() + 6;
+    for (const Trace &trace : m_traces) {
+        painter.setPen(trace.color);
+        painter.drawText(QRect(legendX, area.top() + 4, 200, metrics.height()),
+                         Qt::AlignLeft | Qt::AlignTop, trace.name);
+        legendX += metrics.horizontalAdvance(trace.name) + 12;
+    }
+    painter.setPen(Qt::white);
+    painter.drawText(area.adjusted(0, 4, -6, 0), Qt::AlignRight | Qt::AlignTop,
+                     QString("%1 of %2 s, %3 samples/px")
+                         .arg(spanTime, 0, 'g', 4)
+                         .arg(length / m_sampleRate, 0, 'g', 4)
+                         .arg(samplesPerColumn, 0, 'g', 3));
+}
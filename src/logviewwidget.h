@@ -0,0 +1,100 @@
+#ifndef LOGVIEWWIDGET_H
+#define LOGVIEWWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+#include <QColor>
+#include "minmaxpyramid.h"
+
+// Zoomable plot of long recordings.
+//
+// Each trace keeps its samples in a MinMaxPyramid, so a repaint reduces the
+// visible range to one min/max/mean per pixel column at a cost set by the
+// widget width, not by the hours of data behind it. Zoomed in past one
+// sample per column the samples themselves are drawn. The wheel zooms
+// around the cursor, dragging pans and a double click shows everything.
+// Traces can keep growing while shown; with follow on, the view stays on
+// the newest data.
+class LogViewWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LogViewWidget(QWidget *parent = nullptr);
+
+    // Traces share one sample rate and start at sample 0
+    void clearTraces();
+    int addTrace(const QString &name, const QColor &color);
+    int traceCount() const { return m_traces.size(); }
+    MinMaxPyramid &trace(int index) { return m_traces[index].pyramid; }
+
+    // Replace the traces with the numeric columns of a CSV log written by
+    // this application; the time column sets the sample rate, columns that
+    // never change (frequency, amplitude of a fixed run) are left out
+    bool loadCsv(const QString &fileName);
+    // The same for a binary log; the per-block min/max tell constant
+    // columns apart before any values are decoded
+    bool loadBinaryLog(const QString &fileName);
+    // The same for a tracker log (.jtmtrk): the track errors, target pixel
+    // count and mount position, decoded from the stored status messages
+    bool loadTrackLog(const QString &fileName);
+    QString getLastError() const { return m_lastError; }
+
+    void setSampleRate(double sampleRate);
+    double sampleRate() const { return m_sampleRate; }
+
+    // Call after appending samples to any trace
+    void dataAppended();
+
+    void setFollow(bool follow);
+    bool follow() const { return m_follow; }
+    void zoomToFit();
+
+    QSize sizeHint() const override { return QSize(600, 300); }
+
+signals:
+    // Zooming or panning by hand stops following
+    void followChanged(bool follow);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct Trace {
+        QString name;
+        QColor color;
+        MinMaxPyramid pyramid;
+    };
+
+    QVector<Trace> m_traces;
+    double m_sampleRate;
+    QString m_lastError;
+
+    // View in samples: first sample at the left edge, samples across
+    double m_viewFirst;
+    double m_viewSpan;
+    bool m_follow;
+
+    bool m_dragging;
+    double m_dragStartX;
+    double m_dragStartFirst;
+
+    // Per-column reduction of every visible trace, reused between paints
+    QVector<QVector<MinMaxPyramid::Summary>> m_columns;
+
+    QRect plotArea() const;
+    qint64 dataLength() const;
+    void setView(double first, double span);
+    void stopFollowing();
+    void showLoaded(QVector<Trace> &traces, double sampleRate);
+
+    static QColor traceColor(int index);
+};
+
+#endif // LOGVIEWWIDGET_H
@@ -1,5 +1,7 @@
 #include "mainwindow.h"
+#include "tracelog.h"
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QSurfaceFormat>
 
 int main(int argc, char *argv[])
@@ -10,9 +12,33 @@ int main(int argc, char *argv[])
     QApplication::setApplicationName("Joystick Mirror Controller");
     QApplication::setApplicationVersion("1.0");
     QApplication::setOrganizationName("Your Organization");
-    
-    MainWindow w;
-    w.show();
-    
-    return a.exec();
+
+    // Command line options
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Joystick and tracker control for a fast steering mirror");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption backendOption("ao-backend",
+        "Mirror output backend: advantech, simulated or null.", "backend", "advantech");
+    parser.addOption(backendOption);
+    parser.process(a);
+
+    AoBackend::Type aoBackend = AoBackend::Advantech;
+    if (!AoBackend::typeFromName(parser.value(backendOption), &aoBackend)) {
+        qCritical("Unknown output backend '%s'", qPrintable(parser.value(backendOption)));
+        return 1;
+    }
+
+    // Drain hot-path trace messages in the background
+    TraceLog::start();
+
+    int result;
+    {
+        MainWindow w(aoBackend);
+        w.show();
+        result = a.exec();
+    }
+
+    TraceLog::stop();
+    return result;
 }
\ No newline at end of file
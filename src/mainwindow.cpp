@@ -19,34 +19,48 @@
 #include <QPainter>
 #include <QDateTime>
 #include <QElapsedTimer>
-
-MainWindow::MainWindow(QWidget *parent)
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QRegularExpression>
+#include <QFileInfo>
+#include <algorithm>
+#include "simulatedaostream.h"
+#include "spectrumwidget.h"
+#include "scopewidget.h"
+#include "logviewwidget.h"
+#include "xyscopewidget.h"
+#include "monotonicclock.h"
+#include "simulatedaobackend.h"
+
+MainWindow::MainWindow(AoBackend::Type aoBackend, QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_joystickManager(new JoystickManager(this))
     , m_mirrorController(new FastSteeringMirror(this))
+    , m_outputThread(new OutputThread(m_mirrorController, this))
+    , m_streamThread(new StreamThread(m_mirrorController, this))
     , m_selectedJoystickIndex(-1)
     , m_mirrorOutputEnabled(false)
-    , m_xAxisIndex(0)
-    , m_yAxisIndex(1)
-    , m_invertXAxis(false)
-    , m_invertYAxis(false)
-    , m_deadzone(0.05)  // 5% deadzone
-    , m_updateTimer(new QTimer(this))
+    , m_outputStatusTimer(new QTimer(this))
     , m_sineWaveActive(false)
-    , m_sinePhase(0.0)
     , m_sineFrequency(10.0)
     , m_sineAmplitude(0.5)
     , m_phaseOffset(90)
+    , m_commandHistoryRead(0)
+    , m_feedbackHistoryRead(0)
+    , m_sweepActive(false)
+    , m_spectrumSource(SpectrumXCommand)
+    , m_spectrumFramesShown(0)
+    , m_spectrumTimer(nullptr)
+    , m_logViewTimer(nullptr)
+    , m_logViewReadIndex(0)
+    , m_scopeSampleRate(1000.0)
     , m_loggingActive(false)
-    , m_logFile(nullptr)
-    , m_logStream(nullptr)
     , m_loggingThread(new LoggingThread(this))
     // Initialize tracker-related members
     , m_trackerMemory(new TrackerMemory(this))
     , m_trackerLogger(new Logger(this))
     , m_trackerPollTimer(new QTimer(this))
-    , m_loggingTimer()
 {
     ui->setupUi(this);
 
@@ -98,6 +112,18 @@ MainWindow::MainWindow(QWidget *parent)
     QWidget *mirrorTab = new QWidget();
     QVBoxLayout *mirrorLayout = new QVBoxLayout(mirrorTab);
 
+    // Add output backend selection
+    QHBoxLayout *backendLayout = new QHBoxLayout();
+    backendLayout->addWidget(new QLabel("Output Backend:"));
+    m_aoBackendComboBox = new QComboBox();
+    m_aoBackendComboBox->addItem(AoBackend::displayName(AoBackend::Advantech), AoBackend::Advantech);
+    m_aoBackendComboBox->addItem(AoBackend::displayName(AoBackend::Simulated), AoBackend::Simulated);
+    m_aoBackendComboBox->addItem(AoBackend::displayName(AoBackend::Null), AoBackend::Null);
+    m_aoBackendComboBox->setCurrentIndex(m_aoBackendComboBox->findData(aoBackend));
+    backendLayout->addWidget(m_aoBackendComboBox);
+    backendLayout->addStretch();
+    mirrorLayout->addLayout(backendLayout);
+
     // Add mirror device selection controls
     QHBoxLayout *mirrorSelectionLayout = new QHBoxLayout();
     mirrorSelectionLayout->addWidget(new QLabel("Select Mirror Device:"));
@@ -140,6 +166,49 @@ MainWindow::MainWindow(QWidget *parent)
     // Add the group to the mirror controls
     mirrorLayout->addWidget(profileGroup);
 
+    // Simulated mirror dynamics, only shown for the simulated backend
+    m_simulatedMirrorGroup = new QGroupBox("Simulated Mirror");
+    QGridLayout *simulatedLayout = new QGridLayout(m_simulatedMirrorGroup);
+
+    simulatedLayout->addWidget(new QLabel("Response:"), 0, 0);
+    m_simOrderComboBox = new QComboBox();
+    m_simOrderComboBox->addItem("First order");
+    m_simOrderComboBox->addItem("Second order");
+    m_simOrderComboBox->setCurrentIndex(1);
+    simulatedLayout->addWidget(m_simOrderComboBox, 0, 1);
+
+    simulatedLayout->addWidget(new QLabel("Bandwidth:"), 0, 2);
+    m_simBandwidthSpinBox = new QDoubleSpinBox();
+    m_simBandwidthSpinBox->setRange(1.0, 20000.0);
+    m_simBandwidthSpinBox->setValue(500.0);
+    m_simBandwidthSpinBox->setSuffix(" Hz");
+    simulatedLayout->addWidget(m_simBandwidthSpinBox, 0, 3);
+
+    simulatedLayout->addWidget(new QLabel("Damping:"), 1, 0);
+    m_simDampingSpinBox = new QDoubleSpinBox();
+    m_simDampingSpinBox->setRange(0.0, 2.0);
+    m_simDampingSpinBox->setSingleStep(0.05);
+    m_simDampingSpinBox->setValue(0.7);
+    simulatedLayout->addWidget(m_simDampingSpinBox, 1, 1);
+
+    simulatedLayout->addWidget(new QLabel("Latency:"), 1, 2);
+    m_simLatencySpinBox = new QDoubleSpinBox();
+    m_simLatencySpinBox->setRange(0.0, 100000.0);
+    m_simLatencySpinBox->setValue(100.0);
+    m_simLatencySpinBox->setSuffix(" us");
+    simulatedLayout->addWidget(m_simLatencySpinBox, 1, 3);
+
+    simulatedLayout->addWidget(new QLabel("DAC Resolution:"), 2, 0);
+    m_simDacBitsSpinBox = new QSpinBox();
+    m_simDacBitsSpinBox->setRange(0, 24);
+    m_simDacBitsSpinBox->setValue(16);
+    m_simDacBitsSpinBox->setSuffix(" bits");
+    m_simDacBitsSpinBox->setSpecialValueText("Unquantized");
+    simulatedLayout->addWidget(m_simDacBitsSpinBox, 2, 1);
+
+    m_simulatedMirrorGroup->setVisible(aoBackend == AoBackend::Simulated);
+    mirrorLayout->addWidget(m_simulatedMirrorGroup);
+
     // Add mirror enable checkbox
     m_enableMirrorCheckbox = new QCheckBox("Enable Mirror Output");
     mirrorLayout->addWidget(m_enableMirrorCheckbox);
@@ -169,6 +238,44 @@ MainWindow::MainWindow(QWidget *parent)
 
     mirrorLayout->addWidget(mappingGroup);
 
+    // Output thread scheduling
+    QGroupBox *outputThreadGroup = new QGroupBox("Output Thread");
+    QGridLayout *outputThreadLayout = new QGridLayout(outputThreadGroup);
+
+    outputThreadLayout->addWidget(new QLabel("Update Rate:"), 0, 0);
+    m_outputRateSpinBox = new QSpinBox();
+    m_outputRateSpinBox->setRange(100, 10000);
+    m_outputRateSpinBox->setValue(1000);
+    m_outputRateSpinBox->setSingleStep(100);
+    m_outputRateSpinBox->setSuffix(" Hz");
+    outputThreadLayout->addWidget(m_outputRateSpinBox, 0, 1);
+
+    m_outputRealtimeCheckBox = new QCheckBox("Real-time priority (SCHED_FIFO)");
+    outputThreadLayout->addWidget(m_outputRealtimeCheckBox, 0, 2);
+    m_outputPrioritySpinBox = new QSpinBox();
+    m_outputPrioritySpinBox->setRange(1, 99);
+    m_outputPrioritySpinBox->setValue(80);
+    outputThreadLayout->addWidget(m_outputPrioritySpinBox, 0, 3);
+
+    outputThreadLayout->addWidget(new QLabel("CPU:"), 1, 0);
+    m_outputCpuSpinBox = new QSpinBox();
+    m_outputCpuSpinBox->setRange(-1, 255);
+    m_outputCpuSpinBox->setValue(-1);
+    m_outputCpuSpinBox->setSpecialValueText("Any");
+    outputThreadLayout->addWidget(m_outputCpuSpinBox, 1, 1);
+
+    m_outputLockMemoryCheckBox = new QCheckBox("Lock memory");
+    outputThreadLayout->addWidget(m_outputLockMemoryCheckBox, 1, 2);
+
+    QPushButton *applyOutputThreadButton = new QPushButton("Apply");
+    outputThreadLayout->addWidget(applyOutputThreadButton, 1, 3);
+
+    m_outputThreadStatusLabel = new QLabel("Output thread not running");
+    m_outputThreadStatusLabel->setWordWrap(true);
+    outputThreadLayout->addWidget(m_outputThreadStatusLabel, 2, 0, 1, 4);
+
+    mirrorLayout->addWidget(outputThreadGroup);
+
     // Create placeholder for mirror status UI
     QWidget *mirrorStatusWidget = new QWidget();
     m_mirrorStatusLayout = new QVBoxLayout(mirrorStatusWidget);
@@ -188,6 +295,8 @@ MainWindow::MainWindow(QWidget *parent)
     m_joystickManager->initialize();
 
     // Initialize mirror controller
+    m_mirrorController->setBackendType(aoBackend);
+    applySimulatedMirrorParameters();
     if (!m_mirrorController->initialize()) {
         QMessageBox::warning(this, "Mirror Initialization Error",
             "Failed to initialize mirror controller: " + m_mirrorController->getLastError());
@@ -199,10 +308,23 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::onJoystickSelected);
     connect(calibrateButton, &QPushButton::clicked, this, &MainWindow::onCalibrateJoystick);
 
+    connect(m_aoBackendComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onAoBackendChanged);
+    connect(m_simOrderComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::applySimulatedMirrorParameters);
+    connect(m_simBandwidthSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::applySimulatedMirrorParameters);
+    connect(m_simDampingSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::applySimulatedMirrorParameters);
+    connect(m_simLatencySpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::applySimulatedMirrorParameters);
+    connect(m_simDacBitsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::applySimulatedMirrorParameters);
     connect(m_refreshMirrorButton, &QPushButton::clicked, this, &MainWindow::onRefreshMirrorDevices);
     connect(m_mirrorDeviceComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onMirrorDeviceSelected);
     connect(m_enableMirrorCheckbox, &QCheckBox::toggled, this, &MainWindow::onEnableMirrorOutput);
+    connect(applyOutputThreadButton, &QPushButton::clicked, this, &MainWindow::onApplyOutputThreadConfig);
 
     connect(m_xAxisComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onAxisMappingChanged);
@@ -251,9 +373,16 @@ MainWindow::MainWindow(QWidget *parent)
         }
     });
 
-    // Configure timer for mirror updates
-    connect(m_updateTimer, &QTimer::timeout, this, &MainWindow::onUpdateMirrorPosition);
-    m_updateTimer->setInterval(16);  // ~60Hz updates
+    // The joystick publishes mapped positions straight to the output thread
+    m_joystickManager->setSetpointMailbox(m_outputThread->mailbox(OutputThread::JoystickSource));
+
+    // Start the output thread idle; it sleeps until a source is selected
+    m_outputThread->setLoggingThread(m_loggingThread);
+    m_outputThread->startOutput(OutputThreadConfig());
+    m_streamThread->setLoggingThread(m_loggingThread);
+    connect(m_outputStatusTimer, &QTimer::timeout, this, &MainWindow::onOutputStatusTimer);
+    m_outputStatusTimer->setInterval(100);
+    m_outputStatusTimer->start();
 
     // Connect tracker signals and configure poll timer
     connect(m_trackerMemory, &TrackerMemory::errorOccurred, this, &MainWindow::handleTrackerError);
@@ -267,6 +396,21 @@ MainWindow::MainWindow(QWidget *parent)
     // Create sine wave tab
     createSineWaveTab();
 
+    // Create frequency response tab
+    createFrequencyResponseTab();
+
+    // Create spectrum analyzer tab
+    createSpectrumTab();
+
+    // Create XY scope tab
+    createXyScopeTab();
+
+    // Create log viewer tab
+    createLogViewTab();
+
+    // Create diagnostics tab
+    createDiagnosticsTab();
+
     // Initial updates
     updateJoystickList();
     updateMirrorDeviceList();
@@ -275,26 +419,18 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     // Stop all timers
-    m_updateTimer->stop();
+    m_outputStatusTimer->stop();
+    m_diagnosticsTimer->stop();
+    m_spectrumTimer->stop();
+    m_logViewTimer->stop();
     m_trackerPollTimer->stop();
 
-    if (m_sineWaveTimer) {
-        m_sineWaveTimer->stop();
-    }
-
-    // Close joystick logging if active
-    if (m_loggingActive) {
-        if (m_logStream) {
-            m_logStream->flush();
-            delete m_logStream;
-            m_logStream = nullptr;
-        }
+    // No mirror writes may be in flight while the device is closed
+    m_outputThread->stopOutput();
+    m_streamThread->stopStreaming();
 
-        if (m_logFile) {
-            m_logFile->close();
-            delete m_logFile;
-            m_logFile = nullptr;
-        }
+    if (m_displayTimer) {
+        m_displayTimer->stop();
     }
 
     // Close tracker logging
@@ -572,6 +708,48 @@ QString MainWindow::hatValueToString(int value)
 }
 
 // Mirror related methods
+void MainWindow::onAoBackendChanged(int index)
+{
+    AoBackend::Type type = static_cast<AoBackend::Type>(m_aoBackendComboBox->itemData(index).toInt());
+    if (type == m_mirrorController->backendType()) {
+        return;
+    }
+
+    // Stop everything driving the current backend first
+    if (m_sineWaveActive) {
+        onStartStopSineWave();
+        m_sineWaveButton->setChecked(false);
+    }
+    m_enableMirrorCheckbox->setChecked(false);
+    m_outputThread->setSource(OutputThread::NoSource);
+
+    if (!m_mirrorController->setBackendType(type)) {
+        QMessageBox::warning(this, "Mirror Initialization Error",
+            "Failed to initialize " + AoBackend::displayName(type) + ": " +
+            m_mirrorController->getLastError());
+    }
+
+    m_simulatedMirrorGroup->setVisible(type == AoBackend::Simulated);
+    applySimulatedMirrorParameters();
+    updateMirrorDeviceList();
+}
+
+void MainWindow::applySimulatedMirrorParameters()
+{
+    SimulatedAoBackend *simulated = qobject_cast<SimulatedAoBackend *>(m_mirrorController->backend());
+    if (!simulated) {
+        return;
+    }
+
+    MirrorModelParams params;
+    params.order = m_simOrderComboBox->currentIndex() + 1;
+    params.bandwidthHz = m_simBandwidthSpinBox->value();
+    params.damping = m_simDampingSpinBox->value();
+    params.latency = m_simLatencySpinBox->value() * 1e-6;
+    params.dacBits = m_simDacBitsSpinBox->value();
+    simulated->setModelParameters(params);
+}
+
 void MainWindow::onRefreshMirrorDevices()
 {
     updateMirrorDeviceList();
@@ -598,7 +776,8 @@ void MainWindow::onMirrorDeviceSelected(int index)
         m_enableMirrorCheckbox->setEnabled(false);
         m_enableMirrorCheckbox->setChecked(false);
         m_mirrorOutputEnabled = false;
-        m_updateTimer->stop();
+        m_outputThread->setSource(OutputThread::NoSource);
+        m_streamThread->stopStreaming();
         m_mirrorController->closeDevice();
         return;
     }
@@ -611,13 +790,17 @@ void MainWindow::onMirrorDeviceSelected(int index)
         m_mirrorController->setProfilePath(profilePath);
     }
 
+    // Reopening replaces the device under the output and stream threads
+    m_outputThread->setSource(OutputThread::NoSource);
+    m_streamThread->stopStreaming();
+
     if (m_mirrorController->openDevice(deviceName)) {
         m_enableMirrorCheckbox->setEnabled(true);
+        updateOutputSource();
     } else {
         m_enableMirrorCheckbox->setEnabled(false);
         m_enableMirrorCheckbox->setChecked(false);
         m_mirrorOutputEnabled = false;
-        m_updateTimer->stop();
         QMessageBox::warning(this, "Device Error",
             "Failed to open mirror device: " + m_mirrorController->getLastError());
     }
@@ -702,81 +885,49 @@ void MainWindow::onEnableMirrorOutput(bool enabled)
 
         // All checks passed, enable output
         m_mirrorOutputEnabled = true;
-        m_updateTimer->start();
+        updateOutputSource();
         qDebug() << "Mirror output enabled successfully!";
     } else {
-        // Stop the update timer when mirror output is disabled
-        m_updateTimer->stop();
         m_mirrorOutputEnabled = false;
-
-        // Reset mirror position to center
-        if (m_mirrorController->isDeviceOpen()) {
-            m_mirrorController->setPosition(0.0, 0.0);
-        }
+        updateOutputSource();
 
         qDebug() << "Mirror output disabled.";
     }
 }
 
-void MainWindow::onUpdateMirrorPosition()
+void MainWindow::onApplyOutputThreadConfig()
 {
-    if (!m_mirrorOutputEnabled || !m_joystickManager->isJoystickOpen() || !m_mirrorController->isDeviceOpen()) {
-        m_updateTimer->stop();
-        m_enableMirrorCheckbox->setChecked(false);
-        m_mirrorOutputEnabled = false;
-        return;
-    }
-
-    // Get axis values from mapping
-    int numAxes = m_joystickManager->getNumAxes();
-    if (m_xAxisIndex >= numAxes || m_yAxisIndex >= numAxes) {
-        return;
-    }
-
-    // Get the current joystick positions for X and Y axes
-    int xAxisValue = 0;
-    int yAxisValue = 0;
-
-    // Find the appropriate axis values from the UI
-    for (int i = 0; i < m_axisProgressBars.size(); i++) {
-        if (i == m_xAxisIndex) {
-            xAxisValue = m_axisProgressBars[i]->value();
-        }
-        if (i == m_yAxisIndex) {
-            yAxisValue = m_axisProgressBars[i]->value();
-        }
-    }
-
-    // Map joystick values to mirror positions
-    double xPosition = mapAxisToPosition(xAxisValue);
-    double yPosition = mapAxisToPosition(yAxisValue);
-
-    // Apply inversion if needed
-    if (m_invertXAxis) xPosition = -xPosition;
-    if (m_invertYAxis) yPosition = -yPosition;
-
-    // Update the mirror position
-    m_mirrorController->setPosition(xPosition, yPosition);
+    OutputThreadConfig config;
+    config.rateHz = m_outputRateSpinBox->value();
+    config.realtime = m_outputRealtimeCheckBox->isChecked();
+    config.priority = m_outputPrioritySpinBox->value();
+    config.cpu = m_outputCpuSpinBox->value();
+    config.lockMemory = m_outputLockMemoryCheckBox->isChecked();
+
+    // Restarting keeps the selected source and setpoints
+    m_outputThread->startOutput(config);
 }
 
-double MainWindow::mapAxisToPosition(int axisValue)
+void MainWindow::onOutputStatusTimer()
 {
-    // Convert joystick axis value (-32768 to 32767) to position (-1.0 to 1.0)
-    double normalizedValue = axisValue / 32768.0;
-
-    // Apply deadzone
-    if (qAbs(normalizedValue) < m_deadzone) {
-        return 0.0;
-    }
-
-    // Rescale the remaining range to still use the full -1 to 1 output range
-    if (normalizedValue > 0) {
-        normalizedValue = (normalizedValue - m_deadzone) / (1.0 - m_deadzone);
-    } else {
-        normalizedValue = (normalizedValue + m_deadzone) / (1.0 - m_deadzone);
+    m_outputThreadStatusLabel->setText(
+        QString("%1 Hz, %2 cycles, %3 deadline misses, max wake latency %4 us, "
+                "setpoint latency %5 us (max %6 us) (%7)")
+            .arg(m_outputThread->config().rateHz)
+            .arg(m_outputThread->cycleCount())
+            .arg(m_outputThread->deadlineMisses())
+            .arg(m_outputThread->maxWakeLatencyUs(), 0, 'f', 1)
+            .arg(m_outputThread->setpointLatencyUs(), 0, 'f', 1)
+            .arg(m_outputThread->maxSetpointLatencyUs(), 0, 'f', 1)
+            .arg(m_outputThread->schedulingStatus()));
+
+    // The output thread does not signal each write; refresh the status here
+    if (m_outputThread->source() != OutputThread::NoSource) {
+        double xPosition = 0.0;
+        double yPosition = 0.0;
+        m_outputThread->lastPosition(&xPosition, &yPosition);
+        onMirrorPositionChanged(xPosition, yPosition);
     }
-
-    return qBound(-1.0, normalizedValue, 1.0);
 }
 
 void MainWindow::onMirrorPositionChanged(double xPosition, double yPosition)
@@ -799,7 +950,7 @@ void MainWindow::onMirrorDeviceError(const QString &errorMessage)
     // Disable mirror output on error
     m_enableMirrorCheckbox->setChecked(false);
     m_mirrorOutputEnabled = false;
-    m_updateTimer->stop();
+    updateOutputSource();
 }
 
 void MainWindow::onAxisMappingChanged()
@@ -808,24 +959,20 @@ void MainWindow::onAxisMappingChanged()
         return;
     }
 
-    m_xAxisIndex = m_xAxisComboBox->currentData().toInt();
-    m_yAxisIndex = m_yAxisComboBox->currentData().toInt();
+    m_joystickManager->setAxisMapping(m_xAxisComboBox->currentData().toInt(),
+                                      m_yAxisComboBox->currentData().toInt());
 }
 
 void MainWindow::onDeadzoneChanged(int value)
 {
-    m_deadzone = value / 100.0;
+    m_joystickManager->setDeadzone(value / 100.0);
 }
 
 void MainWindow::onInvertAxisToggled(bool checked)
 {
-    QObject *sender = QObject::sender();
-
-    if (sender == m_invertXCheckbox) {
-        m_invertXAxis = checked;
-    } else if (sender == m_invertYCheckbox) {
-        m_invertYAxis = checked;
-    }
+    Q_UNUSED(checked);
+    m_joystickManager->setAxisInversion(m_invertXCheckbox->isChecked(),
+                                        m_invertYCheckbox->isChecked());
 }
 
 // Sine wave test methods
@@ -836,44 +983,94 @@ void MainWindow::createSineWaveTab()
     QVBoxLayout *mainLayout = new QVBoxLayout(sineWaveTab);
 
     // Create parameter controls group
-    QGroupBox *parametersGroup = new QGroupBox("Sine Wave Parameters");
+    QGroupBox *parametersGroup = new QGroupBox("Waveform Parameters");
     QGridLayout *parametersLayout = new QGridLayout(parametersGroup);
 
+    // Waveform shape
+    parametersLayout->addWidget(new QLabel("Waveform:"), 0, 0);
+    m_waveformShapeComboBox = new QComboBox();
+    for (int shape = static_cast<int>(WaveformShape::Sine);
+         shape <= static_cast<int>(WaveformShape::Prbs); ++shape) {
+        m_waveformShapeComboBox->addItem(
+            WaveformGenerator::shapeName(static_cast<WaveformShape>(shape)), shape);
+    }
+    m_waveformShapeComboBox->setToolTip("Chirp starts at Frequency; PRBS uses Frequency as its chip rate");
+    parametersLayout->addWidget(m_waveformShapeComboBox, 0, 1);
+    connect(m_waveformShapeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onWaveformShapeChanged);
+
+    // Shape-specific parameters, enabled for the shape that uses them
+    parametersLayout->addWidget(new QLabel("Shape Parameters:"), 1, 0);
+    QHBoxLayout *shapeLayout = new QHBoxLayout();
+    shapeLayout->addWidget(new QLabel("End:"));
+    m_endFrequencySpinBox = new QDoubleSpinBox();
+    m_endFrequencySpinBox->setRange(0.1, 5000.0);
+    m_endFrequencySpinBox->setValue(100.0);
+    m_endFrequencySpinBox->setDecimals(1);
+    m_endFrequencySpinBox->setSuffix(" Hz");
+    shapeLayout->addWidget(m_endFrequencySpinBox);
+    shapeLayout->addWidget(new QLabel("Sweep:"));
+    m_sweepTimeSpinBox = new QDoubleSpinBox();
+    m_sweepTimeSpinBox->setRange(0.1, 600.0);
+    m_sweepTimeSpinBox->setValue(10.0);
+    m_sweepTimeSpinBox->setDecimals(1);
+    m_sweepTimeSpinBox->setSuffix(" s");
+    shapeLayout->addWidget(m_sweepTimeSpinBox);
+    shapeLayout->addWidget(new QLabel("Tones:"));
+    m_toneCountSpinBox = new QSpinBox();
+    m_toneCountSpinBox->setRange(1, MultisineGenerator::MaxTones);
+    m_toneCountSpinBox->setValue(8);
+    shapeLayout->addWidget(m_toneCountSpinBox);
+    shapeLayout->addWidget(new QLabel("PRBS order:"));
+    m_prbsOrderSpinBox = new QSpinBox();
+    m_prbsOrderSpinBox->setRange(2, 16);
+    m_prbsOrderSpinBox->setValue(10);
+    shapeLayout->addWidget(m_prbsOrderSpinBox);
+    parametersLayout->addLayout(shapeLayout, 1, 1);
+    connect(m_endFrequencySpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::updatePeriodicOutput);
+    connect(m_sweepTimeSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::updatePeriodicOutput);
+    connect(m_toneCountSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updatePeriodicOutput);
+    connect(m_prbsOrderSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::updatePeriodicOutput);
+
     // Frequency control
-    parametersLayout->addWidget(new QLabel("Frequency (Hz):"), 0, 0);
+    parametersLayout->addWidget(new QLabel("Frequency (Hz):"), 2, 0);
     m_frequencySpinBox = new QDoubleSpinBox();
     m_frequencySpinBox->setRange(0.1, 1000.0);
     m_frequencySpinBox->setValue(10.0);
     m_frequencySpinBox->setSingleStep(0.1);
     m_frequencySpinBox->setDecimals(1);
     m_frequencySpinBox->setSuffix(" Hz");
-    parametersLayout->addWidget(m_frequencySpinBox, 0, 1);
+    parametersLayout->addWidget(m_frequencySpinBox, 2, 1);
     connect(m_frequencySpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this, &MainWindow::onFrequencyChanged);
 
     // Amplitude control
-    parametersLayout->addWidget(new QLabel("Amplitude:"), 1, 0);
+    parametersLayout->addWidget(new QLabel("Amplitude:"), 3, 0);
     m_amplitudeSpinBox = new QDoubleSpinBox();
     m_amplitudeSpinBox->setRange(0.01, 1.0);
     m_amplitudeSpinBox->setValue(0.5);
     m_amplitudeSpinBox->setSingleStep(0.01);
     m_amplitudeSpinBox->setDecimals(2);
-    parametersLayout->addWidget(m_amplitudeSpinBox, 1, 1);
+    parametersLayout->addWidget(m_amplitudeSpinBox, 3, 1);
     connect(m_amplitudeSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
             this, &MainWindow::onAmplitudeChanged);
 
     // Phase offset control (degrees between X and Y axes)
-    parametersLayout->addWidget(new QLabel("Phase Offset (°):"), 2, 0);
+    parametersLayout->addWidget(new QLabel("Phase Offset (°):"), 4, 0);
     m_phaseOffsetSpinBox = new QSpinBox();
     m_phaseOffsetSpinBox->setRange(0, 359);
     m_phaseOffsetSpinBox->setValue(90);
     m_phaseOffsetSpinBox->setSuffix("°");
-    parametersLayout->addWidget(m_phaseOffsetSpinBox, 2, 1);
+    parametersLayout->addWidget(m_phaseOffsetSpinBox, 4, 1);
     connect(m_phaseOffsetSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &MainWindow::onPhaseOffsetChanged);
 
     // Axis selection controls
-    parametersLayout->addWidget(new QLabel("Output Axes:"), 3, 0);
+    parametersLayout->addWidget(new QLabel("Output Axes:"), 5, 0);
     QHBoxLayout *axisLayout = new QHBoxLayout();
     m_xAxisCheckBox = new QCheckBox("X-Axis");
     m_xAxisCheckBox->setChecked(true);
@@ -885,17 +1082,52 @@ void MainWindow::createSineWaveTab()
     axisLayout->addWidget(m_yAxisCheckBox);
     connect(m_yAxisCheckBox, &QCheckBox::toggled, this, &MainWindow::onYAxisToggled);
 
-    parametersLayout->addLayout(axisLayout, 3, 1);
+    parametersLayout->addLayout(axisLayout, 5, 1);
+
+    // Output timing: software timer or hardware-clocked buffered output
+    parametersLayout->addWidget(new QLabel("Output Mode:"), 6, 0);
+    m_outputModeComboBox = new QComboBox();
+    m_outputModeComboBox->addItem("Output thread (software timed)");
+    m_outputModeComboBox->addItem("Hardware clocked (streamed)");
+    m_outputModeComboBox->addItem("Hardware clocked (cyclic)");
+    parametersLayout->addWidget(m_outputModeComboBox, 6, 1);
+    connect(m_outputModeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onOutputModeChanged);
+
+    parametersLayout->addWidget(new QLabel("Sample Rate:"), 7, 0);
+    QHBoxLayout *sampleRateLayout = new QHBoxLayout();
+    m_sampleRateSpinBox = new QSpinBox();
+    m_sampleRateSpinBox->setRange(1000, 100000);
+    m_sampleRateSpinBox->setValue(10000);
+    m_sampleRateSpinBox->setSingleStep(1000);
+    m_sampleRateSpinBox->setSuffix(" S/s");
+    sampleRateLayout->addWidget(m_sampleRateSpinBox);
+    parametersLayout->addLayout(sampleRateLayout, 7, 1);
+
+    // Sensor feedback: buffered AI clocked alongside the buffered AO
+    parametersLayout->addWidget(new QLabel("Feedback:"), 8, 0);
+    QHBoxLayout *feedbackLayout = new QHBoxLayout();
+    m_feedbackCheckBox = new QCheckBox("Acquire sensors (AI0/AI1)");
+    m_feedbackCheckBox->setToolTip("Log the measured sensor voltages instead of the commanded ones");
+    feedbackLayout->addWidget(m_feedbackCheckBox);
+    feedbackLayout->addWidget(new QLabel("Delay:"));
+    m_feedbackDelaySpinBox = new QSpinBox();
+    m_feedbackDelaySpinBox->setRange(0, 10000);
+    m_feedbackDelaySpinBox->setValue(0);
+    m_feedbackDelaySpinBox->setSuffix(" samples");
+    m_feedbackDelaySpinBox->setToolTip("Frames between a command leaving the AO and its response at the AI");
+    feedbackLayout->addWidget(m_feedbackDelaySpinBox);
+    parametersLayout->addLayout(feedbackLayout, 8, 1);
 
     // Add parameters group to main layout
     mainLayout->addWidget(parametersGroup);
 
     // Create output control group
-    QGroupBox *outputGroup = new QGroupBox("Sine Wave Output");
+    QGroupBox *outputGroup = new QGroupBox("Waveform Output");
     QVBoxLayout *outputLayout = new QVBoxLayout(outputGroup);
 
-    // Start/Stop sine wave button
-    m_sineWaveButton = new QPushButton("Start Sine Wave");
+    // Start/Stop waveform button
+    m_sineWaveButton = new QPushButton("Start Waveform");
     m_sineWaveButton->setIcon(QIcon(":/sinewaveOff.svg"));
     m_sineWaveButton->setIconSize(QSize(32, 32));
     m_sineWaveButton->setCheckable(true);
@@ -924,13 +1156,31 @@ void MainWindow::createSineWaveTab()
     yOutputLayout->addWidget(m_yOutputBar);
     outputLayout->addLayout(yOutputLayout);
 
-    // Waveform visualization - allow resize but set minimum
-    m_waveformLabel = new QLabel("Sine Wave Visualization");
-    m_waveformLabel->setAlignment(Qt::AlignCenter);
-    m_waveformLabel->setMinimumSize(400, 150); // Set minimum size instead of fixed
-    m_waveformLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding); // Allow expansion
-    m_waveformLabel->setStyleSheet("border: 1px solid gray; background-color: black;");
-    outputLayout->addWidget(m_waveformLabel);
+    // Buffered output statistics
+    m_streamStatusLabel = new QLabel();
+    outputLayout->addWidget(m_streamStatusLabel);
+
+    // Waveform visualization; history reaches back minutes at full rate
+    QHBoxLayout *scopeLayout = new QHBoxLayout();
+    scopeLayout->addWidget(new QLabel("Scope Window:"));
+    m_scopeWindowComboBox = new QComboBox();
+    for (double seconds : {1.0, 2.0, 5.0, 10.0, 30.0, 60.0, 120.0, 300.0}) {
+        m_scopeWindowComboBox->addItem(QString("%1 s").arg(seconds), seconds);
+    }
+    m_scopeWindowComboBox->setToolTip("Longer windows are redrawn from the scope history, "
+                                      "which holds about 4M frames (7 min at 10 kS/s)");
+    scopeLayout->addWidget(m_scopeWindowComboBox);
+    scopeLayout->addStretch();
+    outputLayout->addLayout(scopeLayout);
+
+    m_scopeWidget = new ScopeWidget();
+    m_scopeWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    m_scopeWidget->setTimeWindow(1.0);
+    outputLayout->addWidget(m_scopeWidget);
+    m_outputThread->setHistory(&m_scopeWidget->history());
+    m_streamThread->setScopeHistory(&m_scopeWidget->history());
+    connect(m_scopeWindowComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onScopeWindowChanged);
 
     // Add output group to main layout
     mainLayout->addWidget(outputGroup);
@@ -952,6 +1202,29 @@ void MainWindow::createSineWaveTab()
 
     loggingLayout->addLayout(fileLayout);
 
+    // Long recordings continue in name-2.csv, name-3.csv, ... past a limit;
+    // the same settings apply to the tracker log
+    QHBoxLayout *rotateLayout = new QHBoxLayout();
+    rotateLayout->addWidget(new QLabel("New File Every:"));
+    m_logRotateSizeComboBox = new QComboBox();
+    m_logRotateSizeComboBox->addItem("Any Size", qint64(0));
+    m_logRotateSizeComboBox->addItem("256 MB", qint64(256) << 20);
+    m_logRotateSizeComboBox->addItem("1 GB", qint64(1) << 30);
+    m_logRotateSizeComboBox->addItem("4 GB", qint64(4) << 30);
+    rotateLayout->addWidget(m_logRotateSizeComboBox);
+    m_logRotateTimeComboBox = new QComboBox();
+    m_logRotateTimeComboBox->addItem("Any Length", qint64(0));
+    m_logRotateTimeComboBox->addItem("10 min", qint64(600) * 1000000000LL);
+    m_logRotateTimeComboBox->addItem("1 h", qint64(3600) * 1000000000LL);
+    m_logRotateTimeComboBox->addItem("6 h", qint64(6 * 3600) * 1000000000LL);
+    rotateLayout->addWidget(m_logRotateTimeComboBox);
+
+    // Bypass the page cache so hours of logging don't evict everything else
+    m_logDirectCheckBox = new QCheckBox("Direct I/O");
+    rotateLayout->addWidget(m_logDirectCheckBox);
+    rotateLayout->addStretch();
+    loggingLayout->addLayout(rotateLayout);
+
     // Start/Stop logging button
     m_loggingButton = new QPushButton("Start Logging");
     m_loggingButton->setEnabled(false); // Disabled until file is selected
@@ -967,31 +1240,22 @@ void MainWindow::createSineWaveTab()
     // Add the tab to the tab widget
     QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
     if (tabWidget) {
-        tabWidget->addTab(sineWaveTab, "Sine Wave Test");
+        tabWidget->addTab(sineWaveTab, "Waveform Test");
     }
 
     // Initialize sine wave variables
     m_sineWaveActive = false;
-    m_sinePhase = 0.0;
     m_sineFrequency = m_frequencySpinBox->value();
     m_sineAmplitude = m_amplitudeSpinBox->value();
     m_phaseOffset = m_phaseOffsetSpinBox->value();
     m_loggingActive = false;
-    m_logFile = nullptr;
-    m_logStream = nullptr;
-
-    // Create sine wave timer with 1ms interval for 1000Hz
-    m_sineWaveTimer = new QTimer(this);
-    m_sineWaveTimer->setInterval(1); // 1ms = 1000Hz update rate
-    connect(m_sineWaveTimer, &QTimer::timeout, this, &MainWindow::onUpdateSineWave);
-
-    // Initialize waveform data vectors with appropriate size
-    m_xWaveformData.resize(100, 0.0);
-    m_yWaveformData.resize(100, 0.0);
-    m_waveformPoints.resize(100);
 
-    // Initialize data logging buffer
-    m_logBuffer.reserve(1000); // Pre-allocate space for 1 second of data
+    // Samples come from the output thread, or from the stream thread in
+    // buffered mode; this timer only refreshes the display
+    m_displayTimer = new QTimer(this);
+    m_displayTimer->setInterval(10);
+    connect(m_displayTimer, &QTimer::timeout, this, &MainWindow::onUpdateDisplay);
+    onOutputModeChanged(m_outputModeComboBox->currentIndex());
 }
 
 void MainWindow::onStartStopSineWave()
@@ -999,187 +1263,323 @@ void MainWindow::onStartStopSineWave()
     m_sineWaveActive = !m_sineWaveActive;
 
     if (m_sineWaveActive) {
-        // Starting the sine wave
-        m_sinePhase = 0.0;
-        m_startTime = QDateTime::currentDateTime();
+        // Starting the waveform
+        bool buffered = m_outputModeComboBox->currentIndex() != 0;
+
+        // The cyclic pattern and its step checks are built for a sine
+        if (m_outputModeComboBox->currentIndex() == 2
+            && currentWaveformSettings().shape != WaveformShape::Sine) {
+            m_sineWaveActive = false;
+            m_sineWaveButton->setChecked(false);
+            QMessageBox::warning(this, "Streaming Error",
+                "Cyclic output plays sine patterns only, use streamed output for other shapes.");
+            return;
+        }
+
+        // The scope sees every frame, from the stream or the output thread
+        m_scopeSampleRate = buffered ? m_sampleRateSpinBox->value() : m_outputThread->config().rateHz;
+        m_scopeWidget->clear();
+        m_scopeWidget->setSampleRate(m_scopeSampleRate);
+        if (m_logViewLiveCheckBox->isChecked()) {
+            startLiveLogView();
+        }
+
+        // Fed with command and feedback volts in buffered mode
+        m_xyScopeWidget->clear();
+        m_xyScopeWidget->setSampleRate(m_scopeSampleRate);
+        m_xyScopeWidget->setRange(m_mirrorController->positionToVoltage(-1.0),
+                                  m_mirrorController->positionToVoltage(1.0));
+
+        m_outputThread->setSource(OutputThread::NoSource);
+        if (buffered && !startBufferedSineWave()) {
+            m_sineWaveActive = false;
+            m_sineWaveButton->setChecked(false);
+            updateOutputSource();
+            QMessageBox::warning(this, "Streaming Error",
+                "Failed to start buffered output: " + m_mirrorController->getLastError());
+            return;
+        }
 
         // Set button to active state
-        m_sineWaveButton->setText("Stop Sine Wave");
+        m_sineWaveButton->setText("Stop Waveform");
         m_sineWaveButton->setIcon(QIcon(":/sinewave.svg"));
+        m_outputModeComboBox->setEnabled(false);
+        m_sampleRateSpinBox->setEnabled(false);
+        m_feedbackCheckBox->setEnabled(false);
+        m_feedbackDelaySpinBox->setEnabled(false);
+        m_waveformShapeComboBox->setEnabled(m_outputModeComboBox->currentIndex() != 2);
+
+        // Start the display timer
+        if (!buffered) {
+            m_outputThread->setWaveform(currentWaveformSettings());
+            m_outputThread->resetWaveform();
+            m_outputThread->setWaveformLogging(m_loggingActive);
+            updateOutputSource();
+        }
+        m_displayTimer->start();
 
-        // Start the timer
-        m_sineWaveTimer->start();
-
-        qDebug() << "Sine wave started. Frequency:" << m_sineFrequency
+        qDebug() << WaveformGenerator::shapeName(currentWaveformSettings().shape)
+                 << "waveform started. Frequency:" << m_sineFrequency
                  << "Hz, Amplitude:" << m_sineAmplitude;
     } else {
-        // Stopping the sine wave
-        m_sineWaveTimer->stop();
-
-        // Reset the mirror position to center
-        if (m_mirrorController->isDeviceOpen()) {
-            m_mirrorController->setPosition(0.0, 0.0);
+        // Stopping the waveform
+        m_displayTimer->stop();
+        m_streamThread->stopStreaming();
+        updateStreamStatus();
+        if (m_sweepActive) {
+            m_sweepActive = false;
+            m_frequencySweep.stop();
+            updateSweepProgress();
         }
+        m_mirrorController->stopStreaming();
+        onOutputModeChanged(m_outputModeComboBox->currentIndex());
+        m_outputModeComboBox->setEnabled(true);
+        m_waveformShapeComboBox->setEnabled(true);
+
+        // Hand the mirror back to the joystick/tracker, or center it
+        updateOutputSource();
 
         // Set button to inactive state
-        m_sineWaveButton->setText("Start Sine Wave");
+        m_sineWaveButton->setText("Start Waveform");
         m_sineWaveButton->setIcon(QIcon(":/sinewaveOff.svg"));
 
         // Reset progress bars
         m_xOutputBar->setValue(0);
         m_yOutputBar->setValue(0);
 
-        qDebug() << "Sine wave stopped";
+        qDebug() << "Waveform stopped";
     }
 }
 
-void MainWindow::onUpdateSineWave()
+void MainWindow::onUpdateDisplay()
 {
-    if (!m_sineWaveActive || !m_mirrorController->isDeviceOpen()) {
+    if (!m_sineWaveActive) {
         return;
     }
 
-    // Calculate elapsed time in seconds since start
-    qint64 elapsedNs = m_loggingTimer.nsecsElapsed();
-    double elapsedSec = elapsedNs / 1.0e9;  // Convert nanoseconds to seconds
+    if (m_mirrorController->isStreaming()) {
+        updateStreamDisplay();
+        return;
+    }
 
-    // Calculate the sine wave values (-1.0 to 1.0)
+    // Show what the output thread last wrote
     double xValue = 0.0;
     double yValue = 0.0;
+    m_outputThread->lastPosition(&xValue, &yValue);
 
-    if (m_xAxisCheckBox->isChecked()) {
-        xValue = m_sineAmplitude * sin(2.0 * M_PI * m_sineFrequency * elapsedSec);
-        m_xOutputBar->setValue(static_cast<int>(xValue * 100));
-    }
+    m_xOutputBar->setValue(static_cast<int>(xValue * 100));
+    m_yOutputBar->setValue(static_cast<int>(yValue * 100));
+}
 
-    if (m_yAxisCheckBox->isChecked()) {
-        double phaseOffsetRad = m_phaseOffset * M_PI / 180.0;
-        yValue = m_sineAmplitude * sin(2.0 * M_PI * m_sineFrequency * elapsedSec + phaseOffsetRad);
-        m_yOutputBar->setValue(static_cast<int>(yValue * 100));
+bool MainWindow::startBufferedSineWave()
+{
+    double sampleRate = m_sampleRateSpinBox->value();
+
+    // Frame 0 goes out as the stream starts below; the device clock takes
+    // over from there
+    const qint64 startNs = MonotonicClock::sessionNs();
+    m_mirrorController->setFeedbackEnabled(m_feedbackCheckBox->isChecked());
+    m_streamStatusTimer.start();
+
+    // Cyclic mode: upload the pattern once, the output clock loops it
+    if (m_outputModeComboBox->currentIndex() == 2) {
+        if (!m_mirrorController->startPeriodicWaveform(currentPeriodicWaveform(), sampleRate)) {
+            return false;
+        }
+    } else {
+        // 20 ms per device buffer; the host FIFO adds four buffers of slack
+        // for the stream thread's 5 ms fill ticks
+        int bufferFrames = qMax(256, static_cast<int>(sampleRate * 0.02));
+        if (!m_mirrorController->startStreaming(sampleRate, bufferFrames)) {
+            return false;
+        }
     }
 
-    // Output to the mirror
-    m_mirrorController->setPosition(xValue, yValue);
-
-    // Log data if logging is active
-    if (m_loggingActive) {
-        // Get current mirror position feedback
-        QPair<double, double> currentVoltages = m_mirrorController->getCurrentVoltages();
-
-        // Create a data record
-        LogRecord record;
-        record.elapsedTime = elapsedNs;
-        record.frequency = m_sineFrequency;
-        record.amplitude = m_sineAmplitude;
-        record.xCommand = xValue;
-        record.yCommand = yValue;
-        record.xFeedback = currentVoltages.first;
-        record.yFeedback = currentVoltages.second;
+    // The spectrum picks up from the new stream's first sample
+    m_commandHistoryRead = m_streamThread->commandHistory().written();
+    m_feedbackHistoryRead = m_streamThread->feedbackHistory().written();
+
+    // Synthesis, refill, feedback alignment and log records all run on the
+    // stream thread; the first fill primes the FIFO before this returns
+    m_streamThread->setLogging(m_loggingActive);
+    m_streamThread->startStreaming(streamWaveformSettings(),
+                                   m_sweepActive ? &m_frequencySweep : nullptr,
+                                   m_feedbackDelaySpinBox->value(), startNs);
+    return true;
+}
 
-        // Add record to logging thread
-        m_loggingThread->addRecord(record);
+WaveformSettings MainWindow::streamWaveformSettings() const
+{
+    // Cyclic output plays the frequency rounded to the pattern length
+    WaveformSettings settings = currentWaveformSettings();
+    AoStream *stream = m_mirrorController->stream();
+    if (stream && stream->isCyclic()) {
+        settings.frequency = m_mirrorController->stagedPeriodicFrequency();
     }
+    return settings;
+}
 
-    // Update visualization less frequently (every 10ms)
-    static int visualUpdateCounter = 0;
-    if (++visualUpdateCounter >= 10) {
-        visualUpdateCounter = 0;
-
-        // Update waveform visualization data
-        m_xWaveformData.pop_front();
-        m_xWaveformData.push_back(xValue);
-        m_yWaveformData.pop_front();
-        m_yWaveformData.push_back(yValue);
+WaveformSettings MainWindow::currentWaveformSettings() const
+{
+    WaveformSettings settings;
+    settings.shape = static_cast<WaveformShape>(m_waveformShapeComboBox->currentData().toInt());
+    settings.frequency = m_sineFrequency;
+    settings.amplitude = m_sineAmplitude;
+    settings.phaseOffset = m_phaseOffset;
+    settings.xEnabled = m_xAxisCheckBox->isChecked();
+    settings.yEnabled = m_yAxisCheckBox->isChecked();
+    settings.endFrequency = m_endFrequencySpinBox->value();
+    settings.sweepSeconds = m_sweepTimeSpinBox->value();
+    settings.toneCount = m_toneCountSpinBox->value();
+    settings.prbsOrder = m_prbsOrderSpinBox->value();
+    return settings;
+}
 
-        // Update waveform display
-        updateWaveformDisplay();
-    }
+PeriodicWaveform MainWindow::currentPeriodicWaveform() const
+{
+    PeriodicWaveform waveform;
+    waveform.frequency = m_sineFrequency;
+    waveform.amplitude = m_sineAmplitude;
+    waveform.phaseOffset = m_phaseOffset;
+    waveform.xEnabled = m_xAxisCheckBox->isChecked();
+    waveform.yEnabled = m_yAxisCheckBox->isChecked();
+    return waveform;
 }
 
-void MainWindow::writeLogBuffer()
+void MainWindow::updatePeriodicOutput()
 {
-    if (!m_logStream || m_logBuffer.isEmpty()) {
+    if (!m_sineWaveActive) {
         return;
     }
 
-    // Write all records in the buffer
-    for (const LogRecord& record : m_logBuffer) {
-        // Convert nanoseconds to seconds with 9 decimal places (nanosecond precision)
-        double elapsedSeconds = record.elapsedTime / 1.0e9;
-        *m_logStream << QString::number(elapsedSeconds, 'f', 9) << ","
-                    << QString::number(record.frequency, 'f', 1) << ","
-                    << QString::number(record.amplitude, 'f', 1) << ","
-                    << QString::number(record.xCommand, 'f', 5) << ","
-                    << QString::number(record.yCommand, 'f', 5) << ","
-                    << QString::number(record.xFeedback, 'f', 5) << ","
-                    << QString::number(record.yFeedback, 'f', 5) << "\n";
+    // Parameter changes are staged and take effect at the next period boundary
+    AoStream *stream = m_mirrorController->stream();
+    if (stream && stream->isCyclic()) {
+        m_mirrorController->updatePeriodicWaveform(currentPeriodicWaveform());
     }
 
-    // Flush the data to disk
-    m_logStream->flush();
-
-    // Clear the buffer
-    m_logBuffer.clear();
+    if (stream) {
+        // Same shape: parameters change and keep the phase. A new shape
+        // starts a fresh generator, caught up to the stream's position.
+        m_streamThread->setWaveform(streamWaveformSettings());
+    } else {
+        // Software timed: the output thread keeps its phase across changes
+        m_outputThread->setWaveform(currentWaveformSettings());
+    }
 }
 
-void MainWindow::updateWaveformDisplay()
+void MainWindow::updateOutputSource()
 {
-    // Use the current width and height of the label
-    int width = m_waveformLabel->width();
-    int height = m_waveformLabel->height();
-
-    // Create pixmap of current size
-    QPixmap pixmap(width, height);
-    pixmap.fill(Qt::black);
-
-    QPainter painter(&pixmap);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    int centerY = height / 2;
-
-    // Draw zero line
-    painter.setPen(QPen(Qt::darkGray, 1));
-    painter.drawLine(0, centerY, width, centerY);
+    // Sine test overrides tracker drive, which overrides the joystick
+    // while buffered output owns the device nothing is written here
+    OutputThread::Source source = OutputThread::NoSource;
+    if (m_sineWaveActive) {
+        if (!m_mirrorController->isStreaming()) {
+            source = OutputThread::WaveformSource;
+        }
+    } else if (m_trackerDriveCheckBox->isChecked()) {
+        source = OutputThread::TrackerSource;
+    } else if (m_mirrorOutputEnabled) {
+        source = OutputThread::JoystickSource;
+    }
 
-    // Calculate point spacing based on current width
-    double pointSpacing = static_cast<double>(width) / (m_xWaveformData.size() - 1);
+    m_outputThread->setSource(source);
 
-    // Draw X waveform
-    if (m_xAxisCheckBox->isChecked()) {
-        painter.setPen(QPen(Qt::green, 2));
-        QPolygonF points;
+    // Nothing drives the mirror any more: park it at center
+    if (source == OutputThread::NoSource && m_mirrorController->isDeviceOpen()
+        && !m_mirrorController->isStreaming()) {
+        m_mirrorController->setPosition(0.0, 0.0);
+    }
+}
 
-        for (int i = 0; i < m_xWaveformData.size(); ++i) {
-            // Calculate x-coordinate based on fixed spacing (data rolls left)
-            double x = width - (m_xWaveformData.size() - 1 - i) * pointSpacing;
+void MainWindow::updateStreamDisplay()
+{
+    if (m_sweepActive && m_streamThread->sweepComplete()) {
+        // Every point has been measured; stopping also finishes the table
+        m_sineWaveButton->setChecked(false);
+        onStartStopSineWave();
+        return;
+    }
 
-            // Calculate y-coordinate (centered around middle of display)
-            double y = centerY - m_xWaveformData[i] * centerY * 0.9; // 90% of half height
+    // Show what the stream thread last queued
+    double xValue = 0.0;
+    double yValue = 0.0;
+    m_streamThread->lastPosition(&xValue, &yValue);
+    m_xOutputBar->setValue(static_cast<int>(xValue * 100));
+    m_yOutputBar->setValue(static_cast<int>(yValue * 100));
+
+    // Revolutions are only defined for a sine; the sweep always plays one
+    AoStream *stream = m_mirrorController->stream();
+    double frequency = m_sineFrequency;
+    if (m_sweepActive) {
+        frequency = m_streamThread->sweepFrequency();
+    } else if (stream->isCyclic()) {
+        frequency = m_mirrorController->periodicFrequency();
+    } else if (currentWaveformSettings().shape != WaveformShape::Sine) {
+        frequency = 0.0;
+    }
+    m_xyScopeWidget->setFrequency(frequency);
+
+    feedSpectrumHistory(m_streamThread->commandHistory(), &m_commandHistoryRead,
+                        SpectrumXCommand, stream->sampleRate());
+    AiStream *feedback = m_mirrorController->feedbackStream();
+    if (feedback) {
+        feedSpectrumHistory(m_streamThread->feedbackHistory(), &m_feedbackHistoryRead,
+                            SpectrumXFeedback, feedback->sampleRate());
+    }
 
-            points << QPointF(x, y);
+    // Refresh the statistics a few times per second
+    if (m_streamStatusTimer.elapsed() >= 250) {
+        m_streamStatusTimer.restart();
+        updateStreamStatus();
+        if (m_sweepActive) {
+            updateSweepProgress();
         }
-        painter.drawPolyline(points);
+    }
+}
+
+void MainWindow::updateStreamStatus()
+{
+    AoStream *stream = m_mirrorController->stream();
+    if (!stream) {
+        m_streamStatusLabel->clear();
+        return;
     }
 
-    // Draw Y waveform
-    if (m_yAxisCheckBox->isChecked()) {
-        painter.setPen(QPen(Qt::red, 2));
-        QPolygonF points;
+    QString status = QString("%1: %2 frames at %3 S/s, %4 underruns")
+                         .arg(stream->isCyclic() ? "Cyclic" : "Streaming")
+                         .arg(stream->framesTransmitted())
+                         .arg(stream->sampleRate(), 0, 'f', 0)
+                         .arg(stream->underrunCount());
 
-        for (int i = 0; i < m_yWaveformData.size(); ++i) {
-            // Calculate x-coordinate based on fixed spacing (data rolls left)
-            double x = width - (m_yWaveformData.size() - 1 - i) * pointSpacing;
+    if (stream->isCyclic()) {
+        status += QString(", %1 Hz actual, %2 pattern updates")
+                      .arg(m_mirrorController->periodicFrequency(), 0, 'f', 4)
+                      .arg(stream->patternSwapCount());
+    }
 
-            // Calculate y-coordinate (centered around middle of display)
-            double y = centerY - m_yWaveformData[i] * centerY * 0.9; // 90% of half height
+    SimulatedAoStream *simulated = qobject_cast<SimulatedAoStream *>(stream);
+    if (simulated) {
+        status += QString(", %1 discontinuities (max step %2 V)")
+                      .arg(simulated->discontinuityCount())
+                      .arg(simulated->maxStep(), 0, 'f', 4);
+    }
 
-            points << QPointF(x, y);
+    AiStream *feedback = m_mirrorController->feedbackStream();
+    if (feedback) {
+        status += QString("\nFeedback: %1 frames acquired, %2 aligned, %3 unmatched, %4 overruns")
+                      .arg(feedback->framesAcquired())
+                      .arg(m_streamThread->matchedCount())
+                      .arg(m_streamThread->unmatchedCount())
+                      .arg(feedback->overrunCount());
+        if (m_streamThread->alignmentLost()) {
+            status += QString(", %1 device overruns, %2 frames not aligned")
+                          .arg(feedback->deviceOverrunCount())
+                          .arg(m_streamThread->unalignedCount());
         }
-        painter.drawPolyline(points);
     }
 
-    // Set the pixmap to the label
-    m_waveformLabel->setPixmap(pixmap);
+    m_streamStatusLabel->setText(status);
 }
 
 void MainWindow::onBrowseLogFile()
@@ -1187,7 +1587,7 @@ void MainWindow::onBrowseLogFile()
     QString filePath = QFileDialog::getSaveFileName(this,
                                                    "Select Log File",
                                                    "",
-                                                   "CSV Files (*.csv);;All Files (*)");
+                                                   "CSV Files (*.csv);;Binary Logs (*.jtmlog);;All Files (*)");
 
     if (!filePath.isEmpty()) {
         m_logFileEdit->setText(filePath);
@@ -1208,67 +1608,114 @@ void MainWindow::onStartStopLogging()
             return;
         }
 
-        // Start the timer for elapsed time tracking
-        m_loggingTimer.start();
-
-        // Start the logging thread
-        m_loggingThread->startLogging(filePath);
+        // Start the logging thread; the rate only labels binary logs
+        const double sampleRate = m_outputModeComboBox->currentIndex() != 0
+                                      ? m_sampleRateSpinBox->value()
+                                      : m_outputThread->config().rateHz;
+        m_loggingThread->setFileOptions(logFileOptions());
+        if (!m_loggingThread->startLogging(filePath, sampleRate)) {
+            QMessageBox::warning(this, "Logging Error", m_loggingThread->getLastError());
+            m_loggingActive = false;
+            return;
+        }
+        m_outputThread->setWaveformLogging(true);
+        m_streamThread->setLogging(true);
 
         // Update UI
         m_loggingButton->setText("Stop Logging");
         m_browseButton->setEnabled(false);
+        m_logRotateSizeComboBox->setEnabled(false);
+        m_logRotateTimeComboBox->setEnabled(false);
+        m_logDirectCheckBox->setEnabled(false);
 
         qDebug() << "Data logging started to file:" << filePath;
     } else {
         // Stop logging
+        m_outputThread->setWaveformLogging(false);
+        m_streamThread->setLogging(false);
         m_loggingThread->stopLogging();
 
         // Update UI
         m_loggingButton->setText("Start Logging");
         m_browseButton->setEnabled(true);
+        m_logRotateSizeComboBox->setEnabled(true);
+        m_logRotateTimeComboBox->setEnabled(true);
+        m_logDirectCheckBox->setEnabled(true);
 
         qDebug() << "Data logging stopped";
     }
 }
 
+LogFile::Options MainWindow::logFileOptions() const
+{
+    LogFile::Options options;
+    options.rotateBytes = m_logRotateSizeComboBox->currentData().toLongLong();
+    options.rotateNs = m_logRotateTimeComboBox->currentData().toLongLong();
+    options.direct = m_logDirectCheckBox->isChecked();
+    return options;
+}
+
 void MainWindow::onFrequencyChanged(double value)
 {
     m_sineFrequency = value;
-    qDebug() << "Sine wave frequency changed to" << value << "Hz";
+    updatePeriodicOutput();
+    qDebug() << "Waveform frequency changed to" << value << "Hz";
 }
 
 void MainWindow::onAmplitudeChanged(double value)
 {
     m_sineAmplitude = value;
-    qDebug() << "Sine wave amplitude changed to" << value;
+    updatePeriodicOutput();
+    qDebug() << "Waveform amplitude changed to" << value;
+}
+
+void MainWindow::onScopeWindowChanged(int index)
+{
+    m_scopeWidget->setTimeWindow(m_scopeWindowComboBox->itemData(index).toDouble());
 }
 
 void MainWindow::onXAxisToggled(bool checked)
 {
     qDebug() << "X-axis output" << (checked ? "enabled" : "disabled");
-
-    // If both X and Y are unchecked, reset the mirror to center
-    if (!checked && !m_yAxisCheckBox->isChecked() && m_sineWaveActive) {
-        m_mirrorController->setPosition(0.0, 0.0);
-    }
+    m_scopeWidget->setChannelVisible(0, checked);
+    updatePeriodicOutput();
 }
 
 void MainWindow::onYAxisToggled(bool checked)
 {
     qDebug() << "Y-axis output" << (checked ? "enabled" : "disabled");
-
-    // If both X and Y are unchecked, reset the mirror to center
-    if (!checked && !m_xAxisCheckBox->isChecked() && m_sineWaveActive) {
-        m_mirrorController->setPosition(0.0, 0.0);
-    }
+    m_scopeWidget->setChannelVisible(1, checked);
+    updatePeriodicOutput();
 }
 
 void MainWindow::onPhaseOffsetChanged(int value)
 {
     m_phaseOffset = value;
+    updatePeriodicOutput();
     qDebug() << "Phase offset changed to" << value << "degrees";
 }
 
+void MainWindow::onWaveformShapeChanged(int index)
+{
+    Q_UNUSED(index);
+    WaveformShape shape = currentWaveformSettings().shape;
+    m_endFrequencySpinBox->setEnabled(shape == WaveformShape::Chirp);
+    m_sweepTimeSpinBox->setEnabled(shape == WaveformShape::Chirp);
+    m_toneCountSpinBox->setEnabled(shape == WaveformShape::Multisine);
+    m_prbsOrderSpinBox->setEnabled(shape == WaveformShape::Prbs);
+
+    updatePeriodicOutput();
+    qDebug() << "Waveform shape changed to" << WaveformGenerator::shapeName(shape);
+}
+
+void MainWindow::onOutputModeChanged(int index)
+{
+    bool buffered = index != 0;
+    m_sampleRateSpinBox->setEnabled(buffered);
+    m_feedbackCheckBox->setEnabled(buffered);
+    m_feedbackDelaySpinBox->setEnabled(buffered);
+}
+
 // Tracker-related methods
 void MainWindow::createTrackerTab()
 {
@@ -1350,6 +1797,20 @@ void MainWindow::createTrackerTab()
 
     trackerLayout->addLayout(controlLayout);
 
+    // Closed-loop drive: mirror position = gain * filtered track error
+    QHBoxLayout *driveLayout = new QHBoxLayout();
+    m_trackerDriveCheckBox = new QCheckBox("Drive Mirror From Track Error");
+    driveLayout->addWidget(m_trackerDriveCheckBox);
+    driveLayout->addWidget(new QLabel("Gain:"));
+    m_trackerGainSpinBox = new QDoubleSpinBox();
+    m_trackerGainSpinBox->setRange(-1.0, 1.0);
+    m_trackerGainSpinBox->setDecimals(4);
+    m_trackerGainSpinBox->setSingleStep(0.001);
+    m_trackerGainSpinBox->setValue(0.01);
+    driveLayout->addWidget(m_trackerGainSpinBox);
+    driveLayout->addStretch();
+    trackerLayout->addLayout(driveLayout);
+
     // Create status label
     m_trackerStatusLabel = new QLabel("Not Initialized");
     trackerLayout->addWidget(m_trackerStatusLabel);
@@ -1369,6 +1830,7 @@ void MainWindow::createTrackerTab()
     connect(m_trackerStartLoggingButton, &QPushButton::clicked, this, &MainWindow::onTrackerStartLoggingButtonClicked);
     connect(m_trackerStopLoggingButton, &QPushButton::clicked, this, &MainWindow::onTrackerStopLoggingButtonClicked);
     connect(m_trackerAutoPollCheckBox, &QCheckBox::toggled, this, &MainWindow::onTrackerAutoPollToggled);
+    connect(m_trackerDriveCheckBox, &QCheckBox::toggled, this, &MainWindow::onTrackerDriveToggled);
 
     // Initialize UI state
     setTrackerUIEnabled(false);
@@ -1397,11 +1859,13 @@ void MainWindow::onTrackerPingButtonClicked()
 
 void MainWindow::onTrackerStartLoggingButtonClicked()
 {
-    QString filename = QFileDialog::getSaveFileName(this, "Save Track Log File", "", "CSV Files (*.csv);;All Files (*)");
+    QString filename = QFileDialog::getSaveFileName(this, "Save Track Log File", "",
+                                                    "CSV Files (*.csv);;Tracker Logs (*.jtmtrk);;All Files (*)");
     if (filename.isEmpty()) {
         return;
     }
 
+    m_trackerLogger->setFileOptions(logFileOptions());
     if (m_trackerLogger->startLogging(filename)) {
         m_trackerStatusLabel->setText("Logging started: " + filename);
         m_trackerStartLoggingButton->setEnabled(false);
@@ -1429,15 +1893,44 @@ void MainWindow::onTrackerAutoPollToggled(bool checked)
     }
 }
 
+void MainWindow::onTrackerDriveToggled(bool checked)
+{
+    if (checked && !m_mirrorController->isDeviceOpen()) {
+        m_trackerStatusLabel->setText("Mirror device not open");
+    }
+
+    // Start from center rather than a stale setpoint
+    m_outputThread->mailbox(OutputThread::TrackerSource)->publish(0.0, 0.0);
+    updateOutputSource();
+}
+
 void MainWindow::pollTracker()
 {
-    TrackData data;
-    if (m_trackerMemory->readStatusData(data)) {
+    uint16_t statusMsg[TrackData::StatusMessageWords];
+    if (m_trackerMemory->readStatusMessage(statusMsg)) {
+        // Stamped when read, so the setpoint latency and the log both
+        // include the time spent here
+        const qint64 readNs = MonotonicClock::nowNs();
+        const TrackData data = TrackData::fromStatusMessage(statusMsg);
+        if (m_trackerDriveCheckBox->isChecked()) {
+            double gain = m_trackerGainSpinBox->value();
+            m_outputThread->mailbox(OutputThread::TrackerSource)->publish(
+                qBound(-1.0, gain * data.filteredErrorX, 1.0),
+                qBound(-1.0, gain * data.filteredErrorY, 1.0), readNs);
+        }
+
         updateTrackerUI(data);
 
+        // Tracker errors are sampled once per poll
+        const double errors[4] = {data.rawErrorX, data.rawErrorY, data.filteredErrorX, data.filteredErrorY};
+        const double pollRate = 1000.0 / m_trackerPollTimer->interval();
+        for (int i = 0; i < 4; ++i) {
+            feedSpectrum(static_cast<SpectrumSource>(SpectrumTrackerRawX + i), &errors[i], 1, 1, pollRate);
+        }
+
         // Log the data if logging is enabled
         if (m_trackerLogger->isLogging()) {
-            m_trackerLogger->logData(data);
+            m_trackerLogger->logData(statusMsg, MonotonicClock::sessionNs(readNs));
         }
     }
 }
@@ -1462,6 +1955,8 @@ void MainWindow::setTrackerUIEnabled(bool enabled)
     m_trackerPingButton->setEnabled(enabled);
     m_trackerStartLoggingButton->setEnabled(enabled);
     m_trackerAutoPollCheckBox->setEnabled(enabled);
+    m_trackerDriveCheckBox->setEnabled(enabled);
+    m_trackerGainSpinBox->setEnabled(enabled);
 }
 
 void MainWindow::handleTrackerError(const QString& errorMsg)
@@ -1474,4 +1969,814 @@ void MainWindow::handleLoggerError(const QString& errorMsg)
 {
     m_trackerStatusLabel->setText("Logger error: " + errorMsg);
     QMessageBox::critical(this, "Logger Error", errorMsg);
-}
\ No newline at end of file
+}
+
+// Frequency response methods
+void MainWindow::createFrequencyResponseTab()
+{
+    QWidget *responseTab = new QWidget();
+    QVBoxLayout *responseLayout = new QVBoxLayout(responseTab);
+
+    QGroupBox *sweepGroup = new QGroupBox("Sweep Parameters");
+    QGridLayout *sweepLayout = new QGridLayout(sweepGroup);
+
+    sweepLayout->addWidget(new QLabel("Mode:"), 0, 0);
+    m_sweepModeComboBox = new QComboBox();
+    m_sweepModeComboBox->addItem("Stepped sine", SweepSettings::SteppedSine);
+    m_sweepModeComboBox->addItem("Chirp (quick survey)", SweepSettings::Chirp);
+    sweepLayout->addWidget(m_sweepModeComboBox, 0, 1);
+
+    // Frequency points: a range, or an explicit list that overrides it
+    sweepLayout->addWidget(new QLabel("Frequencies:"), 1, 0);
+    QHBoxLayout *rangeLayout = new QHBoxLayout();
+    m_sweepStartSpinBox = new QDoubleSpinBox();
+    m_sweepStartSpinBox->setRange(0.1, 5000.0);
+    m_sweepStartSpinBox->setValue(1.0);
+    m_sweepStartSpinBox->setDecimals(1);
+    m_sweepStartSpinBox->setSuffix(" Hz");
+    rangeLayout->addWidget(m_sweepStartSpinBox);
+    rangeLayout->addWidget(new QLabel("to"));
+    m_sweepStopSpinBox = new QDoubleSpinBox();
+    m_sweepStopSpinBox->setRange(0.1, 5000.0);
+    m_sweepStopSpinBox->setValue(500.0);
+    m_sweepStopSpinBox->setDecimals(1);
+    m_sweepStopSpinBox->setSuffix(" Hz");
+    rangeLayout->addWidget(m_sweepStopSpinBox);
+    rangeLayout->addWidget(new QLabel("Points:"));
+    m_sweepPointsSpinBox = new QSpinBox();
+    m_sweepPointsSpinBox->setRange(1, 500);
+    m_sweepPointsSpinBox->setValue(30);
+    rangeLayout->addWidget(m_sweepPointsSpinBox);
+    m_sweepLogCheckBox = new QCheckBox("Logarithmic");
+    m_sweepLogCheckBox->setChecked(true);
+    rangeLayout->addWidget(m_sweepLogCheckBox);
+    sweepLayout->addLayout(rangeLayout, 1, 1);
+
+    sweepLayout->addWidget(new QLabel("Custom List:"), 2, 0);
+    m_sweepListEdit = new QLineEdit();
+    m_sweepListEdit->setPlaceholderText("e.g. 5, 10, 20, 50, 100 (Hz, overrides the range)");
+    sweepLayout->addWidget(m_sweepListEdit, 2, 1);
+
+    sweepLayout->addWidget(new QLabel("Amplitude:"), 3, 0);
+    m_sweepAmplitudeSpinBox = new QDoubleSpinBox();
+    m_sweepAmplitudeSpinBox->setRange(0.01, 1.0);
+    m_sweepAmplitudeSpinBox->setValue(0.2);
+    m_sweepAmplitudeSpinBox->setSingleStep(0.01);
+    m_sweepAmplitudeSpinBox->setDecimals(2);
+    sweepLayout->addWidget(m_sweepAmplitudeSpinBox, 3, 1);
+
+    sweepLayout->addWidget(new QLabel("Stepped Sine:"), 4, 0);
+    QHBoxLayout *steppedLayout = new QHBoxLayout();
+    steppedLayout->addWidget(new QLabel("Settle:"));
+    m_sweepSettleSpinBox = new QDoubleSpinBox();
+    m_sweepSettleSpinBox->setRange(0.0, 100.0);
+    m_sweepSettleSpinBox->setValue(5.0);
+    m_sweepSettleSpinBox->setDecimals(1);
+    m_sweepSettleSpinBox->setSuffix(" cycles");
+    steppedLayout->addWidget(m_sweepSettleSpinBox);
+    steppedLayout->addWidget(new QLabel("Measure:"));
+    m_sweepMeasureSpinBox = new QSpinBox();
+    m_sweepMeasureSpinBox->setRange(1, 1000);
+    m_sweepMeasureSpinBox->setValue(20);
+    m_sweepMeasureSpinBox->setSuffix(" cycles");
+    steppedLayout->addWidget(m_sweepMeasureSpinBox);
+    steppedLayout->addStretch();
+    sweepLayout->addLayout(steppedLayout, 4, 1);
+
+    sweepLayout->addWidget(new QLabel("Chirp Duration:"), 5, 0);
+    m_sweepChirpTimeSpinBox = new QDoubleSpinBox();
+    m_sweepChirpTimeSpinBox->setRange(1.0, 600.0);
+    m_sweepChirpTimeSpinBox->setValue(20.0);
+    m_sweepChirpTimeSpinBox->setDecimals(1);
+    m_sweepChirpTimeSpinBox->setSuffix(" s");
+    sweepLayout->addWidget(m_sweepChirpTimeSpinBox, 5, 1);
+
+    QLabel *noteLabel = new QLabel(
+        "Streams through the Waveform Test output using its sample rate, axes and phase offset, "
+        "and needs sensor feedback (AI0/AI1). Phase is measured after the feedback delay set there.");
+    noteLabel->setWordWrap(true);
+    sweepLayout->addWidget(noteLabel, 6, 0, 1, 2);
+
+    responseLayout->addWidget(sweepGroup);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    m_sweepButton = new QPushButton("Start Sweep");
+    m_sweepButton->setCheckable(true);
+    controlLayout->addWidget(m_sweepButton);
+    m_saveSweepButton = new QPushButton("Save Table...");
+    m_saveSweepButton->setEnabled(false);
+    controlLayout->addWidget(m_saveSweepButton);
+    m_sweepStatusLabel = new QLabel();
+    controlLayout->addWidget(m_sweepStatusLabel, 1);
+    responseLayout->addLayout(controlLayout);
+
+    // Bode table, filled in as each point completes
+    m_sweepTable = new QTableWidget(0, 5);
+    m_sweepTable->setHorizontalHeaderLabels({"Frequency (Hz)", "X Gain (dB)", "X Phase (°)",
+                                             "Y Gain (dB)", "Y Phase (°)"});
+    m_sweepTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_sweepTable->verticalHeader()->setVisible(false);
+    m_sweepTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    responseLayout->addWidget(m_sweepTable, 1);
+
+    QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
+    if (tabWidget) {
+        tabWidget->addTab(responseTab, "Frequency Response");
+    }
+
+    connect(m_sweepButton, &QPushButton::clicked, this, &MainWindow::onStartStopSweep);
+    connect(m_saveSweepButton, &QPushButton::clicked, this, &MainWindow::onSaveSweepTable);
+}
+
+SweepSettings MainWindow::currentSweepSettings() const
+{
+    SweepSettings settings;
+    settings.mode = static_cast<SweepSettings::Mode>(m_sweepModeComboBox->currentData().toInt());
+    settings.amplitude = m_sweepAmplitudeSpinBox->value();
+    settings.phaseOffset = m_phaseOffset;
+    settings.xEnabled = m_xAxisCheckBox->isChecked();
+    settings.yEnabled = m_yAxisCheckBox->isChecked();
+    settings.settleCycles = m_sweepSettleSpinBox->value();
+    settings.measureCycles = m_sweepMeasureSpinBox->value();
+    settings.chirpSeconds = m_sweepChirpTimeSpinBox->value();
+
+    const QStringList entries = m_sweepListEdit->text().split(QRegularExpression("[,;\\s]+"),
+                                                              Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        double frequency = entry.toDouble(&ok);
+        if (ok && frequency > 0.0) {
+            settings.frequencies.append(frequency);
+        }
+    }
+    if (settings.frequencies.isEmpty()) {
+        settings.frequencies = SweepSettings::frequencyList(m_sweepStartSpinBox->value(),
+                                                            m_sweepStopSpinBox->value(),
+                                                            m_sweepPointsSpinBox->value(),
+                                                            m_sweepLogCheckBox->isChecked());
+    }
+    return settings;
+}
+
+void MainWindow::onStartStopSweep()
+{
+    if (m_sweepActive) {
+        // Stopping the waveform ends the sweep and keeps the points so far
+        m_sineWaveButton->setChecked(false);
+        onStartStopSineWave();
+        return;
+    }
+
+    if (m_sineWaveActive) {
+        m_sweepButton->setChecked(false);
+        QMessageBox::warning(this, "Sweep Error", "Stop the running waveform before starting a sweep.");
+        return;
+    }
+
+    if (!m_frequencySweep.start(currentSweepSettings(), m_sampleRateSpinBox->value())) {
+        m_sweepButton->setChecked(false);
+        QMessageBox::warning(this, "Sweep Error", m_frequencySweep.getLastError());
+        return;
+    }
+
+    // The sweep is streamed, and reduced from the aligned sensor feedback
+    m_outputModeComboBox->setCurrentIndex(1);
+    m_feedbackCheckBox->setChecked(true);
+    m_sweepTable->setRowCount(0);
+    m_saveSweepButton->setEnabled(false);
+
+    m_sweepActive = true;
+    m_sineWaveButton->setChecked(true);
+    onStartStopSineWave();
+
+    if (!m_sineWaveActive) {
+        // Start failed and was reported; the stop path never ran
+        m_sweepActive = false;
+        m_frequencySweep.stop();
+        m_sweepButton->setChecked(false);
+        updateSweepProgress();
+        return;
+    }
+
+    if (!m_mirrorController->feedbackStream()) {
+        m_sineWaveButton->setChecked(false);
+        onStartStopSineWave();
+        QMessageBox::warning(this, "Sweep Error",
+            "The selected output device does not provide sensor feedback, a sweep needs AI0/AI1.");
+        return;
+    }
+
+    m_sweepButton->setText("Stop Sweep");
+    updateSweepProgress();
+
+    qDebug() << "Frequency sweep started:" << m_frequencySweep.pointCount() << "points,"
+             << m_frequencySweep.totalFrames() / m_sampleRateSpinBox->value() << "s";
+}
+
+void MainWindow::updateSweepProgress()
+{
+    // The stream thread measures the points
+    const QVector<BodePoint> results = m_streamThread->sweepResults();
+    for (int row = m_sweepTable->rowCount(); row < results.size(); ++row) {
+        const BodePoint &point = results[row];
+        m_sweepTable->insertRow(row);
+        m_sweepTable->setItem(row, 0, new QTableWidgetItem(QString::number(point.frequency, 'f', 2)));
+        for (int axis = 0; axis < 2; ++axis) {
+            QString gain = "-";
+            QString phase = "-";
+            if (!qIsNaN(point.gain[axis]) && point.gain[axis] > 0.0) {
+                gain = QString::number(20.0 * std::log10(point.gain[axis]), 'f', 2);
+                phase = QString::number(point.phaseDeg[axis], 'f', 1);
+            }
+            m_sweepTable->setItem(row, 1 + 2 * axis, new QTableWidgetItem(gain));
+            m_sweepTable->setItem(row, 2 + 2 * axis, new QTableWidgetItem(phase));
+        }
+    }
+
+    const int points = m_frequencySweep.pointCount();
+    if (m_sweepActive) {
+        m_sweepStatusLabel->setText(QString("Measured %1 of %2 points, commanding %3 Hz")
+                                        .arg(results.size())
+                                        .arg(points)
+                                        .arg(m_streamThread->sweepFrequency(), 0, 'f', 2));
+        return;
+    }
+
+    if (m_streamThread->sweepComplete()) {
+        m_sweepStatusLabel->setText(QString("Sweep complete, %1 points").arg(results.size()));
+    } else {
+        m_sweepStatusLabel->setText(QString("Sweep stopped after %1 of %2 points")
+                                        .arg(results.size())
+                                        .arg(points));
+    }
+    m_sweepButton->setChecked(false);
+    m_sweepButton->setText("Start Sweep");
+    m_saveSweepButton->setEnabled(!results.isEmpty());
+}
+
+void MainWindow::onSaveSweepTable()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Save Frequency Response",
+        QString("bode_%1.csv").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+        "CSV Files (*.csv);;All Files (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "Save Error", "Could not open file for writing: " + file.errorString());
+        return;
+    }
+
+    QTextStream out(&file);
+    m_frequencySweep.writeTable(out);
+    qDebug() << "Frequency response saved to" << filePath;
+}
+
+// Spectrum analyzer methods
+void MainWindow::createSpectrumTab()
+{
+    QWidget *spectrumTab = new QWidget();
+    QVBoxLayout *spectrumLayout = new QVBoxLayout(spectrumTab);
+
+    QGroupBox *settingsGroup = new QGroupBox("Analyzer Settings");
+    QGridLayout *settingsLayout = new QGridLayout(settingsGroup);
+
+    settingsLayout->addWidget(new QLabel("Signal:"), 0, 0);
+    m_spectrumSourceComboBox = new QComboBox();
+    m_spectrumSourceComboBox->addItem("X Command", SpectrumXCommand);
+    m_spectrumSourceComboBox->addItem("Y Command", SpectrumYCommand);
+    m_spectrumSourceComboBox->addItem("X Feedback (AI0)", SpectrumXFeedback);
+    m_spectrumSourceComboBox->addItem("Y Feedback (AI1)", SpectrumYFeedback);
+    m_spectrumSourceComboBox->addItem("Tracker Raw Error X", SpectrumTrackerRawX);
+    m_spectrumSourceComboBox->addItem("Tracker Raw Error Y", SpectrumTrackerRawY);
+    m_spectrumSourceComboBox->addItem("Tracker Filtered Error X", SpectrumTrackerFilteredX);
+    m_spectrumSourceComboBox->addItem("Tracker Filtered Error Y", SpectrumTrackerFilteredY);
+    m_spectrumSourceComboBox->setToolTip("Commands need buffered output, feedback also needs sensor "
+                                         "acquisition; tracker errors are sampled at the poll rate");
+    settingsLayout->addWidget(m_spectrumSourceComboBox, 0, 1);
+
+    settingsLayout->addWidget(new QLabel("FFT Size:"), 0, 2);
+    m_spectrumSizeComboBox = new QComboBox();
+    for (int size = 512; size <= 65536; size *= 2) {
+        m_spectrumSizeComboBox->addItem(QString::number(size), size);
+    }
+    m_spectrumSizeComboBox->setCurrentIndex(m_spectrumSizeComboBox->findData(4096));
+    settingsLayout->addWidget(m_spectrumSizeComboBox, 0, 3);
+
+    settingsLayout->addWidget(new QLabel("Window:"), 1, 0);
+    m_spectrumWindowComboBox = new QComboBox();
+    for (SpectrumAnalyzer::Window window : {SpectrumAnalyzer::Hann, SpectrumAnalyzer::BlackmanHarris,
+                                            SpectrumAnalyzer::Rectangular}) {
+        m_spectrumWindowComboBox->addItem(SpectrumAnalyzer::windowName(window), window);
+    }
+    settingsLayout->addWidget(m_spectrumWindowComboBox, 1, 1);
+
+    settingsLayout->addWidget(new QLabel("Overlap:"), 1, 2);
+    m_spectrumOverlapComboBox = new QComboBox();
+    m_spectrumOverlapComboBox->addItem("0%", 0.0);
+    m_spectrumOverlapComboBox->addItem("50%", 0.5);
+    m_spectrumOverlapComboBox->addItem("75%", 0.75);
+    m_spectrumOverlapComboBox->setCurrentIndex(1);
+    settingsLayout->addWidget(m_spectrumOverlapComboBox, 1, 3);
+
+    settingsLayout->addWidget(new QLabel("Averages:"), 2, 0);
+    m_spectrumAveragesSpinBox = new QSpinBox();
+    m_spectrumAveragesSpinBox->setRange(1, 1000);
+    m_spectrumAveragesSpinBox->setValue(16);
+    m_spectrumAveragesSpinBox->setToolTip("Linear average up to this many frames, exponential after");
+    settingsLayout->addWidget(m_spectrumAveragesSpinBox, 2, 1);
+
+    m_spectrumLogCheckBox = new QCheckBox("Log Frequency Axis");
+    m_spectrumLogCheckBox->setChecked(true);
+    settingsLayout->addWidget(m_spectrumLogCheckBox, 2, 2);
+
+    QPushButton *resetButton = new QPushButton("Reset");
+    settingsLayout->addWidget(resetButton, 2, 3);
+
+    spectrumLayout->addWidget(settingsGroup);
+
+    m_spectrumStatusLabel = new QLabel();
+    spectrumLayout->addWidget(m_spectrumStatusLabel);
+
+    m_spectrumWidget = new SpectrumWidget();
+    spectrumLayout->addWidget(m_spectrumWidget, 1);
+
+    QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
+    if (tabWidget) {
+        tabWidget->addTab(spectrumTab, "Spectrum");
+    }
+
+    connect(m_spectrumSourceComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSpectrumSettingsChanged);
+    connect(m_spectrumSizeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSpectrumSettingsChanged);
+    connect(m_spectrumWindowComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSpectrumSettingsChanged);
+    connect(m_spectrumOverlapComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSpectrumSettingsChanged);
+    connect(m_spectrumAveragesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onSpectrumSettingsChanged);
+    connect(m_spectrumLogCheckBox, &QCheckBox::toggled, m_spectrumWidget, &SpectrumWidget::setLogFrequency);
+    connect(resetButton, &QPushButton::clicked, this, &MainWindow::onSpectrumSettingsChanged);
+
+    // The rate is replaced by the source's own on its first samples
+    configureSpectrum(1000.0);
+
+    m_spectrumTimer = new QTimer(this);
+    m_spectrumTimer->setInterval(250);
+    connect(m_spectrumTimer, &QTimer::timeout, this, &MainWindow::updateSpectrumDisplay);
+    m_spectrumTimer->start();
+}
+
+void MainWindow::configureSpectrum(double sampleRate)
+{
+    m_spectrumSource = static_cast<SpectrumSource>(m_spectrumSourceComboBox->currentData().toInt());
+    if (!m_spectrumAnalyzer.configure(m_spectrumSizeComboBox->currentData().toInt(),
+            static_cast<SpectrumAnalyzer::Window>(m_spectrumWindowComboBox->currentData().toInt()),
+            m_spectrumOverlapComboBox->currentData().toDouble(),
+            m_spectrumAveragesSpinBox->value(), sampleRate)) {
+        qDebug() << "Spectrum analyzer:" << m_spectrumAnalyzer.getLastError();
+    }
+    m_spectrumFramesShown = 0;
+    m_spectrumWidget->clear();
+    updateSpectrumDisplay();
+}
+
+void MainWindow::onSpectrumSettingsChanged()
+{
+    configureSpectrum(m_spectrumAnalyzer.sampleRate());
+}
+
+void MainWindow::feedSpectrum(SpectrumSource source, const double *data, int count, int stride,
+                              double sampleRate)
+{
+    if (source != m_spectrumSource || count <= 0) {
+        return;
+    }
+
+    // A new stream may run at a different rate; frames must not mix rates
+    if (sampleRate != m_spectrumAnalyzer.sampleRate()) {
+        configureSpectrum(sampleRate);
+    }
+    m_spectrumAnalyzer.addSamples(data, count, stride);
+}
+
+void MainWindow::feedSpectrumHistory(HistoryRing<StreamSample> &history, quint64 *readIndex,
+                                     SpectrumSource xSource, double sampleRate)
+{
+    const SpectrumSource ySource = static_cast<SpectrumSource>(xSource + 1);
+    const quint64 written = history.written();
+    if (m_spectrumSource != xSource && m_spectrumSource != ySource) {
+        *readIndex = written;
+        return;
+    }
+
+    // Whatever the stream thread has overwritten since the last tick is lost
+    quint64 first = qMax(*readIndex, history.oldest(written));
+    StreamSample block[256];
+    while (first < written) {
+        const int count = static_cast<int>(qMin<quint64>(written - first, 256));
+        const StreamSample *a = nullptr;
+        const StreamSample *b = nullptr;
+        int countA = 0;
+        int countB = 0;
+        history.segments(first, count, &a, &countA, &b, &countB);
+        std::copy(a, a + countA, block);
+        std::copy(b, b + countB, block + countA);
+        if (!history.isIntact(first)) {
+            first = history.oldest(history.written());
+            continue;
+        }
+
+        feedSpectrum(xSource, &block[0].x, count, 2, sampleRate);
+        feedSpectrum(ySource, &block[0].y, count, 2, sampleRate);
+        first += count;
+    }
+    *readIndex = first;
+}
+
+void MainWindow::updateSpectrumDisplay()
+{
+    const quint64 frames = m_spectrumAnalyzer.frameCount();
+    if (frames == 0) {
+        m_spectrumStatusLabel->setText(QString("Collecting the first %1-sample frame")
+                                           .arg(m_spectrumAnalyzer.fftSize()));
+        return;
+    }
+    if (frames == m_spectrumFramesShown) {
+        return;
+    }
+    m_spectrumFramesShown = frames;
+
+    QString units = "px";
+    if (m_spectrumSource == SpectrumXCommand || m_spectrumSource == SpectrumYCommand) {
+        units = "FS";
+    } else if (m_spectrumSource == SpectrumXFeedback || m_spectrumSource == SpectrumYFeedback) {
+        units = "V";
+    }
+    m_spectrumWidget->setSpectrum(m_spectrumAnalyzer.psd(), m_spectrumAnalyzer.binWidth(), units);
+
+    m_spectrumStatusLabel->setText(QString("%1 frames, averaging %2 at %3 S/s, %4 Hz resolution")
+                                       .arg(frames)
+                                       .arg(qMin<quint64>(frames, m_spectrumAnalyzer.averages()))
+                                       .arg(m_spectrumAnalyzer.sampleRate(), 0, 'f', 0)
+                                       .arg(m_spectrumAnalyzer.binWidth(), 0, 'g', 4));
+}
+
+// XY scope methods
+void MainWindow::createXyScopeTab()
+{
+    QWidget *xyTab = new QWidget();
+    QVBoxLayout *xyLayout = new QVBoxLayout(xyTab);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    controlLayout->addWidget(new QLabel("Persistence:"));
+    m_xyPersistenceComboBox = new QComboBox();
+    m_xyPersistenceComboBox->addItem("0.1 s", 0.1);
+    m_xyPersistenceComboBox->addItem("0.3 s", 0.3);
+    m_xyPersistenceComboBox->addItem("1 s", 1.0);
+    m_xyPersistenceComboBox->addItem("3 s", 3.0);
+    m_xyPersistenceComboBox->addItem("Infinite", 0.0);
+    m_xyPersistenceComboBox->setCurrentIndex(2);
+    m_xyPersistenceComboBox->setToolTip("Time for old points to fade to about a third of their brightness");
+    controlLayout->addWidget(m_xyPersistenceComboBox);
+
+    QPushButton *clearButton = new QPushButton("Clear");
+    controlLayout->addWidget(clearButton);
+    controlLayout->addStretch();
+    xyLayout->addLayout(controlLayout);
+
+    QLabel *hintLabel = new QLabel("Shows buffered output: the command in green, the sensor feedback in "
+                                   "yellow when acquired. Set a 90° phase offset for a circle.");
+    hintLabel->setWordWrap(true);
+    xyLayout->addWidget(hintLabel);
+
+    m_xyScopeWidget = new XyScopeWidget();
+    m_xyScopeWidget->setRange(m_mirrorController->positionToVoltage(-1.0),
+                              m_mirrorController->positionToVoltage(1.0));
+    xyLayout->addWidget(m_xyScopeWidget, 1);
+    m_streamThread->setXyHistory(&m_xyScopeWidget->history());
+
+    QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
+    if (tabWidget) {
+        tabWidget->addTab(xyTab, "XY Scope");
+    }
+
+    connect(m_xyPersistenceComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onXyPersistenceChanged);
+    connect(clearButton, &QPushButton::clicked, m_xyScopeWidget, &XyScopeWidget::clear);
+    onXyPersistenceChanged(m_xyPersistenceComboBox->currentIndex());
+}
+
+void MainWindow::onXyPersistenceChanged(int index)
+{
+    m_xyScopeWidget->setPersistence(m_xyPersistenceComboBox->itemData(index).toDouble());
+}
+
+// Log viewer methods
+void MainWindow::createLogViewTab()
+{
+    QWidget *logViewTab = new QWidget();
+    QVBoxLayout *logViewLayout = new QVBoxLayout(logViewTab);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    QPushButton *openButton = new QPushButton("Open Log...");
+    openButton->setToolTip("Load a waveform or tracker CSV log");
+    controlLayout->addWidget(openButton);
+
+    m_logViewLiveCheckBox = new QCheckBox("Live Output");
+    m_logViewLiveCheckBox->setToolTip("Record the X/Y commands as they are output, up to an hour at 10 kS/s");
+    controlLayout->addWidget(m_logViewLiveCheckBox);
+
+    m_logViewFollowCheckBox = new QCheckBox("Follow");
+    m_logViewFollowCheckBox->setToolTip("Keep the newest samples in view");
+    controlLayout->addWidget(m_logViewFollowCheckBox);
+
+    QPushButton *fitButton = new QPushButton("Show All");
+    controlLayout->addWidget(fitButton);
+    controlLayout->addStretch();
+    logViewLayout->addLayout(controlLayout);
+
+    m_logViewStatusLabel = new QLabel("Wheel to zoom, drag to pan, double-click to show all");
+    logViewLayout->addWidget(m_logViewStatusLabel);
+
+    m_logViewWidget = new LogViewWidget();
+    logViewLayout->addWidget(m_logViewWidget, 1);
+
+    QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
+    if (tabWidget) {
+        tabWidget->addTab(logViewTab, "Log Viewer");
+    }
+
+    connect(openButton, &QPushButton::clicked, this, &MainWindow::onOpenLogView);
+    connect(m_logViewLiveCheckBox, &QCheckBox::toggled, this, &MainWindow::onLogViewLiveToggled);
+    connect(m_logViewFollowCheckBox, &QCheckBox::toggled, m_logViewWidget, &LogViewWidget::setFollow);
+    connect(m_logViewWidget, &LogViewWidget::followChanged, m_logViewFollowCheckBox, &QCheckBox::setChecked);
+    connect(fitButton, &QPushButton::clicked, m_logViewWidget, &LogViewWidget::zoomToFit);
+
+    m_logViewTimer = new QTimer(this);
+    m_logViewTimer->setInterval(100);
+    connect(m_logViewTimer, &QTimer::timeout, this, &MainWindow::pollLogViewLive);
+}
+
+void MainWindow::onOpenLogView()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Log File", "",
+                                                    "Log Files (*.csv *.jtmlog *.jtmtrk);;All Files (*)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    m_logViewLiveCheckBox->setChecked(false);
+    m_logViewFollowCheckBox->setChecked(false);
+    bool loaded;
+    if (fileName.endsWith(".jtmlog", Qt::CaseInsensitive)) {
+        loaded = m_logViewWidget->loadBinaryLog(fileName);
+    } else if (fileName.endsWith(".jtmtrk", Qt::CaseInsensitive)) {
+        loaded = m_logViewWidget->loadTrackLog(fileName);
+    } else {
+        loaded = m_logViewWidget->loadCsv(fileName);
+    }
+    if (!loaded) {
+        QMessageBox::warning(this, "Log Viewer", m_logViewWidget->getLastError());
+        return;
+    }
+
+    const qint64 samples = m_logViewWidget->traceCount() > 0 ? m_logViewWidget->trace(0).size() : 0;
+    m_logViewStatusLabel->setText(QString("%1: %2 samples at %3 S/s")
+                                      .arg(QFileInfo(fileName).fileName())
+                                      .arg(samples)
+                                      .arg(m_logViewWidget->sampleRate(), 0, 'g', 6));
+}
+
+void MainWindow::onLogViewLiveToggled(bool checked)
+{
+    if (checked) {
+        startLiveLogView();
+        m_logViewFollowCheckBox->setChecked(true);
+        m_logViewTimer->start();
+    } else {
+        m_logViewTimer->stop();
+    }
+}
+
+void MainWindow::startLiveLogView()
+{
+    m_logViewWidget->clearTraces();
+    m_logViewWidget->addTrace("X Command", Qt::green);
+    m_logViewWidget->addTrace("Y Command", Qt::yellow);
+    m_logViewWidget->setSampleRate(m_scopeSampleRate);
+    m_logViewWidget->zoomToFit();
+    m_logViewReadIndex = m_scopeWidget->history().written();
+}
+
+void MainWindow::pollLogViewLive()
+{
+    // Another reader of the scope history: copy out a block, check the
+    // producer left it alone, then add it to the pyramids
+    static constexpr int BlockSize = 4096;
+    PositionSample block[BlockSize];
+
+    HistoryRing<PositionSample> &history = m_scopeWidget->history();
+    MinMaxPyramid &x = m_logViewWidget->trace(0);
+    MinMaxPyramid &y = m_logViewWidget->trace(1);
+    const quint64 written = history.written();
+    quint64 first = qMax(m_logViewReadIndex, history.oldest(written));
+
+    while (first < written && x.size() < LogViewLiveLimit) {
+        const int count = static_cast<int>(qMin<quint64>(written - first, BlockSize));
+        const PositionSample *a;
+        const PositionSample *b;
+        int countA;
+        int countB;
+        history.segments(first, count, &a, &countA, &b, &countB);
+        std::copy(a, a + countA, block);
+        std::copy(b, b + countB, block + countA);
+        if (!history.isIntact(first)) {
+            qDebug() << "Log viewer fell behind the scope history, samples skipped";
+            first = history.oldest(history.written());
+            continue;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            x.append(block[i].x);
+            y.append(block[i].y);
+        }
+        first += count;
+    }
+    m_logViewReadIndex = first;
+    m_logViewWidget->dataAppended();
+
+    m_logViewStatusLabel->setText(QString("Live: %1 samples, %2 s at %3 S/s")
+                                      .arg(x.size())
+                                      .arg(x.size() / m_logViewWidget->sampleRate(), 0, 'f', 1)
+                                      .arg(m_logViewWidget->sampleRate(), 0, 'g', 6));
+    if (x.size() >= LogViewLiveLimit) {
+        m_logViewLiveCheckBox->setChecked(false);
+        m_logViewStatusLabel->setText(m_logViewStatusLabel->text() + " (limit reached, recording stopped)");
+    }
+}
+
+// Diagnostics methods
+void MainWindow::createDiagnosticsTab()
+{
+    QWidget *diagnosticsTab = new QWidget();
+    QVBoxLayout *diagnosticsLayout = new QVBoxLayout(diagnosticsTab);
+
+    QGroupBox *timingGroup = new QGroupBox("Output Timing (us)");
+    QGridLayout *timingLayout = new QGridLayout(timingGroup);
+
+    m_histograms << &m_mirrorController->writeHistogram()
+                 << &m_outputThread->periodHistogram()
+                 << &m_scopeWidget->guiHistogram();
+
+    const QStringList columns = {"Samples", "Min", "Mean", "p50", "p99", "p99.9", "Max"};
+    for (int column = 0; column < columns.size(); ++column) {
+        timingLayout->addWidget(new QLabel(columns[column]), 0, column + 1);
+    }
+
+    for (int row = 0; row < m_histograms.size(); ++row) {
+        timingLayout->addWidget(new QLabel(m_histograms[row]->name() + ":"), row + 1, 0);
+
+        QVector<QLabel*> labels;
+        for (int column = 0; column < columns.size(); ++column) {
+            QLabel *label = new QLabel("-");
+            timingLayout->addWidget(label, row + 1, column + 1);
+            labels.append(label);
+        }
+        m_histogramLabels.append(labels);
+    }
+
+    diagnosticsLayout->addWidget(timingGroup);
+
+    // Share of the GUI thread, which also tops up the output stream
+    m_guiLoadLabel = new QLabel();
+    diagnosticsLayout->addWidget(m_guiLoadLabel);
+    m_lastScopeGuiNs = 0.0;
+    m_guiLoadTimer.start();
+
+    // Log writer backlog; drops mean the disk fell behind for a whole queue
+    m_loggingQueueLabel = new QLabel();
+    diagnosticsLayout->addWidget(m_loggingQueueLabel);
+
+    // Sustained write rate of the log files, over the last refresh
+    m_logThroughputLabel = new QLabel();
+    diagnosticsLayout->addWidget(m_logThroughputLabel);
+    m_lastWaveformLogBytes = 0;
+    m_lastTrackerLogBytes = 0;
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    m_instrumentationCheckBox = new QCheckBox("Record Timing");
+    m_instrumentationCheckBox->setChecked(true);
+    controlLayout->addWidget(m_instrumentationCheckBox);
+
+    QPushButton *resetButton = new QPushButton("Reset");
+    controlLayout->addWidget(resetButton);
+
+    QPushButton *dumpButton = new QPushButton("Dump to File...");
+    controlLayout->addWidget(dumpButton);
+    controlLayout->addStretch();
+
+    diagnosticsLayout->addLayout(controlLayout);
+
+    // Add a stretch to keep UI elements at the top
+    diagnosticsLayout->addStretch();
+
+    QTabWidget *tabWidget = qobject_cast<QTabWidget*>(centralWidget());
+    if (tabWidget) {
+        tabWidget->addTab(diagnosticsTab, "Diagnostics");
+    }
+
+    connect(m_instrumentationCheckBox, &QCheckBox::toggled, this, &MainWindow::onInstrumentationToggled);
+    connect(resetButton, &QPushButton::clicked, this, &MainWindow::onResetHistograms);
+    connect(dumpButton, &QPushButton::clicked, this, &MainWindow::onDumpHistograms);
+
+    m_diagnosticsTimer = new QTimer(this);
+    m_diagnosticsTimer->setInterval(250);
+    connect(m_diagnosticsTimer, &QTimer::timeout, this, &MainWindow::updateDiagnostics);
+    m_diagnosticsTimer->start();
+}
+
+void MainWindow::onInstrumentationToggled(bool checked)
+{
+    m_mirrorController->setInstrumentationEnabled(checked);
+    m_outputThread->setInstrumentationEnabled(checked);
+}
+
+void MainWindow::onResetHistograms()
+{
+    for (LatencyHistogram *histogram : m_histograms) {
+        histogram->reset();
+    }
+    updateDiagnostics();
+}
+
+void MainWindow::onDumpHistograms()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Save Timing Histograms",
+        QString("timing_%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+        "Text Files (*.txt);;All Files (*)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "Dump Error", "Could not open file: " + file.errorString());
+        return;
+    }
+
+    QTextStream out(&file);
+    out << "# Output timing, " << QDateTime::currentDateTime().toString(Qt::ISODate)
+        << ", backend " << AoBackend::displayName(m_mirrorController->backendType())
+        << ", output thread " << m_outputThread->config().rateHz << " Hz ("
+        << m_outputThread->schedulingStatus() << ")\n\n";
+    for (const LatencyHistogram *histogram : m_histograms) {
+        histogram->writeDistribution(out);
+    }
+}
+
+void MainWindow::updateDiagnostics()
+{
+    for (int row = 0; row < m_histograms.size(); ++row) {
+        const LatencyHistogram *histogram = m_histograms[row];
+        const QVector<QLabel*> &labels = m_histogramLabels[row];
+
+        labels[0]->setText(QString::number(histogram->count()));
+        labels[1]->setText(QString::number(histogram->minNs() / 1000.0, 'f', 2));
+        labels[2]->setText(QString::number(histogram->meanNs() / 1000.0, 'f', 2));
+        labels[3]->setText(QString::number(histogram->percentileNs(50.0) / 1000.0, 'f', 2));
+        labels[4]->setText(QString::number(histogram->percentileNs(99.0) / 1000.0, 'f', 2));
+        labels[5]->setText(QString::number(histogram->percentileNs(99.9) / 1000.0, 'f', 2));
+        labels[6]->setText(QString::number(histogram->maxNs() / 1000.0, 'f', 2));
+    }
+
+    const LatencyHistogram &scope = m_scopeWidget->guiHistogram();
+    const double scopeNs = scope.meanNs() * scope.count();
+    const qint64 elapsedNs = m_guiLoadTimer.nsecsElapsed();
+    if (elapsedNs > 0 && scopeNs >= m_lastScopeGuiNs) {
+        m_guiLoadLabel->setText(QString("Scope GUI-thread time: %1 ms/s")
+                                    .arg((scopeNs - m_lastScopeGuiNs) / elapsedNs * 1000.0, 0, 'f', 2));
+    }
+    m_lastScopeGuiNs = scopeNs;
+    m_guiLoadTimer.restart();
+
+    // Byte counts restart with each log; a smaller count means a new one
+    const qint64 waveformBytes = m_loggingThread->bytesWritten();
+    const qint64 trackerBytes = m_trackerLogger->bytesWritten();
+    if (elapsedNs > 0) {
+        const double toMBps = 1.0e9 / elapsedNs / (1 << 20);
+        m_logThroughputLabel->setText(QString("Log writes: waveform %1 MB/s, tracker %2 MB/s")
+                                          .arg(qMax<qint64>(0, waveformBytes - m_lastWaveformLogBytes) * toMBps, 0, 'f', 2)
+                                          .arg(qMax<qint64>(0, trackerBytes - m_lastTrackerLogBytes) * toMBps, 0, 'f', 2));
+    }
+    m_lastWaveformLogBytes = waveformBytes;
+    m_lastTrackerLogBytes = trackerBytes;
+
+    m_loggingQueueLabel->setText(QString("Log queue: %1 queued, %2 written, %3 dropped")
+                                     .arg(m_loggingThread->queuedCount())
+                                     .arg(m_loggingThread->writtenCount())
+                                     .arg(m_loggingThread->droppedCount()));
+}
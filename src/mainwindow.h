@@ -15,7 +15,6 @@
 #include <QLineEdit>
 #include <QFile>
 #include <QTextStream>
-#include <QDateTime>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QPainter>
@@ -28,6 +27,11 @@
 #include "logger.h"
 #include <QElapsedTimer>
 #include "loggingthread.h"
+#include "outputthread.h"
+#include "streamthread.h"
+#include "waveformgenerator.h"
+#include "frequencysweep.h"
+#include "spectrumanalyzer.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -35,13 +39,18 @@ QT_END_NAMESPACE
 
 class QGroupBox;
 class QTabWidget;
+class QTableWidget;
+class SpectrumWidget;
+class ScopeWidget;
+class LogViewWidget;
+class XyScopeWidget;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(AoBackend::Type aoBackend = AoBackend::Advantech, QWidget *parent = nullptr);
     ~MainWindow();
 
 private slots:
@@ -56,20 +65,23 @@ private slots:
     void onCalibrateJoystick();
 
     // Mirror related slots
+    void onAoBackendChanged(int index);
+    void applySimulatedMirrorParameters();
     void onRefreshMirrorDevices();
     void onMirrorDeviceSelected(int index);
     void updateMirrorDeviceList();
-    void onUpdateMirrorPosition();
     void onMirrorPositionChanged(double xPosition, double yPosition);
     void onMirrorDeviceError(const QString &errorMessage);
     void onAxisMappingChanged();
     void onDeadzoneChanged(int value);
     void onInvertAxisToggled(bool checked);
     void onEnableMirrorOutput(bool enabled);
+    void onApplyOutputThreadConfig();
+    void onOutputStatusTimer();
 
     // Sine wave testing slots
     void onStartStopSineWave();
-    void onUpdateSineWave();
+    void onUpdateDisplay();
     void onBrowseLogFile();
     void onStartStopLogging();
     void onFrequencyChanged(double value);
@@ -77,6 +89,25 @@ private slots:
     void onXAxisToggled(bool checked);
     void onYAxisToggled(bool checked);
     void onPhaseOffsetChanged(int value);
+    void onWaveformShapeChanged(int index);
+    void onOutputModeChanged(int index);
+    void onScopeWindowChanged(int index);
+
+    // Frequency response slots
+    void onStartStopSweep();
+    void onSaveSweepTable();
+
+    // Spectrum analyzer slots
+    void onSpectrumSettingsChanged();
+    void updateSpectrumDisplay();
+
+    // XY scope slots
+    void onXyPersistenceChanged(int index);
+
+    // Log viewer slots
+    void onOpenLogView();
+    void onLogViewLiveToggled(bool checked);
+    void pollLogViewLive();
 
     // Tracker related slots
     void onTrackerInitButtonClicked();
@@ -84,14 +115,23 @@ private slots:
     void onTrackerStartLoggingButtonClicked();
     void onTrackerStopLoggingButtonClicked();
     void onTrackerAutoPollToggled(bool checked);
+    void onTrackerDriveToggled(bool checked);
     void pollTracker();
     void handleTrackerError(const QString& errorMsg);
     void handleLoggerError(const QString& errorMsg);
 
+    // Diagnostics slots
+    void onInstrumentationToggled(bool checked);
+    void onResetHistograms();
+    void onDumpHistograms();
+    void updateDiagnostics();
+
 private:
     Ui::MainWindow *ui;
     JoystickManager *m_joystickManager;
     FastSteeringMirror *m_mirrorController;
+    OutputThread *m_outputThread;
+    StreamThread *m_streamThread;
 
     // Joystick UI elements
     QVector<QLabel*> m_buttonLabels;
@@ -100,6 +140,7 @@ private:
     QVBoxLayout *m_inputsLayout;
 
     // Mirror UI elements
+    QComboBox *m_aoBackendComboBox;
     QComboBox *m_mirrorDeviceComboBox;
     QPushButton *m_refreshMirrorButton;
     QCheckBox *m_enableMirrorCheckbox;
@@ -111,17 +152,35 @@ private:
     QVBoxLayout *m_mirrorStatusLayout;
     QLineEdit *m_profilePathEdit;  // Added for XML profile support
 
+    // Simulated mirror parameters
+    QGroupBox *m_simulatedMirrorGroup;
+    QComboBox *m_simOrderComboBox;
+    QDoubleSpinBox *m_simBandwidthSpinBox;
+    QDoubleSpinBox *m_simDampingSpinBox;
+    QDoubleSpinBox *m_simLatencySpinBox;
+    QSpinBox *m_simDacBitsSpinBox;
+
     // Mirror status UI
     QLabel *m_mirrorXLabel;
     QLabel *m_mirrorYLabel;
     QProgressBar *m_mirrorXBar;
     QProgressBar *m_mirrorYBar;
 
+    // Output thread UI
+    QSpinBox *m_outputRateSpinBox;
+    QCheckBox *m_outputRealtimeCheckBox;
+    QSpinBox *m_outputPrioritySpinBox;
+    QSpinBox *m_outputCpuSpinBox;
+    QCheckBox *m_outputLockMemoryCheckBox;
+    QLabel *m_outputThreadStatusLabel;
+    QTimer *m_outputStatusTimer;
+
     // Sine wave test UI elements
     QPushButton *m_sineWaveButton;
     QProgressBar *m_xOutputBar;
     QProgressBar *m_yOutputBar;
-    QLabel *m_waveformLabel;
+    ScopeWidget *m_scopeWidget;
+    QComboBox *m_scopeWindowComboBox;
     QDoubleSpinBox *m_frequencySpinBox;
     QDoubleSpinBox *m_amplitudeSpinBox;
     QSpinBox *m_phaseOffsetSpinBox;
@@ -130,33 +189,92 @@ private:
     QPushButton *m_browseButton;
     QCheckBox *m_xAxisCheckBox;
     QCheckBox *m_yAxisCheckBox;
+    QComboBox *m_outputModeComboBox;
+    QComboBox *m_waveformShapeComboBox;
+    QDoubleSpinBox *m_endFrequencySpinBox;
+    QDoubleSpinBox *m_sweepTimeSpinBox;
+    QSpinBox *m_toneCountSpinBox;
+    QSpinBox *m_prbsOrderSpinBox;
+    QSpinBox *m_sampleRateSpinBox;
+    QCheckBox *m_feedbackCheckBox;
+    QSpinBox *m_feedbackDelaySpinBox;
+    QLabel *m_streamStatusLabel;
 
     // Sine wave generation
-    QTimer *m_sineWaveTimer;
+    QTimer *m_displayTimer;   // Display refresh while a waveform runs
     bool m_sineWaveActive;
-    double m_sinePhase;
     double m_sineFrequency;
     double m_sineAmplitude;
     int m_phaseOffset;    // Phase offset between X and Y (in degrees)
-    QVector<double> m_xWaveformData;
-    QVector<double> m_yWaveformData;
-    QVector<QPointF> m_waveformPoints;
-    QDateTime m_startTime;
+
+    // Hardware-clocked (buffered) output, fed by m_streamThread
+    QElapsedTimer m_streamStatusTimer;  // Since the status line was last refreshed
+    quint64 m_commandHistoryRead;       // Next stream sample for the spectrum
+    quint64 m_feedbackHistoryRead;
+
+    // Frequency response sweep, streamed through the waveform output
+    FrequencySweep m_frequencySweep;
+    bool m_sweepActive;
+    QComboBox *m_sweepModeComboBox;
+    QDoubleSpinBox *m_sweepStartSpinBox;
+    QDoubleSpinBox *m_sweepStopSpinBox;
+    QSpinBox *m_sweepPointsSpinBox;
+    QCheckBox *m_sweepLogCheckBox;
+    QLineEdit *m_sweepListEdit;
+    QDoubleSpinBox *m_sweepAmplitudeSpinBox;
+    QDoubleSpinBox *m_sweepSettleSpinBox;
+    QSpinBox *m_sweepMeasureSpinBox;
+    QDoubleSpinBox *m_sweepChirpTimeSpinBox;
+    QPushButton *m_sweepButton;
+    QPushButton *m_saveSweepButton;
+    QLabel *m_sweepStatusLabel;
+    QTableWidget *m_sweepTable;
+
+    // Live spectrum of one command, feedback or tracker error signal
+    enum SpectrumSource {
+        SpectrumXCommand,
+        SpectrumYCommand,
+        SpectrumXFeedback,
+        SpectrumYFeedback,
+        SpectrumTrackerRawX,
+        SpectrumTrackerRawY,
+        SpectrumTrackerFilteredX,
+        SpectrumTrackerFilteredY
+    };
+    SpectrumAnalyzer m_spectrumAnalyzer;
+    SpectrumSource m_spectrumSource;
+    quint64 m_spectrumFramesShown;
+    QComboBox *m_spectrumSourceComboBox;
+    QComboBox *m_spectrumSizeComboBox;
+    QComboBox *m_spectrumWindowComboBox;
+    QComboBox *m_spectrumOverlapComboBox;
+    QSpinBox *m_spectrumAveragesSpinBox;
+    QCheckBox *m_spectrumLogCheckBox;
+    QLabel *m_spectrumStatusLabel;
+    SpectrumWidget *m_spectrumWidget;
+    QTimer *m_spectrumTimer;
+
+    // X/Y view of command and feedback with a per-revolution ellipse fit
+    XyScopeWidget *m_xyScopeWidget;
+    QComboBox *m_xyPersistenceComboBox;
+
+    // Log viewer: a CSV log loaded from disk, or the output read back from
+    // the scope history while it runs
+    static constexpr qint64 LogViewLiveLimit = 36000000;   // 1 h at 10 kS/s
+    LogViewWidget *m_logViewWidget;
+    QCheckBox *m_logViewLiveCheckBox;
+    QCheckBox *m_logViewFollowCheckBox;
+    QLabel *m_logViewStatusLabel;
+    QTimer *m_logViewTimer;
+    quint64 m_logViewReadIndex;
+    double m_scopeSampleRate;
 
     // Data logging
-    QFile *m_logFile;
-    QTextStream *m_logStream;
     bool m_loggingActive;
 
     // State variables
     int m_selectedJoystickIndex;
     bool m_mirrorOutputEnabled;
-    int m_xAxisIndex;
-    int m_yAxisIndex;
-    bool m_invertXAxis;
-    bool m_invertYAxis;
-    double m_deadzone;
-    QTimer *m_updateTimer;
 
     // Tracker-related members
     TrackerMemory *m_trackerMemory;
@@ -178,11 +296,26 @@ private:
     QPushButton *m_trackerStartLoggingButton;
     QPushButton *m_trackerStopLoggingButton;
     QCheckBox *m_trackerAutoPollCheckBox;
+    QCheckBox *m_trackerDriveCheckBox;
+    QDoubleSpinBox *m_trackerGainSpinBox;
 
-    // Add data logging buffer
-    QVector<LogRecord> m_logBuffer;
+    // Diagnostics UI elements
+    QCheckBox *m_instrumentationCheckBox;
+    QVector<LatencyHistogram*> m_histograms;
+    QVector<QVector<QLabel*>> m_histogramLabels;
+    QTimer *m_diagnosticsTimer;
+    QLabel *m_guiLoadLabel;
+    QElapsedTimer m_guiLoadTimer;
+    double m_lastScopeGuiNs;
+    QLabel *m_loggingQueueLabel;
+    QLabel *m_logThroughputLabel;
+    qint64 m_lastWaveformLogBytes;
+    qint64 m_lastTrackerLogBytes;
 
-    QElapsedTimer m_loggingTimer;
+    // Log file rotation and O_DIRECT, for both the waveform and tracker logs
+    QComboBox *m_logRotateSizeComboBox;
+    QComboBox *m_logRotateTimeComboBox;
+    QCheckBox *m_logDirectCheckBox;
 
     LoggingThread* m_loggingThread;
 
@@ -191,13 +324,29 @@ private:
     void createMirrorControlUI();
     void createSineWaveTab();
     void createTrackerTab();  // New method for creating tracker tab
-    void updateWaveformDisplay();
+    void createFrequencyResponseTab();
+    void createSpectrumTab();
+    void createXyScopeTab();
+    void createLogViewTab();
+    void startLiveLogView();
+    void createDiagnosticsTab();
     void updateTrackerUI(const TrackData& data);
     void setTrackerUIEnabled(bool enabled);
     QString hatValueToString(int value);
-    void writeLogBuffer();
-
-    // Helper method to map joystick axis value to mirror position
-    double mapAxisToPosition(int axisValue);
+    bool startBufferedSineWave();
+    LogFile::Options logFileOptions() const;
+    PeriodicWaveform currentPeriodicWaveform() const;
+    void updatePeriodicOutput();
+    void updateStreamDisplay();
+    void updateStreamStatus();
+    WaveformSettings streamWaveformSettings() const;
+    WaveformSettings currentWaveformSettings() const;
+    void updateOutputSource();
+    SweepSettings currentSweepSettings() const;
+    void updateSweepProgress();
+    void configureSpectrum(double sampleRate);
+    void feedSpectrum(SpectrumSource source, const double *data, int count, int stride, double sampleRate);
+    void feedSpectrumHistory(HistoryRing<StreamSample> &history, quint64 *readIndex,
+                             SpectrumSource xSource, double sampleRate);
 };
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "minmaxpyramid.h"
+#include <cmath>
+#include <limits>
+
+static_assert(MinMaxPyramid::Factor == 16, "bucket spans are computed as shifts by 4 bits per level");
+
+MinMaxPyramid::MinMaxPyramid()
+{
+}
+
+void MinMaxPyramid::clear()
+{
+    m_samples.clear();
+    m_levels.clear();
+}
+
+void MinMaxPyramid::reserve(qint64 samples)
+{
+    m_samples.reserve(samples);
+    qint64 buckets = samples / Factor;
+    for (int level = 0; buckets > 0; ++level, buckets /= Factor) {
+        if (level == m_levels.size()) {
+            m_levels.append(QVector<Bucket>());
+        }
+        m_levels[level].reserve(buckets);
+    }
+}
+
+void MinMaxPyramid::append(double value)
+{
+    m_samples.append(static_cast<float>(value));
+    if (m_samples.size() % Factor == 0) {
+        closeBucket(0);
+    }
+}
+
+void MinMaxPyramid::append(const double *values, int count, int stride)
+{
+    for (int i = 0; i < count; ++i) {
+        append(values[i * stride]);
+    }
+}
+
+void MinMaxPyramid::closeBucket(int level)
+{
+    // Summarize the last Factor items below into one bucket at level + 1
+    Bucket bucket;
+    if (level == 0) {
+        const float *items = m_samples.constData() + m_samples.size() - Factor;
+        bucket = {items[0], items[0], 0.0};
+        for (int i = 0; i < Factor; ++i) {
+            bucket.min = qMin(bucket.min, items[i]);
+            bucket.max = qMax(bucket.max, items[i]);
+            bucket.sum += items[i];
+        }
+    } else {
+        const QVector<Bucket> &below = m_levels[level - 1];
+        const Bucket *items = below.constData() + below.size() - Factor;
+        bucket = items[0];
+        for (int i = 1; i < Factor; ++i) {
+            bucket.min = qMin(bucket.min, items[i].min);
+            bucket.max = qMax(bucket.max, items[i].max);
+            bucket.sum += items[i].sum;
+        }
+    }
+
+    if (level == m_levels.size()) {
+        m_levels.append(QVector<Bucket>());
+    }
+    QVector<Bucket> &buckets = m_levels[level];
+    buckets.append(bucket);
+    if (buckets.size() % Factor == 0) {
+        closeBucket(level + 1);
+    }
+}
+
+void MinMaxPyramid::accumulate(int level, qint64 first, qint64 last, Summary *summary) const
+{
+    if (first >= last) {
+        return;
+    }
+
+    // Hand whole buckets of the next level up, keep only the ragged ends
+    if (level < m_levels.size()) {
+        const qint64 upperFirst = (first + Factor - 1) / Factor;
+        const qint64 upperLast = qMin<qint64>(last / Factor, m_levels[level].size());
+        if (upperFirst < upperLast) {
+            accumulate(level, first, upperFirst * Factor, summary);
+            accumulate(level + 1, upperFirst, upperLast, summary);
+            accumulate(level, upperLast * Factor, last, summary);
+            return;
+        }
+    }
+
+    if (level == 0) {
+        const float *items = m_samples.constData();
+        for (qint64 i = first; i < last; ++i) {
+            summary->min = qMin(summary->min, items[i]);
+            summary->max = qMax(summary->max, items[i]);
+            summary->sum += items[i];
+        }
+        summary->count += last - first;
+        return;
+    }
+
+    const Bucket *items = m_levels[level - 1].constData();
+    for (qint64 i = first; i < last; ++i) {
+        summary->min = qMin(summary->min, items[i].min);
+        summary->max = qMax(summary->max, items[i].max);
+        summary->sum += items[i].sum;
+    }
+    summary->count += (last - first) << (4 * level);
+}
+
+MinMaxPyramid::Summary MinMaxPyramid::summarize(qint64 first, qint64 last) const
+{
+    Summary summary = {std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0.0, 0};
+    accumulate(0, qMax<qint64>(first, 0), qMin<qint64>(last, size()), &summary);
+    if (summary.count == 0) {
+        summary.min = summary.max = 0.0f;
+    }
+    return summary;
+}
+
+void MinMaxPyramid::reduce(double first, double samplesPerColumn, int columns, Summary *out) const
+{
+    qint64 start = static_cast<qint64>(std::floor(first));
+    for (int column = 0; column < columns; ++column) {
+        qint64 end = static_cast<qint64>(std::floor(first + (column + 1) * samplesPerColumn));
+        // Zoomed in past one sample per column: repeat the nearest sample
+        out[column] = summarize(start, qMax(end, start + 1));
+        start = qMax(end, start);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// Multi-resolution min/max/mean summary of one sampled signal.
+//
+// Level 0 holds the samples themselves; every level above it holds one
+// bucket per Factor buckets of the level below. Buckets are closed as soon
+// as they are full, so appending costs O(1) amortized and the pyramid can be
+// queried at any time while it grows. A query over any sample range reads
+// whole buckets at the coarsest level that fits and only descends at the
+// ends, which makes reducing a view to N pixel columns cost O(N) whether it
+// spans a hundred samples or a hundred million.
+class MinMaxPyramid
+{
+public:
+    static constexpr int Factor = 16;
+
+    struct Summary {
+        float min;
+        float max;
+        double sum;
+        qint64 count;
+
+        double mean() const { return count > 0 ? sum / count : 0.0; }
+    };
+
+    MinMaxPyramid();
+
+    void clear();
+    void reserve(qint64 samples);
+
+    void append(double value);
+    void append(const double *values, int count, int stride = 1);
+
+    qint64 size() const { return m_samples.size(); }
+    float sample(qint64 index) const { return m_samples[index]; }
+    const float *samples() const { return m_samples.constData(); }
+
+    // Samples [first, last), clipped to what has been appended
+    Summary summarize(qint64 first, qint64 last) const;
+
+    // Reduce samples [first, first + columns * samplesPerColumn) to one
+    // summary per column; columns past the data get a count of zero
+    void reduce(double first, double samplesPerColumn, int columns, Summary *out) const;
+
+private:
+    struct Bucket {
+        float min;
+        float max;
+        double sum;
+    };
+
+    QVector<float> m_samples;
+    QVector<QVector<Bucket>> m_levels;   // m_levels[0] is pyramid level 1
+
+    void closeBucket(int level);
+    void accumulate(int level, qint64 first, qint64 last, Summary *summary) const;
+};
+
+#endif // MINMAXPYRAMID_H
@@ -0,0 +1,142 @@
+#include "mirrormodel.h"
+#include <QtMath>
+
+MirrorModel::MirrorModel(const MirrorModelParams &params)
+    : m_params(params)
+    , m_time(0.0)
+    , m_pendingHead(0)
+{
+    setParameters(params);
+    reset();
+}
+
+void MirrorModel::setParameters(const MirrorModelParams &params)
+{
+    m_params = params;
+    m_params.order = qBound(1, m_params.order, 2);
+    m_params.bandwidthHz = qMax(1.0, m_params.bandwidthHz);
+    m_params.damping = qMax(0.0, m_params.damping);
+    m_params.latency = qMax(0.0, m_params.latency);
+    m_params.dacBits = qBound(0, m_params.dacBits, 24);
+}
+
+void MirrorModel::reset()
+{
+    m_time = 0.0;
+    for (int axis = 0; axis < 2; ++axis) {
+        m_applied[axis] = 0.0;
+        m_position[axis] = 0.0;
+        m_velocity[axis] = 0.0;
+    }
+    m_pending.clear();
+    m_pendingHead = 0;
+}
+
+void MirrorModel::write(double t, const double volts[2])
+{
+    advanceTo(t);
+
+    PendingCommand command;
+    command.time = m_time + m_params.latency;
+    command.volts[0] = quantize(volts[0]);
+    command.volts[1] = quantize(volts[1]);
+
+    // Drop the consumed front of the queue once it dominates the storage
+    if (m_pendingHead > 0 && m_pendingHead * 2 >= m_pending.size()) {
+        m_pending.remove(0, m_pendingHead);
+        m_pendingHead = 0;
+    }
+    m_pending.append(command);
+
+    // Zero latency: the mirror sees the command immediately
+    advanceTo(m_time);
+}
+
+void MirrorModel::advanceTo(double t)
+{
+    while (m_pendingHead < m_pending.size() && m_pending[m_pendingHead].time <= t) {
+        const PendingCommand &command = m_pending[m_pendingHead];
+        integrate(command.time - m_time);
+        m_time = qMax(m_time, command.time);
+        m_applied[0] = command.volts[0];
+        m_applied[1] = command.volts[1];
+        ++m_pendingHead;
+    }
+
+    if (t > m_time) {
+        integrate(t - m_time);
+        m_time = t;
+    }
+}
+
+void MirrorModel::processBlock(const double *frames, int frameCount, double sampleRate, double *output)
+{
+    const double dt = 1.0 / sampleRate;
+    for (int i = 0; i < frameCount; ++i) {
+        write(m_time + dt, frames + 2 * i);
+        if (output) {
+            output[2 * i] = m_position[0];
+            output[2 * i + 1] = m_position[1];
+        }
+    }
+}
+
+void MirrorModel::output(double volts[2]) const
+{
+    volts[0] = m_position[0];
+    volts[1] = m_position[1];
+}
+
+double MirrorModel::quantize(double volts) const
+{
+    volts = qBound(m_params.minVoltage, volts, m_params.maxVoltage);
+    if (m_params.dacBits <= 0) {
+        return volts;
+    }
+
+    double lsb = (m_params.maxVoltage - m_params.minVoltage) / ((1 << m_params.dacBits) - 1);
+    return m_params.minVoltage + qRound64((volts - m_params.minVoltage) / lsb) * lsb;
+}
+
+void MirrorModel::integrate(double dt)
+{
+    if (dt <= 0.0) {
+        return;
+    }
+
+    const double omega = 2.0 * M_PI * m_params.bandwidthHz;
+
+    if (m_params.order == 1) {
+        // Exact step response of a first-order lag
+        double alpha = 1.0 - qExp(-omega * dt);
+        for (int axis = 0; axis < 2; ++axis) {
+            m_position[axis] += (m_applied[axis] - m_position[axis]) * alpha;
+            m_velocity[axis] = 0.0;
+        }
+        return;
+    }
+
+    // Long idle gaps: the mirror has long since settled, skip the integration
+    double settleTime = 10.0 / (qMax(m_params.damping, 0.05) * omega);
+    if (dt > settleTime) {
+        for (int axis = 0; axis < 2; ++axis) {
+            m_position[axis] = m_applied[axis];
+            m_velocity[axis] = 0.0;
+        }
+        return;
+    }
+
+    // Semi-implicit Euler with steps well below the resonance period
+    int steps = qMax(1, qCeil(dt * omega / 0.05));
+    double h = dt / steps;
+    double omega2 = omega * omega;
+    double twoZetaOmega = 2.0 * m_params.damping * omega;
+
+    for (int i = 0; i < steps; ++i) {
+        for (int axis = 0; axis < 2; ++axis) {
+            double accel = omega2 * (m_applied[axis] - m_position[axis]) - twoZetaOmega * m_velocity[axis];
+            m_velocity[axis] += accel * h;
+            m_position[axis] += m_velocity[axis] * h;
+        }
+    }
+}
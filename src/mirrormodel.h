@@ -0,0 +1,76 @@
+#ifndef MIRRORMODEL_H
+#define MIRRORMODEL_H
+
+#include <QVector>
+
+// Parameters of the simulated two-axis mirror
+struct MirrorModelParams {
+    int order;              // 1 = first-order lag, 2 = second-order resonance
+    double bandwidthHz;     // Corner (order 1) or natural (order 2) frequency
+    double damping;         // Damping ratio, second order only
+    double latency;         // Transport delay from DAC to mirror, seconds
+    int dacBits;            // DAC resolution, 0 disables quantization
+    double minVoltage;      // DAC output range
+    double maxVoltage;
+
+    MirrorModelParams()
+        : order(2)
+        , bandwidthHz(500.0)
+        , damping(0.7)
+        , latency(100e-6)
+        , dacBits(16)
+        , minVoltage(-10.0)
+        , maxVoltage(10.0)
+    {
+    }
+};
+
+// Two independent axes driven by DAC voltages. Commands are quantized to the
+// DAC resolution, delayed by the transport latency and then filtered by the
+// mechanical response. Output is in volts, at the same scale as the command.
+//
+// Time is the model's own: write() and processBlock() move it forward, so the
+// same model serves both single writes and sample-clocked streams.
+class MirrorModel
+{
+public:
+    explicit MirrorModel(const MirrorModelParams &params = MirrorModelParams());
+
+    void setParameters(const MirrorModelParams &params);
+    const MirrorModelParams &parameters() const { return m_params; }
+
+    void reset();
+    double time() const { return m_time; }
+
+    // Apply a command at time t (seconds) and advance the model to it
+    void write(double t, const double volts[2]);
+
+    // Advance to time t with the commands written so far
+    void advanceTo(double t);
+
+    // Feed a block of interleaved two-channel frames clocked at sampleRate.
+    // output (optional) receives the mirror response for every frame.
+    void processBlock(const double *frames, int frameCount, double sampleRate, double *output = nullptr);
+
+    void output(double volts[2]) const;
+
+    double quantize(double volts) const;
+
+private:
+    struct PendingCommand {
+        double time;
+        double volts[2];
+    };
+
+    MirrorModelParams m_params;
+    double m_time;
+    double m_applied[2];     // Command currently seen by the mirror
+    double m_position[2];
+    double m_velocity[2];
+    QVector<PendingCommand> m_pending;
+    int m_pendingHead;
+
+    void integrate(double dt);
+};
+
+#endif // MIRRORMODEL_H
@@ -0,0 +1,46 @@
+#include "monotonicclock.h"
+#include <cerrno>
+
+namespace {
+
+struct Epoch {
+    qint64 monotonicNs;
+    qint64 wallMs;
+
+    Epoch()
+        : monotonicNs(MonotonicClock::nowNs())
+        , wallMs(QDateTime::currentMSecsSinceEpoch())
+    {
+    }
+};
+
+// Taken during static initialization, before main(); the function-local
+// fallback covers callers from other static initializers
+const Epoch &epoch()
+{
+    static const Epoch instance;
+    return instance;
+}
+
+[[maybe_unused]] const Epoch &s_epoch = epoch();
+
+}
+
+qint64 MonotonicClock::epochNs()
+{
+    return epoch().monotonicNs;
+}
+
+QDateTime MonotonicClock::wallTime(qint64 sessionNs)
+{
+    return QDateTime::fromMSecsSinceEpoch(epoch().wallMs + sessionNs / 1000000);
+}
+
+void MonotonicClock::sleepUntil(qint64 deadlineNs)
+{
+    timespec ts;
+    ts.tv_sec = deadlineNs / 1000000000LL;
+    ts.tv_nsec = deadlineNs % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+#include <QDateTime>
+#include <time.h>
+
+// The one timebase of the process.
+//
+// Every generator, poller and logger stamps against CLOCK_MONOTONIC in
+// nanoseconds, so joystick, AO, AI and tracker timestamps line up and no
+// timebase restarts when logging or output is switched on. Session times
+// count from a single epoch taken when the process starts; the wall-clock
+// time of that epoch is kept to label files, never to measure intervals.
+//
+// CLOCK_MONOTONIC rather than CLOCK_MONOTONIC_RAW: the output thread sleeps
+// to absolute deadlines with clock_nanosleep, which does not accept the raw
+// clock, and stamps must be on the same clock as those deadlines.
+class MonotonicClock
+{
+public:
+    static qint64 nowNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    // Session time: nanoseconds since the epoch
+    static qint64 epochNs();
+    static qint64 sessionNs() { return nowNs() - epochNs(); }
+    static qint64 sessionNs(qint64 monotonicNs) { return monotonicNs - epochNs(); }
+
+    // Wall-clock time at a session time, from the epoch's wall-clock time
+    // plus monotonic time since, so it never jumps with clock adjustments
+    static QDateTime wallTime(qint64 sessionNs);
+
+    // Sleep until an absolute nowNs() deadline, resuming after signals
+    static void sleepUntil(qint64 deadlineNs);
+};
+
+#endif // MONOTONICCLOCK_H
@@ -0,0 +1,169 @@
+#include "nco.h"
+#include <QtMath>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Map a phase word onto [-pi, pi)
+inline double phaseToRadians(quint64 phase)
+{
+    return static_cast<qint64>(phase) * (2.0 * M_PI / 18446744073709551616.0);
+}
+
+}
+
+Nco::Nco(double sampleRate)
+    : m_phase(0)
+    , m_increment(0)
+    , m_sampleRate(sampleRate > 0.0 ? sampleRate : 1000.0)
+    , m_frequency(0.0)
+    , m_amplitude(1.0)
+    , m_offsetCos(1.0)
+    , m_offsetSin(0.0)
+    , m_blockPos(BlockSize)
+{
+    updateIncrement();
+}
+
+void Nco::setSampleRate(double sampleRate)
+{
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    discardBlock();
+    m_sampleRate = sampleRate;
+    updateIncrement();
+}
+
+void Nco::setFrequency(double frequency)
+{
+    discardBlock();
+    m_frequency = qMax(0.0, frequency);
+    updateIncrement();
+}
+
+double Nco::frequency() const
+{
+    return std::ldexp(static_cast<double>(m_increment), -64) * m_sampleRate;
+}
+
+void Nco::setAmplitude(double amplitude)
+{
+    discardBlock();
+    m_amplitude = amplitude;
+}
+
+void Nco::setPhaseOffset(double degrees)
+{
+    discardBlock();
+    const double offset = qDegreesToRadians(degrees);
+    m_offsetCos = std::cos(offset);
+    m_offsetSin = std::sin(offset);
+}
+
+void Nco::reset(double phaseDegrees)
+{
+    // Wrap in degrees first (remainder is exact), then go through the signed
+    // word: [-0.5, 0.5] cycles scale to [-2^63, 2^63], and +2^63 is the same
+    // phase as -2^63, which does fit
+    qint64 word = 0;
+    if (std::isfinite(phaseDegrees)) {
+        const double scaled = std::ldexp(std::remainder(phaseDegrees, 360.0) / 360.0, 64);
+        word = scaled >= 9223372036854775808.0 ? std::numeric_limits<qint64>::min()
+                                                : static_cast<qint64>(scaled);
+    }
+    m_phase = static_cast<quint64>(word);
+    m_blockPos = BlockSize;
+}
+
+void Nco::advance(qint64 samples)
+{
+    discardBlock();
+    m_phase += static_cast<quint64>(samples) * m_increment;
+}
+
+void Nco::generate(double *x, double *y, int count)
+{
+    discardBlock();
+
+    alignas(32) double sinBlock[BlockSize];
+    alignas(32) double cosBlock[BlockSize];
+    const double xScale = m_amplitude;
+    const double yFromSin = m_amplitude * m_offsetCos;
+    const double yFromCos = m_amplitude * m_offsetSin;
+
+    for (int done = 0; done < count; ) {
+        const int n = qMin(count - done, BlockSize);
+
+        // Seed the lanes from the accumulator, so rotation error never
+        // builds up beyond one block
+        const double theta = phaseToRadians(m_phase);
+        const double s0 = std::sin(theta);
+        const double c0 = std::cos(theta);
+        double s[Lanes];
+        double c[Lanes];
+        for (int k = 0; k < Lanes; ++k) {
+            s[k] = s0 * m_laneCos[k] + c0 * m_laneSin[k];
+            c[k] = c0 * m_laneCos[k] - s0 * m_laneSin[k];
+        }
+
+        // Independent lanes: no dependency between neighbouring samples
+        for (int i = 0; i < n; i += Lanes) {
+            for (int k = 0; k < Lanes; ++k) {
+                sinBlock[i + k] = s[k];
+                cosBlock[i + k] = c[k];
+                const double sNext = s[k] * m_stepCos + c[k] * m_stepSin;
+                c[k] = c[k] * m_stepCos - s[k] * m_stepSin;
+                s[k] = sNext;
+            }
+        }
+
+        // sin(t + offset) = sin(t) cos(offset) + cos(t) sin(offset)
+        double *xOut = x + done;
+        double *yOut = y + done;
+        for (int i = 0; i < n; ++i) {
+            xOut[i] = xScale * sinBlock[i];
+            yOut[i] = yFromSin * sinBlock[i] + yFromCos * cosBlock[i];
+        }
+
+        m_phase += static_cast<quint64>(n) * m_increment;
+        done += n;
+    }
+}
+
+void Nco::next(double *x, double *y)
+{
+    if (m_blockPos == BlockSize) {
+        generate(m_blockX, m_blockY, BlockSize);
+        m_blockPos = 0;
+    }
+    *x = m_blockX[m_blockPos];
+    *y = m_blockY[m_blockPos];
+    ++m_blockPos;
+}
+
+void Nco::discardBlock()
+{
+    // Rewind over the samples next() synthesized but never handed out
+    if (m_blockPos < BlockSize) {
+        m_phase -= static_cast<quint64>(BlockSize - m_blockPos) * m_increment;
+        m_blockPos = BlockSize;
+    }
+}
+
+void Nco::updateIncrement()
+{
+    // Below Nyquist the ratio is under 1, so it fits the 64-bit word
+    const double ratio = qBound(0.0, m_frequency / m_sampleRate, 0.5);
+    m_increment = static_cast<quint64>(std::ldexp(ratio, 64));
+
+    for (int k = 0; k < Lanes; ++k) {
+        const double angle = phaseToRadians(static_cast<quint64>(k) * m_increment);
+        m_laneCos[k] = std::cos(angle);
+        m_laneSin[k] = std::sin(angle);
+    }
+    const double step = phaseToRadians(static_cast<quint64>(Lanes) * m_increment);
+    m_stepCos = std::cos(step);
+    m_stepSin = std::sin(step);
+}
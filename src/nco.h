@@ -0,0 +1,78 @@
+#ifndef NCO_H
+#define NCO_H
+
+#include <QtGlobal>
+
+// Numerically controlled oscillator for the X/Y sine outputs.
+//
+// Phase lives in a 64-bit integer accumulator (2^64 = one cycle), so it
+// wraps exactly and a run of any length has the same precision as the
+// first second. Samples are synthesized in blocks: each block is seeded
+// from the accumulator with one sin/cos per lane, then extended by complex
+// rotation, which is a handful of multiply-adds per sample in a loop the
+// compiler vectorizes. Y is derived from the same sin/cos pair, so the X/Y
+// phase offset is exact.
+//
+// Frequency, amplitude and offset changes are phase continuous: the next
+// sample continues from wherever the previous one left off.
+class Nco
+{
+public:
+    explicit Nco(double sampleRate = 1000.0);
+
+    // Changing the rate keeps the frequency in Hz and the current phase
+    void setSampleRate(double sampleRate);
+    double sampleRate() const { return m_sampleRate; }
+
+    void setFrequency(double frequency);
+    double frequency() const;  // After quantization to the phase increment
+
+    void setAmplitude(double amplitude);
+    double amplitude() const { return m_amplitude; }
+
+    // Y leads X by this much
+    void setPhaseOffset(double degrees);
+
+    // Restart at the given X phase
+    void reset(double phaseDegrees = 0.0);
+
+    // Skip samples without synthesizing them
+    void advance(qint64 samples);
+
+    // Synthesize count samples of each axis
+    void generate(double *x, double *y, int count);
+
+    // One sample at a time, served from an internal block
+    void next(double *x, double *y);
+
+    // Samples per synthesis block; also the internal block of next()
+    static constexpr int BlockSize = 64;
+
+private:
+    static constexpr int Lanes = 4;
+
+    quint64 m_phase;       // Phase of the next sample to synthesize
+    quint64 m_increment;   // Phase step per sample
+    double m_sampleRate;
+    double m_frequency;
+    double m_amplitude;
+    double m_offsetCos;
+    double m_offsetSin;
+
+    // Rotations derived from the increment: lane k starts k samples after
+    // lane 0, and every lane steps Lanes samples per iteration
+    double m_laneCos[Lanes];
+    double m_laneSin[Lanes];
+    double m_stepCos;
+    double m_stepSin;
+
+    // Block served by next()
+    double m_blockX[BlockSize];
+    double m_blockY[BlockSize];
+    int m_blockPos;
+
+    void discardBlock();
+    void updateIncrement();
+};
+
+#endif // NCO_H
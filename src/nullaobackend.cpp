@@ -0,0 +1,47 @@
+#include "nullaobackend.h"
+#include "simulatedaostream.h"
+
+NullAoBackend::NullAoBackend(QObject *parent)
+    : AoBackend(parent)
+    , m_writeCount(0)
+{
+}
+
+bool NullAoBackend::initialize()
+{
+    return true;
+}
+
+void NullAoBackend::cleanup()
+{
+}
+
+QStringList NullAoBackend::availableDevices()
+{
+    return QStringList() << "Null output";
+}
+
+bool NullAoBackend::open(const QString &deviceName, const QString &profilePath)
+{
+    Q_UNUSED(deviceName);
+    Q_UNUSED(profilePath);
+    m_writeCount.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void NullAoBackend::close()
+{
+}
+
+bool NullAoBackend::write(const double voltages[2])
+{
+    Q_UNUSED(voltages);
+    m_writeCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+AoStream *NullAoBackend::createStream(QObject *parent)
+{
+    // Still clocked at the stream rate, the frames just go nowhere
+    return new SimulatedAoStream(parent);
+}
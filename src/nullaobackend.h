@@ -0,0 +1,37 @@
+#ifndef NULLAOBACKEND_H
+#define NULLAOBACKEND_H
+
+#include "aobackend.h"
+#include <atomic>
+
+// Discards every sample. Used to measure the cost of the output pipeline
+// itself, without any device or model in the way.
+class NullAoBackend : public AoBackend
+{
+    Q_OBJECT
+
+public:
+    explicit NullAoBackend(QObject *parent = nullptr);
+
+    Type type() const override { return Null; }
+
+    bool initialize() override;
+    void cleanup() override;
+
+    QStringList availableDevices() override;
+
+    bool open(const QString &deviceName, const QString &profilePath) override;
+    void close() override;
+
+    bool write(const double voltages[2]) override;
+
+    AoStream *createStream(QObject *parent) override;
+
+    // Written by the output thread, read by the GUI
+    quint64 writeCount() const { return m_writeCount.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_writeCount;
+};
+
+#endif // NULLAOBACKEND_H
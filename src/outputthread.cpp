@@ -0,0 +1,395 @@
+#include "outputthread.h"
+#include "loggingthread.h"
+#include "monotonicclock.h"
+#include <QStringList>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+OutputThread::OutputThread(FastSteeringMirror *mirror, QObject *parent)
+    : QThread(parent)
+    , m_mirror(mirror)
+    , m_loggingThread(nullptr)
+    , m_history(nullptr)
+    , m_lastSequence(0)
+    , m_source(NoSource)
+    , m_generator(nullptr)
+    , m_generatorSamples(0)
+    , m_waveformStartNs(-1)
+    , m_waveformLogging(false)
+    , m_stopRequested(false)
+    , m_cycles(0)
+    , m_deadlineMisses(0)
+    , m_maxWakeLatencyNs(0)
+    , m_setpointLatencyNs(0)
+    , m_maxSetpointLatencyNs(0)
+    , m_instrumentationEnabled(true)
+    , m_periodHistogram("Output period")
+{
+    m_lastPosition[0].store(0.0);
+    m_lastPosition[1].store(0.0);
+}
+
+OutputThread::~OutputThread()
+{
+    stopOutput();
+    delete m_generator;
+}
+
+void OutputThread::startOutput(const OutputThreadConfig &config)
+{
+    stopOutput();
+
+    m_config = config;
+    m_config.rateHz = qBound(10.0, m_config.rateHz, 20000.0);
+    m_config.priority = qBound(1, m_config.priority, 99);
+    if (m_generator) {
+        m_generator->setSampleRate(m_config.rateHz);
+    }
+    m_stopRequested = false;
+    resetStatistics();
+    start();
+}
+
+void OutputThread::stopOutput()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopRequested = true;
+        m_sourceChanged.wakeAll();
+    }
+    wait();
+}
+
+OutputThreadConfig OutputThread::config() const
+{
+    return m_config;
+}
+
+void OutputThread::setSource(Source source)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_source = source;
+        m_lastSequence = 0;
+        m_sourceChanged.wakeAll();
+    }
+
+    // A write that read the previous source took m_writeMutex before the
+    // source changed; any later one sees the new source
+    QMutexLocker writeLocker(&m_writeMutex);
+}
+
+OutputThread::Source OutputThread::source() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_source;
+}
+
+SetpointMailbox *OutputThread::mailbox(Source source)
+{
+    return &m_mailboxes[source];
+}
+
+void OutputThread::setWaveform(const WaveformSettings &settings)
+{
+    // configure() allocates and can take milliseconds (multisine scaling, a
+    // PRBS sequence), so every change is prepared on a generator of its own
+    // and only swapped in under the lock
+    WaveformSettings current;
+    double sampleRate = m_config.rateHz;
+    bool sameShape = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_generator && m_generator->shape() == settings.shape) {
+            sameShape = true;
+            current = m_generator->settings();
+            sampleRate = m_generator->sampleRate();
+        }
+    }
+
+    WaveformGenerator *generator = nullptr;
+    if (sameShape) {
+        // Continue from the running generator: copy its position, apply the
+        // change, then catch up with the samples the loop took meanwhile
+        generator = WaveformGenerator::create(current, sampleRate);
+        quint64 copiedAt = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            generator->copyState(*m_generator);
+            copiedAt = m_generatorSamples;
+        }
+        generator->configure(settings);
+
+        QMutexLocker locker(&m_mutex);
+        generator->advance(static_cast<qint64>(m_generatorSamples - copiedAt));
+        std::swap(generator, m_generator);
+    } else {
+        generator = WaveformGenerator::create(settings, m_config.rateHz);
+        QMutexLocker locker(&m_mutex);
+        std::swap(generator, m_generator);
+    }
+    // The one replaced
+    delete generator;
+}
+
+void OutputThread::resetWaveform()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_generator) {
+        m_generator->reset();
+    }
+    m_waveformStartNs = -1;
+}
+
+void OutputThread::setLoggingThread(LoggingThread *loggingThread)
+{
+    QMutexLocker locker(&m_mutex);
+    m_loggingThread = loggingThread;
+}
+
+void OutputThread::setHistory(HistoryRing<PositionSample> *history)
+{
+    QMutexLocker locker(&m_mutex);
+    m_history = history;
+}
+
+void OutputThread::setWaveformLogging(bool enabled)
+{
+    // Logged time counts from the first logged sample
+    QMutexLocker locker(&m_mutex);
+    m_waveformLogging = enabled;
+    m_waveformStartNs = -1;
+}
+
+void OutputThread::lastPosition(double *xPosition, double *yPosition) const
+{
+    *xPosition = m_lastPosition[0].load(std::memory_order_relaxed);
+    *yPosition = m_lastPosition[1].load(std::memory_order_relaxed);
+}
+
+quint64 OutputThread::cycleCount() const
+{
+    return m_cycles.load(std::memory_order_relaxed);
+}
+
+quint64 OutputThread::deadlineMisses() const
+{
+    return m_deadlineMisses.load(std::memory_order_relaxed);
+}
+
+double OutputThread::maxWakeLatencyUs() const
+{
+    return m_maxWakeLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double OutputThread::setpointLatencyUs() const
+{
+    return m_setpointLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double OutputThread::maxSetpointLatencyUs() const
+{
+    return m_maxSetpointLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+void OutputThread::resetStatistics()
+{
+    m_cycles = 0;
+    m_deadlineMisses = 0;
+    m_maxWakeLatencyNs = 0;
+    m_setpointLatencyNs = 0;
+    m_maxSetpointLatencyNs = 0;
+}
+
+void OutputThread::setInstrumentationEnabled(bool enabled)
+{
+    m_instrumentationEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+QString OutputThread::schedulingStatus() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_schedulingStatus;
+}
+
+void OutputThread::applySchedulingConfig()
+{
+    QStringList status;
+
+    if (m_config.lockMemory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            status << "memory locked";
+        } else {
+            status << QString("mlockall failed: %1").arg(strerror(errno));
+        }
+    }
+
+    if (m_config.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(m_config.cpu, &cpus);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (result == 0) {
+            status << QString("CPU %1").arg(m_config.cpu);
+        } else {
+            status << QString("affinity failed: %1").arg(strerror(result));
+        }
+    }
+
+    if (m_config.realtime) {
+        sched_param param;
+        param.sched_priority = m_config.priority;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result == 0) {
+            status << QString("SCHED_FIFO %1").arg(m_config.priority);
+        } else {
+            status << QString("SCHED_FIFO failed: %1").arg(strerror(result));
+        }
+    }
+
+    if (status.isEmpty()) {
+        status << "default scheduling";
+    }
+
+    QString text = status.join(", ");
+    qDebug() << "Output thread at" << m_config.rateHz << "Hz:" << text;
+
+    QMutexLocker locker(&m_mutex);
+    m_schedulingStatus = text;
+}
+
+void OutputThread::run()
+{
+    applySchedulingConfig();
+
+    const qint64 periodNs = static_cast<qint64>(1.0e9 / m_config.rateHz);
+    qint64 deadlineNs = MonotonicClock::nowNs();
+    qint64 previousWakeNs = -1;
+
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_stopRequested) {
+                break;
+            }
+            if (m_source == NoSource) {
+                // Nothing to drive: sleep until a source is selected, then
+                // restart the schedule from now
+                m_sourceChanged.wait(&m_mutex);
+                deadlineNs = MonotonicClock::nowNs();
+                previousWakeNs = -1;
+                continue;
+            }
+        }
+
+        deadlineNs += periodNs;
+        MonotonicClock::sleepUntil(deadlineNs);
+
+        qint64 wakeNs = MonotonicClock::nowNs();
+        qint64 wakeLatencyNs = wakeNs - deadlineNs;
+        if (wakeLatencyNs > m_maxWakeLatencyNs.load(std::memory_order_relaxed)) {
+            m_maxWakeLatencyNs.store(wakeLatencyNs, std::memory_order_relaxed);
+        }
+
+        // Actual sample-to-sample period, skipped periods included
+        if (previousWakeNs >= 0 && m_instrumentationEnabled.load(std::memory_order_relaxed)) {
+            m_periodHistogram.record(wakeNs - previousWakeNs);
+        }
+        previousWakeNs = wakeNs;
+
+        runCycle(deadlineNs);
+        m_cycles.fetch_add(1, std::memory_order_relaxed);
+
+        // Finished after the next deadline: count it and skip the periods
+        // that are already gone instead of bursting to catch up
+        qint64 overrunNs = MonotonicClock::nowNs() - (deadlineNs + periodNs);
+        if (overrunNs > 0) {
+            qint64 missed = overrunNs / periodNs + 1;
+            m_deadlineMisses.fetch_add(missed, std::memory_order_relaxed);
+            deadlineNs += missed * periodNs;
+        }
+    }
+}
+
+void OutputThread::runCycle(qint64 deadlineNs)
+{
+    double x = 0.0;
+    double y = 0.0;
+    HistoryRing<PositionSample> *history = nullptr;
+    LoggingThread *loggingThread = nullptr;
+    LogRecord record = {};
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_source == WaveformSource) {
+        if (m_waveformStartNs < 0) {
+            m_waveformStartNs = deadlineNs;
+        }
+
+        // Served from a block synthesized every BlockSize cycles
+        if (m_generator) {
+            m_generator->next(&x, &y);
+            ++m_generatorSamples;
+        }
+        history = m_history;
+
+        if (m_waveformLogging && m_generator && m_loggingThread) {
+            loggingThread = m_loggingThread;
+            record.elapsedTime = deadlineNs - m_waveformStartNs;
+            record.sessionTime = MonotonicClock::sessionNs(deadlineNs);
+            record.sampleIndex = qRound64(record.elapsedTime * m_config.rateHz / 1.0e9);
+            record.frequency = m_generator->settings().frequency;
+            record.amplitude = m_generator->settings().amplitude;
+            record.xCommand = x;
+            record.yCommand = y;
+        }
+    } else if (m_source != NoSource) {
+        Setpoint setpoint = m_mailboxes[m_source].read();
+        x = setpoint.x;
+        y = setpoint.y;
+
+        // Sources publish on their own schedule; only a new setpoint says
+        // anything about how long it took to get here
+        if (setpoint.sequence != m_lastSequence && setpoint.sequence != 0) {
+            m_lastSequence = setpoint.sequence;
+            qint64 latencyNs = MonotonicClock::nowNs() - setpoint.timestampNs;
+            m_setpointLatencyNs.store(latencyNs, std::memory_order_relaxed);
+            if (latencyNs > m_maxSetpointLatencyNs.load(std::memory_order_relaxed)) {
+                m_maxSetpointLatencyNs.store(latencyNs, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Everything needed is copied out; the write and the log hand-off run
+    // with the GUI free to change the source or waveform
+    QMutexLocker writeLocker(&m_writeMutex);
+    locker.unlock();
+    const bool written = m_mirror->writePosition(x, y);
+    writeLocker.unlock();
+    if (!written) {
+        return;
+    }
+
+    m_lastPosition[0].store(x, std::memory_order_relaxed);
+    m_lastPosition[1].store(y, std::memory_order_relaxed);
+
+    if (history) {
+        history->push({static_cast<float>(x), static_cast<float>(y)});
+    }
+
+    if (loggingThread) {
+        QPair<double, double> voltages = m_mirror->getCurrentVoltages();
+        record.xFeedback = voltages.first;
+        record.yFeedback = voltages.second;
+        loggingThread->addRecord(record);
+    }
+}
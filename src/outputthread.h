@@ -0,0 +1,149 @@
+#ifndef OUTPUTTHREAD_H
+#define OUTPUTTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <atomic>
+#include "faststeeringmirror.h"
+#include "setpointmailbox.h"
+#include "latencyhistogram.h"
+#include "waveformgenerator.h"
+#include "historyring.h"
+
+class LoggingThread;
+
+// Scheduling options for the output loop. The real-time options need the
+// matching privileges (CAP_SYS_NICE / CAP_IPC_LOCK or rtprio/memlock limits);
+// when they are refused the loop still runs, and the refusal is reported.
+struct OutputThreadConfig {
+    double rateHz;
+    bool realtime;        // SCHED_FIFO
+    int priority;         // SCHED_FIFO priority, 1-99
+    int cpu;              // CPU to pin the thread to, -1 for any
+    bool lockMemory;      // mlockall(MCL_CURRENT | MCL_FUTURE)
+
+    OutputThreadConfig()
+        : rateHz(1000.0)
+        , realtime(false)
+        , priority(80)
+        , cpu(-1)
+        , lockMemory(false)
+    {
+    }
+};
+
+// Writes the mirror position at a fixed rate from its own thread, so GUI
+// stalls (repaints, dialogs) no longer stall the mirror.
+//
+// Each cycle sleeps until an absolute CLOCK_MONOTONIC deadline, reads the
+// latest setpoint from the active source's mailbox and writes it. Sources
+// publish from any thread without locking; the loop never touches a widget. A cycle that finishes
+// after the next deadline is counted as a deadline miss and the missed
+// periods are skipped rather than replayed.
+class OutputThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Source {
+        NoSource,
+        JoystickSource,
+        WaveformSource,
+        TrackerSource
+    };
+
+    explicit OutputThread(FastSteeringMirror *mirror, QObject *parent = nullptr);
+    ~OutputThread();
+
+    // Start/stop the loop. A new configuration takes effect on the next start.
+    void startOutput(const OutputThreadConfig &config);
+    void stopOutput();
+    OutputThreadConfig config() const;
+
+    // Select which source drives the mirror. Returns once no write from the
+    // previous source is in progress.
+    void setSource(Source source);
+    Source source() const;
+
+    // Mailbox a source publishes its latest position (-1.0 to 1.0) into.
+    // One producer per mailbox.
+    SetpointMailbox *mailbox(Source source);
+
+    // Waveform source: generated in the loop. Parameter changes keep the
+    // phase. Any change is prepared on a new generator outside the loop's
+    // lock, which is held only to copy the position and swap it in.
+    void setWaveform(const WaveformSettings &settings);
+    void resetWaveform();
+
+    // Log a record per waveform sample while enabled
+    void setLoggingThread(LoggingThread *loggingThread);
+    void setWaveformLogging(bool enabled);
+
+    // Last position written, for display
+    void lastPosition(double *xPosition, double *yPosition) const;
+
+    // Every waveform sample written is also pushed here; the loop is then
+    // the ring's only producer
+    void setHistory(HistoryRing<PositionSample> *history);
+
+    // Statistics
+    quint64 cycleCount() const;
+    quint64 deadlineMisses() const;
+    double maxWakeLatencyUs() const;
+    // Source timestamp to mirror write, measured on each new setpoint
+    double setpointLatencyUs() const;
+    double maxSetpointLatencyUs() const;
+    void resetStatistics();
+
+    // What the scheduler actually granted
+    QString schedulingStatus() const;
+
+    // Time between consecutive writes, recorded while enabled
+    void setInstrumentationEnabled(bool enabled);
+    LatencyHistogram &periodHistogram() { return m_periodHistogram; }
+
+protected:
+    void run() override;
+
+private:
+    FastSteeringMirror *m_mirror;
+    LoggingThread *m_loggingThread;
+    HistoryRing<PositionSample> *m_history;
+    OutputThreadConfig m_config;
+
+    SetpointMailbox m_mailboxes[4];
+    quint64 m_lastSequence;
+
+    // Guards the source selection and waveform generator. The loop holds it
+    // only while it reads them, never across a write or a log hand-off, so
+    // the GUI is not held up by the device or a full log queue.
+    mutable QMutex m_mutex;
+    // Held by the loop across the mirror write alone, taken while m_mutex is
+    // still held, so setSource() can wait out a write in flight
+    QMutex m_writeMutex;
+    QWaitCondition m_sourceChanged;
+    Source m_source;
+    WaveformGenerator *m_generator;
+    quint64 m_generatorSamples;  // Taken from m_generator by the loop
+    qint64 m_waveformStartNs;
+    bool m_waveformLogging;
+    bool m_stopRequested;
+
+    std::atomic<double> m_lastPosition[2];
+    std::atomic<quint64> m_cycles;
+    std::atomic<quint64> m_deadlineMisses;
+    std::atomic<qint64> m_maxWakeLatencyNs;
+    std::atomic<qint64> m_setpointLatencyNs;
+    std::atomic<qint64> m_maxSetpointLatencyNs;
+    QString m_schedulingStatus;
+
+    std::atomic<bool> m_instrumentationEnabled;
+    LatencyHistogram m_periodHistogram;
+
+    void applySchedulingConfig();
+    void runCycle(qint64 deadlineNs);
+};
+
+#endif // OUTPUTTHREAD_H
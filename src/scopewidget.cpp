@@ -0,0 +1,418 @@
+#include "scopewidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QScreen>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+// How often the renderer looks for new history
+const unsigned long PollIntervalMs = 5;
+
+const QRgb BackgroundColor = qRgb(0, 0, 0);
+const QRgb ZeroLineColor = qRgb(128, 128, 128);
+const QRgb ChannelColors[ScopeRenderer::Channels] = {qRgb(0, 255, 0), qRgb(255, 0, 0)};
+
+}
+
+ScopeRenderer::ScopeRenderer(QObject *parent)
+    : QThread(parent)
+    , m_history(HistoryCapacityLog2)
+    , m_settingsChanged(true)
+    , m_clearRequested(false)
+    , m_clearIndex(0)
+    , m_shouldStop(false)
+    , m_dropped(0)
+    , m_writeColumn(0)
+    , m_dirty(false)
+    , m_baseIndex(0)
+    , m_readIndex(0)
+    , m_columnsPerSample(0.0)
+    , m_position(0.0)
+    , m_haveLast(false)
+{
+    m_requested.width = 0;
+    m_requested.height = 0;
+    m_requested.sampleRate = 100.0;
+    m_requested.timeWindow = 1.0;
+    for (int channel = 0; channel < Channels; ++channel) {
+        m_requested.visible[channel] = true;
+        m_last[channel] = 0.0;
+    }
+    m_settings = m_requested;
+}
+
+ScopeRenderer::~ScopeRenderer()
+{
+    stop();
+}
+
+void ScopeRenderer::stop()
+{
+    {
+        QMutexLocker locker(&m_inputMutex);
+        m_shouldStop = true;
+        m_inputCondition.wakeOne();
+    }
+    wait();
+}
+
+void ScopeRenderer::setGeometry(int width, int height)
+{
+    QMutexLocker locker(&m_inputMutex);
+    m_requested.width = qMax(0, width);
+    m_requested.height = qMax(0, height);
+    m_settingsChanged = true;
+    m_inputCondition.wakeOne();
+}
+
+void ScopeRenderer::setSampleRate(double sampleRate)
+{
+    QMutexLocker locker(&m_inputMutex);
+    if (sampleRate > 0.0 && sampleRate != m_requested.sampleRate) {
+        m_requested.sampleRate = sampleRate;
+        m_settingsChanged = true;
+        m_inputCondition.wakeOne();
+    }
+}
+
+void ScopeRenderer::setTimeWindow(double seconds)
+{
+    QMutexLocker locker(&m_inputMutex);
+    if (seconds > 0.0 && seconds != m_requested.timeWindow) {
+        m_requested.timeWindow = seconds;
+        m_settingsChanged = true;
+        m_inputCondition.wakeOne();
+    }
+}
+
+void ScopeRenderer::setChannelVisible(int channel, bool visible)
+{
+    if (channel < 0 || channel >= Channels) {
+        return;
+    }
+    QMutexLocker locker(&m_inputMutex);
+    m_requested.visible[channel] = visible;
+    m_settingsChanged = true;
+    m_inputCondition.wakeOne();
+}
+
+void ScopeRenderer::clear()
+{
+    // Called while nothing is producing, so everything written so far is old
+    QMutexLocker locker(&m_inputMutex);
+    m_clearIndex = m_history.written();
+    m_clearRequested = true;
+    m_inputCondition.wakeOne();
+}
+
+void ScopeRenderer::run()
+{
+    while (true) {
+        Settings settings;
+        bool settingsChanged = false;
+        bool clearRequested = false;
+        quint64 clearIndex = 0;
+        {
+            // The producer never signals; poll a few times per display frame
+            QMutexLocker locker(&m_inputMutex);
+            if (!m_settingsChanged && !m_clearRequested && !m_shouldStop) {
+                m_inputCondition.wait(&m_inputMutex, PollIntervalMs);
+            }
+            if (m_shouldStop) {
+                break;
+            }
+            settings = m_requested;
+            settingsChanged = m_settingsChanged;
+            clearRequested = m_clearRequested;
+            clearIndex = m_clearIndex;
+            m_settingsChanged = false;
+            m_clearRequested = false;
+        }
+
+        QMutexLocker imageLocker(&m_imageMutex);
+        bool drawn = false;
+        if (clearRequested) {
+            m_baseIndex = clearIndex;
+        }
+        if (settingsChanged) {
+            applySettings(settings);
+        }
+        if (settingsChanged || clearRequested) {
+            rebuild();
+            drawn = true;
+        }
+        drawn |= drawNewSamples();
+        imageLocker.unlock();
+
+        if (drawn) {
+            m_dirty.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void ScopeRenderer::applySettings(const Settings &settings)
+{
+    if (settings.width != m_settings.width || settings.height != m_settings.height) {
+        if (settings.width > 0 && settings.height > 0) {
+            m_image = QImage(settings.width, settings.height, QImage::Format_RGB32);
+        } else {
+            m_image = QImage();
+        }
+    }
+    m_settings = settings;
+    m_columnsPerSample = settings.width / (settings.sampleRate * settings.timeWindow);
+}
+
+void ScopeRenderer::rebuild()
+{
+    m_writeColumn = 0;
+    m_position = 0.0;
+    m_haveLast = false;
+    if (m_image.isNull()) {
+        return;
+    }
+
+    m_image.fill(BackgroundColor);
+    QRgb *zeroLine = reinterpret_cast<QRgb *>(m_image.scanLine(valueToRow(0.0)));
+    for (int column = 0; column < m_settings.width; ++column) {
+        zeroLine[column] = ZeroLineColor;
+    }
+
+    // Redraw the window from history, as far back as it reaches
+    const quint64 written = m_history.written();
+    const quint64 windowFrames = static_cast<quint64>(m_settings.timeWindow * m_settings.sampleRate);
+    m_readIndex = qMax(m_baseIndex, m_history.oldest(written));
+    if (written > windowFrames) {
+        m_readIndex = qMax(m_readIndex, written - windowFrames);
+    }
+}
+
+bool ScopeRenderer::drawNewSamples()
+{
+    const quint64 written = m_history.written();
+    quint64 first = qMax(m_readIndex, m_history.oldest(written));
+    if (first >= written) {
+        return false;
+    }
+
+    // Too far behind to catch up safely: skip to the newest half of the ring
+    const quint64 limit = m_history.readable() / 2;
+    if (written - first > limit) {
+        first = written - limit;
+    }
+    m_dropped.fetch_add(first - m_readIndex, std::memory_order_relaxed);
+
+    if (!m_image.isNull()) {
+        const PositionSample *a = nullptr;
+        const PositionSample *b = nullptr;
+        int countA = 0;
+        int countB = 0;
+        m_history.segments(first, static_cast<int>(written - first), &a, &countA, &b, &countB);
+        processSamples(a, countA);
+        processSamples(b, countB);
+        if (!m_history.isIntact(first)) {
+            qDebug() << "Scope history overran while drawing";
+        }
+    }
+
+    m_readIndex = written;
+    return true;
+}
+
+void ScopeRenderer::processSamples(const PositionSample *samples, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const double value[Channels] = {samples[i].x, samples[i].y};
+
+        if (!m_haveLast) {
+            for (int channel = 0; channel < Channels; ++channel) {
+                m_open.min[channel] = m_open.max[channel] = static_cast<float>(value[channel]);
+                m_last[channel] = value[channel];
+            }
+            m_haveLast = true;
+            m_position = 0.0;
+            continue;
+        }
+
+        // Walk the segment from the last sample to this one, closing every
+        // column boundary it crosses with the interpolated value there, so
+        // neighbouring columns always join up
+        double start = m_position;
+        double end = m_position + m_columnsPerSample;
+        double from[Channels] = {m_last[0], m_last[1]};
+        while (end >= 1.0) {
+            const double t = (1.0 - start) / (end - start);
+            float boundary[Channels];
+            for (int channel = 0; channel < Channels; ++channel) {
+                boundary[channel] = static_cast<float>(from[channel] + t * (value[channel] - from[channel]));
+                m_open.min[channel] = qMin(m_open.min[channel], boundary[channel]);
+                m_open.max[channel] = qMax(m_open.max[channel], boundary[channel]);
+            }
+            closeColumn();
+            for (int channel = 0; channel < Channels; ++channel) {
+                m_open.min[channel] = m_open.max[channel] = boundary[channel];
+                from[channel] = boundary[channel];
+            }
+            start = 0.0;
+            end -= 1.0;
+        }
+
+        for (int channel = 0; channel < Channels; ++channel) {
+            const float current = static_cast<float>(value[channel]);
+            m_open.min[channel] = qMin(m_open.min[channel], current);
+            m_open.max[channel] = qMax(m_open.max[channel], current);
+            m_last[channel] = value[channel];
+        }
+        m_position = end;
+    }
+}
+
+void ScopeRenderer::closeColumn()
+{
+    drawColumn(m_writeColumn, m_open);
+    m_writeColumn = (m_writeColumn + 1) % m_settings.width;
+}
+
+int ScopeRenderer::valueToRow(double value) const
+{
+    // Full scale uses 90% of the half height, as the old display did
+    const double center = m_settings.height / 2.0;
+    const int row = static_cast<int>(center - value * center * 0.9);
+    return qBound(0, row, m_settings.height - 1);
+}
+
+void ScopeRenderer::drawColumn(int imageColumn, const Column &column)
+{
+    const int height = m_settings.height;
+    const int zeroRow = valueToRow(0.0);
+
+    for (int row = 0; row < height; ++row) {
+        reinterpret_cast<QRgb *>(m_image.scanLine(row))[imageColumn] =
+            row == zeroRow ? ZeroLineColor : BackgroundColor;
+    }
+
+    // Y over X, as before; spans are at least two pixels thick
+    for (int channel = 0; channel < Channels; ++channel) {
+        if (!m_settings.visible[channel]) {
+            continue;
+        }
+        const int top = valueToRow(column.max[channel]);
+        const int bottom = qMin(height - 1, qMax(valueToRow(column.min[channel]), top + 1));
+        for (int row = top; row <= bottom; ++row) {
+            reinterpret_cast<QRgb *>(m_image.scanLine(row))[imageColumn] = ChannelColors[channel];
+        }
+    }
+}
+
+ScopeWidget::ScopeWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_refreshTimer(new QTimer(this))
+    , m_guiHistogram("Scope (GUI thread)")
+{
+    setMinimumSize(400, 150);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    m_renderer.start();
+
+    // Repaint at the display rate; data may arrive much more often
+    double refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    m_refreshTimer->setTimerType(Qt::PreciseTimer);
+    m_refreshTimer->setInterval(qMax(4, static_cast<int>(1000.0 / qMax(1.0, refreshRate))));
+    connect(m_refreshTimer, &QTimer::timeout, this, &ScopeWidget::onRefresh);
+    m_refreshTimer->start();
+}
+
+ScopeWidget::~ScopeWidget()
+{
+    m_refreshTimer->stop();
+    m_renderer.stop();
+}
+
+void ScopeWidget::addSamples(const double *x, const double *y, int count)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PositionSample block[256];
+    for (int done = 0; done < count; ) {
+        const int chunk = qMin(count - done, 256);
+        for (int i = 0; i < chunk; ++i) {
+            block[i].x = static_cast<float>(x[done + i]);
+            block[i].y = static_cast<float>(y[done + i]);
+        }
+        m_renderer.history().write(block, chunk);
+        done += chunk;
+    }
+
+    m_guiHistogram.record(timer.nsecsElapsed());
+}
+
+void ScopeWidget::setSampleRate(double sampleRate)
+{
+    m_renderer.setSampleRate(sampleRate);
+}
+
+void ScopeWidget::setTimeWindow(double seconds)
+{
+    m_renderer.setTimeWindow(seconds);
+}
+
+void ScopeWidget::setChannelVisible(int channel, bool visible)
+{
+    m_renderer.setChannelVisible(channel, visible);
+}
+
+void ScopeWidget::clear()
+{
+    m_renderer.clear();
+}
+
+void ScopeWidget::onRefresh()
+{
+    if (m_renderer.takeDirty()) {
+        update();
+    }
+}
+
+void ScopeWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_renderer.setGeometry(width(), height());
+}
+
+void ScopeWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QElapsedTimer timer;
+    timer.start();
+
+    QPainter painter(this);
+    {
+        QMutexLocker locker(m_renderer.imageMutex());
+        const QImage &image = m_renderer.image();
+        if (image.isNull() || image.width() != width() || image.height() != height()) {
+            // The renderer has not caught up with a resize yet
+            painter.fillRect(rect(), Qt::black);
+        } else {
+            // Oldest column first: from the write position to the right
+            // edge, then the wrapped part
+            const int split = m_renderer.writeColumn();
+            const int h = image.height();
+            painter.drawImage(QRect(0, 0, image.width() - split, h), image,
+                              QRect(split, 0, image.width() - split, h));
+            if (split > 0) {
+                painter.drawImage(QRect(image.width() - split, 0, split, h), image,
+                                  QRect(0, 0, split, h));
+            }
+        }
+    }
+
+    painter.setPen(QPen(Qt::gray, 1));
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+
+    m_guiHistogram.record(timer.nsecsElapsed());
+}
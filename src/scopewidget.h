@@ -0,0 +1,152 @@
+#ifndef SCOPEWIDGET_H
+#define SCOPEWIDGET_H
+
+#include <QWidget>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QTimer>
+#include <atomic>
+#include "latencyhistogram.h"
+#include "historyring.h"
+
+// Reduces X/Y samples to pixel columns and draws them into a ring image.
+//
+// Samples come from a HistoryRing that the producer (the stream thread for
+// buffered output, the output thread otherwise) writes without locking;
+// the renderer polls it from its own thread and reads the values in place.
+// The ring holds minutes of full-rate data, so a new time window or widget
+// size is redrawn from history rather than starting empty.
+//
+// Each column shows the min..max of the samples that fell into it, joined
+// to its neighbours, so a trace keeps its envelope at any sample rate;
+// columns without samples are interpolated. The image is a ring too: a new
+// column overwrites the oldest one, nothing is ever scrolled.
+class ScopeRenderer : public QThread
+{
+    Q_OBJECT
+public:
+    static constexpr int Channels = 2;
+
+    // 4M frames: 7 minutes at 10 kS/s, 42 s at 100 kS/s
+    static constexpr int HistoryCapacityLog2 = 22;
+
+    explicit ScopeRenderer(QObject *parent = nullptr);
+    ~ScopeRenderer();
+
+    void stop();
+
+    // Written by exactly one producer at a time
+    HistoryRing<PositionSample> &history() { return m_history; }
+
+    // GUI side
+    void setGeometry(int width, int height);
+    void setSampleRate(double sampleRate);
+    void setTimeWindow(double seconds);
+    void setChannelVisible(int channel, bool visible);
+    void clear();
+
+    // True once after new columns were drawn
+    bool takeDirty() { return m_dirty.exchange(false, std::memory_order_acquire); }
+
+    // The caller holds imageMutex() while reading image() and writeColumn()
+    QMutex *imageMutex() { return &m_imageMutex; }
+    const QImage &image() const { return m_image; }
+    int writeColumn() const { return m_writeColumn; }
+
+    quint64 droppedSamples() const { return m_dropped.load(std::memory_order_relaxed); }
+
+protected:
+    void run() override;
+
+private:
+    struct Column {
+        float min[Channels];
+        float max[Channels];
+    };
+
+    struct Settings {
+        int width;
+        int height;
+        double sampleRate;
+        double timeWindow;
+        bool visible[Channels];
+    };
+
+    HistoryRing<PositionSample> m_history;
+
+    // Handed over from the GUI thread
+    QMutex m_inputMutex;
+    QWaitCondition m_inputCondition;
+    Settings m_requested;
+    bool m_settingsChanged;
+    bool m_clearRequested;
+    quint64 m_clearIndex;          // History index at the last clear()
+    bool m_shouldStop;
+    std::atomic<quint64> m_dropped;
+
+    // Owned by the render thread; the image is shared under m_imageMutex
+    QMutex m_imageMutex;
+    QImage m_image;
+    int m_writeColumn;
+    std::atomic<bool> m_dirty;
+
+    Settings m_settings;
+    quint64 m_baseIndex;           // Nothing before this is drawn
+    quint64 m_readIndex;           // Next history index to draw
+    double m_columnsPerSample;
+    double m_position;             // Of the last sample within the open column
+    bool m_haveLast;
+    double m_last[Channels];
+    Column m_open;
+
+    void applySettings(const Settings &settings);
+    void rebuild();
+    bool drawNewSamples();
+    void processSamples(const PositionSample *samples, int count);
+    void closeColumn();
+    void drawColumn(int imageColumn, const Column &column);
+    int valueToRow(double value) const;
+};
+
+// Scrolling X/Y oscilloscope.
+//
+// The widget repaints at the display refresh rate whenever the renderer
+// has drawn new columns, however often samples arrive. GUI-thread time
+// spent on the scope (writing samples, painting) is recorded in
+// guiHistogram(). Samples are written with addSamples() from the GUI
+// thread, or straight into history() from another single producer.
+class ScopeWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ScopeWidget(QWidget *parent = nullptr);
+    ~ScopeWidget();
+
+    void addSamples(const double *x, const double *y, int count);
+    HistoryRing<PositionSample> &history() { return m_renderer.history(); }
+
+    void setSampleRate(double sampleRate);
+    void setTimeWindow(double seconds);
+    void setChannelVisible(int channel, bool visible);
+    void clear();
+
+    LatencyHistogram &guiHistogram() { return m_guiHistogram; }
+
+    QSize sizeHint() const override { return QSize(400, 150); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    ScopeRenderer m_renderer;
+    QTimer *m_refreshTimer;
+    LatencyHistogram m_guiHistogram;
+
+    void onRefresh();
+};
+
+#endif // SCOPEWIDGET_H
@@ -0,0 +1,85 @@
+#ifndef SETPOINTMAILBOX_H
+#define SETPOINTMAILBOX_H
+
+#include <QtGlobal>
+#include <atomic>
+#include "monotonicclock.h"
+
+// One published mirror setpoint
+struct Setpoint {
+    double x;              // -1.0 to 1.0
+    double y;              // -1.0 to 1.0
+    quint64 sequence;      // 1 for the first publish, 0 if nothing published yet
+    qint64 timestampNs;    // MonotonicClock::nowNs() when the source produced it
+};
+
+// "Latest value" mailbox between one producer and any number of readers,
+// implemented as a seqlock. publish() never waits and read() never blocks the
+// producer: a reader that races a publish simply retries. Only the newest
+// setpoint is kept; intermediate ones are overwritten, which is what a
+// position command wants.
+//
+// Single writer only: each source owns its own mailbox.
+class SetpointMailbox
+{
+public:
+    SetpointMailbox()
+        : m_sequence(0)
+        , m_x(0.0)
+        , m_y(0.0)
+        , m_timestampNs(0)
+    {
+    }
+
+    void publish(double x, double y, qint64 timestampNs)
+    {
+        // Odd sequence marks a write in progress
+        quint64 sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_x.store(x, std::memory_order_relaxed);
+        m_y.store(y, std::memory_order_relaxed);
+        m_timestampNs.store(timestampNs, std::memory_order_relaxed);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void publish(double x, double y)
+    {
+        publish(x, y, MonotonicClock::nowNs());
+    }
+
+    Setpoint read() const
+    {
+        Setpoint setpoint;
+        quint64 before;
+        quint64 after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            setpoint.x = m_x.load(std::memory_order_relaxed);
+            setpoint.y = m_y.load(std::memory_order_relaxed);
+            setpoint.timestampNs = m_timestampNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        setpoint.sequence = before / 2;
+        return setpoint;
+    }
+
+    quint64 sequence() const
+    {
+        return m_sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    // Producer and readers sit on different cores; the alignment also pads
+    // the mailbox to a full cache line so neighbours never share it
+    alignas(64) std::atomic<quint64> m_sequence;
+    std::atomic<double> m_x;
+    std::atomic<double> m_y;
+    std::atomic<qint64> m_timestampNs;
+};
+
+#endif // SETPOINTMAILBOX_H
@@ -0,0 +1,25 @@
+#include "simulatedaistream.h"
+
+SimulatedAiStream::SimulatedAiStream(QObject *parent)
+    : AiStream(parent)
+{
+}
+
+SimulatedAiStream::~SimulatedAiStream()
+{
+    stop();
+}
+
+void SimulatedAiStream::acquire(const double *frames, int frameCount)
+{
+    pushFrames(frames, frameCount);
+}
+
+bool SimulatedAiStream::startDevice()
+{
+    return true;
+}
+
+void SimulatedAiStream::stopDevice()
+{
+}
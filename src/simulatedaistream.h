@@ -0,0 +1,26 @@
+#ifndef SIMULATEDAISTREAM_H
+#define SIMULATEDAISTREAM_H
+
+#include "aistream.h"
+
+// Software stand-in for buffered AI. It has no clock of its own: the
+// simulated AO stream hands it the modelled mirror response for every frame
+// it clocks out, so feedback frame n is exactly the response to command
+// frame n.
+class SimulatedAiStream : public AiStream
+{
+    Q_OBJECT
+
+public:
+    explicit SimulatedAiStream(QObject *parent = nullptr);
+    ~SimulatedAiStream();
+
+    // Called from the simulated AO clock thread
+    void acquire(const double *frames, int frameCount);
+
+protected:
+    bool startDevice() override;
+    void stopDevice() override;
+};
+
+#endif // SIMULATEDAISTREAM_H
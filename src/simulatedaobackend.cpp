@@ -0,0 +1,106 @@
+#include "simulatedaobackend.h"
+#include "simulatedaostream.h"
+#include "simulatedaistream.h"
+#include <QDebug>
+
+SimulatedAoBackend::SimulatedAoBackend(QObject *parent)
+    : AoBackend(parent)
+    , m_open(false)
+{
+}
+
+SimulatedAoBackend::~SimulatedAoBackend()
+{
+    cleanup();
+}
+
+bool SimulatedAoBackend::initialize()
+{
+    return true;
+}
+
+void SimulatedAoBackend::cleanup()
+{
+    close();
+}
+
+QStringList SimulatedAoBackend::availableDevices()
+{
+    return QStringList() << "Simulated FSM";
+}
+
+bool SimulatedAoBackend::open(const QString &deviceName, const QString &profilePath)
+{
+    Q_UNUSED(profilePath);
+
+    QMutexLocker locker(&m_mutex);
+    m_model.reset();
+    m_clock.start();
+    m_open = true;
+
+    const MirrorModelParams &params = m_model.parameters();
+    qDebug() << "Simulated mirror" << deviceName << "opened: order" << params.order
+             << "," << params.bandwidthHz << "Hz," << params.latency * 1e6 << "us latency,"
+             << params.dacBits << "bit DAC";
+    return true;
+}
+
+void SimulatedAoBackend::close()
+{
+    m_open = false;
+}
+
+bool SimulatedAoBackend::write(const double voltages[2])
+{
+    QMutexLocker locker(&m_mutex);
+    // After a stream the model clock may run ahead of the wall clock
+    double t = qMax(m_clock.nsecsElapsed() / 1.0e9, m_model.time());
+    m_model.write(t, voltages);
+    return true;
+}
+
+AoStream *SimulatedAoBackend::createStream(QObject *parent)
+{
+    SimulatedAoStream *stream = new SimulatedAoStream(parent);
+    stream->setSampleSink([this, stream](const double *frames, int frameCount) {
+        QMutexLocker locker(&m_mutex);
+        if (!m_feedbackStream) {
+            m_model.processBlock(frames, frameCount, stream->sampleRate());
+            return;
+        }
+
+        if (m_responseBuffer.size() < frameCount * 2) {
+            m_responseBuffer.resize(frameCount * 2);
+        }
+        m_model.processBlock(frames, frameCount, stream->sampleRate(), m_responseBuffer.data());
+        m_feedbackStream->acquire(m_responseBuffer.constData(), frameCount);
+    });
+    return stream;
+}
+
+AiStream *SimulatedAoBackend::createAiStream(QObject *parent)
+{
+    SimulatedAiStream *stream = new SimulatedAiStream(parent);
+
+    QMutexLocker locker(&m_mutex);
+    m_feedbackStream = stream;
+    return stream;
+}
+
+void SimulatedAoBackend::setModelParameters(const MirrorModelParams &params)
+{
+    QMutexLocker locker(&m_mutex);
+    m_model.setParameters(params);
+}
+
+MirrorModelParams SimulatedAoBackend::modelParameters() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_model.parameters();
+}
+
+void SimulatedAoBackend::mirrorOutput(double volts[2]) const
+{
+    QMutexLocker locker(&m_mutex);
+    m_model.output(volts);
+}
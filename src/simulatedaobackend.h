@@ -0,0 +1,58 @@
+#ifndef SIMULATEDAOBACKEND_H
+#define SIMULATEDAOBACKEND_H
+
+#include "aobackend.h"
+#include "mirrormodel.h"
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVector>
+
+class SimulatedAiStream;
+
+// Software mirror: every write, single or streamed, drives a MirrorModel so
+// the output pipeline can be exercised without a card.
+class SimulatedAoBackend : public AoBackend
+{
+    Q_OBJECT
+
+public:
+    explicit SimulatedAoBackend(QObject *parent = nullptr);
+    ~SimulatedAoBackend();
+
+    Type type() const override { return Simulated; }
+
+    bool initialize() override;
+    void cleanup() override;
+
+    QStringList availableDevices() override;
+
+    bool open(const QString &deviceName, const QString &profilePath) override;
+    void close() override;
+
+    bool write(const double voltages[2]) override;
+
+    AoStream *createStream(QObject *parent) override;
+
+    // Acquires the modelled mirror response of every streamed frame
+    AiStream *createAiStream(QObject *parent) override;
+
+    void setModelParameters(const MirrorModelParams &params);
+    MirrorModelParams modelParameters() const;
+
+    // Latest mirror response, in volts
+    void mirrorOutput(double volts[2]) const;
+
+private:
+    mutable QMutex m_mutex;   // The model is shared with the stream clock thread
+    MirrorModel m_model;
+    QElapsedTimer m_clock;
+    bool m_open;
+
+    // Feedback stream fed by the output stream's clock thread. It is only
+    // deleted while no output stream runs.
+    QPointer<SimulatedAiStream> m_feedbackStream;
+    QVector<double> m_responseBuffer;
+};
+
+#endif // SIMULATEDAOBACKEND_H
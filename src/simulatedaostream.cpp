@@ -0,0 +1,127 @@
+#include "simulatedaostream.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <QDebug>
+
+SimulatedAoStream::SimulatedAoStream(QObject *parent)
+    : AoStream(parent)
+    , m_clockThread(nullptr)
+    , m_stopRequested(false)
+    , m_stepLimit(0.0)
+    , m_discontinuities(0)
+    , m_maxStep(0.0)
+    , m_havePreviousFrame(false)
+{
+}
+
+SimulatedAoStream::~SimulatedAoStream()
+{
+    stop();
+}
+
+void SimulatedAoStream::setSampleSink(const SampleSink &sink)
+{
+    m_sink = sink;
+}
+
+void SimulatedAoStream::setStepLimit(double volts)
+{
+    m_stepLimit = volts;
+}
+
+quint64 SimulatedAoStream::discontinuityCount() const
+{
+    return m_discontinuities.load(std::memory_order_relaxed);
+}
+
+double SimulatedAoStream::maxStep() const
+{
+    return m_maxStep.load(std::memory_order_relaxed);
+}
+
+bool SimulatedAoStream::startDevice()
+{
+    // Like the card, the first buffer is transmitted straight from the FIFO
+    m_transferBuffer.resize(bufferFrames() * channelCount());
+    m_previousFrame.fill(0.0, channelCount());
+    m_havePreviousFrame = false;
+    m_discontinuities = 0;
+    m_maxStep = 0.0;
+    m_stopRequested = false;
+
+    m_clockThread = QThread::create([this]() { clockLoop(); });
+    m_clockThread->start(QThread::TimeCriticalPriority);
+
+    qDebug() << "Simulated AO stream started at" << sampleRate() << "S/s";
+    return true;
+}
+
+void SimulatedAoStream::stopDevice()
+{
+    if (!m_clockThread) {
+        return;
+    }
+
+    m_stopRequested = true;
+    m_clockThread->wait();
+    delete m_clockThread;
+    m_clockThread = nullptr;
+}
+
+void SimulatedAoStream::clockLoop()
+{
+    // Transfers happen in half-buffer chunks, matching the card's
+    // DataTransmitted cadence
+    const int chunkFrames = qMax(1, bufferFrames() / 2);
+    const double rate = sampleRate();
+
+    QElapsedTimer clock;
+    clock.start();
+    quint64 framesConsumed = 0;
+
+    while (!m_stopRequested) {
+        // Frames the simulated ConvertClock has clocked out so far
+        quint64 framesDue = static_cast<quint64>(clock.nsecsElapsed() * rate / 1.0e9);
+
+        while (framesDue >= framesConsumed + chunkFrames) {
+            fillFromQueue(m_transferBuffer.data(), chunkFrames);
+            checkContinuity(m_transferBuffer.constData(), chunkFrames);
+            if (m_sink) {
+                m_sink(m_transferBuffer.constData(), chunkFrames);
+            }
+            framesConsumed += chunkFrames;
+        }
+
+        // Sleep until roughly the next chunk is due
+        qint64 nextDueNs = static_cast<qint64>((framesConsumed + chunkFrames) * 1.0e9 / rate);
+        qint64 waitUs = (nextDueNs - clock.nsecsElapsed()) / 1000;
+        QThread::usleep(qBound<qint64>(50, waitUs, 1000));
+    }
+}
+
+void SimulatedAoStream::checkContinuity(const double *frames, int frameCount)
+{
+    const int channels = channelCount();
+    const double limit = m_stepLimit.load(std::memory_order_relaxed);
+    double maxStep = m_maxStep.load(std::memory_order_relaxed);
+    double *previous = m_previousFrame.data();
+
+    for (int i = 0; i < frameCount; ++i) {
+        const double *frame = frames + i * channels;
+        if (m_havePreviousFrame) {
+            for (int ch = 0; ch < channels; ++ch) {
+                double step = qAbs(frame[ch] - previous[ch]);
+                maxStep = qMax(maxStep, step);
+                if (limit > 0.0 && step > limit) {
+                    m_discontinuities.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        for (int ch = 0; ch < channels; ++ch) {
+            previous[ch] = frame[ch];
+        }
+        m_havePreviousFrame = true;
+    }
+
+    m_maxStep.store(maxStep, std::memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+#ifndef SIMULATEDAOSTREAM_H
+#define SIMULATEDAOSTREAM_H
+
+#include "aostream.h"
+#include <functional>
+
+class QThread;
+
+// Software stand-in for a buffered AO card. A worker thread consumes the FIFO
+// at the configured sample rate in device-buffer-sized transfers, exactly as
+// the card would, and hands every transmitted frame to an optional sink so the
+// produced stream can be checked without hardware.
+//
+// The stream is also checked for continuity: any sample-to-sample step larger
+// than the configured limit is counted as a discontinuity.
+class SimulatedAoStream : public AoStream
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(const double *frames, int frameCount)> SampleSink;
+
+    explicit SimulatedAoStream(QObject *parent = nullptr);
+    ~SimulatedAoStream();
+
+    // Receives every transmitted frame, called from the simulated clock
+    // thread. Set it before the stream starts.
+    void setSampleSink(const SampleSink &sink);
+
+    // Largest step between consecutive frames (in volts) that is still
+    // considered continuous. Zero disables the check.
+    void setStepLimit(double volts);
+    quint64 discontinuityCount() const;
+    double maxStep() const;
+
+protected:
+    bool startDevice() override;
+    void stopDevice() override;
+
+private:
+    QThread *m_clockThread;
+    std::atomic<bool> m_stopRequested;
+    QVector<double> m_transferBuffer;
+    SampleSink m_sink;
+
+    // Continuity check, updated by the clock thread
+    std::atomic<double> m_stepLimit;
+    std::atomic<quint64> m_discontinuities;
+    std::atomic<double> m_maxStep;
+    QVector<double> m_previousFrame;
+    bool m_havePreviousFrame;
+
+    void checkContinuity(const double *frames, int frameCount);
+
+    void clockLoop();
+};
+
+#endif // SIMULATEDAOSTREAM_H
@@ -0,0 +1,45 @@
+#include "singlebindft.h"
+
+SingleBinDft::SingleBinDft()
+    : m_frequency(0.0)
+    , m_channels(0)
+    , m_count(0)
+{
+    reset();
+}
+
+void SingleBinDft::configure(double frequency, double sampleRate, int channels)
+{
+    m_frequency = frequency;
+    m_channels = qBound(0, channels, static_cast<int>(MaxChannels));
+
+    // X carries sin, Y (90 degrees ahead) carries cos
+    m_reference.setSampleRate(sampleRate);
+    m_reference.setFrequency(frequency);
+    m_reference.setAmplitude(1.0);
+    m_reference.setPhaseOffset(90.0);
+    reset();
+}
+
+void SingleBinDft::reset()
+{
+    m_reference.reset();
+    for (int c = 0; c < MaxChannels; ++c) {
+        m_re[c] = 0.0;
+        m_im[c] = 0.0;
+    }
+    m_count = 0;
+}
+
+void SingleBinDft::skip(qint64 samples)
+{
+    m_reference.advance(samples);
+}
+
+std::complex<double> SingleBinDft::bin(int channel) const
+{
+    if (channel < 0 || channel >= m_channels || m_count == 0) {
+        return std::complex<double>();
+    }
+    return std::complex<double>(m_re[channel], m_im[channel]) * (2.0 / m_count);
+}
@@ -0,0 +1,56 @@
+#ifndef SINGLEBINDFT_H
+#define SINGLEBINDFT_H
+
+#include <QtGlobal>
+#include <complex>
+#include "nco.h"
+
+// Running DFT of a few channels at one frequency.
+//
+// Each sample is correlated with a cos/sin reference from an NCO, so the
+// accumulators stay accurate at frequencies far below the sample rate
+// where a Goertzel recursion loses precision. Only the sums are kept;
+// the samples themselves are never stored.
+class SingleBinDft
+{
+public:
+    static constexpr int MaxChannels = 4;
+
+    SingleBinDft();
+
+    void configure(double frequency, double sampleRate, int channels);
+    void reset();
+
+    // Add one sample per channel
+    void add(const double *samples)
+    {
+        double sine;
+        double cosine;
+        m_reference.next(&sine, &cosine);
+        for (int c = 0; c < m_channels; ++c) {
+            m_re[c] += samples[c] * cosine;
+            m_im[c] -= samples[c] * sine;
+        }
+        ++m_count;
+    }
+
+    // Account for samples that never arrived, keeping the reference in step
+    void skip(qint64 samples);
+
+    // Complex amplitude: a sine of amplitude A at the bin frequency reads
+    // back with magnitude A. Phases are relative to the first sample.
+    std::complex<double> bin(int channel) const;
+
+    double frequency() const { return m_frequency; }
+    qint64 count() const { return m_count; }
+
+private:
+    Nco m_reference;
+    double m_frequency;
+    int m_channels;
+    double m_re[MaxChannels];
+    double m_im[MaxChannels];
+    qint64 m_count;
+};
+
+#endif // SINGLEBINDFT_H
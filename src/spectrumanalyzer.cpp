@@ -0,0 +1,135 @@
+#include "spectrumanalyzer.h"
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : m_window(Hann)
+    , m_sampleRate(1000.0)
+    , m_hop(1)
+    , m_averages(1)
+    , m_scale(1.0)
+    , m_fill(0)
+    , m_frames(0)
+{
+}
+
+QString SpectrumAnalyzer::windowName(Window window)
+{
+    switch (window) {
+    case Rectangular: return "Rectangular";
+    case Hann: return "Hann";
+    case BlackmanHarris: return "Blackman-Harris";
+    }
+    return "Unknown";
+}
+
+bool SpectrumAnalyzer::configure(int fftSize, Window window, double overlap, int averages,
+                                 double sampleRate)
+{
+    if (sampleRate <= 0.0) {
+        m_lastError = "Sample rate must be positive";
+        return false;
+    }
+    if (!m_fft.setSize(fftSize)) {
+        m_lastError = QString("FFT size %1 is not a power of two of at least 4").arg(fftSize);
+        return false;
+    }
+
+    m_window = window;
+    m_sampleRate = sampleRate;
+    m_averages = qMax(1, averages);
+    m_hop = qMax(1, static_cast<int>(std::lround(fftSize * (1.0 - qBound(0.0, overlap, 0.9)))));
+
+    // Periodic windows, so consecutive overlapped frames sum evenly
+    m_coefficients.resize(fftSize);
+    double sumSquares = 0.0;
+    for (int i = 0; i < fftSize; ++i) {
+        const double x = 2.0 * M_PI * i / fftSize;
+        double w = 1.0;
+        switch (window) {
+        case Rectangular:
+            break;
+        case Hann:
+            w = 0.5 - 0.5 * std::cos(x);
+            break;
+        case BlackmanHarris:
+            w = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x)
+                - 0.01168 * std::cos(3.0 * x);
+            break;
+        }
+        m_coefficients[i] = w;
+        sumSquares += w * w;
+    }
+    m_scale = 1.0 / (sampleRate * sumSquares);
+
+    m_buffer.resize(fftSize);
+    m_frame.resize(fftSize);
+    m_re.resize(m_fft.binCount());
+    m_im.resize(m_fft.binCount());
+    reset();
+    return true;
+}
+
+void SpectrumAnalyzer::reset()
+{
+    m_fill = 0;
+    m_frames = 0;
+    m_psd.clear();
+}
+
+void SpectrumAnalyzer::addSamples(const double *data, int count, int stride)
+{
+    const int size = m_fft.size();
+    if (size == 0) {
+        return;
+    }
+
+    double *buffer = m_buffer.data();
+    for (int i = 0; i < count; ++i) {
+        buffer[m_fill++] = data[i * stride];
+        if (m_fill == size) {
+            processFrame();
+            // Keep the overlap for the next frame
+            std::memmove(buffer, buffer + m_hop, (size - m_hop) * sizeof(double));
+            m_fill = size - m_hop;
+        }
+    }
+}
+
+void SpectrumAnalyzer::processFrame()
+{
+    const int size = m_fft.size();
+    const double *buffer = m_buffer.constData();
+    const double *window = m_coefficients.constData();
+    double *frame = m_frame.data();
+
+    // Without detrending, a static mirror offset leaks into the low bins
+    double mean = 0.0;
+    for (int i = 0; i < size; ++i) {
+        mean += buffer[i];
+    }
+    mean /= size;
+    for (int i = 0; i < size; ++i) {
+        frame[i] = (buffer[i] - mean) * window[i];
+    }
+
+    double *re = m_re.data();
+    double *im = m_im.data();
+    m_fft.forward(frame, re, im);
+
+    const int bins = m_fft.binCount();
+    if (m_psd.size() != bins) {
+        m_psd.fill(0.0, bins);
+    }
+
+    ++m_frames;
+    const double weight = 1.0 / static_cast<double>(qMin<quint64>(m_frames, m_averages));
+    double *psd = m_psd.data();
+    for (int k = 0; k < bins; ++k) {
+        // One-sided: every bin but DC and Nyquist carries both halves
+        const double factor = (k == 0 || k == bins - 1) ? m_scale : 2.0 * m_scale;
+        const double power = (re[k] * re[k] + im[k] * im[k]) * factor;
+        psd[k] += weight * (power - psd[k]);
+    }
+}
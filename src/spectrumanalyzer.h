@@ -0,0 +1,71 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QString>
+#include <QVector>
+#include "fft.h"
+
+// Streaming power spectral density estimate (Welch's method).
+//
+// Samples are fed in as they are produced; every time a full frame has
+// arrived it is detrended (mean removed), windowed and transformed, and its
+// periodogram is folded into the average. The average is linear until
+// averages() frames have been seen and exponential after that, so the
+// display settles quickly and then keeps following slow changes. Results
+// are one-sided, in input units squared per Hz.
+class SpectrumAnalyzer
+{
+public:
+    enum Window {
+        Rectangular,
+        Hann,
+        BlackmanHarris  // 4-term, for dynamic range
+    };
+
+    SpectrumAnalyzer();
+
+    // fftSize must be a power of two; overlap is the fraction of a frame
+    // shared with the next, 0 to 0.9
+    bool configure(int fftSize, Window window, double overlap, int averages, double sampleRate);
+    void reset();
+
+    // Add count samples spaced stride values apart (for interleaved data)
+    void addSamples(const double *data, int count, int stride = 1);
+
+    int fftSize() const { return m_fft.size(); }
+    double sampleRate() const { return m_sampleRate; }
+    double binWidth() const { return m_sampleRate / m_fft.size(); }
+    int averages() const { return m_averages; }
+
+    // Frames folded in since the last reset
+    quint64 frameCount() const { return m_frames; }
+
+    // fftSize/2 + 1 bins, empty until the first frame completes
+    const QVector<double> &psd() const { return m_psd; }
+
+    static QString windowName(Window window);
+    QString getLastError() const { return m_lastError; }
+
+private:
+    Fft m_fft;
+    Window m_window;
+    double m_sampleRate;
+    int m_hop;
+    int m_averages;
+    double m_scale;            // Periodogram to one-sided PSD
+
+    QVector<double> m_coefficients;
+    QVector<double> m_buffer;  // Samples of the frame being filled
+    int m_fill;
+    QVector<double> m_frame;
+    QVector<double> m_re;
+    QVector<double> m_im;
+    QVector<double> m_psd;
+    quint64 m_frames;
+
+    QString m_lastError;
+
+    void processFrame();
+};
+
+#endif // SPECTRUMANALYZER_H
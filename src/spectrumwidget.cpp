@@ -0,0 +1,220 @@
+#include "spectrumwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <cmath>
+#include <limits>
+
+SpectrumWidget::SpectrumWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_binWidth(1.0)
+    , m_logFrequency(true)
+    , m_peakFrequency(0.0)
+    , m_peakDb(0.0)
+{
+    setMinimumSize(300, 150);
+}
+
+void SpectrumWidget::setSpectrum(const QVector<double> &psd, double binWidth, const QString &units)
+{
+    m_psd = psd;
+    m_binWidth = binWidth > 0.0 ? binWidth : 1.0;
+    m_units = units;
+    reduce();
+    update();
+}
+
+void SpectrumWidget::clear()
+{
+    m_psd.clear();
+    m_columns.clear();
+    update();
+}
+
+void SpectrumWidget::setLogFrequency(bool logarithmic)
+{
+    m_logFrequency = logarithmic;
+    reduce();
+    update();
+}
+
+void SpectrumWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    reduce();
+}
+
+QRect SpectrumWidget::plotArea() const
+{
+    return rect().adjusted(55, 10, -15, -25);
+}
+
+double SpectrumWidget::minFrequency() const
+{
+    // DC has no place on a log axis; start at the first bin
+    return m_logFrequency ? m_binWidth : 0.0;
+}
+
+double SpectrumWidget::maxFrequency() const
+{
+    return m_binWidth * qMax(2, static_cast<int>(m_psd.size()) - 1);
+}
+
+double SpectrumWidget::frequencyToX(double frequency, const QRect &area) const
+{
+    double position = 0.0;
+    if (m_logFrequency) {
+        position = std::log(frequency / minFrequency()) / std::log(maxFrequency() / minFrequency());
+    } else {
+        position = (frequency - minFrequency()) / (maxFrequency() - minFrequency());
+    }
+    return area.left() + position * area.width();
+}
+
+double SpectrumWidget::xToFrequency(double x, const QRect &area) const
+{
+    const double position = (x - area.left()) / area.width();
+    if (m_logFrequency) {
+        return minFrequency() * std::pow(maxFrequency() / minFrequency(), position);
+    }
+    return minFrequency() + position * (maxFrequency() - minFrequency());
+}
+
+void SpectrumWidget::reduce()
+{
+    m_columns.clear();
+    if (m_psd.size() < 3) {
+        return;
+    }
+
+    const QRect area = plotArea();
+    const int width = qMax(1, area.width());
+    const int lastBin = m_psd.size() - 1;
+    m_columns.resize(width);
+
+    for (int column = 0; column < width; ++column) {
+        const double low = xToFrequency(area.left() + column, area);
+        const double high = xToFrequency(area.left() + column + 1, area);
+        int first = qBound(0, static_cast<int>(std::ceil(low / m_binWidth)), lastBin);
+        int last = qBound(0, static_cast<int>(std::ceil(high / m_binWidth)) - 1, lastBin);
+        if (last < first) {
+            // Zoomed in past the bin spacing: show the nearest bin
+            first = last = qBound(0, static_cast<int>(std::lround(low / m_binWidth)), lastBin);
+        }
+
+        double peak = 0.0;
+        for (int bin = first; bin <= last; ++bin) {
+            peak = qMax(peak, m_psd[bin]);
+        }
+        m_columns[column] = 10.0 * std::log10(qMax(peak, 1e-30));
+    }
+
+    // Peak readout skips DC, which the detrending leaves near zero anyway
+    int peakBin = 1;
+    for (int bin = 2; bin <= lastBin; ++bin) {
+        if (m_psd[bin] > m_psd[peakBin]) {
+            peakBin = bin;
+        }
+    }
+    m_peakFrequency = peakBin * m_binWidth;
+    m_peakDb = 10.0 * std::log10(qMax(m_psd[peakBin], 1e-30));
+}
+
+void SpectrumWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    const QRect area = plotArea();
+    painter.setPen(QPen(Qt::darkGray, 1));
+    painter.drawRect(area);
+
+    if (m_columns.isEmpty()) {
+        painter.setPen(Qt::gray);
+        painter.drawText(area, Qt::AlignCenter, "Waiting for the first frame");
+        return;
+    }
+
+    // dB scale: top on the next 10 dB above the peak, at least 40 dB shown
+    double maxDb = -std::numeric_limits<double>::infinity();
+    double minDb = std::numeric_limits<double>::infinity();
+    for (double value : m_columns) {
+        maxDb = qMax(maxDb, value);
+        minDb = qMin(minDb, value);
+    }
+    const double topDb = std::ceil(maxDb / 10.0) * 10.0;
+    const double rangeDb = qBound(40.0, std::ceil((topDb - minDb) / 10.0) * 10.0, 160.0);
+    const double dbStep = rangeDb > 80.0 ? 20.0 : 10.0;
+
+    auto dbToY = [&](double db) {
+        return area.top() + (topDb - db) / rangeDb * area.height();
+    };
+
+    const QFontMetrics metrics = painter.fontMetrics();
+
+    // Horizontal grid
+    for (double db = topDb; db >= topDb - rangeDb - 1e-9; db -= dbStep) {
+        const int y = static_cast<int>(dbToY(db));
+        painter.setPen(QPen(QColor(50, 50, 50), 1, Qt::DotLine));
+        painter.drawLine(area.left(), y, area.right(), y);
+        painter.setPen(Qt::gray);
+        painter.drawText(QRect(0, y - metrics.height() / 2, area.left() - 4, metrics.height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(db, 'f', 0));
+    }
+
+    // Vertical grid: decades on a log axis, round steps on a linear one
+    QVector<double> ticks;
+    if (m_logFrequency) {
+        for (double decade = std::pow(10.0, std::floor(std::log10(minFrequency())));
+             decade <= maxFrequency(); decade *= 10.0) {
+            for (double multiple : {1.0, 2.0, 5.0}) {
+                const double frequency = decade * multiple;
+                if (frequency >= minFrequency() && frequency <= maxFrequency()) {
+                    ticks.append(frequency);
+                }
+            }
+        }
+    } else {
+        const double rough = maxFrequency() / 8.0;
+        const double magnitude = std::pow(10.0, std::floor(std::log10(rough)));
+        double step = magnitude;
+        for (double multiple : {2.0, 5.0, 10.0}) {
+            if (step < rough) {
+                step = magnitude * multiple;
+            }
+        }
+        for (double frequency = 0.0; frequency <= maxFrequency(); frequency += step) {
+            ticks.append(frequency);
+        }
+    }
+
+    for (double frequency : ticks) {
+        const int x = static_cast<int>(frequencyToX(frequency, area));
+        painter.setPen(QPen(QColor(50, 50, 50), 1, Qt::DotLine));
+        painter.drawLine(x, area.top(), x, area.bottom());
+        painter.setPen(Qt::gray);
+        QString label = frequency >= 1000.0 ? QString("%1k").arg(frequency / 1000.0)
+                                            : QString::number(frequency);
+        painter.drawText(QRect(x - 30, area.bottom() + 4, 60, metrics.height()),
+                         Qt::AlignHCenter | Qt::AlignTop, label);
+    }
+
+    // Trace
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::green, 1));
+    QPolygonF trace;
+    trace.reserve(m_columns.size());
+    for (int column = 0; column < m_columns.size(); ++column) {
+        trace << QPointF(area.left() + column + 0.5, qMin(dbToY(m_columns[column]), double(area.bottom())));
+    }
+    painter.drawPolyline(trace);
+
+    painter.setPen(Qt::white);
+    painter.drawText(area.adjusted(0, 4, -6, 0), Qt::AlignRight | Qt::AlignTop,
+                     QString("Peak %1 Hz, %2 dB(%3²/Hz)")
+                         .arg(m_peakFrequency, 0, 'f', 2)
+                         .arg(m_peakDb, 0, 'f', 1)
+                         .arg(m_units));
+}
@@ -0,0 +1,53 @@
+#ifndef SPECTRUMWIDGET_H
+#define SPECTRUMWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+
+// Plots a power spectral density in dB against frequency.
+//
+// Bins are reduced to one value per pixel column (the largest, so narrow
+// resonance peaks survive at any FFT size) when the spectrum is set; paint
+// only draws the reduced trace.
+class SpectrumWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit SpectrumWidget(QWidget *parent = nullptr);
+
+    // psd holds bins 0..N/2 spaced binWidth Hz apart; units names the
+    // input quantity, e.g. "V" for V^2/Hz
+    void setSpectrum(const QVector<double> &psd, double binWidth, const QString &units);
+    void clear();
+
+    void setLogFrequency(bool logarithmic);
+    bool logFrequency() const { return m_logFrequency; }
+
+    QSize sizeHint() const override { return QSize(600, 300); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    QVector<double> m_psd;
+    double m_binWidth;
+    QString m_units;
+    bool m_logFrequency;
+
+    // Trace reduced to the plot width, in dB
+    QVector<double> m_columns;
+    double m_peakFrequency;
+    double m_peakDb;
+
+    QRect plotArea() const;
+    double frequencyToX(double frequency, const QRect &area) const;
+    double xToFrequency(double x, const QRect &area) const;
+    double minFrequency() const;
+    double maxFrequency() const;
+    void reduce();
+};
+
+#endif // SPECTRUMWIDGET_H
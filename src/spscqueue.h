@@ -0,0 +1,102 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+// Bounded FIFO between one producer thread and one consumer thread.
+//
+// Unlike HistoryRing nothing is ever overwritten: when the queue is full
+// tryPush() fails and the caller decides whether to drop or retry. Neither
+// side takes a lock or calls into the kernel; each keeps a cached copy of
+// the other side's index and only reloads it when the cache says full (or
+// empty), so in steady state a push or pop touches no shared cache line but
+// the slot itself. The consumer reads records in place with peek() and
+// hands the slots back with release().
+//
+// The producer may change threads as long as the old and the new producer
+// synchronize (e.g. through a mutex) around the switch.
+template<typename T>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue stores plain values");
+
+public:
+    // Capacity is 2^capacityLog2 values
+    explicit SpscQueue(int capacityLog2)
+        : m_capacity(quint64(1) << qBound(1, capacityLog2, 30))
+        , m_mask(m_capacity - 1)
+        , m_data(static_cast<T *>(::operator new[](m_capacity * sizeof(T), std::align_val_t(64))))
+        , m_tail(0)
+        , m_cachedHead(0)
+        , m_head(0)
+        , m_cachedTail(0)
+    {
+    }
+
+    ~SpscQueue()
+    {
+        ::operator delete[](m_data, std::align_val_t(64));
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    quint64 capacity() const { return m_capacity; }
+
+    // Either side; a snapshot that may be stale by the time it returns
+    quint64 size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    // Producer side
+    bool tryPush(const T &value)
+    {
+        const quint64 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead >= m_capacity) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead >= m_capacity) {
+                return false;
+            }
+        }
+        m_data[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: up to maxCount queued values from the oldest on, in
+    // place and without wrapping; call release() once they are used
+    int peek(const T **values, int maxCount)
+    {
+        const quint64 head = m_head.load(std::memory_order_relaxed);
+        if (m_cachedTail == head) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+        }
+        const quint64 available = qMin<quint64>(m_cachedTail - head, m_capacity - (head & m_mask));
+        *values = m_data + (head & m_mask);
+        return static_cast<int>(qMin<quint64>(available, static_cast<quint64>(maxCount)));
+    }
+
+    void release(int count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    const quint64 m_capacity;
+    const quint64 m_mask;
+    T *const m_data;
+
+    // Producer line: its index and its view of the consumer's
+    alignas(64) std::atomic<quint64> m_tail;
+    quint64 m_cachedHead;
+
+    // Consumer line
+    alignas(64) std::atomic<quint64> m_head;
+    quint64 m_cachedTail;
+};
+
+#endif // SPSCQUEUE_H
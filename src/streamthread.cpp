@@ -0,0 +1,391 @@
+#include "streamthread.h"
+#include "loggingthread.h"
+#include "monotonicclock.h"
+#include "xyscopewidget.h"
+#include <limits>
+#include <utility>
+
+StreamThread::StreamThread(FastSteeringMirror *mirror, QObject *parent)
+    : QThread(parent)
+    , m_mirror(mirror)
+    , m_loggingThread(nullptr)
+    , m_scopeHistory(nullptr)
+    , m_xyHistory(nullptr)
+    , m_commandHistory(HistoryCapacityLog2)
+    , m_feedbackHistory(HistoryCapacityLog2)
+    , m_generator(nullptr)
+    , m_sweep(nullptr)
+    , m_sampleIndex(0)
+    , m_startNs(0)
+    , m_logging(false)
+    , m_stopRequested(false)
+{
+    m_lastPosition[0].store(0.0);
+    m_lastPosition[1].store(0.0);
+}
+
+StreamThread::~StreamThread()
+{
+    stopStreaming();
+    delete m_generator;
+}
+
+void StreamThread::setLoggingThread(LoggingThread *loggingThread)
+{
+    m_loggingThread = loggingThread;
+}
+
+void StreamThread::setScopeHistory(HistoryRing<PositionSample> *history)
+{
+    m_scopeHistory = history;
+}
+
+void StreamThread::setXyHistory(HistoryRing<XyFrame> *history)
+{
+    m_xyHistory = history;
+}
+
+void StreamThread::startStreaming(const WaveformSettings &settings, FrequencySweep *sweep,
+                                  int feedbackDelayFrames, qint64 startNs)
+{
+    stopStreaming();
+
+    AoStream *stream = m_mirror->stream();
+    if (!stream) {
+        return;
+    }
+    const double sampleRate = stream->sampleRate();
+
+    // Streamed: room for the whole FIFO. Cyclic: 80 ms of played frames per
+    // fill for display and logging, more than a tick's worth.
+    const int frames = stream->isCyclic() ? qMax(256, static_cast<int>(sampleRate * 0.08))
+                                          : stream->bufferFrames() * 4;
+    m_xData.resize(frames);
+    m_yData.resize(frames);
+    m_feedbackData.resize(frames * 2);
+
+    delete m_generator;
+    m_generator = WaveformGenerator::create(settings, sampleRate);
+    m_sweep = sweep;
+    m_sampleIndex = 0;
+    m_startNs = startNs;
+    m_aligner.reset(sampleRate, startNs);
+    m_aligner.setDelayFrames(feedbackDelayFrames);
+    m_lastPosition[0].store(0.0);
+    m_lastPosition[1].store(0.0);
+
+    // Fill the FIFO right away so the device starts primed
+    fill();
+
+    m_stopRequested.store(false, std::memory_order_release);
+    start();
+}
+
+void StreamThread::stopStreaming()
+{
+    if (!isRunning()) {
+        return;
+    }
+    m_stopRequested.store(true, std::memory_order_release);
+    wait();
+}
+
+void StreamThread::setWaveform(const WaveformSettings &settings)
+{
+    // As OutputThread::setWaveform(): configure() may take milliseconds, so
+    // the change is made on a generator of its own and swapped in
+    WaveformSettings current;
+    double sampleRate = 0.0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_generator) {
+            return;
+        }
+        current = m_generator->settings();
+        sampleRate = m_generator->sampleRate();
+    }
+
+    WaveformGenerator *generator = nullptr;
+    if (current.shape == settings.shape) {
+        // Same shape: continue from the running generator's phase
+        generator = WaveformGenerator::create(current, sampleRate);
+        qint64 copiedAt = 0;
+        {
+            QMutexLocker locker(&m_mutex);
+            generator->copyState(*m_generator);
+            copiedAt = m_sampleIndex;
+        }
+        generator->configure(settings);
+
+        QMutexLocker locker(&m_mutex);
+        generator->advance(m_sampleIndex - copiedAt);
+        std::swap(generator, m_generator);
+    } else {
+        // A new shape starts fresh, caught up to the stream's position
+        generator = WaveformGenerator::create(settings, sampleRate);
+        QMutexLocker locker(&m_mutex);
+        generator->advance(m_sampleIndex);
+        std::swap(generator, m_generator);
+    }
+    delete generator;
+}
+
+void StreamThread::setLogging(bool enabled)
+{
+    m_logging.store(enabled, std::memory_order_release);
+}
+
+void StreamThread::lastPosition(double *xPosition, double *yPosition) const
+{
+    *xPosition = m_lastPosition[0].load(std::memory_order_relaxed);
+    *yPosition = m_lastPosition[1].load(std::memory_order_relaxed);
+}
+
+quint64 StreamThread::matchedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_aligner.matchedCount();
+}
+
+quint64 StreamThread::unmatchedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_aligner.unmatchedCount();
+}
+
+quint64 StreamThread::unalignedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_aligner.unalignedCount();
+}
+
+bool StreamThread::alignmentLost() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_aligner.alignmentLost();
+}
+
+QVector<BodePoint> StreamThread::sweepResults() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sweep ? m_sweep->results() : QVector<BodePoint>();
+}
+
+double StreamThread::sweepFrequency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sweep ? m_sweep->currentFrequency() : 0.0;
+}
+
+bool StreamThread::sweepComplete() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sweep && m_sweep->isComplete();
+}
+
+void StreamThread::run()
+{
+    qint64 deadlineNs = MonotonicClock::nowNs();
+    while (!m_stopRequested.load(std::memory_order_acquire)) {
+        deadlineNs += FillIntervalNs;
+        MonotonicClock::sleepUntil(deadlineNs);
+        fill();
+
+        // A late tick already topped the FIFO up in full; carry on from now
+        // instead of bursting through the missed ones
+        const qint64 nowNs = MonotonicClock::nowNs();
+        if (nowNs - deadlineNs > FillIntervalNs) {
+            deadlineNs = nowNs;
+        }
+    }
+}
+
+void StreamThread::fill()
+{
+    AoStream *stream = m_mirror->stream();
+    if (!stream) {
+        return;
+    }
+
+    const double sampleRate = stream->sampleRate();
+    double *xData = m_xData.data();
+    double *yData = m_yData.data();
+    double frequency = 0.0;
+    double amplitude = 0.0;
+    qint64 firstIndex = 0;
+    int queued = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // Cyclic output plays the generator's frequency, which is the one
+        // the pattern was rounded to
+        const WaveformSettings &settings = m_generator->settings();
+        frequency = m_sweep ? m_sweep->currentFrequency() : settings.frequency;
+        amplitude = m_sweep ? m_sweep->settings().amplitude : settings.amplitude;
+
+        int count = 0;
+        if (stream->isCyclic()) {
+            // The output clock loops the pattern on its own; only catch the
+            // display and log up with what has been played
+            const qint64 played = static_cast<qint64>(stream->framesTransmitted());
+            count = static_cast<int>(qMin<qint64>(played - m_sampleIndex, m_xData.size()));
+            m_generator->advance(played - count - m_sampleIndex);
+            m_sampleIndex = played - count;
+        } else {
+            count = qMin(stream->freeFrames(), static_cast<int>(m_xData.size()));
+        }
+
+        if (count > 0) {
+            // The generator carries the phase from block to block,
+            // independent of when this tick happens to run
+            if (m_sweep) {
+                m_sweep->generate(xData, yData, count);
+            } else {
+                m_generator->generate(xData, yData, count);
+            }
+
+            queued = stream->isCyclic() ? count : m_mirror->queueSamples(xData, yData, count);
+            if (queued < count && !m_sweep) {
+                // Take back what the FIFO refused, it is synthesized again
+                // next tick. The sweep asks for exactly the free space, so
+                // it is never refused.
+                m_generator->advance(queued - count);
+            }
+
+            // Measured positions are logged once they come back from the AI
+            if (m_mirror->feedbackStream()) {
+                m_aligner.addCommands(m_sampleIndex, xData, yData, queued, frequency, amplitude);
+            }
+            firstIndex = m_sampleIndex;
+            m_sampleIndex += queued;
+        }
+    }
+
+    if (queued > 0) {
+        m_lastPosition[0].store(xData[queued - 1], std::memory_order_relaxed);
+        m_lastPosition[1].store(yData[queued - 1], std::memory_order_relaxed);
+        writeCommands(xData, yData, queued);
+
+        if (!m_mirror->feedbackStream() && m_loggingThread && m_logging.load(std::memory_order_acquire)) {
+            for (int i = 0; i < queued; ++i) {
+                LogRecord record;
+                record.sampleIndex = firstIndex + i;
+                record.elapsedTime = static_cast<qint64>((firstIndex + i) * 1.0e9 / sampleRate);
+                record.sessionTime = m_startNs + record.elapsedTime;
+                record.frequency = frequency;
+                record.amplitude = amplitude;
+                record.xCommand = xData[i];
+                record.yCommand = yData[i];
+                record.xFeedback = m_mirror->positionToVoltage(xData[i]);
+                record.yFeedback = m_mirror->positionToVoltage(yData[i]);
+                m_loggingThread->addRecord(record);
+            }
+        }
+    }
+
+    drainFeedback();
+}
+
+void StreamThread::writeCommands(const double *x, const double *y, int count)
+{
+    // Without a sensor the XY view shows the command alone
+    const bool xyCommands = m_xyHistory && !m_mirror->feedbackStream();
+    const float none = std::numeric_limits<float>::quiet_NaN();
+
+    PositionSample scope[256];
+    StreamSample spectrum[256];
+    XyFrame xy[256];
+    for (int done = 0; done < count; ) {
+        const int chunk = qMin(count - done, 256);
+        for (int i = 0; i < chunk; ++i) {
+            scope[i] = {static_cast<float>(x[done + i]), static_cast<float>(y[done + i])};
+            spectrum[i] = {x[done + i], y[done + i]};
+        }
+        if (m_scopeHistory) {
+            m_scopeHistory->write(scope, chunk);
+        }
+        m_commandHistory.write(spectrum, chunk);
+
+        if (xyCommands) {
+            for (int i = 0; i < chunk; ++i) {
+                xy[i] = {static_cast<float>(m_mirror->positionToVoltage(x[done + i])),
+                         static_cast<float>(m_mirror->positionToVoltage(y[done + i])),
+                         none, none};
+            }
+            m_xyHistory->write(xy, chunk);
+        }
+        done += chunk;
+    }
+}
+
+void StreamThread::drainFeedback()
+{
+    AiStream *feedback = m_mirror->feedbackStream();
+    if (!feedback || m_feedbackData.isEmpty()) {
+        return;
+    }
+
+    // After samples were lost in the driver the indices are off, and from
+    // there on feedback is only counted, never paired or logged
+    const qint64 alignmentLostAt = feedback->alignmentLostAt();
+
+    // Read even when not logging, so the acquisition ring never overruns
+    const int maxFrames = m_feedbackData.size() / 2;
+    quint64 firstFrame = 0;
+    int frames = 0;
+    while ((frames = feedback->read(m_feedbackData.data(), maxFrames, &firstFrame)) > 0) {
+        const double *data = m_feedbackData.constData();
+
+        StreamSample spectrum[256];
+        for (int done = 0; done < frames; ) {
+            const int chunk = qMin(frames - done, 256);
+            for (int i = 0; i < chunk; ++i) {
+                spectrum[i] = {data[2 * (done + i)], data[2 * (done + i) + 1]};
+            }
+            m_feedbackHistory.write(spectrum, chunk);
+            done += chunk;
+        }
+
+        m_alignedRecords.clear();
+        {
+            QMutexLocker locker(&m_mutex);
+            if (alignmentLostAt >= 0) {
+                m_aligner.setAlignmentLost(alignmentLostAt);
+            }
+            m_aligner.align(static_cast<qint64>(firstFrame), data, frames, &m_alignedRecords);
+
+            if (m_sweep) {
+                // Command and feedback compared in volts, as the mirror sees them
+                for (const LogRecord &record : m_alignedRecords) {
+                    const double command[2] = {m_mirror->positionToVoltage(record.xCommand),
+                                               m_mirror->positionToVoltage(record.yCommand)};
+                    const double measured[2] = {record.xFeedback, record.yFeedback};
+                    m_sweep->analyze(record.sampleIndex, command, measured);
+                }
+            }
+        }
+
+        // Command against measured position, both in volts
+        if (m_xyHistory) {
+            XyFrame block[256];
+            for (int done = 0; done < m_alignedRecords.size(); ) {
+                const int chunk = qMin(static_cast<int>(m_alignedRecords.size()) - done, 256);
+                for (int i = 0; i < chunk; ++i) {
+                    const LogRecord &record = m_alignedRecords[done + i];
+                    block[i] = {static_cast<float>(m_mirror->positionToVoltage(record.xCommand)),
+                                static_cast<float>(m_mirror->positionToVoltage(record.yCommand)),
+                                static_cast<float>(record.xFeedback),
+                                static_cast<float>(record.yFeedback)};
+                }
+                m_xyHistory->write(block, chunk);
+                done += chunk;
+            }
+        }
+
+        if (m_loggingThread && m_logging.load(std::memory_order_acquire)) {
+            for (const LogRecord &record : m_alignedRecords) {
+                m_loggingThread->addRecord(record);
+            }
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef STREAMTHREAD_H
+#define STREAMTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include "faststeeringmirror.h"
+#include "feedbackaligner.h"
+#include "frequencysweep.h"
+#include "historyring.h"
+#include "logrecord.h"
+#include "waveformgenerator.h"
+
+class LoggingThread;
+struct XyFrame;
+
+// X/Y pair at full precision, for the spectrum analyzer
+struct StreamSample {
+    double x;
+    double y;
+};
+
+// Keeps the mirror's buffered output fed from its own thread.
+//
+// Every FillIntervalNs the loop synthesizes as many frames as the stream's
+// FIFO has room for (cyclic mode: as many as were played, for display and
+// logging), queues them, pairs the acquired feedback with its commands and
+// hands records to the logging thread. Displays get their data through
+// lock-free histories, so a repaint or a dialog on the GUI thread no longer
+// holds up the output, and the loop never touches a widget.
+//
+// The generator and the sweep are shared with the GUI under m_mutex; a new
+// waveform is prepared outside it and swapped in, as in OutputThread.
+class StreamThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    // A quarter of the 20 ms device buffer, with four buffers in the FIFO
+    static constexpr qint64 FillIntervalNs = 5000000;
+
+    // 2^16 samples: 0.65 s at 100 kS/s for the GUI to catch up
+    static constexpr int HistoryCapacityLog2 = 16;
+
+    explicit StreamThread(FastSteeringMirror *mirror, QObject *parent = nullptr);
+    ~StreamThread();
+
+    // Where the samples go. Set while stopped; the loop is then the only
+    // producer of the display histories and the logging queue.
+    void setLoggingThread(LoggingThread *loggingThread);
+    void setScopeHistory(HistoryRing<PositionSample> *history);
+    void setXyHistory(HistoryRing<XyFrame> *history);
+
+    // Start feeding the mirror's stream, which must be armed (streamed or
+    // cyclic); startNs is the session time of its frame 0. sweep, when
+    // given, replaces the waveform and is left to the loop until the next
+    // start. The first fill runs on the calling thread, so a streamed device
+    // starts primed and from there.
+    void startStreaming(const WaveformSettings &settings, FrequencySweep *sweep,
+                        int feedbackDelayFrames, qint64 startNs);
+    // Returns once the loop has let go of the stream
+    void stopStreaming();
+
+    // Parameter changes keep the phase, a new shape is caught up to the
+    // stream's position
+    void setWaveform(const WaveformSettings &settings);
+    void setLogging(bool enabled);
+
+    // Last position queued, for display
+    void lastPosition(double *xPosition, double *yPosition) const;
+
+    // Commanded positions at the stream rate, feedback volts at the AI rate
+    HistoryRing<StreamSample> &commandHistory() { return m_commandHistory; }
+    HistoryRing<StreamSample> &feedbackHistory() { return m_feedbackHistory; }
+
+    // Feedback statistics since startStreaming()
+    quint64 matchedCount() const;
+    quint64 unmatchedCount() const;
+    quint64 unalignedCount() const;
+    bool alignmentLost() const;
+
+    // State of the sweep given to the last start, read under the lock
+    QVector<BodePoint> sweepResults() const;
+    double sweepFrequency() const;
+    bool sweepComplete() const;
+
+protected:
+    void run() override;
+
+private:
+    FastSteeringMirror *m_mirror;
+    LoggingThread *m_loggingThread;
+    HistoryRing<PositionSample> *m_scopeHistory;
+    HistoryRing<XyFrame> *m_xyHistory;
+    HistoryRing<StreamSample> m_commandHistory;
+    HistoryRing<StreamSample> m_feedbackHistory;
+
+    // Guards the generator, the sweep and the aligner. The loop holds it
+    // while it synthesizes and queues a fill and while it pairs feedback,
+    // never across a log hand-off or a history write.
+    mutable QMutex m_mutex;
+    WaveformGenerator *m_generator;
+    FrequencySweep *m_sweep;
+    FeedbackAligner m_aligner;
+    qint64 m_sampleIndex;          // Stream frame the generator is at
+    qint64 m_startNs;              // Session time of stream frame 0
+
+    // Loop side
+    QVector<double> m_xData;
+    QVector<double> m_yData;
+    QVector<double> m_feedbackData;
+    QVector<LogRecord> m_alignedRecords;
+
+    std::atomic<bool> m_logging;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<double> m_lastPosition[2];
+
+    void fill();
+    void drainFeedback();
+    void writeCommands(const double *x, const double *y, int count);
+};
+
+#endif // STREAMTHREAD_H
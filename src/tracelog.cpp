@@ -0,0 +1,243 @@
+#include "tracelog.h"
+#include "monotonicclock.h"
+#include <QThread>
+#include <QStringList>
+#include <QDebug>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const int kRingCapacity = 4096;        // Must be a power of two
+const int kMessageSize = 112;
+
+// One message. The sequence number tells producers and the consumer who owns
+// the slot (bounded MPSC queue after D. Vyukov).
+struct TraceSlot {
+    std::atomic<quint64> sequence;
+    qint64 timestampNs;            // Session time
+    quint32 category;
+    int level;
+    char text[kMessageSize];
+};
+
+struct TraceRing {
+    TraceSlot entries[kRingCapacity];
+    alignas(64) std::atomic<quint64> enqueuePos;
+    alignas(64) quint64 dequeuePos;
+    std::atomic<quint64> dropped;
+
+    TraceRing()
+        : enqueuePos(0)
+        , dequeuePos(0)
+        , dropped(0)
+    {
+        for (int i = 0; i < kRingCapacity; ++i) {
+            entries[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+};
+
+TraceRing &ring()
+{
+    static TraceRing instance;
+    return instance;
+}
+
+const char *levelName(int level)
+{
+    switch (level) {
+    case TraceLog::Error: return "ERROR";
+    case TraceLog::Warn: return "WARN";
+    case TraceLog::Info: return "INFO";
+    case TraceLog::Debug: return "DEBUG";
+    default: return "TRACE";
+    }
+}
+
+const struct {
+    const char *name;
+    quint32 category;
+} s_categoryNames[] = {
+    { "mirror", TraceLog::Mirror },
+    { "tracker", TraceLog::Tracker },
+    { "joystick", TraceLog::Joystick },
+    { "stream", TraceLog::Stream },
+    { "logging", TraceLog::Logging },
+};
+
+const char *categoryName(quint32 category)
+{
+    for (const auto &entry : s_categoryNames) {
+        if (entry.category == category) {
+            return entry.name;
+        }
+    }
+    return "misc";
+}
+
+quint32 initialCategoryMask()
+{
+    QByteArray names = qgetenv("JTM_TRACE_CATEGORIES");
+    if (names.isEmpty()) {
+        return TraceLog::AllCategories;
+    }
+    return TraceLog::parseCategories(QString::fromLatin1(names));
+}
+
+} // namespace
+
+std::atomic<quint32> TraceLog::s_categoryMask(initialCategoryMask());
+QThread *TraceLog::s_drainThread = nullptr;
+std::atomic<bool> TraceLog::s_stopRequested(false);
+
+void TraceLog::start()
+{
+    if (s_drainThread) {
+        return;
+    }
+
+    s_stopRequested = false;
+    s_drainThread = QThread::create([]() { drainLoop(); });
+    s_drainThread->start(QThread::LowPriority);
+}
+
+void TraceLog::stop()
+{
+    if (!s_drainThread) {
+        return;
+    }
+
+    s_stopRequested = true;
+    s_drainThread->wait();
+    delete s_drainThread;
+    s_drainThread = nullptr;
+}
+
+void TraceLog::setCategoryMask(quint32 mask)
+{
+    s_categoryMask.store(mask, std::memory_order_relaxed);
+}
+
+quint32 TraceLog::categoryMask()
+{
+    return s_categoryMask.load(std::memory_order_relaxed);
+}
+
+quint32 TraceLog::parseCategories(const QString &names)
+{
+    quint32 mask = 0;
+    const QStringList parts = names.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        QString name = part.trimmed().toLower();
+        if (name == "all") {
+            return AllCategories;
+        }
+        for (const auto &entry : s_categoryNames) {
+            if (name == entry.name) {
+                mask |= entry.category;
+            }
+        }
+    }
+    return mask;
+}
+
+void TraceLog::write(Level level, quint32 category, const char *format, ...)
+{
+    TraceRing &r = ring();
+
+    // Claim a slot; give up instead of waiting if the drain thread is behind
+    quint64 pos = r.enqueuePos.load(std::memory_order_relaxed);
+    TraceSlot *slot = nullptr;
+    for (;;) {
+        slot = &r.entries[pos & (kRingCapacity - 1)];
+        quint64 sequence = slot->sequence.load(std::memory_order_acquire);
+        qint64 diff = static_cast<qint64>(sequence) - static_cast<qint64>(pos);
+        if (diff == 0) {
+            if (r.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            r.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = r.enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->timestampNs = MonotonicClock::sessionNs();
+    slot->category = category;
+    slot->level = level;
+
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(slot->text, kMessageSize, format, args);
+    va_end(args);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+quint64 TraceLog::droppedCount()
+{
+    return ring().dropped.load(std::memory_order_relaxed);
+}
+
+void TraceLog::drainLoop()
+{
+    quint64 reportedDrops = 0;
+
+    while (!s_stopRequested.load(std::memory_order_relaxed)) {
+        if (drain() == 0) {
+            QThread::msleep(20);
+        }
+
+        quint64 dropped = droppedCount();
+        if (dropped != reportedDrops) {
+            qWarning() << "Trace ring full," << (dropped - reportedDrops) << "messages dropped";
+            reportedDrops = dropped;
+        }
+    }
+
+    drain();
+}
+
+int TraceLog::drain()
+{
+    TraceRing &r = ring();
+    int count = 0;
+    char text[kMessageSize];
+
+    for (;;) {
+        TraceSlot *slot = &r.entries[r.dequeuePos & (kRingCapacity - 1)];
+        if (slot->sequence.load(std::memory_order_acquire) != r.dequeuePos + 1) {
+            break;
+        }
+
+        qint64 timestampNs = slot->timestampNs;
+        quint32 category = slot->category;
+        int level = slot->level;
+        std::memcpy(text, slot->text, kMessageSize);
+
+        // Hand the slot back before the (slow) formatting below
+        slot->sequence.store(r.dequeuePos + kRingCapacity, std::memory_order_release);
+        ++r.dequeuePos;
+        ++count;
+
+        QString line = QString("[%1 %2 %3] %4")
+                           .arg(timestampNs / 1.0e9, 0, 'f', 6)
+                           .arg(levelName(level))
+                           .arg(categoryName(category))
+                           .arg(QString::fromUtf8(text));
+
+        if (level <= Error) {
+            qCritical().noquote() << line;
+        } else if (level == Warn) {
+            qWarning().noquote() << line;
+        } else {
+            qDebug().noquote() << line;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,121 @@
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+
+// Compile-time log levels. The build selects one with the JTM_LOG_LEVEL CMake
+// option; statements above it compile away entirely, arguments included.
+#define JTM_LOG_LEVEL_OFF   0
+#define JTM_LOG_LEVEL_ERROR 1
+#define JTM_LOG_LEVEL_WARN  2
+#define JTM_LOG_LEVEL_INFO  3
+#define JTM_LOG_LEVEL_DEBUG 4
+#define JTM_LOG_LEVEL_TRACE 5
+
+#ifndef JTM_LOG_LEVEL
+#define JTM_LOG_LEVEL JTM_LOG_LEVEL_DEBUG
+#endif
+
+class QThread;
+
+// Low-overhead logging for hot paths.
+//
+// Enabled statements format into a fixed-size slot of a bounded lock-free
+// ring and return; a background thread drains the ring into the normal Qt
+// message handler. When the ring is full new messages are dropped and
+// counted rather than blocking the caller. Categories can be switched on and
+// off at runtime, by default from the JTM_TRACE_CATEGORIES environment
+// variable (e.g. "mirror,tracker" or "all").
+class TraceLog
+{
+public:
+    enum Level {
+        Error = JTM_LOG_LEVEL_ERROR,
+        Warn = JTM_LOG_LEVEL_WARN,
+        Info = JTM_LOG_LEVEL_INFO,
+        Debug = JTM_LOG_LEVEL_DEBUG,
+        Trace = JTM_LOG_LEVEL_TRACE
+    };
+
+    enum Category : quint32 {
+        Mirror = 1u << 0,
+        Tracker = 1u << 1,
+        Joystick = 1u << 2,
+        Stream = 1u << 3,
+        Logging = 1u << 4,
+        AllCategories = 0xFFFFFFFFu
+    };
+
+    // Start/stop the drain thread. stop() flushes whatever is still queued.
+    static void start();
+    static void stop();
+
+    static bool isEnabled(quint32 category)
+    {
+        return (s_categoryMask.load(std::memory_order_relaxed) & category) != 0;
+    }
+    static void setCategoryMask(quint32 mask);
+    static quint32 categoryMask();
+
+    // Parse a comma-separated list of category names
+    static quint32 parseCategories(const QString &names);
+
+    static void write(Level level, quint32 category, const char *format, ...)
+#if defined(__GNUC__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    static quint64 droppedCount();
+
+private:
+    static std::atomic<quint32> s_categoryMask;
+    static QThread *s_drainThread;
+    static std::atomic<bool> s_stopRequested;
+
+    static void drainLoop();
+    static int drain();
+};
+
+#define JTM_LOG_WRITE(level, category, ...) \
+    do { \
+        if (TraceLog::isEnabled(category)) { \
+            TraceLog::write(level, category, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define JTM_LOG_DISCARD(category, ...) do { } while (0)
+
+#if JTM_LOG_LEVEL >= JTM_LOG_LEVEL_ERROR
+#define JTM_ERROR(category, ...) JTM_LOG_WRITE(TraceLog::Error, category, __VA_ARGS__)
+#else
+#define JTM_ERROR(category, ...) JTM_LOG_DISCARD(category, __VA_ARGS__)
+#endif
+
+#if JTM_LOG_LEVEL >= JTM_LOG_LEVEL_WARN
+#define JTM_WARN(category, ...) JTM_LOG_WRITE(TraceLog::Warn, category, __VA_ARGS__)
+#else
+#define JTM_WARN(category, ...) JTM_LOG_DISCARD(category, __VA_ARGS__)
+#endif
+
+#if JTM_LOG_LEVEL >= JTM_LOG_LEVEL_INFO
+#define JTM_INFO(category, ...) JTM_LOG_WRITE(TraceLog::Info, category, __VA_ARGS__)
+#else
+#define JTM_INFO(category, ...) JTM_LOG_DISCARD(category, __VA_ARGS__)
+#endif
+
+#if JTM_LOG_LEVEL >= JTM_LOG_LEVEL_DEBUG
+#define JTM_DEBUG(category, ...) JTM_LOG_WRITE(TraceLog::Debug, category, __VA_ARGS__)
+#else
+#define JTM_DEBUG(category, ...) JTM_LOG_DISCARD(category, __VA_ARGS__)
+#endif
+
+#if JTM_LOG_LEVEL >= JTM_LOG_LEVEL_TRACE
+#define JTM_TRACE(category, ...) JTM_LOG_WRITE(TraceLog::Trace, category, __VA_ARGS__)
+#else
+#define JTM_TRACE(category, ...) JTM_LOG_DISCARD(category, __VA_ARGS__)
+#endif
+
+#endif // TRACELOG_H
@@ -5,6 +5,10 @@
 #include <QString>
 
 struct TrackData {
+    // The tracker's status message to the host (Figure B3.1)
+    static constexpr int StatusMessageWords = 18;
+    static constexpr uint16_t StatusSyncWord = 0xA5A5;
+
     // Raw track errors
     float rawErrorX;
     float rawErrorY;
@@ -30,6 +34,42 @@ struct TrackData {
     int32_t azimuth;
     int32_t elevation;
 
+    // Decode a status message as read from the card; the sync word and
+    // message type are checked by the reader
+    static TrackData fromStatusMessage(const uint16_t* statusMsg) {
+        TrackData data;
+
+        // Apply proper scaling for maximum precision (LSB = 1/32 = 0.03125)
+        // The card provides raw error values as 16-bit two's complement with scaling factor 1/32
+        data.rawErrorX = static_cast<float>(static_cast<int16_t>(statusMsg[2])) / 32.0f;
+        data.rawErrorY = static_cast<float>(static_cast<int16_t>(statusMsg[3])) / 32.0f;
+
+        // Decode word 5 (0-indexed, so word 5 is statusMsg[5])
+        data.targetPolarity = statusMsg[5] & 0x0007;
+        data.trackState = (statusMsg[5] >> 3) & 0x0007;
+        data.trackMode = (statusMsg[5] >> 8) & 0x0007;
+
+        // Extract status word
+        data.status = statusMsg[6];
+
+        // Target information
+        data.targetSizeX = statusMsg[7];
+        data.targetSizeY = statusMsg[8];
+        data.targetLeft = statusMsg[9];
+        data.targetTop = statusMsg[10];
+        data.targetPixelCount = statusMsg[11];
+
+        // Mount position (azimuth and elevation are 32-bit values)
+        data.azimuth = (statusMsg[13] << 16) | statusMsg[12];
+        data.elevation = (statusMsg[15] << 16) | statusMsg[14];
+
+        // Filtered track errors with proper scaling
+        data.filteredErrorX = static_cast<float>(static_cast<int16_t>(statusMsg[16])) / 32.0f;
+        data.filteredErrorY = static_cast<float>(static_cast<int16_t>(statusMsg[17])) / 32.0f;
+
+        return data;
+    }
+
     // Helper functions to get status as strings
     QString getPolarityString() const {
         switch (targetPolarity) {
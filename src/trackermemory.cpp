@@ -1,4 +1,5 @@
 #include "trackermemory.h"
+#include "tracelog.h"
 #include <QDebug>
 #include <unistd.h>  // For usleep
 #include <fcntl.h>   // For open flags
@@ -159,7 +160,7 @@ bool TrackerMemory::sendPing()
         return false;
     }
 
-    qDebug() << "Sending ping message...";
+    JTM_DEBUG(TraceLog::Tracker, "Sending ping message...");
 
     // Construct ping message (message type 0)
     uint16_t pingMessage[3];
@@ -170,7 +171,7 @@ bool TrackerMemory::sendPing()
     uint16_t sum = 0xA5 + 0xA5; // Sum of bytes, not words
     pingMessage[2] = (~sum) + 1;
 
-    qDebug() << "Ping message checksum:" << QString::number(pingMessage[2], 16);
+    JTM_TRACE(TraceLog::Tracker, "Ping message checksum: %x", pingMessage[2]);
 
     // Write the ping message to the command buffer
     for (int i = 0; i < 3; ++i) {
@@ -180,7 +181,7 @@ bool TrackerMemory::sendPing()
     // Write a non-zero value to the command mailbox to interrupt the tracker
     writeWord(COMMAND_MAILBOX_OFFSET, 1);
 
-    qDebug() << "Waiting for tracker to process command...";
+    JTM_TRACE(TraceLog::Tracker, "Waiting for tracker to process command...");
 
     // Wait for tracker to process (mailbox returns to 0)
     int timeout = 100; // 10 second timeout (100 * 100ms)
@@ -194,11 +195,23 @@ bool TrackerMemory::sendPing()
         return false;
     }
 
-    qDebug() << "Ping message processed by tracker";
+    JTM_DEBUG(TraceLog::Tracker, "Ping message processed by tracker");
     return true;
 }
 
 bool TrackerMemory::readStatusData(TrackData& data)
+{
+    uint16_t statusMsg[TrackData::StatusMessageWords];
+    if (!readStatusMessage(statusMsg)) {
+        return false;
+    }
+
+    // Extract data according to Figure B3.1
+    data = TrackData::fromStatusMessage(statusMsg);
+    return true;
+}
+
+bool TrackerMemory::readStatusMessage(uint16_t* statusMsg)
 {
     if (!m_initialized) {
         emit errorOccurred("Tracker memory not initialized");
@@ -211,8 +224,7 @@ bool TrackerMemory::readStatusData(TrackData& data)
     }
 
     // Read the entire status message at once (36 bytes / 18 words)
-    uint16_t statusMsg[18];
-    for (int i = 0; i < 18; ++i) {
+    for (int i = 0; i < TrackData::StatusMessageWords; ++i) {
         statusMsg[i] = readWord(STATUS_MESSAGE_OFFSET + i*2);
     }
 
@@ -220,7 +232,7 @@ bool TrackerMemory::readStatusData(TrackData& data)
     writeWord(STATUS_MAILBOX_OFFSET, 0);
 
     // Verify sync word
-    if (statusMsg[0] != 0xA5A5) {
+    if (statusMsg[0] != TrackData::StatusSyncWord) {
         emit errorOccurred("Invalid sync word in status message");
         return false;
     }
@@ -231,36 +243,6 @@ bool TrackerMemory::readStatusData(TrackData& data)
         return false;
     }
 
-    // Extract data according to Figure B3.1
-
-    // Apply proper scaling for maximum precision (LSB = 1/32 = 0.03125)
-    // The card provides raw error values as 16-bit two's complement with scaling factor 1/32
-    data.rawErrorX = static_cast<float>(static_cast<int16_t>(statusMsg[2])) / 32.0f;
-    data.rawErrorY = static_cast<float>(static_cast<int16_t>(statusMsg[3])) / 32.0f;
-
-    // Decode word 5 (0-indexed, so word 5 is statusMsg[5])
-    data.targetPolarity = statusMsg[5] & 0x0007;
-    data.trackState = (statusMsg[5] >> 3) & 0x0007;
-    data.trackMode = (statusMsg[5] >> 8) & 0x0007;
-
-    // Extract status word
-    data.status = statusMsg[6];
-
-    // Target information
-    data.targetSizeX = statusMsg[7];
-    data.targetSizeY = statusMsg[8];
-    data.targetLeft = statusMsg[9];
-    data.targetTop = statusMsg[10];
-    data.targetPixelCount = statusMsg[11];
-
-    // Mount position (azimuth and elevation are 32-bit values)
-    data.azimuth = (statusMsg[13] << 16) | statusMsg[12];
-    data.elevation = (statusMsg[15] << 16) | statusMsg[14];
-
-    // Filtered track errors with proper scaling
-    data.filteredErrorX = static_cast<float>(static_cast<int16_t>(statusMsg[16])) / 32.0f;
-    data.filteredErrorY = static_cast<float>(static_cast<int16_t>(statusMsg[17])) / 32.0f;
-
     return true;
 }
 
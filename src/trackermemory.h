@@ -23,6 +23,9 @@ public:
 
     // Read status data from the tracker
     bool readStatusData(TrackData& data);
+    // The undecoded status message, TrackData::StatusMessageWords words;
+    // TrackData::fromStatusMessage() decodes it
+    bool readStatusMessage(uint16_t* statusMsg);
 
     // Send ping to the tracker
     bool sendPing();
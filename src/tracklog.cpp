@@ -0,0 +1,296 @@
+#include "tracklog.h"
+#include "monotonicclock.h"
+#include <QtEndian>
+#include <QDebug>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const int FixedHeaderBytes = 40;
+const qint64 RecordBytes = TrackLogFormat::RecordBytes;
+
+template<typename T>
+void put(char *&p, T value)
+{
+    qToLittleEndian(value, p);
+    p += sizeof(T);
+}
+
+template<typename T>
+T get(const char *&p)
+{
+    const T value = qFromLittleEndian<T>(p);
+    p += sizeof(T);
+    return value;
+}
+
+void getRecord(const char *p, TrackLogRecord &record)
+{
+    record.sessionNs = get<qint64>(p);
+    for (uint16_t &word : record.message) {
+        word = get<quint16>(p);
+    }
+}
+
+}
+
+TrackLogWriter::TrackLogWriter()
+    : m_startWallMs(0)
+    , m_fileIndex(0)
+    , m_fd(-1)
+    , m_map(nullptr)
+    , m_mappedBytes(0)
+    , m_capacity(0)
+    , m_count(0)
+    , m_openedNs(0)
+    , m_closedBytes(0)
+{
+}
+
+TrackLogWriter::~TrackLogWriter()
+{
+    close();
+}
+
+bool TrackLogWriter::open(const QString &fileName, qint64 startWallMs, const LogFile::Options &options)
+{
+    close();
+
+    m_baseName = fileName;
+    m_options = options;
+    m_startWallMs = startWallMs;
+    m_fileIndex = 0;
+    m_count = 0;
+    m_closedBytes = 0;
+    return openFile();
+}
+
+bool TrackLogWriter::close()
+{
+    return closeFile();
+}
+
+qint64 TrackLogWriter::bytesWritten() const
+{
+    return m_closedBytes + (m_map ? TrackLogFormat::HeaderBytes + m_count * RecordBytes : 0);
+}
+
+bool TrackLogWriter::fail(const QString &what)
+{
+    m_lastError = QString("%1 %2: %3").arg(what, m_currentName, QString::fromLocal8Bit(strerror(errno)));
+    return false;
+}
+
+bool TrackLogWriter::openFile()
+{
+    ++m_fileIndex;
+    m_currentName = LogFile::rotatedName(m_baseName, m_fileIndex);
+    m_fd = ::open(QFile::encodeName(m_currentName).constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        return fail("Failed to open log file");
+    }
+
+    m_mappedBytes = 0;
+    m_count = 0;
+    m_openedNs = MonotonicClock::nowNs();
+    if (!resize(GrowBytes)) {
+        closeFile();
+        return false;
+    }
+
+    char *p = m_map;
+    std::memcpy(p, TrackLogFormat::Magic, sizeof(TrackLogFormat::Magic));
+    p += sizeof(TrackLogFormat::Magic);
+    put<quint32>(p, TrackLogFormat::Version);
+    put<quint32>(p, TrackLogFormat::HeaderBytes);
+    put<quint32>(p, RecordBytes);
+    put<quint32>(p, 0);
+    put<qint64>(p, m_startWallMs);
+    put<quint64>(p, 0);
+    return true;
+}
+
+bool TrackLogWriter::closeFile()
+{
+    if (m_fd < 0) {
+        return true;
+    }
+
+    // Dirty pages stay in the page cache after munmap; the size drops the
+    // unused part of the last step
+    bool ok = true;
+    const qint64 bytes = TrackLogFormat::HeaderBytes + m_count * RecordBytes;
+    if (m_map) {
+        munmap(m_map, m_mappedBytes);
+        m_map = nullptr;
+        if (ftruncate(m_fd, bytes) != 0) {
+            ok = fail("Failed to truncate log file");
+        }
+        m_closedBytes += bytes;
+    }
+    ::close(m_fd);
+    m_fd = -1;
+    return ok;
+}
+
+bool TrackLogWriter::resize(qint64 bytes)
+{
+    // Allocated rather than sparse, so a full disk fails here and not as a
+    // SIGBUS on a store into the mapping
+    if (fallocate(m_fd, 0, m_mappedBytes, bytes - m_mappedBytes) != 0) {
+        if ((errno != EOPNOTSUPP && errno != ENOSYS) || ftruncate(m_fd, bytes) != 0) {
+            return fail("Failed to extend log file");
+        }
+    }
+
+    void *map = m_map ? mremap(m_map, m_mappedBytes, bytes, MREMAP_MAYMOVE)
+                      : mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        return fail("Failed to map log file");
+    }
+    m_map = static_cast<char *>(map);
+    m_mappedBytes = bytes;
+    m_capacity = (bytes - TrackLogFormat::HeaderBytes) / RecordBytes;
+    return true;
+}
+
+bool TrackLogWriter::append(qint64 sessionNs, const uint16_t *message)
+{
+    if (!m_map) {
+        return false;
+    }
+    if (m_count == m_capacity && !resize(m_mappedBytes + GrowBytes)) {
+        return false;
+    }
+
+    // Copied as is: the host is little endian, like the format
+    static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "Track log records are stored in host byte order");
+    const qint64 start = TrackLogFormat::HeaderBytes + m_count * RecordBytes;
+    std::memcpy(m_map + start, &sessionNs, sizeof(sessionNs));
+    std::memcpy(m_map + start + sizeof(sessionNs), message, RecordBytes - sizeof(sessionNs));
+
+    // The record is complete before the index that covers it
+    ++m_count;
+    std::atomic_thread_fence(std::memory_order_release);
+    qToLittleEndian<quint64>(m_count, m_map + TrackLogFormat::CommitOffset);
+
+    // Limits are checked once per page of records
+    if ((start + RecordBytes) / TrackLogFormat::PageBytes != start / TrackLogFormat::PageBytes) {
+        return rotateIfDue();
+    }
+    return true;
+}
+
+bool TrackLogWriter::rotateIfDue()
+{
+    const qint64 bytes = TrackLogFormat::HeaderBytes + m_count * RecordBytes;
+    const bool full = m_options.rotateBytes > 0 && bytes >= m_options.rotateBytes;
+    const bool old = m_options.rotateNs > 0 && MonotonicClock::nowNs() - m_openedNs >= m_options.rotateNs;
+    if (!full && !old) {
+        return true;
+    }
+    return closeFile() && openFile();
+}
+
+TrackLogReader::TrackLogReader()
+    : m_startWallMs(0)
+    , m_headerBytes(0)
+    , m_records(0)
+    , m_read(0)
+{
+}
+
+bool TrackLogReader::open(const QString &fileName)
+{
+    m_file.close();
+    m_file.setFileName(fileName);
+    m_records = 0;
+    m_read = 0;
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = "Failed to open log file: " + m_file.errorString();
+        return false;
+    }
+
+    const QByteArray fixed = m_file.read(FixedHeaderBytes);
+    if (fixed.size() < FixedHeaderBytes
+        || std::memcmp(fixed.constData(), TrackLogFormat::Magic, sizeof(TrackLogFormat::Magic)) != 0) {
+        m_lastError = fileName + " is not a tracker log";
+        return false;
+    }
+
+    const char *p = fixed.constData() + sizeof(TrackLogFormat::Magic);
+    const quint32 version = get<quint32>(p);
+    m_headerBytes = get<quint32>(p);
+    const quint32 recordBytes = get<quint32>(p);
+    get<quint32>(p);
+    m_startWallMs = get<qint64>(p);
+    const quint64 committed = get<quint64>(p);
+    if (version != TrackLogFormat::Version) {
+        m_lastError = QString("Unsupported tracker log version %1").arg(version);
+        return false;
+    }
+    if (recordBytes != RecordBytes || m_headerBytes < FixedHeaderBytes) {
+        m_lastError = QString("Tracker log records of %1 bytes, expected %2").arg(recordBytes).arg(RecordBytes);
+        return false;
+    }
+
+    // A closed log ends at its last record; after a crash the file still
+    // has the zeros of the last step, and the index may be behind the data
+    const qint64 available = qMax<qint64>(0, m_file.size() - m_headerBytes) / RecordBytes;
+    m_records = qMin<qint64>(committed, available);
+    if (m_records < available) {
+        const qint64 committedRecords = m_records;
+        qint64 lastNs = 0;
+        TrackLogRecord record;
+        if (m_records > 0) {
+            m_file.seek(m_headerBytes + (m_records - 1) * RecordBytes);
+            getRecord(m_file.read(RecordBytes).constData(), record);
+            lastNs = record.sessionNs;
+        }
+        m_file.seek(m_headerBytes + m_records * RecordBytes);
+        while (m_records < available) {
+            const QByteArray bytes = m_file.read(RecordBytes);
+            if (bytes.size() != RecordBytes) {
+                break;
+            }
+            getRecord(bytes.constData(), record);
+            if (record.message[0] != TrackData::StatusSyncWord || record.sessionNs <= lastNs) {
+                break;
+            }
+            lastNs = record.sessionNs;
+            ++m_records;
+        }
+        if (m_records > committedRecords) {
+            qDebug() << "Recovered" << m_records - committedRecords << "tracker records past the commit index of"
+                     << fileName;
+        }
+    }
+
+    m_file.seek(m_headerBytes);
+    m_lastError.clear();
+    return true;
+}
+
+int TrackLogReader::read(TrackLogRecord *records, int maxRecords)
+{
+    const int count = int(qMin<qint64>(maxRecords, m_records - m_read));
+    if (count <= 0) {
+        return 0;
+    }
+    m_buffer = m_file.read(count * RecordBytes);
+    if (m_buffer.size() != count * RecordBytes) {
+        m_lastError = "Failed to read tracker log: " + m_file.errorString();
+        m_read = m_records;
+        return 0;
+    }
+    for (int i = 0; i < count; ++i) {
+        getRecord(m_buffer.constData() + i * RecordBytes, records[i]);
+    }
+    m_read += count;
+    return count;
+}
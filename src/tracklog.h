@@ -0,0 +1,132 @@
+#ifndef TRACKLOG_H
+#define TRACKLOG_H
+
+#include <QString>
+#include <QFile>
+#include <type_traits>
+#include "trackdata.h"
+#include "logfile.h"
+
+// One tracker sample: the status message exactly as the card sent it,
+// decoded only when read
+struct TrackLogRecord {
+    qint64 sessionNs;       // MonotonicClock session time it was read at
+    uint16_t message[TrackData::StatusMessageWords];
+
+    TrackData decode() const { return TrackData::fromStatusMessage(message); }
+};
+
+static_assert(std::is_trivially_copyable<TrackLogRecord>::value, "Track log records are copied as bytes");
+
+// Memory-mapped tracker log of fixed-size records (.jtmtrk).
+//
+// Each record is the session time and the raw status message, 44 bytes, so
+// nothing the card reports is lost and nothing is decoded while recording.
+// The file is sized ahead of the data in GrowBytes steps and mapped shared,
+// so logging a sample copies one record into the mapping and stores the
+// commit index; the kernel writes the pages back on its own schedule and
+// nothing waits on the disk. A crash of the process loses no committed
+// record, since the pages live on in the page cache. After a system crash
+// the file holds what had been written back, and the commit index on disk
+// may be older than the records: the reader then also takes records past
+// it for as long as they start with the sync word and their timestamps keep
+// increasing.
+//
+// Header, one page (little endian):
+//   char[8]  "JTMTRK\r\n"
+//   u32      version
+//   u32      header size in bytes; records start here
+//   u32      record size in bytes
+//   u32      reserved
+//   i64      wall-clock ms since the Unix epoch at session time 0
+//   u64      commit index: the number of complete records
+// Record (little endian):
+//   i64      session time in ns
+//   u16[18]  status message, sync word first
+class TrackLogFormat
+{
+public:
+    static constexpr char Magic[8] = {'J', 'T', 'M', 'T', 'R', 'K', '\r', '\n'};
+    static constexpr quint32 Version = 2;
+    static constexpr int HeaderBytes = 4096;
+    static constexpr int RecordBytes = 8 + 2 * TrackData::StatusMessageWords;
+    static constexpr int CommitOffset = 32;
+    static constexpr int PageBytes = 4096;
+
+    // Every decoded field, as the CSV tracker log and jtmlog2csv write them
+    static constexpr const char *CsvHeader =
+        "SessionTime(s),Timestamp,RawErrorX,RawErrorY,FilteredErrorX,FilteredErrorY,"
+        "TargetPolarity,TrackState,TrackMode,Status,TargetSizeX,TargetSizeY,"
+        "TargetLeft,TargetTop,TargetPixelCount,Azimuth,Elevation\n";
+};
+
+class TrackLogWriter
+{
+public:
+    static constexpr qint64 GrowBytes = 16 << 20;     // 25 min at 250 Hz
+
+    TrackLogWriter();
+    ~TrackLogWriter();
+
+    // Rotates at the size and age limits of options, checked as each page
+    // fills; the write size and O_DIRECT do not apply to a mapping
+    bool open(const QString &fileName, qint64 startWallMs, const LogFile::Options &options);
+    bool close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    // message holds TrackData::StatusMessageWords words
+    bool append(qint64 sessionNs, const uint16_t *message);
+
+    // All files of this run, headers included
+    qint64 bytesWritten() const;
+    int fileCount() const { return m_fileIndex; }
+    QString getLastError() const { return m_lastError; }
+
+private:
+    QString m_baseName;
+    QString m_currentName;
+    LogFile::Options m_options;
+    qint64 m_startWallMs;
+    int m_fileIndex;
+    int m_fd;
+    char *m_map;
+    qint64 m_mappedBytes;
+    qint64 m_capacity;          // Records that fit in the mapping
+    qint64 m_count;
+    qint64 m_openedNs;
+    qint64 m_closedBytes;       // Files already rotated out
+    QString m_lastError;
+
+    bool openFile();
+    bool closeFile();
+    bool resize(qint64 bytes);
+    bool rotateIfDue();
+    bool fail(const QString &what);
+};
+
+class TrackLogReader
+{
+public:
+    TrackLogReader();
+
+    bool open(const QString &fileName);
+    void close() { m_file.close(); }
+
+    qint64 startWallMs() const { return m_startWallMs; }
+    qint64 recordCount() const { return m_records; }
+
+    // Up to maxRecords of the records not read yet; 0 at the end
+    int read(TrackLogRecord *records, int maxRecords);
+    QString getLastError() const { return m_lastError; }
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    qint64 m_startWallMs;
+    qint64 m_headerBytes;
+    qint64 m_records;
+    qint64 m_read;
+    QString m_lastError;
+};
+
+#endif // TRACKLOG_H
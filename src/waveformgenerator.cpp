@@ -0,0 +1,572 @@
+#include "waveformgenerator.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 2^64, one cycle of a phase word
+const double PhaseWordScale = 18446744073709551616.0;
+
+quint64 phaseIncrement(double frequency, double sampleRate)
+{
+    const double ratio = qBound(0.0, frequency / sampleRate, 0.5);
+    return static_cast<quint64>(std::ldexp(ratio, 64));
+}
+
+quint64 phaseWord(double degrees)
+{
+    double cycles = degrees / 360.0 - std::floor(degrees / 360.0);
+    return cycles < 1.0 ? static_cast<quint64>(std::ldexp(cycles, 64)) : 0;
+}
+
+// Galois feedback masks giving maximum-length sequences for orders 2-16
+const quint16 PrbsTaps[17] = {
+    0, 0,
+    0x0003,  // 2: x^2 + x + 1
+    0x0006,  // 3
+    0x000C,  // 4
+    0x0014,  // 5
+    0x0030,  // 6
+    0x0060,  // 7
+    0x00B8,  // 8
+    0x0110,  // 9
+    0x0240,  // 10
+    0x0500,  // 11
+    0x0829,  // 12
+    0x100D,  // 13
+    0x2015,  // 14
+    0x6000,  // 15
+    0xD008   // 16
+};
+
+// Settings that give two generators of a shape the same storage
+bool sameSettings(const WaveformSettings &a, const WaveformSettings &b)
+{
+    return a.shape == b.shape && a.frequency == b.frequency && a.amplitude == b.amplitude
+        && a.phaseOffset == b.phaseOffset && a.xEnabled == b.xEnabled && a.yEnabled == b.yEnabled
+        && a.endFrequency == b.endFrequency && a.sweepSeconds == b.sweepSeconds
+        && a.toneCount == b.toneCount && a.prbsOrder == b.prbsOrder;
+}
+
+}
+
+// WaveformGenerator
+
+WaveformGenerator::WaveformGenerator(const WaveformSettings &settings, double sampleRate)
+    : m_settings(settings)
+    , m_sampleRate(sampleRate > 0.0 ? sampleRate : 1000.0)
+    , m_blockPos(BlockSize)
+{
+}
+
+WaveformGenerator::~WaveformGenerator()
+{
+}
+
+WaveformGenerator *WaveformGenerator::create(const WaveformSettings &settings, double sampleRate)
+{
+    switch (settings.shape) {
+    case WaveformShape::Sine:
+        return new SineGenerator(settings, sampleRate);
+    case WaveformShape::Square:
+    case WaveformShape::Triangle:
+    case WaveformShape::Step:
+        return new PeriodicShapeGenerator(settings, sampleRate);
+    case WaveformShape::Chirp:
+        return new ChirpGenerator(settings, sampleRate);
+    case WaveformShape::Multisine:
+        return new MultisineGenerator(settings, sampleRate);
+    case WaveformShape::Prbs:
+        return new PrbsGenerator(settings, sampleRate);
+    }
+    return nullptr;
+}
+
+QString WaveformGenerator::shapeName(WaveformShape shape)
+{
+    switch (shape) {
+    case WaveformShape::Sine:
+        return "Sine";
+    case WaveformShape::Square:
+        return "Square";
+    case WaveformShape::Triangle:
+        return "Triangle";
+    case WaveformShape::Step:
+        return "Step";
+    case WaveformShape::Chirp:
+        return "Chirp";
+    case WaveformShape::Multisine:
+        return "Multisine";
+    case WaveformShape::Prbs:
+        return "PRBS";
+    }
+    return QString();
+}
+
+void WaveformGenerator::configure(const WaveformSettings &settings)
+{
+    if (settings.shape != m_settings.shape) {
+        return;
+    }
+    discardBlock();
+    m_settings = settings;
+    applySettings();
+}
+
+bool WaveformGenerator::copyState(const WaveformGenerator &other)
+{
+    if (&other == this) {
+        return true;
+    }
+    if (!sameSettings(other.m_settings, m_settings) || other.m_sampleRate != m_sampleRate) {
+        return false;
+    }
+    std::copy(other.m_blockX, other.m_blockX + BlockSize, m_blockX);
+    std::copy(other.m_blockY, other.m_blockY + BlockSize, m_blockY);
+    m_blockPos = other.m_blockPos;
+    copyShapeState(other);
+    return true;
+}
+
+void WaveformGenerator::setSampleRate(double sampleRate)
+{
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    discardBlock();
+    m_sampleRate = sampleRate;
+    applySettings();
+}
+
+void WaveformGenerator::reset()
+{
+    m_blockPos = BlockSize;
+    restart();
+}
+
+void WaveformGenerator::generate(double *x, double *y, int count)
+{
+    discardBlock();
+    synthesize(x, y, count);
+
+    if (!m_settings.xEnabled) {
+        std::fill(x, x + count, 0.0);
+    }
+    if (!m_settings.yEnabled) {
+        std::fill(y, y + count, 0.0);
+    }
+}
+
+void WaveformGenerator::advance(qint64 samples)
+{
+    discardBlock();
+    skip(samples);
+}
+
+void WaveformGenerator::next(double *x, double *y)
+{
+    if (m_blockPos == BlockSize) {
+        generate(m_blockX, m_blockY, BlockSize);
+        m_blockPos = 0;
+    }
+    *x = m_blockX[m_blockPos];
+    *y = m_blockY[m_blockPos];
+    ++m_blockPos;
+}
+
+void WaveformGenerator::discardBlock()
+{
+    // Go back over the samples next() synthesized but never handed out
+    if (m_blockPos < BlockSize) {
+        skip(m_blockPos - BlockSize);
+        m_blockPos = BlockSize;
+    }
+}
+
+// SineGenerator
+
+SineGenerator::SineGenerator(const WaveformSettings &settings, double sampleRate)
+    : WaveformGenerator(settings, sampleRate)
+    , m_nco(sampleRate)
+{
+    applySettings();
+}
+
+void SineGenerator::applySettings()
+{
+    m_nco.setSampleRate(sampleRate());
+    m_nco.setFrequency(settings().frequency);
+    m_nco.setAmplitude(settings().amplitude);
+    m_nco.setPhaseOffset(settings().phaseOffset);
+}
+
+void SineGenerator::restart()
+{
+    m_nco.reset();
+}
+
+void SineGenerator::synthesize(double *x, double *y, int count)
+{
+    m_nco.generate(x, y, count);
+}
+
+void SineGenerator::skip(qint64 samples)
+{
+    m_nco.advance(samples);
+}
+
+void SineGenerator::copyShapeState(const WaveformGenerator &other)
+{
+    m_nco = static_cast<const SineGenerator &>(other).m_nco;
+}
+
+// PeriodicShapeGenerator
+
+PeriodicShapeGenerator::PeriodicShapeGenerator(const WaveformSettings &settings, double sampleRate)
+    : WaveformGenerator(settings, sampleRate)
+    , m_phase(0)
+    , m_increment(0)
+    , m_offset(0)
+{
+    applySettings();
+}
+
+void PeriodicShapeGenerator::applySettings()
+{
+    m_increment = phaseIncrement(settings().frequency, sampleRate());
+    m_offset = phaseWord(settings().phaseOffset);
+}
+
+void PeriodicShapeGenerator::restart()
+{
+    m_phase = 0;
+}
+
+void PeriodicShapeGenerator::synthesize(double *x, double *y, int count)
+{
+    const double amplitude = settings().amplitude;
+    quint64 phase = m_phase;
+
+    // One loop per shape keeps the branch out of the per-sample path
+    switch (shape()) {
+    case WaveformShape::Square:
+        // Same sign as a sine of the same phase
+        for (int i = 0; i < count; ++i) {
+            x[i] = (phase >> 63) ? -amplitude : amplitude;
+            y[i] = ((phase + m_offset) >> 63) ? -amplitude : amplitude;
+            phase += m_increment;
+        }
+        break;
+    case WaveformShape::Triangle: {
+        // Starts at zero rising, peaks a quarter period in, like a sine
+        const quint64 quarter = static_cast<quint64>(1) << 62;
+        const double scale = 4.0 * amplitude / PhaseWordScale;
+        for (int i = 0; i < count; ++i) {
+            qint64 xp = static_cast<qint64>(phase - quarter);
+            qint64 yp = static_cast<qint64>(phase + m_offset - quarter);
+            x[i] = amplitude - scale * std::fabs(static_cast<double>(xp));
+            y[i] = amplitude - scale * std::fabs(static_cast<double>(yp));
+            phase += m_increment;
+        }
+        break;
+    }
+    default:
+        // Step: rest for half a period, then hold the amplitude
+        for (int i = 0; i < count; ++i) {
+            x[i] = (phase >> 63) ? amplitude : 0.0;
+            y[i] = ((phase + m_offset) >> 63) ? amplitude : 0.0;
+            phase += m_increment;
+        }
+        break;
+    }
+
+    m_phase = phase;
+}
+
+void PeriodicShapeGenerator::skip(qint64 samples)
+{
+    m_phase += static_cast<quint64>(samples) * m_increment;
+}
+
+void PeriodicShapeGenerator::copyShapeState(const WaveformGenerator &other)
+{
+    const PeriodicShapeGenerator &source = static_cast<const PeriodicShapeGenerator &>(other);
+    m_phase = source.m_phase;
+    m_increment = source.m_increment;
+    m_offset = source.m_offset;
+}
+
+// ChirpGenerator
+
+ChirpGenerator::ChirpGenerator(const WaveformSettings &settings, double sampleRate)
+    : WaveformGenerator(settings, sampleRate)
+    , m_sample(0)
+    , m_sweepFrames(1)
+    , m_startCycles(0.0)
+    , m_rampCycles(0.0)
+    , m_offsetCos(1.0)
+    , m_offsetSin(0.0)
+{
+    applySettings();
+}
+
+void ChirpGenerator::applySettings()
+{
+    const double rate = sampleRate();
+    const double nyquist = 0.5 * rate;
+    const double start = qBound(0.0, settings().frequency, nyquist) / rate;
+    const double end = qBound(0.0, settings().endFrequency, nyquist) / rate;
+
+    m_sweepFrames = qMax<qint64>(1, qRound64(settings().sweepSeconds * rate));
+    m_startCycles = start;
+    m_rampCycles = (end - start) / (2.0 * m_sweepFrames);
+
+    const double offset = qDegreesToRadians(settings().phaseOffset);
+    m_offsetCos = std::cos(offset);
+    m_offsetSin = std::sin(offset);
+
+    // A new sweep starts with the new parameters
+    m_sample = 0;
+}
+
+void ChirpGenerator::restart()
+{
+    m_sample = 0;
+}
+
+void ChirpGenerator::synthesize(double *x, double *y, int count)
+{
+    const double amplitude = settings().amplitude;
+    const double yFromSin = amplitude * m_offsetCos;
+    const double yFromCos = amplitude * m_offsetSin;
+
+    for (int i = 0; i < count; ++i) {
+        // Phase from the position in the sweep, so it never accumulates error
+        const double n = static_cast<double>(m_sample);
+        double cycles = n * (m_startCycles + m_rampCycles * n);
+        cycles -= std::floor(cycles);
+        const double theta = 2.0 * M_PI * cycles;
+        const double s = std::sin(theta);
+        const double c = std::cos(theta);
+        x[i] = amplitude * s;
+        y[i] = yFromSin * s + yFromCos * c;
+
+        if (++m_sample == m_sweepFrames) {
+            m_sample = 0;
+        }
+    }
+}
+
+void ChirpGenerator::skip(qint64 samples)
+{
+    m_sample = (m_sample + samples) % m_sweepFrames;
+    if (m_sample < 0) {
+        m_sample += m_sweepFrames;
+    }
+}
+
+void ChirpGenerator::copyShapeState(const WaveformGenerator &other)
+{
+    const ChirpGenerator &source = static_cast<const ChirpGenerator &>(other);
+    m_sample = source.m_sample;
+    m_sweepFrames = source.m_sweepFrames;
+    m_startCycles = source.m_startCycles;
+    m_rampCycles = source.m_rampCycles;
+    m_offsetCos = source.m_offsetCos;
+    m_offsetSin = source.m_offsetSin;
+}
+
+// MultisineGenerator
+
+MultisineGenerator::MultisineGenerator(const WaveformSettings &settings, double sampleRate)
+    : WaveformGenerator(settings, sampleRate)
+    , m_scale(1.0)
+{
+    applySettings();
+}
+
+void MultisineGenerator::applySettings()
+{
+    const int tones = qBound(1, settings().toneCount, MaxTones);
+    const bool rebuild = tones != m_tones.size();
+    if (rebuild) {
+        m_tones.resize(tones);
+        updateScale();
+    }
+
+    // Harmonics above 0.45 fs are left silent rather than aliased
+    for (int k = 0; k < tones; ++k) {
+        const int harmonic = k + 1;
+        const double frequency = harmonic * settings().frequency;
+        Nco &tone = m_tones[k];
+        tone.setSampleRate(sampleRate());
+        tone.setFrequency(frequency);
+        tone.setAmplitude(frequency < 0.45 * sampleRate() ? settings().amplitude * m_scale : 0.0);
+
+        // The Y axis is the X signal shifted in time, so each harmonic moves
+        // by its multiple of the fundamental's offset
+        tone.setPhaseOffset(harmonic * settings().phaseOffset);
+    }
+
+    if (rebuild) {
+        restart();
+    }
+}
+
+void MultisineGenerator::restart()
+{
+    // Schroeder phases keep the crest factor low
+    const int tones = m_tones.size();
+    for (int k = 0; k < tones; ++k) {
+        const int harmonic = k + 1;
+        m_tones[k].reset(-180.0 * harmonic * (harmonic - 1) / tones);
+    }
+}
+
+void MultisineGenerator::synthesize(double *x, double *y, int count)
+{
+    for (int done = 0; done < count; ) {
+        const int n = qMin(count - done, static_cast<int>(BlockSize));
+        double *xOut = x + done;
+        double *yOut = y + done;
+        std::fill(xOut, xOut + n, 0.0);
+        std::fill(yOut, yOut + n, 0.0);
+
+        for (Nco &tone : m_tones) {
+            tone.generate(m_toneX, m_toneY, n);
+            for (int i = 0; i < n; ++i) {
+                xOut[i] += m_toneX[i];
+                yOut[i] += m_toneY[i];
+            }
+        }
+        done += n;
+    }
+}
+
+void MultisineGenerator::skip(qint64 samples)
+{
+    for (Nco &tone : m_tones) {
+        tone.advance(samples);
+    }
+}
+
+void MultisineGenerator::copyShapeState(const WaveformGenerator &other)
+{
+    // Tone by tone: assigning the vector would share it with other, and the
+    // first write would then detach in the loop
+    const MultisineGenerator &source = static_cast<const MultisineGenerator &>(other);
+    Q_ASSERT(source.m_tones.size() == m_tones.size());
+    Nco *tones = m_tones.data();
+    for (int k = 0; k < m_tones.size(); ++k) {
+        tones[k] = source.m_tones.at(k);
+    }
+    m_scale = source.m_scale;
+}
+
+void MultisineGenerator::updateScale()
+{
+    // Peak of the unit-amplitude sum over one fundamental period
+    const int tones = m_tones.size();
+    const int points = 256 * tones;
+    double peak = 0.0;
+    for (int i = 0; i < points; ++i) {
+        const double t = static_cast<double>(i) / points;
+        double sum = 0.0;
+        for (int k = 1; k <= tones; ++k) {
+            const double phase = -M_PI * k * (k - 1) / tones;
+            sum += std::sin(2.0 * M_PI * k * t + phase);
+        }
+        peak = qMax(peak, std::fabs(sum));
+    }
+    m_scale = peak > 0.0 ? 1.0 / peak : 1.0;
+}
+
+// PrbsGenerator
+
+PrbsGenerator::PrbsGenerator(const WaveformSettings &settings, double sampleRate)
+    : WaveformGenerator(settings, sampleRate)
+    , m_order(0)
+    , m_sample(0)
+    , m_chipBase(0)
+    , m_chipsPerSample(0.0)
+{
+    applySettings();
+}
+
+void PrbsGenerator::applySettings()
+{
+    const int order = qBound(2, settings().prbsOrder, 16);
+    if (order != m_order) {
+        m_order = order;
+        buildSequence();
+        m_sample = 0;
+        m_chipBase = 0;
+    } else {
+        // Carry on from the current chip at the new rate
+        m_chipBase = chipAt(m_sample);
+        m_sample = 0;
+    }
+    m_chipsPerSample = qBound(0.0, settings().frequency / sampleRate(), 1.0);
+}
+
+void PrbsGenerator::restart()
+{
+    m_sample = 0;
+    m_chipBase = 0;
+}
+
+int PrbsGenerator::chipAt(qint64 sample) const
+{
+    const qint64 length = m_sequence.size();
+    qint64 chip = (m_chipBase + static_cast<qint64>(std::floor(sample * m_chipsPerSample))) % length;
+    return static_cast<int>(chip < 0 ? chip + length : chip);
+}
+
+void PrbsGenerator::synthesize(double *x, double *y, int count)
+{
+    const double amplitude = settings().amplitude;
+    const int length = m_sequence.size();
+    const int yShift = length / 2;  // Near-zero correlation with X
+    const qint8 *sequence = m_sequence.constData();
+
+    for (int i = 0; i < count; ++i) {
+        const int chip = chipAt(m_sample + i);
+        int yChip = chip + yShift;
+        if (yChip >= length) {
+            yChip -= length;
+        }
+        x[i] = amplitude * sequence[chip];
+        y[i] = amplitude * sequence[yChip];
+    }
+    m_sample += count;
+}
+
+void PrbsGenerator::skip(qint64 samples)
+{
+    m_sample += samples;
+}
+
+void PrbsGenerator::copyShapeState(const WaveformGenerator &other)
+{
+    // The same order built the same sequence, so only the position moves
+    const PrbsGenerator &source = static_cast<const PrbsGenerator &>(other);
+    m_order = source.m_order;
+    m_sample = source.m_sample;
+    m_chipBase = source.m_chipBase;
+    m_chipsPerSample = source.m_chipsPerSample;
+}
+
+void PrbsGenerator::buildSequence()
+{
+    // Galois LFSR, any non-zero seed runs through all 2^n - 1 states
+    const int length = (1 << m_order) - 1;
+    const quint32 taps = PrbsTaps[m_order];
+    m_sequence.resize(length);
+
+    quint32 state = 1;
+    for (int i = 0; i < length; ++i) {
+        m_sequence[i] = (state & 1) ? 1 : -1;
+        state = (state & 1) ? (state >> 1) ^ taps : state >> 1;
+    }
+}
@@ -0,0 +1,220 @@
+#ifndef WAVEFORMGENERATOR_H
+#define WAVEFORMGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include "nco.h"
+
+enum class WaveformShape {
+    Sine,
+    Square,
+    Triangle,
+    Step,       // 0 for the first half period, amplitude for the second
+    Chirp,      // Linear sweep from frequency to endFrequency, repeated
+    Multisine,  // Harmonics 1..toneCount of frequency, Schroeder phases
+    Prbs        // Maximum-length sequence, frequency is the chip rate
+};
+
+struct WaveformSettings {
+    WaveformShape shape;
+    double frequency;     // Hz (chirp start, multisine fundamental, PRBS chip rate)
+    double amplitude;     // Normalized, 0.0 to 1.0
+    double phaseOffset;   // Degrees of the fundamental; Y leads X
+    bool xEnabled;
+    bool yEnabled;
+    double endFrequency;  // Chirp
+    double sweepSeconds;  // Chirp
+    int toneCount;        // Multisine
+    int prbsOrder;        // PRBS register length, 2-16
+
+    WaveformSettings()
+        : shape(WaveformShape::Sine)
+        , frequency(10.0)
+        , amplitude(0.5)
+        , phaseOffset(90.0)
+        , xEnabled(true)
+        , yEnabled(true)
+        , endFrequency(100.0)
+        , sweepSeconds(10.0)
+        , toneCount(8)
+        , prbsOrder(10)
+    {
+    }
+};
+
+// Block generator for the X/Y test waveforms.
+//
+// Shapes are created through create() and then driven with generate() for
+// buffered output or next() for one sample per output cycle. Neither
+// allocates; memory is only taken in create() and configure(), so a
+// generator can run inside the output loop. configure() keeps the phase
+// where the shape allows it (periodic shapes and multisine); a chirp
+// restarts its sweep.
+//
+// configure() may allocate and, for multisine and PRBS, take milliseconds,
+// so a generator that is running somewhere else is not configured in
+// place: create() one with the same settings, copyState() from the running
+// one, configure the copy and swap it in.
+class WaveformGenerator
+{
+public:
+    static constexpr int BlockSize = Nco::BlockSize;
+
+    virtual ~WaveformGenerator();
+
+    static WaveformGenerator *create(const WaveformSettings &settings, double sampleRate);
+    static QString shapeName(WaveformShape shape);
+
+    WaveformShape shape() const { return m_settings.shape; }
+    const WaveformSettings &settings() const { return m_settings; }
+    double sampleRate() const { return m_sampleRate; }
+
+    // The shape must stay the same; create a new generator to change it
+    void configure(const WaveformSettings &settings);
+
+    // Continue from where other is. It must have the same shape, settings
+    // and sample rate, so only values are copied and nothing is allocated.
+    // Returns false, leaving this generator as it was, when they differ.
+    bool copyState(const WaveformGenerator &other);
+
+    void setSampleRate(double sampleRate);
+    void reset();
+
+    // Synthesize count samples per axis. Disabled axes read 0.
+    void generate(double *x, double *y, int count);
+
+    // Skip samples, negative to go back
+    void advance(qint64 samples);
+
+    // One sample, served from an internal block
+    void next(double *x, double *y);
+
+protected:
+    WaveformGenerator(const WaveformSettings &settings, double sampleRate);
+
+    // Shape hooks. settings() and sampleRate() already hold the new values
+    // when applySettings() runs.
+    virtual void applySettings() = 0;
+    virtual void restart() = 0;
+    virtual void synthesize(double *x, double *y, int count) = 0;
+    virtual void skip(qint64 samples) = 0;
+
+    // Copy the shape's own state from other, which is the same class
+    virtual void copyShapeState(const WaveformGenerator &other) = 0;
+
+private:
+    WaveformSettings m_settings;
+    double m_sampleRate;
+
+    double m_blockX[BlockSize];
+    double m_blockY[BlockSize];
+    int m_blockPos;
+
+    void discardBlock();
+};
+
+class SineGenerator : public WaveformGenerator
+{
+public:
+    SineGenerator(const WaveformSettings &settings, double sampleRate);
+
+protected:
+    void applySettings() override;
+    void restart() override;
+    void synthesize(double *x, double *y, int count) override;
+    void skip(qint64 samples) override;
+    void copyShapeState(const WaveformGenerator &other) override;
+
+private:
+    Nco m_nco;
+};
+
+// Square, triangle and step: a shape function of the phase word
+class PeriodicShapeGenerator : public WaveformGenerator
+{
+public:
+    PeriodicShapeGenerator(const WaveformSettings &settings, double sampleRate);
+
+protected:
+    void applySettings() override;
+    void restart() override;
+    void synthesize(double *x, double *y, int count) override;
+    void skip(qint64 samples) override;
+    void copyShapeState(const WaveformGenerator &other) override;
+
+private:
+    quint64 m_phase;
+    quint64 m_increment;
+    quint64 m_offset;
+};
+
+class ChirpGenerator : public WaveformGenerator
+{
+public:
+    ChirpGenerator(const WaveformSettings &settings, double sampleRate);
+
+protected:
+    void applySettings() override;
+    void restart() override;
+    void synthesize(double *x, double *y, int count) override;
+    void skip(qint64 samples) override;
+    void copyShapeState(const WaveformGenerator &other) override;
+
+private:
+    qint64 m_sample;       // Position within the sweep
+    qint64 m_sweepFrames;
+    // Cycles completed after n samples: m_startCycles n + m_rampCycles n^2
+    double m_startCycles;
+    double m_rampCycles;
+    double m_offsetCos;
+    double m_offsetSin;
+};
+
+class MultisineGenerator : public WaveformGenerator
+{
+public:
+    MultisineGenerator(const WaveformSettings &settings, double sampleRate);
+
+    static constexpr int MaxTones = 32;
+
+protected:
+    void applySettings() override;
+    void restart() override;
+    void synthesize(double *x, double *y, int count) override;
+    void skip(qint64 samples) override;
+    void copyShapeState(const WaveformGenerator &other) override;
+
+private:
+    QVector<Nco> m_tones;
+    double m_scale;        // Brings the summed peak to 1.0
+    double m_toneX[BlockSize];
+    double m_toneY[BlockSize];
+
+    void updateScale();
+};
+
+class PrbsGenerator : public WaveformGenerator
+{
+public:
+    PrbsGenerator(const WaveformSettings &settings, double sampleRate);
+
+protected:
+    void applySettings() override;
+    void restart() override;
+    void synthesize(double *x, double *y, int count) override;
+    void skip(qint64 samples) override;
+    void copyShapeState(const WaveformGenerator &other) override;
+
+private:
+    QVector<qint8> m_sequence;  // One period of +1/-1 chips
+    int m_order;
+    qint64 m_sample;            // Samples since m_chipBase
+    qint64 m_chipBase;
+    double m_chipsPerSample;
+
+    int chipAt(qint64 sample) const;
+
+    void buildSequence();
+};
+
+#endif // WAVEFORMGENERATOR_H
@@ -0,0 +1,496 @@
+#include "xyscopewidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QScreen>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+// How often the renderer looks for new history, and fades the image
+const unsigned long PollIntervalMs = 5;
+const qint64 FadeIntervalMs = 40;
+
+// A fit spans enough revolutions to hold at least this many frames
+const int MinFitFrames = 32;
+
+const QRgb BackgroundColor = qRgb(0, 0, 0);
+const QRgb CommandColor = qRgb(0, 200, 0);
+const QRgb FeedbackColor = qRgb(255, 220, 0);
+
+double wrapDegrees(double degrees)
+{
+    degrees = std::fmod(degrees, 360.0);
+    if (degrees > 180.0) {
+        degrees -= 360.0;
+    } else if (degrees <= -180.0) {
+        degrees += 360.0;
+    }
+    return degrees;
+}
+
+}
+
+XyScopeRenderer::XyScopeRenderer(QObject *parent)
+    : QThread(parent)
+    , m_history(HistoryCapacityLog2)
+    , m_settingsChanged(true)
+    , m_clearRequested(false)
+    , m_clearIndex(0)
+    , m_shouldStop(false)
+    , m_dirty(false)
+    , m_readIndex(0)
+    , m_haveCommand(false)
+    , m_haveFeedback(false)
+    , m_revolutionPosition(0.0)
+    , m_revolutionsPerFit(1)
+{
+    m_requested.width = 0;
+    m_requested.height = 0;
+    m_requested.minimum = -10.0;
+    m_requested.maximum = 10.0;
+    m_requested.sampleRate = 1000.0;
+    m_requested.frequency = 0.0;
+    m_requested.persistence = 1.0;
+    m_settings = m_requested;
+    m_fit = Fit();
+}
+
+XyScopeRenderer::~XyScopeRenderer()
+{
+    stop();
+}
+
+void XyScopeRenderer::stop()
+{
+    {
+        QMutexLocker locker(&m_inputMutex);
+        m_shouldStop = true;
+        m_inputCondition.wakeOne();
+    }
+    wait();
+}
+
+void XyScopeRenderer::setGeometry(int width, int height)
+{
+    QMutexLocker locker(&m_inputMutex);
+    m_requested.width = qMax(0, width);
+    m_requested.height = qMax(0, height);
+    m_settingsChanged = true;
+    m_inputCondition.wakeOne();
+}
+
+void XyScopeRenderer::setRange(double minimum, double maximum)
+{
+    QMutexLocker locker(&m_inputMutex);
+    if (maximum > minimum) {
+        m_requested.minimum = minimum;
+        m_requested.maximum = maximum;
+        m_settingsChanged = true;
+        m_inputCondition.wakeOne();
+    }
+}
+
+void XyScopeRenderer::setSampleRate(double sampleRate)
+{
+    QMutexLocker locker(&m_inputMutex);
+    if (sampleRate > 0.0 && sampleRate != m_requested.sampleRate) {
+        m_requested.sampleRate = sampleRate;
+        m_settingsChanged = true;
+        m_inputCondition.wakeOne();
+    }
+}
+
+void XyScopeRenderer::setFrequency(double frequency)
+{
+    QMutexLocker locker(&m_inputMutex);
+    if (frequency != m_requested.frequency) {
+        m_requested.frequency = qMax(0.0, frequency);
+        m_settingsChanged = true;
+        m_inputCondition.wakeOne();
+    }
+}
+
+void XyScopeRenderer::setPersistence(double seconds)
+{
+    QMutexLocker locker(&m_inputMutex);
+    m_requested.persistence = qMax(0.0, seconds);
+    m_settingsChanged = true;
+    m_inputCondition.wakeOne();
+}
+
+void XyScopeRenderer::clear()
+{
+    // Called while nothing is producing, so everything written so far is old
+    QMutexLocker locker(&m_inputMutex);
+    m_clearIndex = m_history.written();
+    m_clearRequested = true;
+    m_inputCondition.wakeOne();
+}
+
+QPointF XyScopeRenderer::toPixel(int width, int height, double minimum, double maximum, double x, double y)
+{
+    // Square plot in the middle of the image, Y up
+    const double scale = 0.95 * qMin(width, height) / (maximum - minimum);
+    const double middle = 0.5 * (minimum + maximum);
+    return QPointF(0.5 * width + (x - middle) * scale, 0.5 * height - (y - middle) * scale);
+}
+
+void XyScopeRenderer::run()
+{
+    m_fadeTimer.start();
+    while (true) {
+        Settings settings;
+        bool settingsChanged = false;
+        bool clearRequested = false;
+        quint64 clearIndex = 0;
+        {
+            // The producer never signals; poll a few times per display frame
+            QMutexLocker locker(&m_inputMutex);
+            if (!m_settingsChanged && !m_clearRequested && !m_shouldStop) {
+                m_inputCondition.wait(&m_inputMutex, PollIntervalMs);
+            }
+            if (m_shouldStop) {
+                break;
+            }
+            settings = m_requested;
+            settingsChanged = m_settingsChanged;
+            clearRequested = m_clearRequested;
+            clearIndex = m_clearIndex;
+            m_settingsChanged = false;
+            m_clearRequested = false;
+        }
+
+        QMutexLocker imageLocker(&m_imageMutex);
+        bool drawn = false;
+        if (settingsChanged) {
+            applySettings(settings);
+            drawn = true;
+        }
+        if (clearRequested) {
+            m_readIndex = qMax(m_readIndex, clearIndex);
+            m_fit = Fit();
+            if (!m_image.isNull()) {
+                m_image.fill(BackgroundColor);
+            }
+            m_haveCommand = false;
+            m_haveFeedback = false;
+            restartFit();
+            drawn = true;
+        }
+        drawn |= drawNewFrames();
+        if (m_settings.persistence > 0.0 && m_fadeTimer.elapsed() >= FadeIntervalMs) {
+            fade();
+            drawn = true;
+        }
+        imageLocker.unlock();
+
+        if (drawn) {
+            m_dirty.store(true, std::memory_order_release);
+        }
+    }
+}
+
+void XyScopeRenderer::applySettings(const Settings &settings)
+{
+    const bool resized = settings.width != m_settings.width || settings.height != m_settings.height;
+    const bool rescaled = settings.minimum != m_settings.minimum || settings.maximum != m_settings.maximum;
+    if (resized) {
+        if (settings.width > 0 && settings.height > 0) {
+            m_image = QImage(settings.width, settings.height, QImage::Format_RGB32);
+        } else {
+            m_image = QImage();
+        }
+    }
+    if ((resized || rescaled) && !m_image.isNull()) {
+        // Old points are in the wrong place now; start the trace over
+        m_image.fill(BackgroundColor);
+        m_haveCommand = false;
+        m_haveFeedback = false;
+    }
+
+    const bool refit = settings.frequency != m_settings.frequency || settings.sampleRate != m_settings.sampleRate;
+    m_settings = settings;
+    if (refit) {
+        restartFit();
+    }
+}
+
+void XyScopeRenderer::restartFit()
+{
+    m_commandFit.reset();
+    m_feedbackFit.reset();
+    m_revolutionPosition = 0.0;
+
+    const double framesPerRevolution = m_settings.frequency > 0.0
+        ? m_settings.sampleRate / m_settings.frequency : 0.0;
+    m_revolutionsPerFit = framesPerRevolution > 0.0
+        ? qMax(1, static_cast<int>(std::ceil(MinFitFrames / framesPerRevolution))) : 1;
+}
+
+bool XyScopeRenderer::drawNewFrames()
+{
+    const quint64 written = m_history.written();
+    quint64 first = qMax(m_readIndex, m_history.oldest(written));
+    if (first >= written) {
+        return false;
+    }
+
+    // Too far behind to catch up safely: skip to the newest half of the ring,
+    // the fit starts over since revolutions were lost
+    const quint64 limit = m_history.readable() / 2;
+    if (written - first > limit || first > m_readIndex) {
+        first = qMax(first, written - qMin(written, limit));
+        m_haveCommand = false;
+        m_haveFeedback = false;
+        restartFit();
+    }
+
+    const XyFrame *a = nullptr;
+    const XyFrame *b = nullptr;
+    int countA = 0;
+    int countB = 0;
+    m_history.segments(first, static_cast<int>(written - first), &a, &countA, &b, &countB);
+    processFrames(a, countA);
+    processFrames(b, countB);
+    if (!m_history.isIntact(first)) {
+        qDebug() << "XY scope history overran while drawing";
+    }
+
+    m_readIndex = written;
+    return true;
+}
+
+void XyScopeRenderer::processFrames(const XyFrame *frames, int count)
+{
+    const int width = m_settings.width;
+    const int height = m_settings.height;
+    const double revolutionsPerFrame = m_settings.frequency / m_settings.sampleRate;
+
+    for (int i = 0; i < count; ++i) {
+        const XyFrame &frame = frames[i];
+        const bool haveFeedback = !std::isnan(frame.xFeedback) && !std::isnan(frame.yFeedback);
+
+        if (!m_image.isNull()) {
+            const QPointF command = toPixel(width, height, m_settings.minimum, m_settings.maximum,
+                                            frame.xCommand, frame.yCommand);
+            drawLine(m_haveCommand ? m_lastCommand : command, command, CommandColor);
+            m_lastCommand = command;
+            m_haveCommand = true;
+
+            if (haveFeedback) {
+                const QPointF feedback = toPixel(width, height, m_settings.minimum, m_settings.maximum,
+                                                 frame.xFeedback, frame.yFeedback);
+                drawLine(m_haveFeedback ? m_lastFeedback : feedback, feedback, FeedbackColor);
+                m_lastFeedback = feedback;
+            }
+            m_haveFeedback = haveFeedback;
+        }
+
+        if (revolutionsPerFrame <= 0.0) {
+            continue;
+        }
+        m_commandFit.add(frame.xCommand, frame.yCommand);
+        if (haveFeedback) {
+            m_feedbackFit.add(frame.xFeedback, frame.yFeedback);
+        }
+        m_revolutionPosition += revolutionsPerFrame;
+        if (m_revolutionPosition >= m_revolutionsPerFit) {
+            m_fit.command = m_commandFit.result();
+            m_fit.feedback = m_feedbackFit.result();
+            m_fit.revolutions += m_revolutionsPerFit;
+            m_commandFit.reset();
+            m_feedbackFit.reset();
+            m_revolutionPosition -= m_revolutionsPerFit;
+        }
+    }
+}
+
+void XyScopeRenderer::drawLine(const QPointF &from, const QPointF &to, QRgb color)
+{
+    const double dx = to.x() - from.x();
+    const double dy = to.y() - from.y();
+    const int steps = static_cast<int>(std::ceil(qMax(std::abs(dx), std::abs(dy))));
+    const int width = m_image.width();
+    const int height = m_image.height();
+    for (int step = 0; step <= steps; ++step) {
+        const double t = steps > 0 ? double(step) / steps : 1.0;
+        const int x = static_cast<int>(from.x() + t * dx);
+        const int y = static_cast<int>(from.y() + t * dy);
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            reinterpret_cast<QRgb *>(m_image.scanLine(y))[x] = color;
+        }
+    }
+}
+
+void XyScopeRenderer::fade()
+{
+    const double elapsed = m_fadeTimer.restart() / 1000.0;
+    if (m_image.isNull()) {
+        return;
+    }
+
+    // Scale every channel by exp(-t/tau) in 8-bit fixed point; rounding
+    // down lets even dim points reach black
+    const int factor = static_cast<int>(256.0 * std::exp(-elapsed / m_settings.persistence));
+    const int height = m_image.height();
+    const int width = m_image.width();
+    for (int row = 0; row < height; ++row) {
+        QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(row));
+        for (int column = 0; column < width; ++column) {
+            const QRgb pixel = line[column];
+            if (pixel != BackgroundColor) {
+                line[column] = qRgb((qRed(pixel) * factor) >> 8, (qGreen(pixel) * factor) >> 8,
+                                    (qBlue(pixel) * factor) >> 8);
+            }
+        }
+    }
+}
+
+XyScopeWidget::XyScopeWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_refreshTimer(new QTimer(this))
+    , m_minimum(-10.0)
+    , m_maximum(10.0)
+{
+    setMinimumSize(250, 250);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    m_renderer.start();
+
+    // Repaint at the display rate; data may arrive much more often
+    double refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    m_refreshTimer->setTimerType(Qt::PreciseTimer);
+    m_refreshTimer->setInterval(qMax(4, static_cast<int>(1000.0 / qMax(1.0, refreshRate))));
+    connect(m_refreshTimer, &QTimer::timeout, this, &XyScopeWidget::onRefresh);
+    m_refreshTimer->start();
+}
+
+XyScopeWidget::~XyScopeWidget()
+{
+    m_refreshTimer->stop();
+    m_renderer.stop();
+}
+
+void XyScopeWidget::setRange(double minimum, double maximum)
+{
+    if (maximum > minimum) {
+        m_minimum = minimum;
+        m_maximum = maximum;
+        m_renderer.setRange(minimum, maximum);
+        update();
+    }
+}
+
+void XyScopeWidget::setSampleRate(double sampleRate)
+{
+    m_renderer.setSampleRate(sampleRate);
+}
+
+void XyScopeWidget::setFrequency(double frequency)
+{
+    m_renderer.setFrequency(frequency);
+}
+
+void XyScopeWidget::setPersistence(double seconds)
+{
+    m_renderer.setPersistence(seconds);
+}
+
+void XyScopeWidget::clear()
+{
+    m_renderer.clear();
+}
+
+void XyScopeWidget::onRefresh()
+{
+    if (m_renderer.takeDirty()) {
+        update();
+    }
+}
+
+void XyScopeWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    m_renderer.setGeometry(width(), height());
+}
+
+void XyScopeWidget::drawFit(QPainter &painter, const EllipseFit::Result &fit, const QColor &color)
+{
+    if (!fit.valid) {
+        return;
+    }
+    const QPointF center = XyScopeRenderer::toPixel(width(), height(), m_minimum, m_maximum,
+                                                    fit.centerX, fit.centerY);
+    const double scale = 0.95 * qMin(width(), height()) / (m_maximum - m_minimum);
+
+    painter.save();
+    painter.setPen(QPen(color, 1, Qt::DashLine));
+    painter.translate(center.x(), center.y());
+    painter.rotate(-fit.rotation);      // Y points down on screen
+    painter.drawEllipse(QPointF(0.0, 0.0), fit.majorAxis * scale, fit.minorAxis * scale);
+    painter.restore();
+}
+
+void XyScopeWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    XyScopeRenderer::Fit fit;
+    {
+        QMutexLocker locker(m_renderer.imageMutex());
+        const QImage &image = m_renderer.image();
+        if (image.isNull() || image.width() != width() || image.height() != height()) {
+            // The renderer has not caught up with a resize yet
+            painter.fillRect(rect(), Qt::black);
+        } else {
+            painter.drawImage(0, 0, image);
+        }
+        fit = m_renderer.fit();
+    }
+
+    // Frame of the full range and its center lines
+    const QPointF low = XyScopeRenderer::toPixel(width(), height(), m_minimum, m_maximum, m_minimum, m_minimum);
+    const QPointF high = XyScopeRenderer::toPixel(width(), height(), m_minimum, m_maximum, m_maximum, m_maximum);
+    const QPointF middle = XyScopeRenderer::toPixel(width(), height(), m_minimum, m_maximum,
+                                                    0.5 * (m_minimum + m_maximum), 0.5 * (m_minimum + m_maximum));
+    painter.setPen(QPen(QColor(90, 90, 90), 1));
+    painter.drawRect(QRect(QPoint(int(low.x()), int(high.y())), QPoint(int(high.x()), int(low.y()))));
+    painter.setPen(QPen(QColor(60, 60, 60), 1, Qt::DotLine));
+    painter.drawLine(QPointF(low.x(), middle.y()), QPointF(high.x(), middle.y()));
+    painter.drawLine(QPointF(middle.x(), low.y()), QPointF(middle.x(), high.y()));
+
+    drawFit(painter, fit.command, QColor(0, 255, 0));
+    drawFit(painter, fit.feedback, Qt::white);
+
+    // Readout of the last fitted revolution
+    const QFontMetrics metrics = painter.fontMetrics();
+    int y = 4;
+    auto line = [&](const QString &text, const QColor &color) {
+        painter.setPen(color);
+        painter.drawText(QRect(6, y, width() - 12, metrics.height()), Qt::AlignLeft | Qt::AlignTop, text);
+        y += metrics.height();
+    };
+    auto describe = [](const EllipseFit::Result &result) {
+        return QString("ratio %1, rotation %2°, phase %3°")
+            .arg(result.axisRatio, 0, 'f', 3)
+            .arg(result.rotation, 0, 'f', 1)
+            .arg(result.phase, 0, 'f', 2);
+    };
+
+    if (!fit.command.valid) {
+        line("Fit: waiting for a full revolution", Qt::gray);
+        return;
+    }
+    line(QString("Revolution %1").arg(fit.revolutions), Qt::gray);
+    line("Command: " + describe(fit.command), QColor(0, 255, 0));
+    if (fit.feedback.valid) {
+        line(QString("Feedback: %1, phase error %2°")
+                 .arg(describe(fit.feedback))
+                 .arg(wrapDegrees(fit.feedback.phase - fit.command.phase), 0, 'f', 2),
+             QColor(255, 220, 0));
+    }
+}
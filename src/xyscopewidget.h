@@ -0,0 +1,159 @@
+#ifndef XYSCOPEWIDGET_H
+#define XYSCOPEWIDGET_H
+
+#include <QWidget>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+#include "historyring.h"
+#include "ellipsefit.h"
+
+// Command and measured position of one output frame, in volts. The
+// feedback is NaN when no sensor is acquired.
+struct XyFrame {
+    float xCommand;
+    float yCommand;
+    float xFeedback;
+    float yFeedback;
+};
+
+// Draws X against Y into a persistence image and fits an ellipse to every
+// revolution, on its own thread.
+//
+// Frames come from a HistoryRing written by one producer, as for the time
+// scope. New points are joined to the previous ones and the whole image
+// fades with the persistence time constant. One fit covers a whole number
+// of revolutions of the set frequency (more than one only when a
+// revolution is too short to fit on its own), so the moments are exact.
+class XyScopeRenderer : public QThread
+{
+    Q_OBJECT
+public:
+    // 256k frames: 26 s at 10 kS/s, far more than the renderer lags
+    static constexpr int HistoryCapacityLog2 = 18;
+
+    struct Fit {
+        EllipseFit::Result command;
+        EllipseFit::Result feedback;
+        quint64 revolutions;            // Fitted since the last clear
+    };
+
+    explicit XyScopeRenderer(QObject *parent = nullptr);
+    ~XyScopeRenderer();
+
+    void stop();
+
+    // Written by exactly one producer at a time
+    HistoryRing<XyFrame> &history() { return m_history; }
+
+    // GUI side
+    void setGeometry(int width, int height);
+    void setRange(double minimum, double maximum);
+    void setSampleRate(double sampleRate);
+    void setFrequency(double frequency);
+    void setPersistence(double seconds);    // 0 keeps every point
+    void clear();
+
+    // Pixel position of (x, y) volts in an image of the given size
+    static QPointF toPixel(int width, int height, double minimum, double maximum, double x, double y);
+
+    // True once after the image changed
+    bool takeDirty() { return m_dirty.exchange(false, std::memory_order_acquire); }
+
+    // The caller holds imageMutex() while reading image() and fit()
+    QMutex *imageMutex() { return &m_imageMutex; }
+    const QImage &image() const { return m_image; }
+    const Fit &fit() const { return m_fit; }
+
+protected:
+    void run() override;
+
+private:
+    struct Settings {
+        int width;
+        int height;
+        double minimum;
+        double maximum;
+        double sampleRate;
+        double frequency;
+        double persistence;
+    };
+
+    HistoryRing<XyFrame> m_history;
+
+    // Handed over from the GUI thread
+    QMutex m_inputMutex;
+    QWaitCondition m_inputCondition;
+    Settings m_requested;
+    bool m_settingsChanged;
+    bool m_clearRequested;
+    quint64 m_clearIndex;
+    bool m_shouldStop;
+
+    // Owned by the render thread; image and fit are shared under m_imageMutex
+    QMutex m_imageMutex;
+    QImage m_image;
+    Fit m_fit;
+    std::atomic<bool> m_dirty;
+
+    Settings m_settings;
+    quint64 m_readIndex;
+    bool m_haveCommand;
+    bool m_haveFeedback;
+    QPointF m_lastCommand;          // In pixels
+    QPointF m_lastFeedback;
+    QElapsedTimer m_fadeTimer;
+
+    EllipseFit m_commandFit;
+    EllipseFit m_feedbackFit;
+    double m_revolutionPosition;    // Revolutions into the current fit
+    int m_revolutionsPerFit;
+
+    void applySettings(const Settings &settings);
+    void restartFit();
+    bool drawNewFrames();
+    void processFrames(const XyFrame *frames, int count);
+    void fade();
+    void drawLine(const QPointF &from, const QPointF &to, QRgb color);
+};
+
+// X/Y view of command and feedback for circular tests, with the fitted
+// ellipse and its axis ratio, rotation and X/Y phase overlaid. The phase
+// error compares the feedback with the command of the same revolution.
+class XyScopeWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit XyScopeWidget(QWidget *parent = nullptr);
+    ~XyScopeWidget();
+
+    HistoryRing<XyFrame> &history() { return m_renderer.history(); }
+
+    void setRange(double minimum, double maximum);
+    void setSampleRate(double sampleRate);
+    void setFrequency(double frequency);
+    void setPersistence(double seconds);
+    void clear();
+
+    QSize sizeHint() const override { return QSize(400, 400); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    XyScopeRenderer m_renderer;
+    QTimer *m_refreshTimer;
+    double m_minimum;
+    double m_maximum;
+
+    void onRefresh();
+    void drawFit(QPainter &painter, const EllipseFit::Result &fit, const QColor &color);
+};
+
+#endif // XYSCOPEWIDGET_H